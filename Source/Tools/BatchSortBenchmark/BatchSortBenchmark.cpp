@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Batch.h>
+#include <Urho3D/Math/Random.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Bit offsets of the state sorting key fields, as in Batch::CalculateSortKey().
+static const unsigned sortKeyFieldShifts[] = {51, 39, 29, 15, 0};
+/// Number of distinct values of each state sorting key field in the synthetic batches.
+static const unsigned sortKeyFieldCounts[] = {40, 60, 20, 300, 2000};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: BatchSortBenchmark [options]\n"
+        "\n"
+        "Measures the batch queue sorts on synthetic batches with random states, distances and render orders, against\n"
+        "a comparison sort with the same ordering. Exits with an error if the front to back sort does not group the\n"
+        "batches by state with increasing distance within each state, or the back to front sort does not order the\n"
+        "batches by decreasing distance.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-n <batches> Number of batches. Default 100000.\n"
+        "-i <iterations> Number of sorts to average. Default 10.\n"
+        "-s <seed> Random seed. Default 1.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+bool CompareBatchesStateFrontToBack(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    if (lhs->sortKey_ != rhs->sortKey_)
+        return lhs->sortKey_ < rhs->sortKey_;
+    return lhs->distance_ < rhs->distance_;
+}
+
+bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ > rhs->distance_;
+    return lhs->sortKey_ < rhs->sortKey_;
+}
+
+void CheckFrontToBack(const PODVector<Batch*>& sorted, unsigned numBatches)
+{
+    if (sorted.Size() != numBatches)
+        ErrorExit("Front to back sort returned " + String(sorted.Size()) + " of " + String(numBatches) + " batches");
+
+    // Each state must form one contiguous run within its render order
+    HashSet<Pair<unsigned char, unsigned long long> > finishedStates;
+    for (unsigned i = 1; i < sorted.Size(); ++i)
+    {
+        const Batch* prev = sorted[i - 1];
+        const Batch* batch = sorted[i];
+        if (batch->renderOrder_ < prev->renderOrder_)
+            ErrorExit("Front to back sort: render order decreases at batch " + String(i));
+        if (batch->renderOrder_ == prev->renderOrder_ && batch->sortKey_ == prev->sortKey_)
+        {
+            if (batch->distance_ < prev->distance_)
+                ErrorExit("Front to back sort: distance decreases within a state at batch " + String(i));
+        }
+        else
+        {
+            finishedStates.Insert(MakePair(prev->renderOrder_, prev->sortKey_));
+            if (finishedStates.Contains(MakePair(batch->renderOrder_, batch->sortKey_)))
+                ErrorExit("Front to back sort: state is split at batch " + String(i));
+        }
+    }
+}
+
+void CheckBackToFront(const PODVector<Batch*>& sorted, unsigned numBatches)
+{
+    if (sorted.Size() != numBatches)
+        ErrorExit("Back to front sort returned " + String(sorted.Size()) + " of " + String(numBatches) + " batches");
+
+    for (unsigned i = 1; i < sorted.Size(); ++i)
+    {
+        if (CompareBatchesBackToFront(sorted[i], sorted[i - 1]))
+            ErrorExit("Back to front sort: wrong order at batch " + String(i));
+    }
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numBatches = 100000;
+    unsigned numIterations = 10;
+    unsigned seed = 1;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h" || !hasValue)
+            Help();
+        else if (arg == "-n")
+            numBatches = ToUInt(arguments[++i]);
+        else if (arg == "-i")
+            numIterations = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-s")
+            seed = ToUInt(arguments[++i]);
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    // The Time subsystem calibrates the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+
+    SetRandomSeed(seed);
+
+    PODVector<Batch> batches(numBatches);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch& batch = batches[i];
+        batch.distance_ = Random(1000.0f);
+        batch.renderOrder_ = Rand() % 8 ? 128 : 200;
+        batch.sortKey_ = Rand() % 2 ? 1ULL << 63u : 0;
+        for (unsigned j = 0; j < MAX_SORTKEY_FIELDS; ++j)
+            batch.sortKey_ |= (unsigned long long)(Rand() % sortKeyFieldCounts[j]) << sortKeyFieldShifts[j];
+    }
+
+    BatchQueue queue;
+    queue.maxSortedInstances_ = 0;
+    PODVector<Batch*> sorted(numBatches);
+    long long frontToBackTime = 0;
+    long long backToFrontTime = 0;
+    long long frontToBackReferenceTime = 0;
+    long long backToFrontReferenceTime = 0;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < numIterations; ++i)
+    {
+        queue.batches_ = batches;
+        timer.Reset();
+        queue.SortFrontToBack();
+        frontToBackTime += timer.GetUSec(false);
+        CheckFrontToBack(queue.sortedBatches_, numBatches);
+
+        timer.Reset();
+        queue.SortBackToFront();
+        backToFrontTime += timer.GetUSec(false);
+        CheckBackToFront(queue.sortedBatches_, numBatches);
+
+        for (unsigned j = 0; j < numBatches; ++j)
+            sorted[j] = &queue.batches_[j];
+        timer.Reset();
+        Sort(sorted.Begin(), sorted.End(), CompareBatchesStateFrontToBack);
+        frontToBackReferenceTime += timer.GetUSec(false);
+
+        for (unsigned j = 0; j < numBatches; ++j)
+            sorted[j] = &queue.batches_[j];
+        timer.Reset();
+        Sort(sorted.Begin(), sorted.End(), CompareBatchesBackToFront);
+        backToFrontReferenceTime += timer.GetUSec(false);
+    }
+
+    PrintLine(String(numBatches) + " batches, average of " + String(numIterations) + " sorts");
+    PrintLine("Front to back: " + String(frontToBackTime / 1000.0 / numIterations) + " ms, comparison sort " +
+        String(frontToBackReferenceTime / 1000.0 / numIterations) + " ms");
+    PrintLine("Back to front: " + String(backToFrontTime / 1000.0 / numIterations) + " ms, comparison sort " +
+        String(backToFrontReferenceTime / 1000.0 / numIterations) + " ms");
+}
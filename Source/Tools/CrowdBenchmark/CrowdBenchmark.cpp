@@ -0,0 +1,226 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Animations played on the layers of each character.
+static const char* animationNames[] = {
+    "Models/Mutant/Mutant_Run.ani",
+    "Models/Mutant/Mutant_Idle0.ani",
+    "Models/Mutant/Mutant_HipHop1.ani",
+    "Models/Mutant/Mutant_Jump.ani"
+};
+/// Maximum number of animation layers.
+static const unsigned MAX_LAYERS = sizeof animationNames / sizeof animationNames[0];
+/// Bone that gets an attached weapon.
+static const char* ATTACHMENT_BONE = "Mutant:RightHand";
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: CrowdBenchmark [options]\n"
+        "\n"
+        "Measures the octree update of a crowd of animated characters, each playing a number of blended animation\n"
+        "layers and carrying a weapon attached to a bone. Runs the crowd first with bone nodes, then with lightweight\n"
+        "skeletons, and prints the update time per frame. The Mutant model and animations are loaded from the Data\n"
+        "resource directory.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-n <characters> Number of characters. Default 300.\n"
+        "-l <layers> Number of animation layers per character, 1-4. Default 4.\n"
+        "-f <frames> Number of frames to measure. Default 60.\n"
+        "-t <threads> Number of worker threads. Default is one less than the number of physical CPU cores.\n"
+        "-p <paths> Resource prefix paths, separated by semicolons. Default is the URHO3D_PREFIX_PATH environment\n"
+        "   variable, or the parent directory of the executable.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+double MeasureCrowd(Context* context, bool lightweight, unsigned numCharacters, unsigned numLayers, unsigned numFrames)
+{
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    auto* model = cache->GetResource<Model>("Models/Mutant/Mutant.mdl");
+    auto* weapon = cache->GetResource<Model>("Models/Box.mdl");
+    if (!model || !weapon)
+        ErrorExit("Could not load the character models, check the resource prefix path");
+
+    Animation* animations[MAX_LAYERS];
+    for (unsigned i = 0; i < numLayers; ++i)
+    {
+        animations[i] = cache->GetResource<Animation>(animationNames[i]);
+        if (!animations[i])
+            ErrorExit("Could not load the character animations, check the resource prefix path");
+    }
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    PODVector<AnimatedModel*> characters;
+
+    // Arrange the characters in a square grid, with random animation phases
+    unsigned gridSize = (unsigned)ceilf(sqrtf((float)numCharacters));
+    for (unsigned i = 0; i < numCharacters; ++i)
+    {
+        Node* node = scene->CreateChild("Character");
+        node->SetPosition(Vector3((float)(i % gridSize) * 2.0f, 0.0f, (float)(i / gridSize) * 2.0f));
+
+        auto* character = node->CreateComponent<AnimatedModel>();
+        character->SetLightweightSkeleton(lightweight);
+        character->SetModel(model);
+        for (unsigned j = 0; j < numLayers; ++j)
+        {
+            AnimationState* state = character->AddAnimationState(animations[j]);
+            state->SetWeight(j ? 0.5f : 1.0f);
+            state->SetLooped(true);
+            state->SetTime(Random(animations[j]->GetLength()));
+        }
+
+        Node* boneNode = lightweight ? character->GetBoneNode(ATTACHMENT_BONE) : node->GetChild(ATTACHMENT_BONE, true);
+        if (!boneNode)
+            ErrorExit("Could not find the attachment bone");
+        boneNode->CreateChild("Weapon")->CreateComponent<StaticModel>()->SetModel(weapon);
+
+        characters.Push(character);
+    }
+
+    // Without a camera the animations are updated at full rate regardless of distance, like in a headless server
+    FrameInfo frame;
+    frame.frameNumber_ = 0;
+    frame.timeStep_ = 1.0f / 60.0f;
+    frame.camera_ = nullptr;
+    HiresTimer timer;
+    long long totalTime = 0;
+
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        ++frame.frameNumber_;
+        for (unsigned j = 0; j < characters.Size(); ++j)
+        {
+            const Vector<SharedPtr<AnimationState> >& states = characters[j]->GetAnimationStates();
+            for (unsigned k = 0; k < states.Size(); ++k)
+                states[k]->AddTime(frame.timeStep_);
+        }
+
+        timer.Reset();
+        octree->Update(frame);
+        totalTime += timer.GetUSec(false);
+    }
+
+    return totalTime / 1000.0 / numFrames;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numCharacters = 300;
+    unsigned numLayers = MAX_LAYERS;
+    unsigned numFrames = 60;
+    unsigned numThreads = Max(GetNumPhysicalCPUs(), 1U) - 1;
+    String prefixPaths;
+    if (const char* paths = getenv("URHO3D_PREFIX_PATH"))
+        prefixPaths = paths;
+    else
+        prefixPaths = "..";
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h" || !hasValue)
+            Help();
+        else if (arg == "-n")
+            numCharacters = ToUInt(arguments[++i]);
+        else if (arg == "-l")
+            numLayers = Clamp(ToUInt(arguments[++i]), 1U, MAX_LAYERS);
+        else if (arg == "-f")
+            numFrames = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-t")
+            numThreads = ToUInt(arguments[++i]);
+        else if (arg == "-p")
+            prefixPaths = arguments[++i];
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_LOG_LEVEL] = LOG_WARNING;
+    engineParameters[EP_LOG_NAME] = String::EMPTY;
+    engineParameters[EP_RESOURCE_PATHS] = "Data;CoreData";
+    engineParameters[EP_RESOURCE_PREFIX_PATHS] = prefixPaths;
+    engineParameters[EP_WORKER_THREADS] = false;
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Could not initialize the engine, check the resource prefix path");
+
+    context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+
+    SetRandomSeed(1);
+    double nodeTime = MeasureCrowd(context, false, numCharacters, numLayers, numFrames);
+    double lightweightTime = MeasureCrowd(context, true, numCharacters, numLayers, numFrames);
+
+    PrintLine(String(numCharacters) + " characters, " + String(numLayers) + " animation layers, " +
+        String(context->GetSubsystem<WorkQueue>()->GetNumThreads()) + " worker threads");
+    PrintLine("Bone nodes: " + String(nodeTime) + " ms/frame");
+    PrintLine("Lightweight skeletons: " + String(lightweightTime) + " ms/frame");
+}
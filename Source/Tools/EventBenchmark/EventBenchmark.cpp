@@ -0,0 +1,195 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Event receiver with both a VariantMap and a typed update handler.
+class BenchmarkReceiver : public Object
+{
+    URHO3D_OBJECT(BenchmarkReceiver, Object);
+
+public:
+    /// Construct.
+    explicit BenchmarkReceiver(Context* context) :
+        Object(context)
+    {
+    }
+
+    /// Subscribe to the update event with either handler.
+    void Subscribe(bool typed)
+    {
+        if (typed)
+            SubscribeToEvent(E_UPDATE, URHO3D_TYPED_HANDLER(BenchmarkReceiver, HandleUpdateTyped));
+        else
+            SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(BenchmarkReceiver, HandleUpdate));
+    }
+
+    /// Handle the update event with a VariantMap.
+    void HandleUpdate(StringHash eventType, VariantMap& eventData)
+    {
+        timeSum_ += eventData[Update::P_TIMESTEP].GetFloat();
+        ++numCalls_;
+    }
+
+    /// Handle the update event with the typed event data.
+    void HandleUpdateTyped(StringHash eventType, UpdateEventData& eventData)
+    {
+        timeSum_ += eventData.timeStep_;
+        ++numCalls_;
+    }
+
+    /// Sum of the received timesteps.
+    double timeSum_{};
+    /// Number of handler calls.
+    unsigned numCalls_{};
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: EventBenchmark [options]\n"
+        "\n"
+        "Measures the delivery rate of the update event to a number of receivers, sent either with a VariantMap or with\n"
+        "the typed UpdateEventData, to VariantMap or typed handlers. Exits with an error if a receiver does not get every\n"
+        "event exactly once with the sent timestep.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-n <receivers> Number of receivers. Default 5000.\n"
+        "-e <events> Number of events sent per measurement. Default 200.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Measure(Context* context, Object* sender, Vector<SharedPtr<BenchmarkReceiver> >& receivers, unsigned numEvents,
+    bool typedHandlers, bool typedSend)
+{
+    for (unsigned i = 0; i < receivers.Size(); ++i)
+    {
+        receivers[i]->Subscribe(typedHandlers);
+        receivers[i]->timeSum_ = 0.0;
+        receivers[i]->numCalls_ = 0;
+    }
+
+    const float timeStep = 0.25f;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < numEvents; ++i)
+    {
+        if (typedSend)
+        {
+            UpdateEventData eventData;
+            eventData.timeStep_ = timeStep;
+            sender->SendEvent(E_UPDATE, eventData);
+        }
+        else
+        {
+            VariantMap& eventData = context->GetEventDataMap();
+            eventData[Update::P_TIMESTEP] = timeStep;
+            sender->SendEvent(E_UPDATE, eventData);
+        }
+    }
+
+    long long time = Max(timer.GetUSec(false), 1LL);
+
+    String name = String(typedSend ? "Typed" : "VariantMap") + " send to " + (typedHandlers ? "typed" : "VariantMap") +
+        " handlers";
+    for (unsigned i = 0; i < receivers.Size(); ++i)
+    {
+        if (receivers[i]->numCalls_ != numEvents || receivers[i]->timeSum_ != (double)timeStep * numEvents)
+            ErrorExit(name + ": receiver " + String(i) + " got " + String(receivers[i]->numCalls_) + " of " +
+                String(numEvents) + " events");
+    }
+
+    double numDeliveries = (double)receivers.Size() * numEvents;
+    PrintLine(name + ": " + String(numDeliveries / time) + " M deliveries/s, " + String(time * 1000.0 / numDeliveries) +
+        " ns per delivery");
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numReceivers = 5000;
+    unsigned numEvents = 200;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h" || !hasValue)
+            Help();
+        else if (arg == "-n")
+            numReceivers = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-e")
+            numEvents = Max(ToUInt(arguments[++i]), 1U);
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    // The Time subsystem calibrates the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+
+    SharedPtr<Object> sender(new BenchmarkReceiver(context));
+    Vector<SharedPtr<BenchmarkReceiver> > receivers;
+    for (unsigned i = 0; i < numReceivers; ++i)
+        receivers.Push(SharedPtr<BenchmarkReceiver>(new BenchmarkReceiver(context)));
+
+    Measure(context, sender, receivers, numEvents, false, false);
+    Measure(context, sender, receivers, numEvents, true, true);
+    Measure(context, sender, receivers, numEvents, false, true);
+    Measure(context, sender, receivers, numEvents, true, false);
+
+    // Sending an event without receivers should cost next to nothing
+    const unsigned numEmptyEvents = 1000000;
+    HiresTimer timer;
+    for (unsigned i = 0; i < numEmptyEvents; ++i)
+        sender->SendEvent(E_POSTUPDATE);
+    PrintLine("Send without receivers: " + String(timer.GetUSec(false) * 1000.0 / numEmptyEvents) + " ns per event");
+}
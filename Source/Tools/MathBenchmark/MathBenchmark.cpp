@@ -0,0 +1,431 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/Frustum.h>
+#include <Urho3D/Math/Random.h>
+
+#include <cstring>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: MathBenchmark [options]\n"
+        "\n"
+        "Compares the SIMD implementations of the math classes against scalar reference versions. The results of each\n"
+        "operation must match the scalar version exactly, otherwise exits with an error. Prints the time per operation\n"
+        "of both versions. When the library is built without SIMD, both versions are scalar.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-n <count> Number of random inputs per operation. Default 4096.\n"
+        "-i <iterations> Number of timed passes over the inputs. Default 1000.\n"
+        "-s <seed> Random seed. Default 1.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+/// Random inputs of the benchmarked operations.
+struct Inputs
+{
+    PODVector<Matrix4> matrices_;
+    PODVector<Vector3> vectors3_;
+    PODVector<Vector4> vectors4_;
+    PODVector<Quaternion> quaternions_;
+    PODVector<Plane> planes_;
+    PODVector<BoundingBox> boxes_;
+    PODVector<Sphere> spheres_;
+};
+
+Matrix4 ScalarMultiply(const Matrix4& lhs, const Matrix4& rhs)
+{
+    return Matrix4(
+        lhs.m00_ * rhs.m00_ + lhs.m01_ * rhs.m10_ + lhs.m02_ * rhs.m20_ + lhs.m03_ * rhs.m30_,
+        lhs.m00_ * rhs.m01_ + lhs.m01_ * rhs.m11_ + lhs.m02_ * rhs.m21_ + lhs.m03_ * rhs.m31_,
+        lhs.m00_ * rhs.m02_ + lhs.m01_ * rhs.m12_ + lhs.m02_ * rhs.m22_ + lhs.m03_ * rhs.m32_,
+        lhs.m00_ * rhs.m03_ + lhs.m01_ * rhs.m13_ + lhs.m02_ * rhs.m23_ + lhs.m03_ * rhs.m33_,
+        lhs.m10_ * rhs.m00_ + lhs.m11_ * rhs.m10_ + lhs.m12_ * rhs.m20_ + lhs.m13_ * rhs.m30_,
+        lhs.m10_ * rhs.m01_ + lhs.m11_ * rhs.m11_ + lhs.m12_ * rhs.m21_ + lhs.m13_ * rhs.m31_,
+        lhs.m10_ * rhs.m02_ + lhs.m11_ * rhs.m12_ + lhs.m12_ * rhs.m22_ + lhs.m13_ * rhs.m32_,
+        lhs.m10_ * rhs.m03_ + lhs.m11_ * rhs.m13_ + lhs.m12_ * rhs.m23_ + lhs.m13_ * rhs.m33_,
+        lhs.m20_ * rhs.m00_ + lhs.m21_ * rhs.m10_ + lhs.m22_ * rhs.m20_ + lhs.m23_ * rhs.m30_,
+        lhs.m20_ * rhs.m01_ + lhs.m21_ * rhs.m11_ + lhs.m22_ * rhs.m21_ + lhs.m23_ * rhs.m31_,
+        lhs.m20_ * rhs.m02_ + lhs.m21_ * rhs.m12_ + lhs.m22_ * rhs.m22_ + lhs.m23_ * rhs.m32_,
+        lhs.m20_ * rhs.m03_ + lhs.m21_ * rhs.m13_ + lhs.m22_ * rhs.m23_ + lhs.m23_ * rhs.m33_,
+        lhs.m30_ * rhs.m00_ + lhs.m31_ * rhs.m10_ + lhs.m32_ * rhs.m20_ + lhs.m33_ * rhs.m30_,
+        lhs.m30_ * rhs.m01_ + lhs.m31_ * rhs.m11_ + lhs.m32_ * rhs.m21_ + lhs.m33_ * rhs.m31_,
+        lhs.m30_ * rhs.m02_ + lhs.m31_ * rhs.m12_ + lhs.m32_ * rhs.m22_ + lhs.m33_ * rhs.m32_,
+        lhs.m30_ * rhs.m03_ + lhs.m31_ * rhs.m13_ + lhs.m32_ * rhs.m23_ + lhs.m33_ * rhs.m33_
+    );
+}
+
+Matrix4 ScalarAdd(const Matrix4& lhs, const Matrix4& rhs)
+{
+    Matrix4 ret;
+    const float* l = lhs.Data();
+    const float* r = rhs.Data();
+    float* out = &ret.m00_;
+    for (unsigned i = 0; i < 16; ++i)
+        out[i] = l[i] + r[i];
+    return ret;
+}
+
+Matrix4 ScalarTranspose(const Matrix4& m)
+{
+    return Matrix4(
+        m.m00_, m.m10_, m.m20_, m.m30_,
+        m.m01_, m.m11_, m.m21_, m.m31_,
+        m.m02_, m.m12_, m.m22_, m.m32_,
+        m.m03_, m.m13_, m.m23_, m.m33_
+    );
+}
+
+Vector3 ScalarMultiply(const Matrix4& m, const Vector3& rhs)
+{
+    float invW = 1.0f / (m.m30_ * rhs.x_ + m.m31_ * rhs.y_ + m.m32_ * rhs.z_ + m.m33_);
+
+    return Vector3(
+        (m.m00_ * rhs.x_ + m.m01_ * rhs.y_ + m.m02_ * rhs.z_ + m.m03_) * invW,
+        (m.m10_ * rhs.x_ + m.m11_ * rhs.y_ + m.m12_ * rhs.z_ + m.m13_) * invW,
+        (m.m20_ * rhs.x_ + m.m21_ * rhs.y_ + m.m22_ * rhs.z_ + m.m23_) * invW
+    );
+}
+
+Vector4 ScalarMultiply(const Matrix4& m, const Vector4& rhs)
+{
+    return Vector4(
+        m.m00_ * rhs.x_ + m.m01_ * rhs.y_ + m.m02_ * rhs.z_ + m.m03_ * rhs.w_,
+        m.m10_ * rhs.x_ + m.m11_ * rhs.y_ + m.m12_ * rhs.z_ + m.m13_ * rhs.w_,
+        m.m20_ * rhs.x_ + m.m21_ * rhs.y_ + m.m22_ * rhs.z_ + m.m23_ * rhs.w_,
+        m.m30_ * rhs.x_ + m.m31_ * rhs.y_ + m.m32_ * rhs.z_ + m.m33_ * rhs.w_
+    );
+}
+
+Quaternion ScalarMultiply(const Quaternion& lhs, const Quaternion& rhs)
+{
+    return Quaternion(
+        lhs.w_ * rhs.w_ - lhs.x_ * rhs.x_ - lhs.y_ * rhs.y_ - lhs.z_ * rhs.z_,
+        lhs.w_ * rhs.x_ + lhs.x_ * rhs.w_ + lhs.y_ * rhs.z_ - lhs.z_ * rhs.y_,
+        lhs.w_ * rhs.y_ + lhs.y_ * rhs.w_ + lhs.z_ * rhs.x_ - lhs.x_ * rhs.z_,
+        lhs.w_ * rhs.z_ + lhs.z_ * rhs.w_ + lhs.x_ * rhs.y_ - lhs.y_ * rhs.x_
+    );
+}
+
+Vector3 ScalarMultiply(const Quaternion& q, const Vector3& rhs)
+{
+    Vector3 qVec(q.x_, q.y_, q.z_);
+    Vector3 cross1(qVec.CrossProduct(rhs));
+    Vector3 cross2(qVec.CrossProduct(cross1));
+
+    return rhs + 2.0f * (cross1 * q.w_ + cross2);
+}
+
+Matrix3x4 ScalarReflectionMatrix(const Plane& plane)
+{
+    const Vector3& n = plane.normal_;
+    float d = plane.d_;
+
+    return Matrix3x4(
+        -2.0f * n.x_ * n.x_ + 1.0f,
+        -2.0f * n.x_ * n.y_,
+        -2.0f * n.x_ * n.z_,
+        -2.0f * n.x_ * d,
+        -2.0f * n.y_ * n.x_,
+        -2.0f * n.y_ * n.y_ + 1.0f,
+        -2.0f * n.y_ * n.z_,
+        -2.0f * n.y_ * d,
+        -2.0f * n.z_ * n.x_,
+        -2.0f * n.z_ * n.y_,
+        -2.0f * n.z_ * n.z_ + 1.0f,
+        -2.0f * n.z_ * d
+    );
+}
+
+Intersection ScalarIsInside(const Sphere& sphere, const BoundingBox& box, bool fast)
+{
+    float radiusSquared = sphere.radius_ * sphere.radius_;
+    float distSquared = 0;
+    Vector3 center = sphere.center_;
+    Vector3 min = box.min_;
+    Vector3 max = box.max_;
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        float temp = 0.0f;
+        if (center.Data()[i] < min.Data()[i])
+            temp = center.Data()[i] - min.Data()[i];
+        else if (center.Data()[i] > max.Data()[i])
+            temp = center.Data()[i] - max.Data()[i];
+        else
+            continue;
+        distSquared += temp * temp;
+    }
+
+    if (distSquared >= radiusSquared)
+        return OUTSIDE;
+    if (fast)
+        return INSIDE;
+
+    min -= center;
+    max -= center;
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        Vector3 corner((i & 1) ? max.x_ : min.x_, (i & 2) ? max.y_ : min.y_, (i & 4) ? max.z_ : min.z_);
+        if (corner.LengthSquared() >= radiusSquared)
+            return INTERSECTS;
+    }
+
+    return INSIDE;
+}
+
+Intersection ScalarIsInside(const Frustum& frustum, const BoundingBox& box, bool fast)
+{
+    Vector3 center = box.Center();
+    Vector3 edge = center - box.min_;
+    bool allInside = true;
+
+    for (const auto& plane : frustum.planes_)
+    {
+        float dist = plane.normal_.DotProduct(center) + plane.d_;
+        float absDist = plane.absNormal_.DotProduct(edge);
+
+        if (dist < -absDist)
+            return OUTSIDE;
+        else if (dist < absDist)
+            allInside = false;
+    }
+
+    return fast || allInside ? INSIDE : INTERSECTS;
+}
+
+Intersection ScalarIsInside(const Frustum& frustum, const Sphere& sphere, bool fast)
+{
+    bool allInside = true;
+
+    for (const auto& plane : frustum.planes_)
+    {
+        float dist = plane.Distance(sphere.center_);
+        if (dist < -sphere.radius_)
+            return OUTSIDE;
+        else if (dist < sphere.radius_)
+            allInside = false;
+    }
+
+    return fast || allInside ? INSIDE : INTERSECTS;
+}
+
+Intersection ScalarIsInside(const Frustum& frustum, const Vector3& point)
+{
+    for (const auto& plane : frustum.planes_)
+    {
+        if (plane.Distance(point) < 0.0f)
+            return OUTSIDE;
+    }
+
+    return INSIDE;
+}
+
+/// Run one operation over all inputs with both versions, check that the results are identical and print the timings.
+template <class Result, class SimdFunction, class ScalarFunction> void Benchmark(const String& name, unsigned count,
+    unsigned iterations, SimdFunction simdFunction, ScalarFunction scalarFunction)
+{
+    PODVector<Result> simdResults(count);
+    PODVector<Result> scalarResults(count);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        simdResults[i] = simdFunction(i);
+        scalarResults[i] = scalarFunction(i);
+        if (memcmp(&simdResults[i], &scalarResults[i], sizeof(Result)) != 0)
+            ErrorExit(name + ": result " + String(i) + " differs from the scalar version");
+    }
+
+    HiresTimer timer;
+    for (unsigned j = 0; j < iterations; ++j)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            simdResults[i] = simdFunction(i);
+    }
+    long long simdTime = timer.GetUSec(true);
+
+    for (unsigned j = 0; j < iterations; ++j)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            scalarResults[i] = scalarFunction(i);
+    }
+    long long scalarTime = timer.GetUSec(false);
+
+    double numOps = (double)count * iterations;
+    PrintLine(name + ": SIMD " + String(simdTime * 1000.0 / numOps) + " ns, scalar " + String(scalarTime * 1000.0 /
+        numOps) + " ns, speedup " + String((double)scalarTime / Max(simdTime, 1LL)));
+}
+
+float RandomFloat()
+{
+    return Random(-10.0f, 10.0f);
+}
+
+Vector3 RandomVector3()
+{
+    return Vector3(RandomFloat(), RandomFloat(), RandomFloat());
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned count = 4096;
+    unsigned iterations = 1000;
+    unsigned seed = 1;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h" || !hasValue)
+            Help();
+        else if (arg == "-n")
+            count = Max(ToUInt(arguments[++i]), 2U);
+        else if (arg == "-i")
+            iterations = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-s")
+            seed = ToUInt(arguments[++i]);
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    // The Time subsystem calibrates the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+
+    SetRandomSeed(seed);
+
+    Inputs in;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Matrix4 matrix;
+        float* data = &matrix.m00_;
+        for (unsigned j = 0; j < 16; ++j)
+            data[j] = RandomFloat();
+        in.matrices_.Push(matrix);
+        in.vectors3_.Push(RandomVector3());
+        in.vectors4_.Push(Vector4(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat()));
+        in.quaternions_.Push(Quaternion(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat()));
+        in.planes_.Push(Plane(RandomVector3(), RandomVector3()));
+
+        // Scale the boxes and spheres to the frustums, so that all intersection results occur
+        Vector3 center = RandomVector3() * 60.0f;
+        Vector3 halfSize(Random(0.0f, 20.0f), Random(0.0f, 20.0f), Random(0.0f, 20.0f));
+        in.boxes_.Push(BoundingBox(center - halfSize, center + halfSize));
+        in.spheres_.Push(Sphere(RandomVector3() * 60.0f, Random(0.0f, 30.0f)));
+    }
+
+    // A regular frustum, a mirrored one with flipped plane normals and a degenerate default frustum
+    Frustum frustums[3];
+    frustums[0].Define(60.0f, 1.7f, 1.0f, 0.1f, 500.0f, Matrix3x4(Vector3(3.0f, 2.0f, 1.0f), Quaternion(20.0f, 35.0f, 0.0f),
+        Vector3::ONE));
+    frustums[1].Define(60.0f, 1.7f, 1.0f, 0.1f, 500.0f, Matrix3x4(Vector3(3.0f, 2.0f, 1.0f), Quaternion(20.0f, 35.0f, 0.0f),
+        Vector3(-1.0f, 1.0f, 1.0f)));
+
+    unsigned last = count - 1;
+
+    Benchmark<Matrix4>("Matrix4 * Matrix4", count, iterations,
+        [&](unsigned i) { return in.matrices_[i] * in.matrices_[last - i]; },
+        [&](unsigned i) { return ScalarMultiply(in.matrices_[i], in.matrices_[last - i]); });
+    Benchmark<Matrix4>("Matrix4 + Matrix4", count, iterations,
+        [&](unsigned i) { return in.matrices_[i] + in.matrices_[last - i]; },
+        [&](unsigned i) { return ScalarAdd(in.matrices_[i], in.matrices_[last - i]); });
+    Benchmark<Matrix4>("Matrix4::Transpose", count, iterations,
+        [&](unsigned i) { return in.matrices_[i].Transpose(); },
+        [&](unsigned i) { return ScalarTranspose(in.matrices_[i]); });
+    Benchmark<Vector3>("Matrix4 * Vector3", count, iterations,
+        [&](unsigned i) { return in.matrices_[i] * in.vectors3_[i]; },
+        [&](unsigned i) { return ScalarMultiply(in.matrices_[i], in.vectors3_[i]); });
+    Benchmark<Vector4>("Matrix4 * Vector4", count, iterations,
+        [&](unsigned i) { return in.matrices_[i] * in.vectors4_[i]; },
+        [&](unsigned i) { return ScalarMultiply(in.matrices_[i], in.vectors4_[i]); });
+    Benchmark<Quaternion>("Quaternion * Quaternion", count, iterations,
+        [&](unsigned i) { return in.quaternions_[i] * in.quaternions_[last - i]; },
+        [&](unsigned i) { return ScalarMultiply(in.quaternions_[i], in.quaternions_[last - i]); });
+    Benchmark<Vector3>("Quaternion * Vector3", count, iterations,
+        [&](unsigned i) { return in.quaternions_[i] * in.vectors3_[i]; },
+        [&](unsigned i) { return ScalarMultiply(in.quaternions_[i], in.vectors3_[i]); });
+    Benchmark<Matrix3x4>("Plane::ReflectionMatrix", count, iterations,
+        [&](unsigned i) { return in.planes_[i].ReflectionMatrix(); },
+        [&](unsigned i) { return ScalarReflectionMatrix(in.planes_[i]); });
+    Benchmark<Intersection>("Sphere::IsInside(BoundingBox)", count, iterations,
+        [&](unsigned i) { return in.spheres_[i].IsInside(in.boxes_[i]); },
+        [&](unsigned i) { return ScalarIsInside(in.spheres_[i], in.boxes_[i], false); });
+    Benchmark<Intersection>("Sphere::IsInsideFast(BoundingBox)", count, iterations,
+        [&](unsigned i) { return in.spheres_[i].IsInsideFast(in.boxes_[i]); },
+        [&](unsigned i) { return ScalarIsInside(in.spheres_[i], in.boxes_[i], true); });
+
+    for (unsigned j = 0; j < 3; ++j)
+    {
+        const Frustum& frustum = frustums[j];
+        String suffix = " (frustum " + String(j) + ")";
+
+        Benchmark<Intersection>("Frustum::IsInside(BoundingBox)" + suffix, count, iterations,
+            [&](unsigned i) { return frustum.IsInside(in.boxes_[i]); },
+            [&](unsigned i) { return ScalarIsInside(frustum, in.boxes_[i], false); });
+        Benchmark<Intersection>("Frustum::IsInsideFast(BoundingBox)" + suffix, count, iterations,
+            [&](unsigned i) { return frustum.IsInsideFast(in.boxes_[i]); },
+            [&](unsigned i) { return ScalarIsInside(frustum, in.boxes_[i], true); });
+        Benchmark<Intersection>("Frustum::IsInside(Sphere)" + suffix, count, iterations,
+            [&](unsigned i) { return frustum.IsInside(in.spheres_[i]); },
+            [&](unsigned i) { return ScalarIsInside(frustum, in.spheres_[i], false); });
+        Benchmark<Intersection>("Frustum::IsInsideFast(Sphere)" + suffix, count, iterations,
+            [&](unsigned i) { return frustum.IsInsideFast(in.spheres_[i]); },
+            [&](unsigned i) { return ScalarIsInside(frustum, in.spheres_[i], true); });
+        Benchmark<Intersection>("Frustum::IsInside(Vector3)" + suffix, count, iterations,
+            [&](unsigned i) { return frustum.IsInside(in.spheres_[i].center_); },
+            [&](unsigned i) { return ScalarIsInside(frustum, in.spheres_[i].center_); });
+    }
+
+    PrintLine("Passed: all results match the scalar versions");
+}
@@ -0,0 +1,223 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkPriority.h>
+#include <Urho3D/Network/Protocol.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <SLikeNet/types.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const unsigned short SERVER_PORT = 2346;
+static const float WORLD_SIZE = 1000.0f;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: NetworkBenchmark [options]\n"
+        "\n"
+        "Measures the server side of network updates in a headless scene with simulated client connections. The\n"
+        "connections have no sockets, so the time spent is building the scene updates.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-c <connections> Number of simulated client connections. Default 32.\n"
+        "-n <nodes> Number of moving replicated nodes. Default 2000.\n"
+        "-u <updates> Number of network updates to measure. Default 200.\n"
+        "-t <threads> Number of worker threads. Default is one less than the number of physical CPU cores.\n"
+        "-r <count> Number of nodes removed and recreated on each update. Default 5.\n"
+        "-p Adds a NetworkPriority component to the nodes for distance-based update rates.\n"
+        "-i <cell size> Enables the interest management grid, with update rate tiers at 1, 2 and 4 cell sizes.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+Node* CreateBenchmarkNode(Scene* scene, bool priority)
+{
+    Node* node = scene->CreateChild("Node");
+    node->SetPosition(Vector3(Random(WORLD_SIZE), 0.0f, Random(WORLD_SIZE)));
+    node->SetRotation(Quaternion(Random(360.0f), Vector3::UP));
+    if (priority)
+        node->CreateComponent<NetworkPriority>();
+    return node;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numConnections = 32;
+    unsigned numNodes = 2000;
+    unsigned numUpdates = 200;
+    unsigned numThreads = Max(GetNumPhysicalCPUs(), 1U) - 1;
+    unsigned churn = 5;
+    bool priority = false;
+    float cellSize = 0.0f;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h")
+            Help();
+        else if (arg == "-p")
+            priority = true;
+        else if (!hasValue)
+            Help();
+        else if (arg == "-c")
+            numConnections = ToUInt(arguments[++i]);
+        else if (arg == "-n")
+            numNodes = ToUInt(arguments[++i]);
+        else if (arg == "-u")
+            numUpdates = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-t")
+            numThreads = ToUInt(arguments[++i]);
+        else if (arg == "-r")
+            churn = ToUInt(arguments[++i]);
+        else if (arg == "-i")
+            cellSize = ToFloat(arguments[++i]);
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_LOG_LEVEL] = LOG_WARNING;
+    engineParameters[EP_LOG_NAME] = String::EMPTY;
+    engineParameters[EP_RESOURCE_PATHS] = String::EMPTY;
+    engineParameters[EP_RESOURCE_PREFIX_PATHS] = String::EMPTY;
+    engineParameters[EP_WORKER_THREADS] = false;
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Could not initialize the engine");
+
+    context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+
+    auto* network = context->GetSubsystem<Network>();
+    network->SetUpdateFps(30);
+    if (cellSize > 0.0f)
+    {
+        network->SetInterestCellSize(cellSize);
+        network->AddInterestTier(cellSize, 1);
+        network->AddInterestTier(cellSize * 2.0f, 2);
+        network->AddInterestTier(cellSize * 4.0f, 4);
+    }
+
+    SharedPtr<Scene> scene(new Scene(context));
+    PODVector<Node*> nodes;
+    for (unsigned i = 0; i < numNodes; ++i)
+        nodes.Push(CreateBenchmarkNode(scene, priority));
+
+    if (!network->StartServer(SERVER_PORT))
+        ErrorExit("Could not start the server");
+
+    // Register connections that have no remote system behind them and report the scene as loaded right away, packed the
+    // same way as the messages received from clients
+    VectorBuffer sceneLoaded;
+    sceneLoaded.WriteUInt(MSG_SCENELOADED);
+    sceneLoaded.WriteUInt(sizeof(unsigned));
+    sceneLoaded.WriteUInt(scene->GetChecksum());
+    for (unsigned i = 0; i < numConnections; ++i)
+    {
+        SLNet::AddressOrGUID address;
+        address.rakNetGuid = SLNet::RakNetGUID(i + 1);
+        network->NewConnectionEstablished(address);
+
+        Connection* connection = network->GetConnection(address);
+        connection->SetScene(scene);
+        connection->SetPosition(Vector3(Random(WORLD_SIZE), 0.0f, Random(WORLD_SIZE)));
+        MemoryBuffer message(sceneLoaded.GetData(), sceneLoaded.GetSize());
+        connection->ProcessMessage(MSG_PACKED_MESSAGE, message);
+        if (!connection->IsSceneLoaded())
+            ErrorExit("Could not set up the simulated connections");
+    }
+
+    // The first update sends the whole scene, so leave it out of the measurement
+    const float timeStep = 1.0f / 30.0f;
+    network->PostUpdate(timeStep);
+
+    HiresTimer timer;
+    long long totalTime = 0;
+    long long minTime = M_MAX_INT;
+    long long maxTime = 0;
+
+    for (unsigned i = 0; i < numUpdates; ++i)
+    {
+        for (unsigned j = 0; j < nodes.Size(); ++j)
+            nodes[j]->Translate(Vector3(0.0f, 0.0f, 1.0f) * timeStep);
+
+        for (unsigned j = 0; j < churn && nodes.Size(); ++j)
+        {
+            unsigned index = Rand() % nodes.Size();
+            nodes[index]->Remove();
+            nodes[index] = CreateBenchmarkNode(scene, priority);
+        }
+
+        timer.Reset();
+        network->PostUpdate(timeStep);
+        long long time = timer.GetUSec(false);
+        totalTime += time;
+        minTime = Min(minTime, time);
+        maxTime = Max(maxTime, time);
+    }
+
+    PrintLine(String(numConnections) + " connections, " + String(numNodes) + " nodes, " + String(numThreads) + " worker threads" +
+        (priority ? ", NetworkPriority" : "") + (cellSize > 0.0f ? ", interest grid" : ""));
+    PrintLine("Server update: average " + String(totalTime / 1000.0 / numUpdates) + " ms, min " + String(minTime / 1000.0) +
+        " ms, max " + String(maxTime / 1000.0) + " ms");
+
+    network->StopServer();
+}
@@ -23,6 +23,8 @@
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Container/ArrayPtr.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/PackageFile.h>
@@ -39,6 +41,7 @@
 using namespace Urho3D;
 
 static const unsigned COMPRESSED_BLOCK_SIZE = 32768;
+static const unsigned BENCHMARK_PASSES = 3;
 
 struct FileEntry
 {
@@ -56,6 +59,7 @@ unsigned checksum_ = 0;
 bool compress_ = false;
 bool quiet_ = false;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
+int compressionLevel_ = LZ4HC_CLEVEL_DEFAULT;
 
 String ignoreExtensions_[] = {
     ".bak",
@@ -68,6 +72,7 @@ void Run(const Vector<String>& arguments);
 void ProcessFile(const String& fileName, const String& rootDir);
 void WritePackageFile(const String& fileName, const String& rootDir);
 void WriteHeader(File& dest);
+void BenchmarkRead(PackageFile* packageFile);
 
 int main(int argc, char** argv)
 {
@@ -91,6 +96,7 @@ void Run(const Vector<String>& arguments)
             "\n"
             "Options:\n"
             "-c      Enable package file LZ4 compression\n"
+            "-h      Enable package file LZ4 compression with the highest but slowest compression level, for rarely changing data\n"
             "-q      Enable quiet mode\n"
             "\n"
             "Basepath is an optional prefix that will be added to the file entries.\n\n"
@@ -99,6 +105,7 @@ void Run(const Vector<String>& arguments)
             "-i      Output package file information\n"
             "-l      Output file names (including their paths) contained in the package\n"
             "-L      Similar to -l but also output compression ratio (compressed package file only)\n"
+            "-b      Measure read throughput by reading all files in the package\n"
         );
 
     const String& dirName = arguments[0];
@@ -119,6 +126,10 @@ void Run(const Vector<String>& arguments)
                     case 'c':
                         compress_ = true;
                         break;
+                    case 'h':
+                        compress_ = true;
+                        compressionLevel_ = LZ4HC_CLEVEL_MAX;
+                        break;
                     case 'q':
                         quiet_ = true;
                         break;
@@ -172,6 +183,10 @@ void Run(const Vector<String>& arguments)
             PrintLine("Package size: " + String(packageFile->GetTotalSize()));
             PrintLine("Checksum: " + String(packageFile->GetChecksum()));
             PrintLine("Compressed: " + String(packageFile->IsCompressed() ? "yes" : "no"));
+            PrintLine("Block-indexed: " + String(packageFile->IsBlockIndexed() ? "yes" : "no"));
+            break;
+        case 'b':
+            BenchmarkRead(packageFile);
             break;
         case 'L':
             if (!packageFile->IsCompressed())
@@ -276,26 +291,38 @@ void WritePackageFile(const String& fileName, const String& rootDir)
         }
         else
         {
-            SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[LZ4_compressBound(blockSize_)]);
-
-            unsigned pos = 0;
-
-            while (pos < dataSize)
+            // Compress the blocks independently into memory first, so that the block index can be written before them. Blocks
+            // that do not compress are stored as is, which is indicated by the packed size being equal to the unpacked size
+            unsigned numBlocks = (dataSize + blockSize_ - 1) / blockSize_;
+            SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[numBlocks * LZ4_compressBound(blockSize_)]);
+            PODVector<unsigned> blockOffsets(numBlocks + 1);
+            unsigned packedPos = 0;
+
+            for (unsigned j = 0; j < numBlocks; ++j)
             {
-                unsigned unpackedSize = blockSize_;
-                if (pos + unpackedSize > dataSize)
-                    unpackedSize = dataSize - pos;
+                unsigned pos = j * blockSize_;
+                unsigned unpackedSize = Min(blockSize_, dataSize - pos);
 
-                auto packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)compressBuffer.Get(), unpackedSize, LZ4_compressBound(unpackedSize), 0);
+                blockOffsets[j] = packedPos;
+                auto packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)&compressBuffer[packedPos],
+                    unpackedSize, LZ4_compressBound(unpackedSize), compressionLevel_);
                 if (!packedSize)
                     ErrorExit("LZ4 compression failed for file " + entries_[i].name_ + " at offset " + String(pos));
 
-                dest.WriteUShort((unsigned short)unpackedSize);
-                dest.WriteUShort((unsigned short)packedSize);
-                dest.Write(compressBuffer.Get(), packedSize);
+                if (packedSize >= unpackedSize)
+                {
+                    memcpy(&compressBuffer[packedPos], &buffer[pos], unpackedSize);
+                    packedSize = unpackedSize;
+                }
 
-                pos += unpackedSize;
+                packedPos += packedSize;
             }
+            blockOffsets[numBlocks] = packedPos;
+
+            dest.WriteUInt(blockSize_);
+            dest.WriteUInt(numBlocks);
+            dest.Write(&blockOffsets[0], (numBlocks + 1) * sizeof(unsigned));
+            dest.Write(compressBuffer.Get(), packedPos);
 
             if (!quiet_)
             {
@@ -339,7 +366,50 @@ void WriteHeader(File& dest)
     if (!compress_)
         dest.WriteFileID("UPAK");
     else
-        dest.WriteFileID("ULZ4");
+        dest.WriteFileID("ULZB");
     dest.WriteUInt(entries_.Size());
     dest.WriteUInt(checksum_);
 }
+
+void BenchmarkRead(PackageFile* packageFile)
+{
+    if (!packageFile->GetNumFiles())
+        ErrorExit("No files in package");
+
+    // The Time subsystem calibrates the high-resolution timer. Use worker threads like the engine does, so that block-indexed
+    // packages are decompressed in parallel
+    context_->RegisterSubsystem(new Time(context_));
+    auto* workQueue = new WorkQueue(context_);
+    context_->RegisterSubsystem(workQueue);
+    workQueue->CreateThreads(Max(GetNumPhysicalCPUs(), 1U) - 1);
+
+    PrintLine("Package: " + String(packageFile->IsCompressed() ? (packageFile->IsBlockIndexed() ? "block-indexed" : "compressed") :
+        "uncompressed") + (packageFile->IsMemoryMapped() ? ", memory-mapped" : "") + ", " + String(workQueue->GetNumThreads()) +
+        " worker threads");
+
+    const HashMap<String, PackageEntry>& entries = packageFile->GetEntries();
+    PODVector<unsigned char> buffer;
+    HiresTimer timer;
+
+    for (unsigned pass = 0; pass < BENCHMARK_PASSES; ++pass)
+    {
+        unsigned long long totalBytes = 0;
+        timer.Reset();
+
+        for (HashMap<String, PackageEntry>::ConstIterator i = entries.Begin(); i != entries.End(); ++i)
+        {
+            File file(context_, packageFile, i->first_);
+            unsigned size = file.GetSize();
+            buffer.Resize(size);
+            if (!file.IsOpen() || file.Read(buffer.Buffer(), size) != size)
+                ErrorExit("Could not read file " + i->first_);
+            totalBytes += size;
+        }
+
+        long long usec = Max(timer.GetUSec(false), 1LL);
+        String result;
+        result.AppendWithFormat("Pass %u: %u files, %.1f MB in %.2f ms, %.1f MB/s", pass + 1, entries.Size(), totalBytes / 1000000.0,
+            usec / 1000.0, (double)totalBytes / usec);
+        PrintLine(result);
+    }
+}
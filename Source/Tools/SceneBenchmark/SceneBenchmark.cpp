@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/BulkSceneData.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneResolver.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Scene file formats to compare.
+enum SceneFormat
+{
+    FORMAT_BINARY = 0,
+    FORMAT_XML,
+    FORMAT_JSON,
+    FORMAT_BULK,
+    MAX_FORMATS
+};
+
+/// Names of the scene file formats.
+static const char* formatNames[] = {
+    "Binary",
+    "XML",
+    "JSON",
+    "Bulk"
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: SceneBenchmark [options]\n"
+        "\n"
+        "Measures saving and loading a scene of static models and lights in the binary, XML, JSON and bulk scene\n"
+        "formats. Prints the size and save time of each format, the average load time, and the time of each phase of\n"
+        "the bulk load. Every loaded scene is compared against the original and the tool exits with an error if they\n"
+        "differ. The model and material are loaded from the Data resource directory.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-n <nodes> Number of scene nodes. Default 20000.\n"
+        "-i <iterations> Number of loads to average per format. Default 3.\n"
+        "-t <threads> Number of worker threads. Default is one less than the number of physical CPU cores.\n"
+        "-p <paths> Resource prefix paths, separated by semicolons. Default is the URHO3D_PREFIX_PATH environment\n"
+        "   variable, or the parent directory of the executable.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void CreateScene(Scene* scene, unsigned numNodes)
+{
+    auto* cache = scene->GetSubsystem<ResourceCache>();
+    auto* model = cache->GetResource<Model>("Models/Box.mdl");
+    auto* material = cache->GetResource<Material>("Materials/Stone.xml");
+    if (!model || !material)
+        ErrorExit("Could not load the scene resources, check the resource prefix path");
+
+    scene->CreateComponent<Octree>();
+
+    // Build a random hierarchy where every 50th node may get children of its own
+    PODVector<Node*> parents;
+    parents.Push(scene);
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* parent = parents[Rand() % parents.Size()];
+        Node* node = parent->CreateChild("Node" + String(i));
+        node->SetPosition(Vector3(Random(100.0f), Random(10.0f), Random(100.0f)));
+        node->SetRotation(Quaternion(Random(360.0f), Vector3::UP));
+        if (i % 3 == 0)
+            node->AddTag("Tagged");
+        if (i % 5 == 0)
+            node->SetVar("Health", (int)i);
+
+        auto* staticModel = node->CreateComponent<StaticModel>();
+        staticModel->SetModel(model);
+        staticModel->SetMaterial(material);
+        if (i % 10 == 0)
+            node->CreateComponent<Light>()->SetRange(Random(20.0f));
+
+        if (i % 50 == 0)
+            parents.Push(node);
+    }
+}
+
+bool SaveScene(Scene* scene, SceneFormat format, Serializer& dest)
+{
+    switch (format)
+    {
+    case FORMAT_XML:
+        return scene->SaveXML(dest);
+    case FORMAT_JSON:
+        return scene->SaveJSON(dest);
+    case FORMAT_BULK:
+        return scene->SaveBulk(dest);
+    default:
+        return scene->Save(dest);
+    }
+}
+
+bool LoadScene(Scene* scene, SceneFormat format, Deserializer& source)
+{
+    switch (format)
+    {
+    case FORMAT_XML:
+        return scene->LoadXML(source);
+    case FORMAT_JSON:
+        return scene->LoadJSON(source);
+    default:
+        // The binary and bulk formats are told apart by their file ID
+        return scene->Load(source);
+    }
+}
+
+String ToXML(Scene* scene)
+{
+    VectorBuffer buffer;
+    scene->SaveXML(buffer);
+    return String((const char*)buffer.GetData(), buffer.GetSize());
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numNodes = 20000;
+    unsigned numIterations = 3;
+    unsigned numThreads = Max(GetNumPhysicalCPUs(), 1U) - 1;
+    String prefixPaths;
+    if (const char* paths = getenv("URHO3D_PREFIX_PATH"))
+        prefixPaths = paths;
+    else
+        prefixPaths = "..";
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h" || !hasValue)
+            Help();
+        else if (arg == "-n")
+            numNodes = ToUInt(arguments[++i]);
+        else if (arg == "-i")
+            numIterations = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-t")
+            numThreads = ToUInt(arguments[++i]);
+        else if (arg == "-p")
+            prefixPaths = arguments[++i];
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_LOG_LEVEL] = LOG_WARNING;
+    engineParameters[EP_LOG_NAME] = String::EMPTY;
+    engineParameters[EP_RESOURCE_PATHS] = "Data;CoreData";
+    engineParameters[EP_RESOURCE_PREFIX_PATHS] = prefixPaths;
+    engineParameters[EP_WORKER_THREADS] = false;
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Could not initialize the engine, check the resource prefix path");
+
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    queue->CreateThreads(numThreads);
+
+    SetRandomSeed(1);
+    SharedPtr<Scene> scene(new Scene(context));
+    CreateScene(scene, numNodes);
+    String reference = ToXML(scene);
+
+    PrintLine(String(numNodes) + " nodes, " + String(queue->GetNumThreads()) + " worker threads");
+
+    VectorBuffer buffers[MAX_FORMATS];
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < MAX_FORMATS; ++i)
+    {
+        auto format = (SceneFormat)i;
+        timer.Reset();
+        if (!SaveScene(scene, format, buffers[i]))
+            ErrorExit("Could not save the scene in the " + String(formatNames[i]) + " format");
+        long long saveTime = timer.GetUSec(false);
+
+        long long loadTime = 0;
+        for (unsigned j = 0; j < numIterations; ++j)
+        {
+            SharedPtr<Scene> loaded(new Scene(context));
+            buffers[i].Seek(0);
+            timer.Reset();
+            if (!LoadScene(loaded, format, buffers[i]))
+                ErrorExit("Could not load the scene in the " + String(formatNames[i]) + " format");
+            loadTime += timer.GetUSec(false);
+
+            if (ToXML(loaded) != reference)
+                ErrorExit("The scene loaded from the " + String(formatNames[i]) + " format differs from the original");
+        }
+
+        PrintLine(String(formatNames[i]) + ": " + String(buffers[i].GetSize()) + " bytes, save " +
+            String(saveTime / 1000.0) + " ms, load " + String(loadTime / 1000.0 / numIterations) + " ms");
+    }
+
+    // Break the bulk load down into its phases, skipping the file ID that Scene::Load would consume
+    SharedPtr<Scene> loaded(new Scene(context));
+    VectorBuffer& bulk = buffers[FORMAT_BULK];
+    bulk.Seek(4);
+    BulkSceneData data;
+    SceneResolver resolver;
+
+    timer.Reset();
+    if (!data.Read(bulk))
+        ErrorExit("Could not read the bulk scene data");
+    long long readTime = timer.GetUSec(true);
+    data.Decode(queue);
+    long long decodeTime = timer.GetUSec(true);
+    if (!data.Instantiate(loaded, resolver))
+        ErrorExit("Could not instantiate the bulk scene data");
+    long long instantiateTime = timer.GetUSec(true);
+    resolver.Resolve();
+    loaded->ApplyAttributes();
+    long long applyTime = timer.GetUSec(true);
+
+    PrintLine("Bulk load phases: read " + String(readTime / 1000.0) + " ms, decode " + String(decodeTime / 1000.0) +
+        " ms, instantiate " + String(instantiateTime / 1000.0) + " ms, resolve and apply attributes " +
+        String(applyTime / 1000.0) + " ms");
+}
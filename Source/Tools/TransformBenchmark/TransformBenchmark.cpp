@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Benchmarked scene along with its nodes in creation order.
+struct BenchmarkScene
+{
+    /// Scene.
+    SharedPtr<Scene> scene_;
+    /// Root nodes, which are moved.
+    PODVector<Node*> roots_;
+    /// All nodes.
+    PODVector<Node*> nodes_;
+    /// World transforms read on the last frame.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// Total time spent moving the roots.
+    long long moveTime_{};
+    /// Total time spent in the batch update of the transform store.
+    long long updateTime_{};
+    /// Total time spent reading the world transforms.
+    long long readTime_{};
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: TransformBenchmark [options]\n"
+        "\n"
+        "Compares the world transform update of a node hierarchy through the scene's transform store against the lazy\n"
+        "update through parent nodes. Builds two identical scenes, one with the transform store enabled. On each frame\n"
+        "rotates a part of the root nodes and reads the world transforms of all nodes. Exits with an error if the world\n"
+        "transforms of the two scenes differ.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-r <roots> Number of root nodes. Default 1000.\n"
+        "-c <children> Number of child nodes per node. Default 4.\n"
+        "-d <depth> Number of child levels below the roots. Default 3.\n"
+        "-m <percent> Percentage of the root nodes rotated on each frame. Default 100.\n"
+        "-f <frames> Number of frames to measure. Default 100.\n"
+        "-t <threads> Number of worker threads. Default is one less than the number of physical CPU cores.\n"
+        "-s <seed> Random seed. Default 1.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void CreateChildren(BenchmarkScene& bench, Node* parent, unsigned numChildren, unsigned depth)
+{
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        Node* child = parent->CreateChild();
+        child->SetPosition(Vector3(Random(-2.0f, 2.0f), Random(-2.0f, 2.0f), Random(-2.0f, 2.0f)));
+        child->SetRotation(Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)));
+        bench.nodes_.Push(child);
+        if (depth > 1)
+            CreateChildren(bench, child, numChildren, depth - 1);
+    }
+}
+
+void CreateBenchmarkScene(BenchmarkScene& bench, Context* context, bool transformStore, unsigned numRoots,
+    unsigned numChildren, unsigned depth, unsigned seed)
+{
+    SetRandomSeed(seed);
+
+    bench.scene_ = new Scene(context);
+    bench.scene_->SetTransformStoreEnabled(transformStore);
+    for (unsigned i = 0; i < numRoots; ++i)
+    {
+        Node* root = bench.scene_->CreateChild();
+        root->SetPosition(Vector3(Random(-1000.0f, 1000.0f), 0.0f, Random(-1000.0f, 1000.0f)));
+        bench.roots_.Push(root);
+        bench.nodes_.Push(root);
+        if (depth)
+            CreateChildren(bench, root, numChildren, depth);
+    }
+    bench.worldTransforms_.Resize(bench.nodes_.Size());
+}
+
+void RunFrame(BenchmarkScene& bench, unsigned frame, unsigned numMoved)
+{
+    HiresTimer timer;
+
+    // Move a different range of the roots on each frame
+    unsigned numRoots = bench.roots_.Size();
+    for (unsigned i = 0; i < numMoved; ++i)
+        bench.roots_[(frame * numMoved + i) % numRoots]->Rotate(Quaternion(1.0f, Vector3::UP));
+    bench.moveTime_ += timer.GetUSec(true);
+
+    bench.scene_->UpdateTransforms();
+    bench.updateTime_ += timer.GetUSec(true);
+
+    for (unsigned i = 0; i < bench.nodes_.Size(); ++i)
+        bench.worldTransforms_[i] = bench.nodes_[i]->GetWorldTransform();
+    bench.readTime_ += timer.GetUSec(false);
+}
+
+String FormatTimes(const BenchmarkScene& bench, unsigned numFrames)
+{
+    long long total = bench.moveTime_ + bench.updateTime_ + bench.readTime_;
+    return String(total / 1000.0 / numFrames) + " ms/frame (move " + String(bench.moveTime_ / 1000.0 / numFrames) +
+        ", update " + String(bench.updateTime_ / 1000.0 / numFrames) + ", read " +
+        String(bench.readTime_ / 1000.0 / numFrames) + ")";
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numRoots = 1000;
+    unsigned numChildren = 4;
+    unsigned depth = 3;
+    unsigned movedPercent = 100;
+    unsigned numFrames = 100;
+    unsigned numThreads = Max(GetNumPhysicalCPUs(), 1U) - 1;
+    unsigned seed = 1;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h" || !hasValue)
+            Help();
+        else if (arg == "-r")
+            numRoots = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-c")
+            numChildren = ToUInt(arguments[++i]);
+        else if (arg == "-d")
+            depth = ToUInt(arguments[++i]);
+        else if (arg == "-m")
+            movedPercent = Min(ToUInt(arguments[++i]), 100U);
+        else if (arg == "-f")
+            numFrames = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-t")
+            numThreads = ToUInt(arguments[++i]);
+        else if (arg == "-s")
+            seed = ToUInt(arguments[++i]);
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_LOG_LEVEL] = LOG_WARNING;
+    engineParameters[EP_LOG_NAME] = String::EMPTY;
+    engineParameters[EP_RESOURCE_PATHS] = String::EMPTY;
+    engineParameters[EP_RESOURCE_PREFIX_PATHS] = String::EMPTY;
+    engineParameters[EP_WORKER_THREADS] = false;
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Could not initialize the engine");
+
+    context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+
+    BenchmarkScene lazy;
+    BenchmarkScene store;
+    CreateBenchmarkScene(lazy, context, false, numRoots, numChildren, depth, seed);
+    CreateBenchmarkScene(store, context, true, numRoots, numChildren, depth, seed);
+
+    // The first frame calculates all world transforms, so leave it out of the measurement
+    unsigned numMoved = numRoots * movedPercent / 100;
+    RunFrame(lazy, 0, numMoved);
+    RunFrame(store, 0, numMoved);
+    lazy.moveTime_ = lazy.updateTime_ = lazy.readTime_ = 0;
+    store.moveTime_ = store.updateTime_ = store.readTime_ = 0;
+
+    for (unsigned i = 1; i <= numFrames; ++i)
+    {
+        RunFrame(lazy, i, numMoved);
+        RunFrame(store, i, numMoved);
+
+        for (unsigned j = 0; j < lazy.nodes_.Size(); ++j)
+        {
+            if (lazy.worldTransforms_[j] != store.worldTransforms_[j])
+                ErrorExit("Frame " + String(i) + ": world transform of node " + String(j) +
+                    " differs between the transform store and the lazy update");
+        }
+    }
+
+    PrintLine(String(lazy.nodes_.Size()) + " nodes, " + String(numMoved) + " roots moved per frame, " +
+        String(context->GetSubsystem<WorkQueue>()->GetNumThreads()) + " worker threads");
+    PrintLine("Lazy update: " + FormatTimes(lazy, numFrames));
+    PrintLine("Transform store: " + FormatTimes(store, numFrames));
+}
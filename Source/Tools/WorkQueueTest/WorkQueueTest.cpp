@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/ArrayPtr.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/Random.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Work item of the test graph.
+struct TestItem
+{
+    /// Work item.
+    SharedPtr<WorkItem> item_;
+    /// Indices of the items this item depends on.
+    PODVector<unsigned> dependencies_;
+    /// Number of busy loop iterations to vary the execution time.
+    unsigned cost_{};
+    /// Finished flag.
+    std::atomic<bool> finished_{};
+};
+
+/// Shared state of the test graph.
+struct TestGraph
+{
+    /// Work items.
+    SharedArrayPtr<TestItem> items_;
+    /// Number of executed items.
+    std::atomic<unsigned> numExecuted_{};
+    /// Number of items that started before their dependencies finished or were executed twice.
+    std::atomic<unsigned> numErrors_{};
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+void Help()
+{
+    ErrorExit("Usage: WorkQueueTest [options]\n"
+        "\n"
+        "Stress tests the work item dependencies of the WorkQueue. Each round queues a random graph of work items with\n"
+        "dependencies in random order and checks that every item starts only after its dependencies have finished, and\n"
+        "that every item is executed once. Exits with an error if a check fails.\n"
+        "\n"
+        "Options:\n"
+        "-h Shows this help message.\n"
+        "-t <threads> Number of worker threads. Default 32.\n"
+        "-r <rounds> Number of rounds. Default 200.\n"
+        "-n <items> Number of work items per round. Default 1000.\n"
+        "-d <dependencies> Maximum number of dependencies per work item. Default 4.\n"
+        "-s <seed> Random seed. Default 1.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void TestWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* graph = reinterpret_cast<TestGraph*>(item->aux_);
+    auto* testItem = reinterpret_cast<TestItem*>(item->start_);
+
+    for (unsigned i = 0; i < testItem->dependencies_.Size(); ++i)
+    {
+        if (!graph->items_[testItem->dependencies_[i]].finished_.load(std::memory_order_acquire))
+            ++graph->numErrors_;
+    }
+
+    volatile unsigned counter = 0;
+    for (unsigned i = 0; i < testItem->cost_; ++i)
+        counter = counter + 1;
+
+    if (testItem->finished_.exchange(true, std::memory_order_release))
+        ++graph->numErrors_;
+    ++graph->numExecuted_;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numThreads = 32;
+    unsigned numRounds = 200;
+    unsigned numItems = 1000;
+    unsigned maxDependencies = 4;
+    unsigned seed = 1;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-h" || !hasValue)
+            Help();
+        else if (arg == "-t")
+            numThreads = ToUInt(arguments[++i]);
+        else if (arg == "-r")
+            numRounds = ToUInt(arguments[++i]);
+        else if (arg == "-n")
+            numItems = Max(ToUInt(arguments[++i]), 1U);
+        else if (arg == "-d")
+            maxDependencies = ToUInt(arguments[++i]);
+        else if (arg == "-s")
+            seed = ToUInt(arguments[++i]);
+        else
+            Help();
+    }
+
+    SharedPtr<Context> context(new Context());
+    // The Time subsystem calibrates the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(numThreads);
+
+    SetRandomSeed(seed);
+
+    TestGraph graph;
+    graph.items_ = new TestItem[numItems];
+    PODVector<unsigned> order(numItems);
+    unsigned long long numDependencies = 0;
+
+    HiresTimer timer;
+
+    for (unsigned round = 0; round < numRounds; ++round)
+    {
+        graph.numExecuted_ = 0;
+
+        // Items depend only on items with a smaller index, which keeps the graph acyclic. Dependencies should have at least
+        // the priority of their dependents, so the priority decreases with the index
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            TestItem& testItem = graph.items_[i];
+            testItem.finished_ = false;
+            testItem.cost_ = Rand() % 2000;
+            testItem.dependencies_.Clear();
+            if (i)
+            {
+                unsigned count = Rand() % (maxDependencies + 1);
+                for (unsigned j = 0; j < count; ++j)
+                    testItem.dependencies_.Push(Rand() % i);
+            }
+            numDependencies += testItem.dependencies_.Size();
+
+            testItem.item_ = queue->GetFreeItem();
+            testItem.item_->workFunction_ = TestWork;
+            testItem.item_->start_ = &testItem;
+            testItem.item_->aux_ = &graph;
+            if (i < numItems / 3)
+                testItem.item_->priority_ = M_MAX_UNSIGNED;
+            else if (i < numItems * 2 / 3)
+                testItem.item_->priority_ = 1;
+            else
+                testItem.item_->priority_ = 0;
+
+            order[i] = i;
+        }
+
+        // Queue the items in random order, so that a dependency may be queued, executing or finished already, or not queued
+        // yet when it is added
+        for (unsigned i = numItems - 1; i > 0; --i)
+            Swap(order[i], order[Rand() % (i + 1)]);
+
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            TestItem& testItem = graph.items_[order[i]];
+            for (unsigned j = 0; j < testItem.dependencies_.Size(); ++j)
+                queue->AddDependency(testItem.item_, graph.items_[testItem.dependencies_[j]].item_);
+            queue->AddWorkItem(testItem.item_);
+        }
+
+        // Wait for a single item first, which must also finish the items it depends on
+        TestItem& waitItem = graph.items_[Rand() % numItems];
+        queue->CompleteItem(waitItem.item_);
+        if (!waitItem.finished_)
+            ErrorExit("Round " + String(round) + ": CompleteItem returned before the work item finished");
+
+        queue->Complete(0);
+
+        if (graph.numExecuted_ != numItems)
+            ErrorExit("Round " + String(round) + ": " + String(graph.numExecuted_.load()) + " of " + String(numItems) +
+                " work items executed");
+        if (graph.numErrors_)
+            ErrorExit("Round " + String(round) + ": " + String(graph.numErrors_.load()) +
+                " work items started before their dependencies finished or were executed twice");
+
+        for (unsigned i = 0; i < numItems; ++i)
+            graph.items_[i].item_.Reset();
+    }
+
+    long long time = timer.GetUSec(false);
+
+    PrintLine("Passed: " + String(numRounds) + " rounds, " + String(numRounds * numItems) + " work items, " +
+        String(numDependencies) + " dependencies, " + String(queue->GetNumThreads()) + " worker threads, " +
+        String(time / 1000.0) + " ms");
+}
@@ -2407,13 +2407,11 @@ template <class T> void RegisterMembers_LightQueryResult(asIScriptEngine* engine
     // Not registered because pointer
     // PODVector<Drawable*> LightQueryResult::litGeometries_
     // Error: type "PODVector<Drawable*>" can not automatically bind
-    // PODVector<Drawable*> LightQueryResult::shadowCasters_
+    // PODVector<Drawable*> LightQueryResult::drawables_
     // Error: type "PODVector<Drawable*>" can not automatically bind
-    // Camera* LightQueryResult::shadowCameras_[MAX_LIGHT_SPLITS]
-    // Not registered because array
-    // unsigned LightQueryResult::shadowCasterBegin_[MAX_LIGHT_SPLITS]
+    // PODVector<Drawable*> LightQueryResult::shadowCasters_[MAX_LIGHT_SPLITS]
     // Not registered because array
-    // unsigned LightQueryResult::shadowCasterEnd_[MAX_LIGHT_SPLITS]
+    // Camera* LightQueryResult::shadowCameras_[MAX_LIGHT_SPLITS]
     // Not registered because array
     // BoundingBox LightQueryResult::shadowCasterBox_[MAX_LIGHT_SPLITS]
     // Not registered because array
@@ -11653,8 +11651,8 @@ template <class T> void RegisterMembers_ResourceCache(asIScriptEngine* engine, c
     // bool ResourceCache::AddResourceDir(const String& pathName, unsigned priority = PRIORITY_LAST)
     engine->RegisterObjectMethod(className, "bool AddResourceDir(const String&in, uint = PRIORITY_LAST)", AS_METHODPR(T, AddResourceDir, (const String&, unsigned), bool), AS_CALL_THISCALL);
 
-    // bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr)
-    engine->RegisterObjectMethod(className, "bool BackgroundLoadResource(StringHash, const String&in, bool = true, Resource@+ = null)", AS_METHODPR(T, BackgroundLoadResource, (StringHash, const String&, bool, Resource*), bool), AS_CALL_THISCALL);
+    // bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, int priority = 0)
+    engine->RegisterObjectMethod(className, "bool BackgroundLoadResource(StringHash, const String&in, bool = true, Resource@+ = null, int = 0)", AS_METHODPR(T, BackgroundLoadResource, (StringHash, const String&, bool, Resource*, int), bool), AS_CALL_THISCALL);
 
     // bool ResourceCache::Exists(const String& name) const
     engine->RegisterObjectMethod(className, "bool Exists(const String&in) const", AS_METHODPR(T, Exists, (const String&) const, bool), AS_CALL_THISCALL);
@@ -11782,7 +11780,7 @@ template <class T> void RegisterMembers_ResourceCache(asIScriptEngine* engine, c
     // void ResourceCache::StoreResourceDependency(Resource* resource, const String& dependency)
     engine->RegisterObjectMethod(className, "void StoreResourceDependency(Resource@+, const String&in)", AS_METHODPR(T, StoreResourceDependency, (Resource*, const String&), void), AS_CALL_THISCALL);
 
-    // template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr)
+    // template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, int priority = 0)
     // Not registered because template
     // template <class T> T* ResourceCache::GetExistingResource(const String& name)
     // Not registered because template
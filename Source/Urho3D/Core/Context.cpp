@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/EventProfiler.h"
+#include "../Core/Mutex.h"
+#include "../Core/Thread.h"
 #include "../IO/Log.h"
 
 #ifndef MINI_URHO
@@ -53,6 +55,89 @@ static void HandleIKLog(const char* msg)
 }
 #endif
 
+/// Size of the lock-free posted event ring buffer. Must be a power of two.
+static const unsigned POSTED_EVENT_QUEUE_SIZE = 1024;
+static const unsigned POSTED_EVENT_QUEUE_MASK = POSTED_EVENT_QUEUE_SIZE - 1;
+
+/// Event posted to be sent in the main thread.
+struct PostedEvent
+{
+    /// Sender. Null if it has been destroyed.
+    Object* sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Event data. Kept allocated between events.
+    VariantMap eventData_;
+};
+
+/// Posted event slot in the ring buffer.
+struct PostedEventSlot : public PostedEvent
+{
+    /// Sequence number. Equal to the enqueue position when free, and to the position plus one when holding an event.
+    std::atomic<unsigned> sequence_;
+};
+
+/// Multiple producer, single consumer queue of posted events. Uses a bounded lock-free ring buffer, and a locked overflow vector when the ring buffer is full.
+struct PostedEventQueue
+{
+    /// Construct.
+    PostedEventQueue() :
+        enqueuePos_(0),
+        dequeuePos_(0),
+        overflowed_(false),
+        sending_(false)
+    {
+        for (unsigned i = 0; i < POSTED_EVENT_QUEUE_SIZE; ++i)
+        {
+            slots_[i].sender_ = nullptr;
+            slots_[i].sequence_.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Try to push an event to the ring buffer. Return false if full.
+    bool Push(Object* sender, StringHash eventType, const VariantMap& eventData)
+    {
+        PostedEventSlot* slot;
+        unsigned pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            slot = &slots_[pos & POSTED_EVENT_QUEUE_MASK];
+            auto diff = (int)(slot->sequence_.load(std::memory_order_acquire) - pos);
+            if (diff == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+
+        slot->sender_ = sender;
+        slot->eventType_ = eventType;
+        slot->eventData_ = eventData;
+        slot->sequence_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Ring buffer slots.
+    PostedEventSlot slots_[POSTED_EVENT_QUEUE_SIZE];
+    /// Next position to push to.
+    std::atomic<unsigned> enqueuePos_;
+    /// Next position to send from. Accessed only by the main thread.
+    unsigned dequeuePos_;
+    /// Overflow events mutex.
+    Mutex overflowMutex_;
+    /// Events posted while the ring buffer was full.
+    Vector<PostedEvent> overflow_;
+    /// Overflow events being sent.
+    Vector<PostedEvent> sendingOverflow_;
+    /// Overflow flag. While set, events are posted to the overflow vector to keep their order.
+    std::atomic<bool> overflowed_;
+    /// Sending flag to prevent recursion.
+    bool sending_;
+};
 
 void EventReceiverGroup::BeginSendEvent()
 {
@@ -70,32 +155,49 @@ void EventReceiverGroup::EndSendEvent()
         for (unsigned i = receivers_.Size() - 1; i < receivers_.Size(); --i)
         {
             if (!receivers_[i])
+            {
                 receivers_.Erase(i);
+                handlers_.Erase(i);
+            }
         }
 
         dirty_ = false;
     }
 }
 
-void EventReceiverGroup::Add(Object* object)
+void EventReceiverGroup::Add(Object* object, EventHandler* handler)
 {
     if (object)
+    {
         receivers_.Push(object);
+        handlers_.Push(handler);
+    }
 }
 
 void EventReceiverGroup::Remove(Object* object)
 {
+    unsigned index = receivers_.IndexOf(object);
+    if (index == receivers_.Size())
+        return;
+
     if (inSend_ > 0)
     {
-        PODVector<Object*>::Iterator i = receivers_.Find(object);
-        if (i != receivers_.End())
-        {
-            (*i) = nullptr;
-            dirty_ = true;
-        }
+        receivers_[index] = nullptr;
+        handlers_[index] = nullptr;
+        dirty_ = true;
     }
     else
-        receivers_.Remove(object);
+    {
+        receivers_.Erase(index);
+        handlers_.Erase(index);
+    }
+}
+
+void EventReceiverGroup::SetHandler(Object* object, EventHandler* handler)
+{
+    unsigned index = receivers_.IndexOf(object);
+    if (index < receivers_.Size())
+        handlers_[index] = handler;
 }
 
 void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attributes, StringHash objectType, const char* name)
@@ -123,6 +225,8 @@ void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attribute
 Context::Context() :
     eventHandler_(nullptr)
 {
+    postedEvents_ = new PostedEventQueue();
+
 #ifdef __ANDROID__
     // Always reset the random seed on Android, as the Urho3D library might not be unloaded between runs
     SetRandomSeed(1);
@@ -238,6 +342,130 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
         info->defaultValue_ = defaultValue;
 }
 
+void Context::PostEvent(Object* sender, StringHash eventType, const VariantMap& eventData)
+{
+    PostedEventQueue* queue = postedEvents_.Get();
+    if (!queue->overflowed_.load(std::memory_order_acquire) && queue->Push(sender, eventType, eventData))
+        return;
+
+    MutexLock lock(queue->overflowMutex_);
+    queue->overflowed_.store(true, std::memory_order_release);
+    queue->overflow_.Resize(queue->overflow_.Size() + 1);
+    PostedEvent& event = queue->overflow_.Back();
+    event.sender_ = sender;
+    event.eventType_ = eventType;
+    event.eventData_ = eventData;
+}
+
+void Context::SendPostedEvents()
+{
+    PostedEventQueue* queue = postedEvents_.Get();
+    if (queue->sending_)
+        return;
+
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Posted events can only be sent from the main thread");
+        return;
+    }
+
+    queue->sending_ = true;
+
+    // Events posted by the handlers will be sent on the next call
+    bool overflowed = queue->overflowed_.load(std::memory_order_acquire);
+    bool drained = true;
+    unsigned endPos = queue->enqueuePos_.load(std::memory_order_acquire);
+    for (;;)
+    {
+        while (queue->dequeuePos_ != endPos)
+        {
+            unsigned pos = queue->dequeuePos_;
+            PostedEventSlot& slot = queue->slots_[pos & POSTED_EVENT_QUEUE_MASK];
+            // Stop if the event is still being written
+            if (slot.sequence_.load(std::memory_order_acquire) != pos + 1)
+            {
+                drained = false;
+                break;
+            }
+
+            SendPostedEvent(slot);
+            queue->dequeuePos_ = pos + 1;
+            slot.sequence_.store(pos + POSTED_EVENT_QUEUE_SIZE, std::memory_order_release);
+        }
+
+        // No events enter the ring while it is overflowed, but events posted before the overflow may have been added after
+        // the end position was read. Those must be sent before the overflowed events
+        if (!drained || !overflowed)
+            break;
+        unsigned newEndPos = queue->enqueuePos_.load(std::memory_order_acquire);
+        if (newEndPos == endPos)
+            break;
+        endPos = newEndPos;
+    }
+
+    // Send the overflowed events only after the ring is empty to keep the posting order, otherwise leave them for the next call
+    if (overflowed && drained)
+    {
+        {
+            MutexLock lock(queue->overflowMutex_);
+            queue->sendingOverflow_.Swap(queue->overflow_);
+            queue->overflowed_.store(false, std::memory_order_release);
+        }
+
+        for (unsigned i = 0; i < queue->sendingOverflow_.Size(); ++i)
+            SendPostedEvent(queue->sendingOverflow_[i]);
+        queue->sendingOverflow_.Clear();
+    }
+
+    queue->sending_ = false;
+}
+
+void Context::SendPostedEvent(PostedEvent& event)
+{
+    Object* sender = event.sender_;
+    if (sender)
+    {
+        event.sender_ = nullptr;
+        sender->numPostedEvents_.fetch_sub(1, std::memory_order_relaxed);
+        sender->SendEvent(event.eventType_, event.eventData_);
+    }
+
+    // Clear the data but keep the map allocated for reuse
+    event.eventData_.Clear();
+}
+
+void Context::RemovePostedEvents(Object* sender)
+{
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Object with posted events pending was destroyed outside the main thread");
+        return;
+    }
+
+    PostedEventQueue* queue = postedEvents_.Get();
+
+    unsigned endPos = queue->enqueuePos_.load(std::memory_order_acquire);
+    for (unsigned pos = queue->dequeuePos_; pos != endPos; ++pos)
+    {
+        PostedEventSlot& slot = queue->slots_[pos & POSTED_EVENT_QUEUE_MASK];
+        if (slot.sequence_.load(std::memory_order_acquire) == pos + 1 && slot.sender_ == sender)
+            slot.sender_ = nullptr;
+    }
+
+    for (unsigned i = 0; i < queue->sendingOverflow_.Size(); ++i)
+    {
+        if (queue->sendingOverflow_[i].sender_ == sender)
+            queue->sendingOverflow_[i].sender_ = nullptr;
+    }
+
+    MutexLock lock(queue->overflowMutex_);
+    for (unsigned i = 0; i < queue->overflow_.Size(); ++i)
+    {
+        if (queue->overflow_[i].sender_ == sender)
+            queue->overflow_[i].sender_ = nullptr;
+    }
+}
+
 VariantMap& Context::GetEventDataMap()
 {
     unsigned nestingLevel = eventSenders_.Size();
@@ -403,20 +631,27 @@ AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
     return nullptr;
 }
 
-void Context::AddEventReceiver(Object* receiver, StringHash eventType)
+void Context::AddEventReceiver(Object* receiver, StringHash eventType, EventHandler* handler)
 {
     SharedPtr<EventReceiverGroup>& group = eventReceivers_[eventType];
     if (!group)
         group = new EventReceiverGroup();
-    group->Add(receiver);
+    group->Add(receiver, handler);
 }
 
-void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash eventType)
+void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash eventType, EventHandler* handler)
 {
     SharedPtr<EventReceiverGroup>& group = specificEventReceivers_[sender][eventType];
     if (!group)
         group = new EventReceiverGroup();
-    group->Add(receiver);
+    group->Add(receiver, handler);
+}
+
+void Context::SetEventReceiverHandler(Object* receiver, Object* sender, StringHash eventType, EventHandler* handler)
+{
+    EventReceiverGroup* group = sender ? GetEventReceivers(sender, eventType) : GetEventReceivers(eventType);
+    if (group)
+        group->SetHandler(receiver, handler);
 }
 
 void Context::RemoveEventSender(Object* sender)
@@ -29,6 +29,9 @@
 namespace Urho3D
 {
 
+struct PostedEvent;
+struct PostedEventQueue;
+
 /// Tracking structure for event receivers.
 class URHO3D_API EventReceiverGroup : public RefCounted
 {
@@ -46,14 +49,19 @@ public:
     /// End event send. Clean up if necessary.
     void EndSendEvent();
 
-    /// Add receiver. Same receiver must not be double-added!
-    void Add(Object* object);
+    /// Add receiver with its event handler. Same receiver must not be double-added!
+    void Add(Object* object, EventHandler* handler);
 
     /// Remove receiver. Leave holes during send, which requires later cleanup.
     void Remove(Object* object);
 
+    /// Replace the event handler of a receiver.
+    void SetHandler(Object* object, EventHandler* handler);
+
     /// Receivers. May contain holes during sending.
     PODVector<Object*> receivers_;
+    /// Event handlers of the receivers in the same order. May contain holes during sending.
+    PODVector<EventHandler*> handlers_;
 
 private:
     /// "In send" recursion counter.
@@ -98,6 +106,10 @@ public:
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
+    /// Queue an event to be sent from an object in the main thread by SendPostedEvents(). Is thread-safe, and lock-free unless the queue is full.
+    void PostEvent(Object* sender, StringHash eventType, const VariantMap& eventData);
+    /// Send the events posted before this call in posting order. Called by Engine at the start of each frame. Must be called from the main thread.
+    void SendPostedEvents();
     /// Initialises the specified SDL systems, if not already. Returns true if successful. This call must be matched with ReleaseSDL() when SDL functions are no longer required, even if this call fails.
     bool RequireSDL(unsigned int sdlFlags);
     /// Indicate that you are done with using SDL. Must be called after using RequireSDL().
@@ -205,9 +217,11 @@ public:
 
 private:
     /// Add event receiver.
-    void AddEventReceiver(Object* receiver, StringHash eventType);
+    void AddEventReceiver(Object* receiver, StringHash eventType, EventHandler* handler);
     /// Add event receiver for specific event.
-    void AddEventReceiver(Object* receiver, Object* sender, StringHash eventType);
+    void AddEventReceiver(Object* receiver, Object* sender, StringHash eventType, EventHandler* handler);
+    /// Replace the event handler of a receiver. Sender is null for non-specific events.
+    void SetEventReceiverHandler(Object* receiver, Object* sender, StringHash eventType, EventHandler* handler);
     /// Remove an event sender from all receivers. Called on its destruction.
     void RemoveEventSender(Object* sender);
     /// Remove event receiver from specific events.
@@ -221,6 +235,10 @@ private:
 
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
+    /// Send a posted event and reset it for reuse.
+    void SendPostedEvent(PostedEvent& event);
+    /// Discard the posted events of a sender. Called by Object on its destruction.
+    void RemovePostedEvents(Object* sender);
 
     /// Object factories.
     HashMap<StringHash, SharedPtr<ObjectFactory> > factories_;
@@ -238,6 +256,8 @@ private:
     PODVector<Object*> eventSenders_;
     /// Event data stack.
     PODVector<VariantMap*> eventDataMaps_;
+    /// Events posted from any thread.
+    UniquePtr<PostedEventQueue> postedEvents_;
     /// Active event handler. Not stored in a stack for performance reasons; is needed only in esoteric cases.
     EventHandler* eventHandler_;
     /// Object categories.
@@ -63,4 +63,24 @@ URHO3D_EVENT(E_ENDFRAME, EndFrame)
 {
 }
 
+/// Typed event data of the frame update events E_UPDATE, E_POSTUPDATE, E_RENDERUPDATE and E_POSTRENDERUPDATE.
+struct UpdateEventData
+{
+    /// Fill from event parameters.
+    void FromVariantMap(const VariantMap& eventData)
+    {
+        VariantMap::ConstIterator i = eventData.Find(Update::P_TIMESTEP);
+        timeStep_ = i != eventData.End() ? i->second_.GetFloat() : 0.0f;
+    }
+
+    /// Store to event parameters.
+    void ToVariantMap(VariantMap& eventData) const
+    {
+        eventData[Update::P_TIMESTEP] = timeStep_;
+    }
+
+    /// Frame timestep.
+    float timeStep_;
+};
+
 }
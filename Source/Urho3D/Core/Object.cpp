@@ -76,7 +76,8 @@ bool TypeInfo::IsTypeOf(const TypeInfo* typeInfo) const
 
 Object::Object(Context* context) :
     context_(context),
-    blockEvents_(false)
+    blockEvents_(false),
+    numPostedEvents_(0)
 {
     assert(context_);
 }
@@ -85,6 +86,8 @@ Object::~Object()
 {
     UnsubscribeFromAllEvents();
     context_->RemoveEventSender(this);
+    if (numPostedEvents_.load(std::memory_order_acquire))
+        context_->RemovePostedEvents(this);
 }
 
 void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData)
@@ -130,6 +133,17 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
     }
 }
 
+void Object::OnTypedEvent(Object* sender, StringHash eventType, EventHandler* handler, void* eventData)
+{
+    if (blockEvents_)
+        return;
+
+    Context* context = context_;
+    context->SetEventHandler(handler);
+    handler->InvokeTyped(eventData);
+    context->SetEventHandler(nullptr);
+}
+
 bool Object::IsInstanceOf(StringHash type) const
 {
     return GetTypeInfo()->IsTypeOf(type);
@@ -153,11 +167,12 @@ void Object::SubscribeToEvent(StringHash eventType, EventHandler* handler)
     {
         eventHandlers_.Erase(oldHandler, previous);
         eventHandlers_.InsertFront(handler);
+        context_->SetEventReceiverHandler(this, nullptr, eventType, handler);
     }
     else
     {
         eventHandlers_.InsertFront(handler);
-        context_->AddEventReceiver(this, eventType);
+        context_->AddEventReceiver(this, eventType, handler);
     }
 }
 
@@ -178,11 +193,12 @@ void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler
     {
         eventHandlers_.Erase(oldHandler, previous);
         eventHandlers_.InsertFront(handler);
+        context_->SetEventReceiverHandler(this, sender, eventType, handler);
     }
     else
     {
         eventHandlers_.InsertFront(handler);
-        context_->AddEventReceiver(this, sender, eventType);
+        context_->AddEventReceiver(this, sender, eventType, handler);
     }
 }
 
@@ -293,9 +309,8 @@ void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& excepti
 
 void Object::SendEvent(StringHash eventType)
 {
-    VariantMap noEventData;
-
-    SendEvent(eventType, noEventData);
+    // Use the preallocated (cleared) event data map to avoid allocating an empty map
+    SendEvent(eventType, GetEventDataMap());
 }
 
 void Object::SendEvent(StringHash eventType, VariantMap& eventData)
@@ -319,7 +334,7 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     // Make a weak pointer to self to check for destruction during event handling
     WeakPtr<Object> self(this);
     Context* context = context_;
-    HashSet<Object*> processed;
+    bool hasSpecificReceivers = false;
 
     context->BeginSendEvent(this, eventType);
 
@@ -348,7 +363,7 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                 return;
             }
 
-            processed.Insert(receiver);
+            hasSpecificReceivers = true;
         }
 
         group->EndSendEvent();
@@ -360,43 +375,105 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     {
         group->BeginSendEvent();
 
-        if (processed.Empty())
+        const unsigned numReceivers = group->receivers_.Size();
+        for (unsigned i = 0; i < numReceivers; ++i)
         {
-            const unsigned numReceivers = group->receivers_.Size();
-            for (unsigned i = 0; i < numReceivers; ++i)
-            {
-                Object* receiver = group->receivers_[i];
-                if (!receiver)
-                    continue;
+            Object* receiver = group->receivers_[i];
+            if (!receiver)
+                continue;
 
-                receiver->OnEvent(this, eventType, eventData);
+            // If there were specific receivers, check that the event is not sent doubly to them. Checking the receiver's own
+            // handlers avoids building a set of the processed receivers on each send
+            if (hasSpecificReceivers && receiver->FindSpecificEventHandler(this, eventType))
+                continue;
 
-                if (self.Expired())
-                {
-                    group->EndSendEvent();
-                    context->EndSendEvent();
-                    return;
-                }
+            receiver->OnEvent(this, eventType, eventData);
+
+            if (self.Expired())
+            {
+                group->EndSendEvent();
+                context->EndSendEvent();
+                return;
             }
         }
-        else
+
+        group->EndSendEvent();
+    }
+
+    context->EndSendEvent();
+}
+
+void Object::SendTypedEvent(StringHash eventType, void* eventData, const void* dataId, void (*toVariantMap)(const void*, VariantMap&))
+{
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Sending events is only supported from the main thread");
+        return;
+    }
+
+    if (blockEvents_)
+        return;
+
+#ifdef URHO3D_TRACY_PROFILING
+    URHO3D_PROFILE_COLOR(SendEvent, URHO3D_PROFILE_EVENT_COLOR);
+
+    const String& eventName = GetEventNameRegister().GetString(eventType);
+    URHO3D_PROFILE_STR(eventName.CString(), eventName.Length());
+#endif
+
+    // Get the event data map for handlers that do not take the typed data before beginning the send, so that it is not
+    // shared with events sent by the handlers. It is filled only when the first such handler is found
+    VariantMap& variantEventData = GetEventDataMap();
+    bool variantEventDataFilled = false;
+
+    WeakPtr<Object> self(this);
+    Context* context = context_;
+    bool hasSpecificReceivers = false;
+
+    context->BeginSendEvent(this, eventType);
+
+    // Go through the specific receivers first, then the non-specific. Typed handlers are known from the receiver groups and
+    // invoked through OnTypedEvent(), other handlers through OnEvent() like in SendEvent()
+    SharedPtr<EventReceiverGroup> group(context->GetEventReceivers(this, eventType));
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+            group = context->GetEventReceivers(eventType);
+        if (!group)
+            continue;
+
+        group->BeginSendEvent();
+
+        const unsigned numReceivers = group->receivers_.Size();
+        for (unsigned i = 0; i < numReceivers; ++i)
         {
-            // If there were specific receivers, check that the event is not sent doubly to them
-            const unsigned numReceivers = group->receivers_.Size();
-            for (unsigned i = 0; i < numReceivers; ++i)
-            {
-                Object* receiver = group->receivers_[i];
-                if (!receiver || processed.Contains(receiver))
-                    continue;
+            Object* receiver = group->receivers_[i];
+            if (!receiver || receiver->blockEvents_)
+                continue;
 
-                receiver->OnEvent(this, eventType, eventData);
+            if (pass == 0)
+                hasSpecificReceivers = true;
+            else if (hasSpecificReceivers && receiver->FindSpecificEventHandler(this, eventType))
+                continue;
 
-                if (self.Expired())
+            EventHandler* handler = group->handlers_[i];
+            if (handler->GetTypedDataId() == dataId)
+                receiver->OnTypedEvent(this, eventType, handler, eventData);
+            else
+            {
+                if (!variantEventDataFilled)
                 {
-                    group->EndSendEvent();
-                    context->EndSendEvent();
-                    return;
+                    toVariantMap(eventData, variantEventData);
+                    variantEventDataFilled = true;
                 }
+                receiver->OnEvent(this, eventType, variantEventData);
+            }
+
+            if (self.Expired())
+            {
+                group->EndSendEvent();
+                context->EndSendEvent();
+                return;
             }
         }
 
@@ -406,6 +483,20 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+void Object::PostEvent(StringHash eventType)
+{
+    PostEvent(eventType, Variant::emptyVariantMap);
+}
+
+void Object::PostEvent(StringHash eventType, const VariantMap& eventData)
+{
+    if (blockEvents_)
+        return;
+
+    numPostedEvents_.fetch_add(1, std::memory_order_relaxed);
+    context_->PostEvent(this, eventType, eventData);
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
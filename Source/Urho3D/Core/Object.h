@@ -25,6 +25,7 @@
 #include "../Container/LinkedList.h"
 #include "../Core/StringHashRegister.h"
 #include "../Core/Variant.h"
+#include <atomic>
 #include <functional>
 #include <utility>
 
@@ -78,6 +79,19 @@ private:
         static const Urho3D::String& GetTypeNameStatic() { return GetTypeInfoStatic()->GetTypeName(); } \
         static const Urho3D::TypeInfo* GetTypeInfoStatic() { static const Urho3D::TypeInfo typeInfoStatic(#typeName, BaseClassName::GetTypeInfoStatic()); return &typeInfoStatic; }
 
+/// Return a unique identifier for a typed event data structure. Used to check that a typed event handler accepts the data being sent.
+template <class E> const void* GetTypedEventDataId()
+{
+    static const char id = 0;
+    return &id;
+}
+
+/// Convert a typed event data structure to event parameters for handlers that take a VariantMap.
+template <class E> void TypedEventDataToVariantMap(const void* eventData, VariantMap& dest)
+{
+    static_cast<const E*>(eventData)->ToVariantMap(dest);
+}
+
 /// Base class for objects with type identification, subsystem access and event sending/receiving capability.
 /// @templateversion
 class URHO3D_API Object : public RefCounted
@@ -100,6 +114,8 @@ public:
     virtual const TypeInfo* GetTypeInfo() const = 0;
     /// Handle event.
     virtual void OnEvent(Object* sender, StringHash eventType, VariantMap& eventData);
+    /// Handle event with a typed event data structure for a handler that takes the same structure. Other handlers receive typed events through OnEvent().
+    virtual void OnTypedEvent(Object* sender, StringHash eventType, EventHandler* handler, void* eventData);
 
     /// Return type info static.
     static const TypeInfo* GetTypeInfoStatic() { return nullptr; }
@@ -136,6 +152,10 @@ public:
     void SendEvent(StringHash eventType);
     /// Send event with parameters to all subscribers.
     void SendEvent(StringHash eventType, VariantMap& eventData);
+    /// Post event to be sent to all subscribers in the main thread at the start of the next frame. Is thread-safe.
+    void PostEvent(StringHash eventType);
+    /// Post event with parameters to be sent to all subscribers in the main thread at the start of the next frame. Is thread-safe. The parameters are copied into pooled storage.
+    void PostEvent(StringHash eventType, const VariantMap& eventData);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
     /// Send event with variadic parameter pairs to all subscribers. The parameter pairs is a list of paramID and paramValue separated by comma, one pair after another.
@@ -143,6 +163,11 @@ public:
     {
         SendEvent(eventType, GetEventDataMap().Populate(args...));
     }
+    /// Send event with a typed event data structure to all subscribers. Handlers taking the same structure receive it directly without a VariantMap; other handlers receive the event parameters from the structure's ToVariantMap() function.
+    template <class E> void SendEvent(StringHash eventType, E& eventData)
+    {
+        SendTypedEvent(eventType, &eventData, GetTypedEventDataId<E>(), TypedEventDataToVariantMap<E>);
+    }
 
     /// Return execution context.
     Context* GetContext() const { return context_; }
@@ -193,12 +218,16 @@ private:
     EventHandler* FindSpecificEventHandler(Object* sender, StringHash eventType, EventHandler** previous = nullptr) const;
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
+    /// Send event with typed event data to all subscribers.
+    void SendTypedEvent(StringHash eventType, void* eventData, const void* dataId, void (*toVariantMap)(const void*, VariantMap&));
 
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
 
     /// Block object from sending and receiving any events.
     bool blockEvents_;
+    /// Number of posted events waiting to be sent.
+    std::atomic<unsigned> numPostedEvents_;
 };
 
 template <class T> T* Object::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
@@ -259,7 +288,8 @@ public:
     explicit EventHandler(Object* receiver, void* userData = nullptr) :
         receiver_(receiver),
         sender_(nullptr),
-        userData_(userData)
+        userData_(userData),
+        typedDataId_(nullptr)
     {
     }
 
@@ -275,6 +305,8 @@ public:
 
     /// Invoke event handler function.
     virtual void Invoke(VariantMap& eventData) = 0;
+    /// Invoke event handler function with typed event data. Called only if the data matches the typed data identifier.
+    virtual void InvokeTyped(void* eventData) { }
     /// Return a unique copy of the event handler.
     virtual EventHandler* Clone() const = 0;
 
@@ -290,6 +322,9 @@ public:
     /// Return userdata.
     void* GetUserData() const { return userData_; }
 
+    /// Return identifier of the typed event data structure accepted, or null if the handler only takes a VariantMap.
+    const void* GetTypedDataId() const { return typedDataId_; }
+
 protected:
     /// Event receiver.
     Object* receiver_;
@@ -299,6 +334,8 @@ protected:
     StringHash eventType_;
     /// Userdata.
     void* userData_;
+    /// Typed event data identifier.
+    const void* typedDataId_;
 };
 
 /// Template implementation of the event handler invoke helper (stores a function pointer of specific class).
@@ -334,6 +371,55 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Template implementation of the typed event handler invoke helper (stores a function pointer of specific class taking a typed event data structure). When the event is sent with a VariantMap, the structure is filled by its FromVariantMap() function.
+template <class T, class E> class TypedEventHandlerImpl : public EventHandler
+{
+public:
+    using HandlerFunctionPtr = void (T::*)(StringHash, E&);
+
+    /// Construct with receiver and function pointers and userdata.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function, void* userData = nullptr) :
+        EventHandler(receiver, userData),
+        function_(function)
+    {
+        assert(receiver_);
+        assert(function_);
+        typedDataId_ = GetTypedEventDataId<E>();
+    }
+
+    /// Invoke event handler function.
+    void Invoke(VariantMap& eventData) override
+    {
+        E data;
+        data.FromVariantMap(eventData);
+        auto* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(eventType_, data);
+    }
+
+    /// Invoke event handler function with typed event data.
+    void InvokeTyped(void* eventData) override
+    {
+        auto* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(eventType_, *static_cast<E*>(eventData));
+    }
+
+    /// Return a unique copy of the event handler.
+    EventHandler* Clone() const override
+    {
+        return new TypedEventHandlerImpl(static_cast<T*>(receiver_), function_, userData_);
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+/// Construct a typed event handler, deducing the event data structure from the handler function.
+template <class T, class E> EventHandler* MakeTypedEventHandler(T* receiver, void (T::*function)(StringHash, E&), void* userData = nullptr)
+{
+    return new TypedEventHandlerImpl<T, E>(receiver, function, userData);
+}
+
 /// Template implementation of the event handler invoke helper (std::function instance).
 /// @nobind
 class EventHandler11Impl : public EventHandler
@@ -375,5 +461,7 @@ URHO3D_API StringHashRegister& GetEventNameRegister();
 #define URHO3D_HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
 #define URHO3D_HANDLER_USERDATA(className, function, userData) (new Urho3D::EventHandlerImpl<className>(this, &className::function, userData))
+/// Convenience macro to construct an EventHandler that points to a receiver object and its member function taking a typed event data structure.
+#define URHO3D_TYPED_HANDLER(className, function) (Urho3D::MakeTypedEventHandler<className>(this, &className::function))
 
 }
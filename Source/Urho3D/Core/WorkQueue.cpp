@@ -22,15 +22,246 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Condition.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
 #include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 
 namespace Urho3D
 {
 
+/// How many times an idle worker thread polls the work deques before parking itself.
+static const unsigned MAX_IDLE_SPINS = 64;
+/// Initial capacity of a work deque. Must be a power of two.
+static const unsigned INITIAL_DEQUE_CAPACITY = 64;
+
+/// Return priority bucket index for a work item priority. Lower index = higher priority.
+static unsigned GetPriorityBucket(unsigned priority)
+{
+    if (priority == M_MAX_UNSIGNED)
+        return 0;
+    else if (priority > 0)
+        return 1;
+    else
+        return 2;
+}
+
+/// Return the lowest work item priority stored in a priority bucket.
+static unsigned GetBucketMinPriority(unsigned bucket)
+{
+    if (bucket == 0)
+        return M_MAX_UNSIGNED;
+    else if (bucket == 1)
+        return 1;
+    else
+        return 0;
+}
+
+/// Return the highest work item priority stored in a priority bucket.
+static unsigned GetBucketMaxPriority(unsigned bucket)
+{
+    if (bucket == 0)
+        return M_MAX_UNSIGNED;
+    else if (bucket == 1)
+        return M_MAX_UNSIGNED - 1;
+    else
+        return 0;
+}
+
+/// Return how many of the highest priority buckets only contain items with at least the specified priority.
+static unsigned GetNumBucketsWithPriority(unsigned priority, unsigned numBuckets)
+{
+    unsigned count = 0;
+    while (count < numBuckets && GetBucketMinPriority(count) >= priority)
+        ++count;
+    return count;
+}
+
+/// Work queue thread index of the current thread. Zero for the main thread and threads not owned by a work queue.
+static thread_local unsigned currentThreadIndex = 0;
+
+/// Shared state of a parallel for.
+struct ParallelForState
+{
+    /// Work function.
+    ParallelForFunction function_;
+    /// Auxiliary data pointer.
+    void* aux_;
+    /// Number of indices.
+    unsigned count_;
+    /// Minimum number of indices per chunk.
+    unsigned minChunkSize_;
+    /// Number of threads taking part.
+    unsigned numRunners_;
+    /// Next unprocessed index.
+    std::atomic<unsigned> next_;
+    /// Number of queued runner work items that have not finished yet.
+    std::atomic<unsigned> numActive_;
+};
+
+/// Take and process chunks of a parallel for until none remain.
+static void RunParallelFor(ParallelForState& state, unsigned threadIndex)
+{
+    unsigned start = state.next_.load(std::memory_order_relaxed);
+
+    while (start < state.count_)
+    {
+        // Take a share of the remaining range, so that chunks get smaller towards the end and threads finish at about the same time
+        unsigned remaining = state.count_ - start;
+        unsigned chunk = Min(Max(remaining / (state.numRunners_ * 2), state.minChunkSize_), remaining);
+
+        if (state.next_.compare_exchange_weak(start, start + chunk, std::memory_order_relaxed))
+        {
+            state.function_(start, start + chunk, threadIndex, state.aux_);
+            start = state.next_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/// Work function of a parallel for runner work item.
+static void ParallelForWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* state = reinterpret_cast<ParallelForState*>(item->aux_);
+    RunParallelFor(*state, threadIndex);
+
+    // The state lives on the main thread's stack, so it must not be accessed after signaling
+    state->numActive_.fetch_sub(1, std::memory_order_release);
+}
+
+/// Lock-free work-stealing deque (Chase-Lev). Only the owner thread pushes and pops at the bottom, while other threads steal from the top.
+class WorkStealingDeque
+{
+public:
+    /// Construct.
+    WorkStealingDeque() :
+        top_(0),
+        bottom_(0),
+        buffer_(new Buffer(INITIAL_DEQUE_CAPACITY))
+    {
+    }
+
+    /// Destruct.
+    ~WorkStealingDeque()
+    {
+        delete buffer_.load();
+        for (unsigned i = 0; i < retiredBuffers_.Size(); ++i)
+            delete retiredBuffers_[i];
+    }
+
+    /// Push an item to the bottom. Owner thread only.
+    void Push(WorkItem* item)
+    {
+        long long b = bottom_.load(std::memory_order_relaxed);
+        long long t = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        if (b - t > (long long)buffer->mask_)
+            buffer = Grow(buffer, t, b);
+
+        buffer->Put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /// Pop an item from the bottom. Owner thread only. Return null if empty.
+    WorkItem* Pop()
+    {
+        long long b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = top_.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        WorkItem* item = buffer->Get(b);
+        if (t == b)
+        {
+            // Last item: race against thieves for it
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    /// Steal an item from the top. Any thread. Return null if empty or if another thread took the item first.
+    WorkItem* Steal()
+    {
+        long long t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        WorkItem* item = buffer->Get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return item;
+    }
+
+    /// Return whether the deque is empty. May be out of date by the time it returns when other threads are active.
+    bool IsEmpty() const { return bottom_.load(std::memory_order_seq_cst) <= top_.load(std::memory_order_seq_cst); }
+
+private:
+    /// Circular item buffer.
+    struct Buffer
+    {
+        /// Construct with capacity, which must be a power of two.
+        explicit Buffer(unsigned capacity) :
+            mask_(capacity - 1),
+            items_(new std::atomic<WorkItem*>[capacity])
+        {
+        }
+
+        /// Destruct.
+        ~Buffer() { delete[] items_; }
+
+        /// Return item at position.
+        WorkItem* Get(long long index) const { return items_[index & mask_].load(std::memory_order_relaxed); }
+        /// Set item at position.
+        void Put(long long index, WorkItem* item) { items_[index & mask_].store(item, std::memory_order_relaxed); }
+
+        /// Capacity minus one.
+        unsigned mask_;
+        /// Items.
+        std::atomic<WorkItem*>* items_;
+    };
+
+    /// Replace the buffer with one of double capacity. Owner thread only.
+    Buffer* Grow(Buffer* buffer, long long top, long long bottom)
+    {
+        auto* newBuffer = new Buffer((buffer->mask_ + 1) * 2);
+        for (long long i = top; i < bottom; ++i)
+            newBuffer->Put(i, buffer->Get(i));
+
+        // Thieves may still be reading the old buffer, so retire it instead of deleting
+        retiredBuffers_.Push(buffer);
+        buffer_.store(newBuffer, std::memory_order_release);
+        return newBuffer;
+    }
+
+    /// Top (steal) position.
+    std::atomic<long long> top_;
+    /// Padding to keep the top and bottom positions on separate cache lines.
+    char padding_[64];
+    /// Bottom (push and pop) position.
+    std::atomic<long long> bottom_;
+    /// Current buffer.
+    std::atomic<Buffer*> buffer_;
+    /// Buffers replaced by growing.
+    PODVector<Buffer*> retiredBuffers_;
+};
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -38,7 +269,8 @@ public:
     /// Construct.
     WorkerThread(WorkQueue* owner, unsigned index) :
         owner_(owner),
-        index_(index)
+        index_(index),
+        parked_(false)
     {
     }
 
@@ -52,9 +284,19 @@ public:
 #endif
         // Init FPU state first
         InitFPU();
+        currentThreadIndex = index_;
         owner_->ProcessItems(index_);
     }
 
+    /// Mark as parked. Called by the worker thread itself before going to sleep.
+    void SetParked() { parked_ = true; }
+    /// Clear the parked flag. Return true if it was set, in which case the caller is responsible for waking the thread.
+    bool ClearParked() { return parked_.exchange(false); }
+    /// Sleep until woken up.
+    void Sleep() { wakeCondition_.Wait(); }
+    /// Wake up from sleep.
+    void Wake() { wakeCondition_.Set(); }
+
     /// Return thread index.
     unsigned GetIndex() const { return index_; }
 
@@ -63,29 +305,41 @@ private:
     WorkQueue* owner_;
     /// Thread index.
     unsigned index_;
+    /// Parked flag.
+    std::atomic<bool> parked_;
+    /// Condition to sleep on while parked.
+    Condition wakeCondition_;
 };
 
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    numParked_(0),
     shutDown_(false),
-    pausing_(false),
     paused_(false),
     completing_(false),
     tolerance_(10),
     lastSize_(0),
     maxNonThreadedWorkMs_(5)
 {
+    // Create the main thread's deques and scratch arena
+    for (unsigned i = 0; i < NUM_PRIORITY_BUCKETS; ++i)
+        deques_.Push(new WorkStealingDeque());
+    scratchArenas_.Resize(1);
+
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
 }
 
 WorkQueue::~WorkQueue()
 {
-    // Stop the worker threads. First make sure they are not waiting for work items
+    // Stop the worker threads. First make sure they are not parked
     shutDown_ = true;
-    Resume();
+    WakeThreads(threads_.Size());
 
     for (unsigned i = 0; i < threads_.Size(); ++i)
         threads_[i]->Stop();
+
+    for (unsigned i = 0; i < deques_.Size(); ++i)
+        delete deques_[i];
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -99,12 +353,17 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // Worker threads access the thread and deque vectors without locking, so fill them before starting any thread
     for (unsigned i = 0; i < numThreads; ++i)
     {
-        SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
-        thread->Run();
-        threads_.Push(thread);
+        threads_.Push(SharedPtr<WorkerThread>(new WorkerThread(this, i + 1)));
+        for (unsigned j = 0; j < NUM_PRIORITY_BUCKETS; ++j)
+            deques_.Push(new WorkStealingDeque());
     }
+    scratchArenas_.Resize(threads_.Size() + 1);
+
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Run();
 #else
     URHO3D_LOGERROR("Can not create worker threads as threading is disabled");
 #endif
@@ -135,44 +394,52 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
         return;
     }
 
-    // Check for duplicate items.
+    // Check for duplicate items. An item removed while still queued can not be re-added until its stale deque entry is consumed
     assert(!workItems_.Contains(item));
+    assert(!cancelledItems_.Contains(item));
 
     // Push to the main thread list to keep item alive
-    // Clear completed flag in case item is reused
+    // Clear completed and claimed flags in case item is reused
     workItems_.Push(item);
     item->completed_ = false;
+    item->claimed_ = false;
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.Acquire();
+    // Push to the main thread's deque of the item's priority bucket, from where worker threads steal it. If the item is still
+    // waiting for dependencies, the last one to finish pushes it instead
+    bool ready = item->pendingDependencies_.fetch_sub(1) == 1;
+    if (ready)
+        GetDeque(0, GetPriorityBucket(item->priority_))->Push(item);
 
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
+    if (threads_.Size())
     {
-        bool inserted = false;
+        paused_ = false;
+        if (ready)
+            WakeThreads(1);
+    }
+}
 
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
-        {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.Insert(i, item);
-                inserted = true;
-                break;
-            }
-        }
+void WorkQueue::AddDependency(const SharedPtr<WorkItem>& item, const SharedPtr<WorkItem>& dependency)
+{
+    if (!item || !dependency || item == dependency)
+    {
+        URHO3D_LOGERROR("Invalid work item dependency");
+        return;
+    }
 
-        if (!inserted)
-            queue_.Push(item);
+    // The dependent item must not be queued yet, otherwise it could already be executing
+    assert(!workItems_.Contains(item));
+
+    while (dependency->dependentsLock_.exchange(true, std::memory_order_acquire))
+    {
     }
 
-    if (threads_.Size())
+    if (!dependency->dependentsReleased_)
     {
-        queueMutex_.Release();
-        paused_ = false;
+        dependency->dependents_.Push(item.Get());
+        ++item->pendingDependencies_;
     }
+
+    dependency->dependentsLock_.store(false, std::memory_order_release);
 }
 
 bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
@@ -180,44 +447,24 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     if (!item)
         return false;
 
-    MutexLock lock(queueMutex_);
-
     // Can only remove successfully if the item was not yet taken by threads for execution
-    List<WorkItem*>::Iterator i = queue_.Find(item.Get());
-    if (i != queue_.End())
-    {
-        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
-        if (j != workItems_.End())
-        {
-            queue_.Erase(i);
-            ReturnToPool(item);
-            workItems_.Erase(j);
-            return true;
-        }
-    }
+    List<SharedPtr<WorkItem> >::Iterator i = workItems_.Find(item);
+    if (i == workItems_.End() || item->claimed_.exchange(true))
+        return false;
 
-    return false;
+    cancelledItems_.Push(item);
+    workItems_.Erase(i);
+    return true;
 }
 
 unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
 {
-    MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
     for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
     {
-        List<WorkItem*>::Iterator j = queue_.Find(i->Get());
-        if (j != queue_.End())
-        {
-            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
-            if (k != workItems_.End())
-            {
-                queue_.Erase(j);
-                ReturnToPool(*k);
-                workItems_.Erase(k);
-                ++removed;
-            }
-        }
+        if (RemoveWorkItem(*i))
+            ++removed;
     }
 
     return removed;
@@ -225,23 +472,15 @@ unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
 
 void WorkQueue::Pause()
 {
-    if (!paused_)
-    {
-        pausing_ = true;
-
-        queueMutex_.Acquire();
-        paused_ = true;
-
-        pausing_ = false;
-    }
+    paused_ = true;
 }
 
 void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
         paused_ = false;
+        WakeThreads(threads_.Size());
     }
 }
 
@@ -250,54 +489,171 @@ void WorkQueue::Complete(unsigned priority)
 {
     completing_ = true;
 
+    // Main thread only takes items from buckets where every item has at least the specified priority
+    unsigned numBuckets = GetNumBucketsWithPriority(priority, NUM_PRIORITY_BUCKETS);
+
     if (threads_.Size())
     {
         Resume();
 
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.Empty())
+        // Take work items also in the main thread until no high-priority items remain and all threaded work has completed
+        while (!IsCompleted(priority))
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
+            WorkItem* item = TakeItem(0, numBuckets);
+            if (item)
+                ExecuteItem(item, 0);
+        }
+
+        // If no work at all remaining, pause worker threads. Items waiting for dependencies count as remaining work, as
+        // worker threads queue them once their dependencies finish
+        if (IsCompleted(0))
+            Pause();
+    }
+    else
+    {
+        // No worker threads: ensure all high-priority items are completed in the main thread. Put back lower priority items
+        // sharing a bucket with them. Repeat while progress is made, as finishing items may queue their dependents
+        PODVector<WorkItem*> deferred;
+        bool executed = true;
+
+        while (executed)
+        {
+            executed = false;
+
+            for (unsigned i = 0; i < NUM_PRIORITY_BUCKETS && GetBucketMaxPriority(i) >= priority; ++i)
             {
-                queueMutex_.Release();
-                break;
+                WorkStealingDeque* deque = GetDeque(0, i);
+                while (WorkItem* item = deque->Pop())
+                {
+                    if (item->priority_ >= priority)
+                    {
+                        ExecuteItem(item, 0);
+                        executed = true;
+                    }
+                    else
+                        deferred.Push(item);
+                }
+
+                for (unsigned j = deferred.Size() - 1; j < deferred.Size(); --j)
+                    deque->Push(deferred[j]);
+                deferred.Clear();
             }
         }
+    }
 
-        // Wait for threaded work to complete
-        while (!IsCompleted(priority))
+    PurgeCompleted(priority);
+    completing_ = false;
+}
+
+void WorkQueue::CompleteItem(const SharedPtr<WorkItem>& item)
+{
+    if (!item || !workItems_.Contains(item))
+        return;
+
+    completing_ = true;
+
+    if (threads_.Size())
+    {
+        Resume();
+
+        // Help in the main thread only with work that has at least the item's priority. Lower priority dependencies are
+        // left to the worker threads
+        unsigned numBuckets = GetNumBucketsWithPriority(item->priority_, NUM_PRIORITY_BUCKETS);
+
+        while (!item->completed_)
         {
+            WorkItem* next = TakeItem(0, numBuckets);
+            if (next)
+                ExecuteItem(next, 0);
         }
-
-        // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
-            Pause();
     }
     else
     {
-        // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+        // No worker threads: execute work of any priority, as the item may depend on lower priority work
+        while (!item->completed_)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* next = TakeItem(0, NUM_PRIORITY_BUCKETS);
+            if (!next)
+            {
+                URHO3D_LOGERROR("Work item can not be completed, as it depends on work that has not been queued");
+                break;
+            }
+            ExecuteItem(next, 0);
         }
     }
 
+    PurgeCompleted(item->priority_);
+    completing_ = false;
+}
+
+void WorkQueue::ParallelFor(unsigned count, ParallelForFunction function, void* aux, unsigned minChunkSize, unsigned priority)
+{
+    if (!count || !function)
+        return;
+
+    // Waiting on the worker threads from one of them could deadlock, so other threads process the whole range serially
+    if (!Thread::IsMainThread())
+    {
+        function(0, count, currentThreadIndex, aux);
+        return;
+    }
+
+    minChunkSize = Max(minChunkSize, 1U);
+
+    // Without worker threads, or if the range is too small to split, process directly in the main thread
+    unsigned numRunners = Min(threads_.Size() + 1, (count + minChunkSize - 1) / minChunkSize);
+    if (numRunners <= 1)
+    {
+        function(0, count, 0, aux);
+        return;
+    }
+
+    ParallelForState state;
+    state.function_ = function;
+    state.aux_ = aux;
+    state.count_ = count;
+    state.minChunkSize_ = minChunkSize;
+    state.numRunners_ = numRunners;
+    state.next_ = 0;
+    state.numActive_ = numRunners - 1;
+
+    for (unsigned i = 1; i < numRunners; ++i)
+    {
+        SharedPtr<WorkItem> item = GetFreeItem();
+        item->priority_ = priority;
+        item->workFunction_ = ParallelForWork;
+        item->aux_ = &state;
+        AddWorkItem(item);
+    }
+
+    completing_ = true;
+
+    // Take chunks also in the main thread, then wait for the chunks taken by worker threads. While waiting, execute other work
+    // of the same priority, including runner items not picked up by any worker thread
+    RunParallelFor(state, 0);
+
+    unsigned numBuckets = GetNumBucketsWithPriority(priority, NUM_PRIORITY_BUCKETS);
+    while (state.numActive_.load(std::memory_order_acquire))
+    {
+        WorkItem* item = TakeItem(0, numBuckets);
+        if (item)
+            ExecuteItem(item, 0);
+    }
+
     PurgeCompleted(priority);
     completing_ = false;
 }
 
+void* WorkQueue::GetScratchBuffer(unsigned threadIndex, unsigned size)
+{
+    assert(threadIndex < scratchArenas_.Size());
+
+    PODVector<unsigned char>& buffer = scratchArenas_[threadIndex].buffer_;
+    if (buffer.Size() < size)
+        buffer.Resize(size);
+    return buffer.Buffer();
+}
+
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
     for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
@@ -311,35 +667,133 @@ bool WorkQueue::IsCompleted(unsigned priority) const
 
 void WorkQueue::ProcessItems(unsigned threadIndex)
 {
-    bool wasActive = false;
+    WorkerThread* thread = threads_[threadIndex - 1];
+    unsigned idleSpins = 0;
 
     for (;;)
     {
         if (shutDown_)
             return;
 
-        if (pausing_ && !wasActive)
-            Time::Sleep(0);
-        else
+        WorkItem* item = paused_ ? nullptr : TakeItem(threadIndex, NUM_PRIORITY_BUCKETS);
+        if (item)
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty())
-            {
-                wasActive = true;
+            idleSpins = 0;
+            ExecuteItem(item, threadIndex);
+        }
+        else if (++idleSpins >= MAX_IDLE_SPINS)
+        {
+            idleSpins = 0;
+            ParkThread(thread);
+        }
+    }
+}
 
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
-            }
-            else
-            {
-                wasActive = false;
+WorkItem* WorkQueue::TakeItem(unsigned threadIndex, unsigned numBuckets)
+{
+    unsigned numQueues = threads_.Size() + 1;
 
-                queueMutex_.Release();
-                Time::Sleep(0);
-            }
+    for (unsigned i = 0; i < numBuckets; ++i)
+    {
+        WorkItem* item = GetDeque(threadIndex, i)->Pop();
+        if (item)
+            return item;
+
+        // Own deque empty, steal from other threads starting from the next one to spread contention
+        for (unsigned j = 1; j < numQueues; ++j)
+        {
+            item = GetDeque((threadIndex + j) % numQueues, i)->Steal();
+            if (item)
+                return item;
+        }
+    }
+
+    return nullptr;
+}
+
+void WorkQueue::ExecuteItem(WorkItem* item, unsigned threadIndex)
+{
+    // If the item was removed while queued, it is already claimed and only the queue entry needs to be marked consumed
+    if (!item->claimed_.exchange(true))
+        item->workFunction_(item, threadIndex);
+
+    ReleaseDependents(item, threadIndex);
+
+    // The item may be purged and reused as soon as it is marked completed, so this must be the last access
+    item->pendingDependencies_ = 1;
+    item->completed_ = true;
+}
+
+void WorkQueue::ReleaseDependents(WorkItem* item, unsigned threadIndex)
+{
+    while (item->dependentsLock_.exchange(true, std::memory_order_acquire))
+    {
+    }
+
+    item->dependentsReleased_ = true;
+    item->dependentsLock_.store(false, std::memory_order_release);
+
+    // No more dependents can be added now, so the list can be accessed without the lock
+    if (item->dependents_.Empty())
+        return;
+
+    unsigned numReleased = 0;
+    for (PODVector<WorkItem*>::ConstIterator i = item->dependents_.Begin(); i != item->dependents_.End(); ++i)
+    {
+        WorkItem* dependent = *i;
+        if (dependent->pendingDependencies_.fetch_sub(1) == 1)
+        {
+            GetDeque(threadIndex, GetPriorityBucket(dependent->priority_))->Push(dependent);
+            ++numReleased;
+        }
+    }
+
+    item->dependents_.Clear();
+    WakeThreads(numReleased);
+}
+
+bool WorkQueue::HasQueuedWork(unsigned numBuckets) const
+{
+    for (unsigned i = 0; i <= threads_.Size(); ++i)
+    {
+        for (unsigned j = 0; j < numBuckets; ++j)
+        {
+            if (!GetDeque(i, j)->IsEmpty())
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkQueue::ParkThread(WorkerThread* thread)
+{
+    ++numParked_;
+    thread->SetParked();
+
+    // Check again after announcing, so that work added or resume / shutdown requested in the meantime is not missed.
+    // If a waker already cleared the flag, it is going to signal, so sleep to consume the signal
+    if ((shutDown_ || (!paused_ && HasQueuedWork(NUM_PRIORITY_BUCKETS))) && thread->ClearParked())
+    {
+        --numParked_;
+        return;
+    }
+
+    thread->Sleep();
+}
+
+void WorkQueue::WakeThreads(unsigned count)
+{
+    // Make sure the parked flags are read after the work or state change that is being signaled has become visible
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (unsigned i = 0; i < threads_.Size() && count && numParked_ > 0; ++i)
+    {
+        if (threads_[i]->ClearParked())
+        {
+            --numParked_;
+            threads_[i]->Wake();
+            --count;
         }
     }
 }
@@ -362,12 +816,27 @@ void WorkQueue::PurgeCompleted(unsigned priority)
                 SendEvent(E_WORKITEMCOMPLETED, eventData);
             }
 
+            // Allow depending on the item again when it is reused
+            (*i)->dependentsReleased_ = false;
             ReturnToPool(*i);
             i = workItems_.Erase(i);
         }
         else
             ++i;
     }
+
+    // Removed items can be released once their deque entry has been consumed
+    for (List<SharedPtr<WorkItem> >::Iterator i = cancelledItems_.Begin(); i != cancelledItems_.End();)
+    {
+        if ((*i)->completed_)
+        {
+            (*i)->dependentsReleased_ = false;
+            ReturnToPool(*i);
+            i = cancelledItems_.Erase(i);
+        }
+        else
+            ++i;
+    }
 }
 
 void WorkQueue::PurgePool()
@@ -398,26 +867,33 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
         item->priority_ = M_MAX_UNSIGNED;
         item->sendEvent_ = false;
         item->completed_ = false;
+        item->claimed_ = false;
 
         poolItems_.Push(item);
     }
 }
 
+unsigned WorkQueue::AllocateScratchSlot()
+{
+    static std::atomic<unsigned> numSlots{0};
+    return numSlots++;
+}
+
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    if (threads_.Empty() && HasQueuedWork(NUM_PRIORITY_BUCKETS))
     {
         URHO3D_PROFILE(CompleteWorkNonthreaded);
 
         HiresTimer timer;
 
-        while (!queue_.Empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = TakeItem(0, NUM_PRIORITY_BUCKETS);
+            if (!item)
+                break;
+            ExecuteItem(item, 0);
         }
     }
 
@@ -23,7 +23,6 @@
 #pragma once
 
 #include "../Container/List.h"
-#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
 #include <atomic>
@@ -38,6 +37,7 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 }
 
 class WorkerThread;
+class WorkStealingDeque;
 
 /// Work queue item.
 /// @nobind
@@ -63,6 +63,56 @@ public:
 
 private:
     bool pooled_{};
+    /// Claimed flag. Set by the thread that starts executing the item, or when the item is removed from the queue.
+    std::atomic<bool> claimed_{};
+    /// Number of unfinished dependencies, plus one until the item has been added to the queue.
+    std::atomic<unsigned> pendingDependencies_{1};
+    /// Work items waiting for this item to finish.
+    PODVector<WorkItem*> dependents_;
+    /// Lock for the dependents list.
+    std::atomic<bool> dependentsLock_{};
+    /// Dependents released flag. Set when the item has finished, after which depending on it is a no-op.
+    bool dependentsReleased_{};
+};
+
+/// Parallel for work function. Called with a range of indices to process, the thread index (0 = main thread) and the auxiliary data pointer.
+using ParallelForFunction = void (*)(unsigned start, unsigned end, unsigned threadIndex, void* aux);
+
+/// %Parallel reduce data. Holds a partial result for each thread.
+/// @nobind
+template <class T> struct ParallelReduceData
+{
+    /// Work function. Accumulates a range of indices into the calling thread's partial result.
+    void (* function_)(unsigned start, unsigned end, T& result, void* aux);
+    /// Auxiliary data pointer.
+    void* aux_;
+    /// Partial results, indexed by thread index.
+    Vector<T> results_;
+};
+
+/// Parallel for work function of a parallel reduce.
+template <class T> void ParallelReduceWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* data = reinterpret_cast<ParallelReduceData<T>*>(aux);
+    data->function_(start, end, data->results_[threadIndex], data->aux_);
+}
+
+/// Scratch vector of a work queue thread.
+/// @nobind
+template <class T> struct ScratchVector : public RefCounted
+{
+    /// Vector.
+    PODVector<T> vector_;
+};
+
+/// Per-thread scratch memory of the work queue.
+/// @nobind
+struct ScratchArena
+{
+    /// Byte buffer.
+    PODVector<unsigned char> buffer_;
+    /// Scratch vectors by element type slot.
+    Vector<SharedPtr<RefCounted> > vectors_;
 };
 
 /// Work queue subsystem for multithreading.
@@ -82,18 +132,58 @@ public:
     void CreateThreads(unsigned numThreads);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
-    /// Add a work item and resume worker threads.
+    /// Add a work item and resume worker threads. If the item has dependencies, it is executed only after they have all finished.
     void AddWorkItem(const SharedPtr<WorkItem>& item);
+    /// Make a work item wait for another work item to finish before starting execution. Must be called before adding the item to the queue. The dependency may already be queued or executing; if it has already finished, the call is a no-op.
+    void AddDependency(const SharedPtr<WorkItem>& item, const SharedPtr<WorkItem>& dependency);
     /// Remove a work item before it has started executing. Return true if successfully removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items);
-    /// Pause worker threads.
+    /// Pause worker threads. Idle worker threads park themselves instead of taking new work.
     void Pause();
-    /// Resume worker threads.
+    /// Resume worker threads and wake up the parked ones.
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    /// Finish a queued work item, including the work it depends on. Main thread will also execute work while waiting, but does not wait for unrelated work to finish.
+    void CompleteItem(const SharedPtr<WorkItem>& item);
+    /// Process a range of indices in the worker threads and the main thread and wait for completion. Threads take chunks of decreasing size until none remain, which balances work with varying per-index cost. When called from another thread, the range is processed serially in the calling thread instead.
+    void ParallelFor(unsigned count, ParallelForFunction function, void* aux, unsigned minChunkSize = 1, unsigned priority = M_MAX_UNSIGNED);
+
+    /// Reduce a range of indices in the worker threads and the main thread and return the result. The work function accumulates ranges into the calling thread's partial result, which starts from the identity value, and the partial results are combined in the calling thread. When called from a thread other than the main thread, the range is processed serially.
+    template <class T> T ParallelReduce(unsigned count, const T& identity, void (* function)(unsigned start, unsigned end, T& result, void* aux),
+        T (* combine)(const T& lhs, const T& rhs), void* aux, unsigned minChunkSize = 1)
+    {
+        ParallelReduceData<T> data;
+        data.function_ = function;
+        data.aux_ = aux;
+        data.results_.Resize(threads_.Size() + 1, identity);
+
+        ParallelFor(count, ParallelReduceWork<T>, &data, minChunkSize);
+
+        T result = data.results_[0];
+        for (unsigned i = 1; i < data.results_.Size(); ++i)
+            result = combine(result, data.results_[i]);
+        return result;
+    }
+
+    /// Return a scratch buffer of at least the specified size in bytes for a thread (0 = main thread), to avoid allocating temporary storage in work functions. The contents stay valid until the same thread requests the buffer again.
+    void* GetScratchBuffer(unsigned threadIndex, unsigned size);
+
+    /// Return a scratch vector for a thread (0 = main thread), to avoid allocating temporary storage in work functions. Each thread has one vector per element type, which keeps its capacity between uses. The contents stay valid until the same thread requests the vector again, so the main thread should not hold it while completing work that may also use it.
+    template <class T> PODVector<T>& GetScratchVector(unsigned threadIndex)
+    {
+        static const unsigned slot = AllocateScratchSlot();
+
+        Vector<SharedPtr<RefCounted> >& vectors = scratchArenas_[threadIndex].vectors_;
+        if (vectors.Size() <= slot)
+            vectors.Resize(slot + 1);
+        if (!vectors[slot])
+            vectors[slot] = new ScratchVector<T>();
+
+        return static_cast<ScratchVector<T>*>(vectors[slot].Get())->vector_;
+    }
 
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
@@ -118,6 +208,20 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Return the work deque of a thread for a priority bucket.
+    WorkStealingDeque* GetDeque(unsigned threadIndex, unsigned bucket) const { return deques_[threadIndex * NUM_PRIORITY_BUCKETS + bucket]; }
+    /// Take a work item from the thread's own deques or steal one from other threads, searching the specified number of highest priority buckets. Return null if none found.
+    WorkItem* TakeItem(unsigned threadIndex, unsigned numBuckets);
+    /// Execute a taken work item unless it has been removed from the queue, release its dependents and mark its queue entry consumed.
+    void ExecuteItem(WorkItem* item, unsigned threadIndex);
+    /// Queue the dependents of a finished work item whose dependencies have now all finished. They are pushed to the executing thread's own deques.
+    void ReleaseDependents(WorkItem* item, unsigned threadIndex);
+    /// Return whether any deque has queued items in the specified number of highest priority buckets.
+    bool HasQueuedWork(unsigned numBuckets) const;
+    /// Park a worker thread until woken up by new work, resume or shutdown.
+    void ParkThread(WorkerThread* thread);
+    /// Wake up to the specified number of parked worker threads.
+    void WakeThreads(unsigned count);
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
@@ -126,6 +230,11 @@ private:
     void ReturnToPool(SharedPtr<WorkItem>& item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Return a new scratch vector slot for an element type.
+    static unsigned AllocateScratchSlot();
+
+    /// Number of priority buckets in each thread's work deques.
+    static const unsigned NUM_PRIORITY_BUCKETS = 3;
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
@@ -133,16 +242,18 @@ private:
     List<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
     List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems).
-    List<WorkItem*> queue_;
-    /// Worker queue mutex.
-    Mutex queueMutex_;
+    /// Work items removed while still referenced from a work deque. Kept alive until the stale deque entry has been consumed.
+    List<SharedPtr<WorkItem> > cancelledItems_;
+    /// Scratch memory, one arena per thread (0 = main thread).
+    Vector<ScratchArena> scratchArenas_;
+    /// Lock-free work deques, one per thread (0 = main thread) and priority bucket. Pointers are guaranteed to be valid (point to workItems or cancelledItems).
+    PODVector<WorkStealingDeque*> deques_;
+    /// Number of parked worker threads.
+    std::atomic<int> numParked_;
     /// Shutting down flag.
     std::atomic<bool> shutDown_;
-    /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
-    std::atomic<bool> pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
-    bool paused_;
+    /// Paused flag. Indicates the worker threads should park instead of taking new work.
+    std::atomic<bool> paused_;
     /// Completing work in the main thread flag.
     bool completing_;
     /// Tolerance for the shared pool before it begins to deallocate.
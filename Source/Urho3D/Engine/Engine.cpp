@@ -496,6 +496,9 @@ void Engine::RunFrame()
 
     time->BeginFrame(timeStep_);
 
+    // Send the events posted from other threads since the previous frame
+    context_->SendPostedEvents();
+
     // If pause when minimized -mode is in use, stop updates and audio as necessary
     if (pauseMinimized_ && input->IsMinimized())
     {
@@ -689,10 +692,8 @@ void Engine::Update()
     URHO3D_PROFILE(Update);
 
     // Logic update event
-    using namespace Update;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
+    UpdateEventData eventData;
+    eventData.timeStep_ = timeStep_;
     SendEvent(E_UPDATE, eventData);
 
     // Logic post-update event
@@ -74,6 +74,7 @@ AnimatedModel::AnimatedModel(Context* context) :
     animationLodBias_(1.0f),
     animationLodTimer_(-1.0f),
     animationLodDistance_(0.0f),
+    sharedPoseTimeStep_(0.0f),
     updateInvisible_(false),
     animationDirty_(false),
     animationOrderDirty_(false),
@@ -83,7 +84,8 @@ AnimatedModel::AnimatedModel(Context* context) :
     isMaster_(true),
     loading_(false),
     assignBonesPending_(false),
-    forceAnimationUpdate_(false)
+    forceAnimationUpdate_(false),
+    lightweightSkeleton_(false)
 {
 }
 
@@ -97,6 +99,8 @@ AnimatedModel::~AnimatedModel()
         if (parent && !parent->GetComponent<AnimatedModel>())
             RemoveRootBone();
     }
+
+    RemoveBoneAttachmentNodes();
 }
 
 void AnimatedModel::RegisterObject(Context* context)
@@ -123,6 +127,8 @@ void AnimatedModel::RegisterObject(Context* context)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, animationStatesStructureElementNames);
     URHO3D_ACCESSOR_ATTRIBUTE("Morphs", GetMorphsAttr, SetMorphsAttr, PODVector<unsigned char>, Variant::emptyBuffer,
         AM_DEFAULT | AM_NOEDIT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Lightweight Skeleton", GetLightweightSkeleton, SetLightweightSkeleton, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Shared Pose Time Step", GetSharedPoseTimeStep, SetSharedPoseTimeStep, float, 0.0f, AM_DEFAULT);
 }
 
 bool AnimatedModel::Load(Deserializer& source)
@@ -152,6 +158,15 @@ bool AnimatedModel::LoadJSON(const JSONValue& source)
     return success;
 }
 
+bool AnimatedModel::LoadValues(const Variant* values, const unsigned* attributeIndices, unsigned numValues)
+{
+    loading_ = true;
+    bool success = Component::LoadValues(values, attributeIndices, numValues);
+    loading_ = false;
+
+    return success;
+}
+
 void AnimatedModel::ApplyAttributes()
 {
     if (assignBonesPending_)
@@ -173,13 +188,26 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         return;
 
     const Vector<Bone>& bones = skeleton_.GetBones();
+    AnimatedModel* poseModel = lightweightSkeleton_ ? GetPoseModel() : nullptr;
     Sphere boneSphere;
 
     for (unsigned i = 0; i < bones.Size(); ++i)
     {
         const Bone& bone = bones[i];
-        if (!bone.node_)
-            continue;
+        Matrix3x4 transform;
+        if (lightweightSkeleton_)
+        {
+            unsigned poseIndex = poseModel ? GetPoseBoneIndex(poseModel, i) : M_MAX_UNSIGNED;
+            if (poseIndex == M_MAX_UNSIGNED)
+                continue;
+            transform = node_->GetWorldTransform() * poseModel->boneModelTransforms_[poseIndex];
+        }
+        else
+        {
+            if (!bone.node_)
+                continue;
+            transform = bone.node_->GetWorldTransform();
+        }
 
         float distance;
 
@@ -188,7 +216,6 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -204,7 +231,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = transform.Translation();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -325,7 +352,31 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
-        debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+        if (!lightweightSkeleton_)
+            debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+        else if (boneModelTransforms_.Size())
+        {
+            // Draw the skeleton from the pose, similarly to DebugRenderer::AddSkeleton()
+            const Vector<Bone>& bones = skeleton_.GetBones();
+            const Matrix3x4& worldTransform = node_->GetWorldTransform();
+            unsigned uintColor = Color(0.75f, 0.75f, 0.75f).ToUInt();
+
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                // Skip if bone contains no skinned geometry
+                if (bones[i].radius_ < M_EPSILON && bones[i].boundingBox_.Size().LengthSquared() < M_EPSILON)
+                    continue;
+
+                Vector3 start = worldTransform * boneModelTransforms_[i].Translation();
+                Vector3 end = start;
+                unsigned j = bones[i].parentIndex_;
+                if (j != i && j < bones.Size() &&
+                    (bones[j].radius_ >= M_EPSILON || bones[j].boundingBox_.Size().LengthSquared() >= M_EPSILON))
+                    end = worldTransform * boneModelTransforms_[j].Translation();
+
+                debug->AddLine(start, end, uintColor, depthTest);
+            }
+        }
     }
 }
 
@@ -548,6 +599,31 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetLightweightSkeleton(bool enable)
+{
+    if (enable == lightweightSkeleton_)
+        return;
+
+    lightweightSkeleton_ = enable;
+    MarkNetworkUpdate();
+
+    // When loading, the bones are assigned according to the mode in ApplyAttributes()
+    if (loading_ || !model_ || !node_)
+        return;
+
+    // Recreate the skeleton in the new mode
+    if (isMaster_)
+        RemoveRootBone();
+    RemoveBoneAttachmentNodes();
+    skeleton_.ClearBones();
+    SetSkeleton(model_->GetSkeleton(), true);
+}
+
+void AnimatedModel::SetSharedPoseTimeStep(float step)
+{
+    sharedPoseTimeStep_ = Max(step, 0.0f);
+    MarkNetworkUpdate();
+}
 
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
@@ -654,6 +730,50 @@ float AnimatedModel::GetMorphWeight(StringHash nameHash) const
     return 0.0f;
 }
 
+Node* AnimatedModel::GetBoneNode(const String& boneName)
+{
+    Bone* bone = skeleton_.GetBone(boneName);
+    if (!bone)
+        return nullptr;
+    if (!lightweightSkeleton_)
+        return bone->node_;
+
+    // The attachment nodes are owned by the master model, which evaluates the pose
+    if (!isMaster_)
+    {
+        AnimatedModel* master = GetPoseModel();
+        return master ? master->GetBoneNode(boneName) : nullptr;
+    }
+
+    unsigned index = skeleton_.GetBoneIndex(bone);
+    if (boneAttachmentNodes_.Size() != skeleton_.GetNumBones())
+        boneAttachmentNodes_.Resize(skeleton_.GetNumBones());
+
+    Node* boneNode = boneAttachmentNodes_[index];
+    if (!boneNode)
+    {
+        // Reuse a node with the bone's name if one was loaded with the scene, otherwise create as local, as bone nodes
+        // are never to be directly synchronized over the network
+        boneNode = node_->GetChild(bone->nameHash_);
+        if (!boneNode)
+        {
+            boneNode = node_->CreateChild(bone->name_, LOCAL);
+            boneNode->SetTemporary(IsTemporary());
+        }
+        if (index < boneModelTransforms_.Size())
+        {
+            Vector3 position;
+            Quaternion rotation;
+            Vector3 scale;
+            boneModelTransforms_[index].Decompose(position, rotation, scale);
+            boneNode->SetTransform(position, rotation, scale);
+        }
+        boneAttachmentNodes_[index] = boneNode;
+    }
+
+    return boneNode;
+}
+
 AnimationState* AnimatedModel::GetAnimationState(Animation* animation) const
 {
     for (Vector<SharedPtr<AnimationState> >::ConstIterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
@@ -710,8 +830,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
 
             for (unsigned i = 0; i < destBones.Size(); ++i)
             {
-                if (destBones[i].node_ && destBones[i].name_ == srcBones[i].name_ && destBones[i].parentIndex_ ==
-                                                                                     srcBones[i].parentIndex_)
+                if ((destBones[i].node_ || lightweightSkeleton_) && destBones[i].name_ == srcBones[i].name_ &&
+                    destBones[i].parentIndex_ == srcBones[i].parentIndex_)
                 {
                     // If compatible, just copy the values and retain the old node and animated status
                     Node* boneNode = destBones[i].node_;
@@ -735,6 +855,7 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
         // Detach the rootbone of the previous model if any
         if (createBones)
             RemoveRootBone();
+        RemoveBoneAttachmentNodes();
 
         skeleton_.Define(skeleton);
 
@@ -742,8 +863,11 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
         FinalizeBoneBoundingBoxes();
 
         Vector<Bone>& bones = skeleton_.GetModifiableBones();
+        // In lightweight skeleton mode evaluate the bones into pose buffers instead of scene nodes
+        if (lightweightSkeleton_)
+            InitializeBonePose();
         // Create scene nodes for the bones
-        if (createBones)
+        else if (createBones)
         {
             for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
             {
@@ -780,7 +904,12 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
         if (master && master != this)
             master->FinalizeBoneBoundingBoxes();
 
-        if (createBones)
+        // In lightweight skeleton mode the bones are matched to the master model's pose when skinning
+        masterBoneIndices_.Resize(skeleton_.GetNumBones());
+        for (unsigned i = 0; i < masterBoneIndices_.Size(); ++i)
+            masterBoneIndices_[i] = M_MAX_UNSIGNED;
+
+        if (createBones && !lightweightSkeleton_)
         {
             Vector<Bone>& bones = skeleton_.GetModifiableBones();
             for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
@@ -909,9 +1038,33 @@ void AnimatedModel::UpdateBoneBoundingBox()
     {
         // The bone bounding box is in local space, so need the node's inverse transform
         boneBoundingBox_.Clear();
+        const Vector<Bone>& bones = skeleton_.GetBones();
+
+        // In lightweight skeleton mode the bone transforms are already relative to the scene node
+        if (lightweightSkeleton_)
+        {
+            AnimatedModel* poseModel = GetPoseModel();
+            for (unsigned i = 0; i < bones.Size() && poseModel; ++i)
+            {
+                unsigned poseIndex = GetPoseBoneIndex(poseModel, i);
+                if (poseIndex == M_MAX_UNSIGNED)
+                    continue;
+
+                const Bone& bone = bones[i];
+                const Matrix3x4& transform = poseModel->boneModelTransforms_[poseIndex];
+                if (bone.collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(bone.boundingBox_.Transformed(transform));
+                else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(transform.Translation(), bone.radius_ * 0.5f));
+            }
+
+            boneBoundingBoxDirty_ = false;
+            MarkWorldBoundingBoxDirty();
+            return;
+        }
+
         Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
 
-        const Vector<Bone>& bones = skeleton_.GetBones();
         for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
         {
             Node* boneNode = i->node_;
@@ -928,7 +1081,7 @@ void AnimatedModel::UpdateBoneBoundingBox()
     }
 
     boneBoundingBoxDirty_ = false;
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
 }
 
 void AnimatedModel::OnNodeSet(Node* node)
@@ -983,24 +1136,33 @@ void AnimatedModel::AssignBoneNodes()
     if (!node_)
         return;
 
-    // Find the bone nodes from the node hierarchy and add listeners
-    Vector<Bone>& bones = skeleton_.GetModifiableBones();
-    bool boneFound = false;
-    for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
+    // In lightweight skeleton mode there are no bone nodes to find, but the pose needs to be initialized
+    if (lightweightSkeleton_)
     {
-        Node* boneNode = node_->GetChild(i->name_, true);
-        if (boneNode)
+        if (isMaster_)
+            InitializeBonePose();
+    }
+    else
+    {
+        // Find the bone nodes from the node hierarchy and add listeners
+        Vector<Bone>& bones = skeleton_.GetModifiableBones();
+        bool boneFound = false;
+        for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
         {
-            boneFound = true;
-            boneNode->AddListener(this);
+            Node* boneNode = node_->GetChild(i->name_, true);
+            if (boneNode)
+            {
+                boneFound = true;
+                boneNode->AddListener(this);
+            }
+            i->node_ = boneNode;
         }
-        i->node_ = boneNode;
-    }
 
-    // If no bones found, this may be a prefab where the bone information was left out.
-    // In that case reassign the skeleton now if possible
-    if (!boneFound && model_)
-        SetSkeleton(model_->GetSkeleton(), true);
+        // If no bones found, this may be a prefab where the bone information was left out.
+        // In that case reassign the skeleton now if possible
+        if (!boneFound && model_)
+            SetSkeleton(model_->GetSkeleton(), true);
+    }
 
     // Re-assign the same start bone to animations to get the proper bone node this time
     for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
@@ -1079,6 +1241,141 @@ void AnimatedModel::RemoveRootBone()
         rootBone->node_->Remove();
 }
 
+void AnimatedModel::RemoveBoneAttachmentNodes()
+{
+    for (Vector<WeakPtr<Node> >::Iterator i = boneAttachmentNodes_.Begin(); i != boneAttachmentNodes_.End(); ++i)
+    {
+        if (*i)
+            (*i)->Remove();
+    }
+    boneAttachmentNodes_.Clear();
+}
+
+void AnimatedModel::InitializeBonePose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = bones.Size();
+
+    bonePositions_.Resize(numBones);
+    boneRotations_.Resize(numBones);
+    boneScales_.Resize(numBones);
+    boneModelTransforms_.Resize(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        bonePositions_[i] = bones[i].initialPosition_;
+        boneRotations_[i] = bones[i].initialRotation_;
+        boneScales_[i] = bones[i].initialScale_;
+    }
+
+    // Order the bones so that parents are evaluated before their children. Bones are marked when entering the chain,
+    // which also terminates a malformed (cyclic) hierarchy
+    boneUpdateOrder_.Clear();
+    boneUpdateOrder_.Reserve(numBones);
+    PODVector<bool> ordered(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+        ordered[i] = false;
+    PODVector<unsigned> chain;
+
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        unsigned index = i;
+        while (index < numBones && !ordered[index])
+        {
+            chain.Push(index);
+            ordered[index] = true;
+            unsigned parentIndex = bones[index].parentIndex_;
+            index = parentIndex != index ? parentIndex : M_MAX_UNSIGNED;
+        }
+
+        while (chain.Size())
+        {
+            boneUpdateOrder_.Push(chain.Back());
+            chain.Pop();
+        }
+    }
+
+    UpdateBoneModelTransforms();
+    skinningDirty_ = true;
+    boneBoundingBoxDirty_ = true;
+}
+
+void AnimatedModel::ResetBonePose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.Size() && i < bonePositions_.Size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_)
+        {
+            bonePositions_[i] = bone.initialPosition_;
+            boneRotations_[i] = bone.initialRotation_;
+            boneScales_[i] = bone.initialScale_;
+        }
+    }
+}
+
+void AnimatedModel::UpdateBoneModelTransforms()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = boneModelTransforms_.Size();
+
+    for (PODVector<unsigned>::ConstIterator i = boneUpdateOrder_.Begin(); i != boneUpdateOrder_.End(); ++i)
+    {
+        unsigned index = *i;
+        unsigned parentIndex = bones[index].parentIndex_;
+        Matrix3x4 localTransform(bonePositions_[index], boneRotations_[index], boneScales_[index]);
+        if (parentIndex != index && parentIndex < numBones)
+            boneModelTransforms_[index] = boneModelTransforms_[parentIndex] * localTransform;
+        else
+            boneModelTransforms_[index] = localTransform;
+    }
+
+    UpdateBoneAttachmentNodes();
+}
+
+void AnimatedModel::UpdateBoneAttachmentNodes()
+{
+    unsigned numBones = boneModelTransforms_.Size();
+    for (unsigned i = 0; i < boneAttachmentNodes_.Size() && i < numBones; ++i)
+    {
+        Node* boneNode = boneAttachmentNodes_[i];
+        if (boneNode)
+        {
+            Vector3 position;
+            Quaternion rotation;
+            Vector3 scale;
+            boneModelTransforms_[i].Decompose(position, rotation, scale);
+            boneNode->SetTransform(position, rotation, scale);
+        }
+    }
+}
+
+AnimatedModel* AnimatedModel::GetPoseModel() const
+{
+    if (isMaster_)
+        return const_cast<AnimatedModel*>(this);
+
+    auto* master = node_ ? node_->GetComponent<AnimatedModel>() : nullptr;
+    return master && master->lightweightSkeleton_ ? master : nullptr;
+}
+
+unsigned AnimatedModel::GetPoseBoneIndex(const AnimatedModel* poseModel, unsigned index)
+{
+    if (poseModel == this)
+        return index < boneModelTransforms_.Size() ? index : M_MAX_UNSIGNED;
+
+    // Validate the cached mapping to the master model's bones, as the master's skeleton may have changed
+    if (index >= masterBoneIndices_.Size())
+        return M_MAX_UNSIGNED;
+    const Vector<Bone>& masterBones = poseModel->skeleton_.GetBones();
+    const Bone& bone = skeleton_.GetBones()[index];
+    unsigned& masterIndex = masterBoneIndices_[index];
+    if (masterIndex >= masterBones.Size() || masterBones[masterIndex].nameHash_ != bone.nameHash_)
+        masterIndex = poseModel->skeleton_.GetBoneIndex(bone.nameHash_);
+
+    return masterIndex < poseModel->boneModelTransforms_.Size() ? masterIndex : M_MAX_UNSIGNED;
+}
+
 void AnimatedModel::MarkAnimationDirty()
 {
     if (isMaster_)
@@ -1270,28 +1567,38 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
             animationLodTimer_ = 0.0f;
     }
 
+    if (sharedPoseTimeStep_ > 0.0f && ApplySharedAnimation(frame.frameNumber_))
+        return;
+
     ApplyAnimation();
 }
 
 void AnimatedModel::ApplyAnimation()
 {
     // Make sure animations are in ascending priority order
-    if (animationOrderDirty_)
-    {
-        Sort(animationStates_.Begin(), animationStates_.End(), CompareAnimationOrder);
-        animationOrderDirty_ = false;
-    }
+    SortAnimationStates();
 
     // Reset skeleton, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
     // (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.ResetSilent();
-        for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
-            (*i)->Apply();
+        if (lightweightSkeleton_)
+        {
+            ResetBonePose();
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
+            UpdateBoneModelTransforms();
+            MarkPoseDirty();
+        }
+        else
+        {
+            skeleton_.ResetSilent();
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
 
-        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
-        node_->MarkDirty();
+            // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
+            node_->MarkDirty();
+        }
 
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
@@ -1300,6 +1607,112 @@ void AnimatedModel::ApplyAnimation()
     animationDirty_ = false;
 }
 
+bool AnimatedModel::ApplySharedAnimation(unsigned frameNumber)
+{
+    if (!isMaster_ || !lightweightSkeleton_ || !octant_ || !model_)
+        return false;
+
+    SortAnimationStates();
+
+    // The key consists of everything that affects the pose: the model, bone animation enable flags and the enabled states
+    // with their start bones, quantized times and weights
+    AnimationPoseKey key;
+    key.Add(model_.Get());
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned animatedBits = 0;
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        animatedBits = (animatedBits << 1u) | (bones[i].animated_ ? 1u : 0u);
+        if ((i & 31u) == 31u || i == bones.Size() - 1)
+        {
+            key.Add(animatedBits);
+            animatedBits = 0;
+        }
+    }
+
+    PODVector<float> quantizedTimes;
+    for (Vector<SharedPtr<AnimationState> >::ConstIterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+    {
+        const AnimationState* state = *i;
+        if (!state->GetAnimation() || !state->IsEnabled())
+            continue;
+
+        auto timeIndex = (unsigned)FloorToInt(state->time_ / sharedPoseTimeStep_ + 0.5f);
+        quantizedTimes.Push(timeIndex * sharedPoseTimeStep_);
+
+        key.Add(state->GetAnimation());
+        key.Add(timeIndex);
+        key.Add(FloatToRawIntBits(state->weight_));
+        key.Add((unsigned)state->blendingMode_ | (unsigned)state->looped_ << 8u | (unsigned)state->layer_ << 16u);
+        // The start bone selects the tracks to apply. Its name identifies it across the models, unlike the bone pointer
+        key.Add(state->startBone_ ? state->startBone_->nameHash_.Value() : 0u);
+        for (Vector<AnimationStateTrack>::ConstIterator j = state->stateTracks_.Begin(); j != state->stateTracks_.End(); ++j)
+            key.Add(FloatToRawIntBits(j->weight_));
+    }
+
+    bool created;
+    SharedPtr<AnimationPose> pose = octant_->GetRoot()->GetAnimationPoseCache().GetPose(key, frameNumber, created);
+
+    if (created)
+    {
+        // Evaluate at the quantized times so that the pose is the same regardless of which model evaluates it
+        ResetBonePose();
+        unsigned index = 0;
+        for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+        {
+            AnimationState* state = *i;
+            if (!state->GetAnimation() || !state->IsEnabled())
+                continue;
+
+            float time = state->time_;
+            state->time_ = quantizedTimes[index++];
+            state->Apply();
+            state->time_ = time;
+        }
+        UpdateBoneModelTransforms();
+        UpdateBoneBoundingBox();
+
+        pose->boneModelTransforms_ = boneModelTransforms_;
+        pose->boneBoundingBox_ = boneBoundingBox_;
+        pose->mutex_.Release();
+    }
+    else
+    {
+        {
+            MutexLock lock(pose->mutex_);
+            boneModelTransforms_ = pose->boneModelTransforms_;
+            boneBoundingBox_ = pose->boneBoundingBox_;
+        }
+        UpdateBoneAttachmentNodes();
+        boneBoundingBoxDirty_ = false;
+        MarkWorldBoundingBoxDirty();
+    }
+
+    MarkPoseDirty();
+    animationDirty_ = false;
+    return true;
+}
+
+void AnimatedModel::SortAnimationStates()
+{
+    if (animationOrderDirty_)
+    {
+        Sort(animationStates_.Begin(), animationStates_.End(), CompareAnimationOrder);
+        animationOrderDirty_ = false;
+    }
+}
+
+void AnimatedModel::MarkPoseDirty()
+{
+    // Only the skinning of the models in this node needs to be dirtied, not the scene node hierarchy
+    const Vector<SharedPtr<Component> >& components = node_->GetComponents();
+    for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
+    {
+        if ((*i)->GetType() == GetTypeStatic())
+            static_cast<AnimatedModel*>(i->Get())->OnMarkedDirty(node_);
+    }
+}
+
 void AnimatedModel::UpdateSkinning()
 {
     // Note: the model's world transform will be baked in the skin matrices
@@ -1307,19 +1720,19 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
-    // Skinning with global matrices only
-    if (!geometrySkinMatrices_.Size())
+    // Lightweight skeleton: calculate directly from the pose, without bone nodes
+    if (lightweightSkeleton_)
     {
+        AnimatedModel* poseModel = GetPoseModel();
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
-            const Bone& bone = bones[i];
-            if (bone.node_)
-                skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
+            unsigned poseIndex = poseModel ? GetPoseBoneIndex(poseModel, i) : M_MAX_UNSIGNED;
+            if (poseIndex != M_MAX_UNSIGNED)
+                skinMatrices_[i] = worldTransform * poseModel->boneModelTransforms_[poseIndex] * bones[i].offsetMatrix_;
             else
                 skinMatrices_[i] = worldTransform;
         }
     }
-    // Skinning with per-geometry matrices
     else
     {
         for (unsigned i = 0; i < bones.Size(); ++i)
@@ -1329,8 +1742,14 @@ void AnimatedModel::UpdateSkinning()
                 skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
             else
                 skinMatrices_[i] = worldTransform;
+        }
+    }
 
-            // Copy the skin matrix to per-geometry matrices as needed
+    // Skinning with per-geometry matrices: copy the skin matrices as needed
+    if (geometrySkinMatrices_.Size())
+    {
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
             for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].Size(); ++j)
                 *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
         }
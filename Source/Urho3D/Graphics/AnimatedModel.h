@@ -54,6 +54,8 @@ public:
     bool LoadXML(const XMLElement& source) override;
     /// Load from JSON data. Return true if successful.
     bool LoadJSON(const JSONValue& source) override;
+    /// Load from attribute values decoded in advance. Return true if successful.
+    bool LoadValues(const Variant* values, const unsigned* attributeIndices, unsigned numValues) override;
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     void ApplyAttributes() override;
     /// Process octree raycast. May be called from a worker thread.
@@ -91,6 +93,12 @@ public:
     /// Set whether to update animation and the bounding box when not visible. Recommended to enable for physically controlled models like ragdolls.
     /// @property
     void SetUpdateInvisible(bool enable);
+    /// Set whether to evaluate animation into flat pose buffers instead of creating a scene node for each bone. Bone nodes for attachments can still be created on demand with GetBoneNode(). Changing the mode after the model has been set recreates the skeleton and removes animation states.
+    /// @property
+    void SetLightweightSkeleton(bool enable);
+    /// Set time quantization step for sharing the evaluated pose with other models that play the same animations with the same weights, for example crowd characters. Animation times are rounded to the step. 0 (default) disables sharing. Requires lightweight skeleton mode.
+    /// @property
+    void SetSharedPoseTimeStep(float step);
     /// Set vertex morph weight by index.
     void SetMorphWeight(unsigned index, float weight);
     /// Set vertex morph weight by name.
@@ -132,6 +140,20 @@ public:
     /// @property
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
+    /// Return whether animation is evaluated into pose buffers instead of bone scene nodes.
+    /// @property
+    bool GetLightweightSkeleton() const { return lightweightSkeleton_; }
+
+    /// Return time quantization step for sharing the evaluated pose.
+    /// @property
+    float GetSharedPoseTimeStep() const { return sharedPoseTimeStep_; }
+
+    /// Return bone transforms relative to the scene node in lightweight skeleton mode. Empty for non-master models.
+    const PODVector<Matrix3x4>& GetBoneModelTransforms() const { return boneModelTransforms_; }
+
+    /// Return scene node of a bone by name. In lightweight skeleton mode the node is created on demand as a child of the model's scene node and follows the animated bone.
+    Node* GetBoneNode(const String& boneName);
+
     /// Return all vertex morphs.
     const Vector<ModelMorph>& GetMorphs() const { return morphs_; }
 
@@ -194,6 +216,26 @@ private:
     void FinalizeBoneBoundingBoxes();
     /// Remove (old) skeleton root bone.
     void RemoveRootBone();
+    /// Remove the bone attachment nodes created in lightweight skeleton mode.
+    void RemoveBoneAttachmentNodes();
+    /// Initialize the pose buffers and bone update order for lightweight skeleton mode.
+    void InitializeBonePose();
+    /// Reset the pose of animated bones to their initial transforms.
+    void ResetBonePose();
+    /// Calculate bone transforms relative to the scene node from the pose buffers and move the bone attachment nodes.
+    void UpdateBoneModelTransforms();
+    /// Move the bone attachment nodes to follow the bone transforms.
+    void UpdateBoneAttachmentNodes();
+    /// Apply a pose shared with other models, evaluating it if this is the first model to use it. Return false if sharing is not possible.
+    bool ApplySharedAnimation(unsigned frameNumber);
+    /// Sort animation states in ascending priority order if needed.
+    void SortAnimationStates();
+    /// Mark the skinning of all animated models in the node dirty after the pose has changed in lightweight skeleton mode.
+    void MarkPoseDirty();
+    /// Return the model whose pose drives the bones in lightweight skeleton mode: this model if master, otherwise the master model.
+    AnimatedModel* GetPoseModel() const;
+    /// Return index of a bone in the pose model's transforms, or M_MAX_UNSIGNED if not available.
+    unsigned GetPoseBoneIndex(const AnimatedModel* poseModel, unsigned index);
     /// Mark animation and skinning to require an update.
     void MarkAnimationDirty();
     /// Mark animation and skinning to require a forced update (blending order changed).
@@ -238,6 +280,28 @@ private:
     Vector<PODVector<Matrix3x4*> > geometrySkinMatrixPtrs_;
     /// Bounding box calculated from bones.
     BoundingBox boneBoundingBox_;
+    /// Bone local positions in lightweight skeleton mode.
+    PODVector<Vector3> bonePositions_;
+    /// Bone local rotations in lightweight skeleton mode.
+    PODVector<Quaternion> boneRotations_;
+    /// Bone local scales in lightweight skeleton mode.
+    PODVector<Vector3> boneScales_;
+    /// Bone transforms relative to the scene node in lightweight skeleton mode.
+    PODVector<Matrix3x4> boneModelTransforms_;
+    /// Bone indices ordered parents first, for calculating the bone transforms in lightweight skeleton mode.
+    PODVector<unsigned> boneUpdateOrder_;
+    /// Matching bone indices in the master model's skeleton, for non-master models in lightweight skeleton mode.
+    PODVector<unsigned> masterBoneIndices_;
+    /// Scene nodes created on demand for attaching objects to bones in lightweight skeleton mode.
+    Vector<WeakPtr<Node> > boneAttachmentNodes_;
+    /// Pose rotations gathered for blending an animation state in lightweight skeleton mode.
+    PODVector<Quaternion> blendRotations_;
+    /// Sampled rotations to blend towards.
+    PODVector<Quaternion> blendTargetRotations_;
+    /// Blending weights of the gathered rotations.
+    PODVector<float> blendWeights_;
+    /// Bone indices of the gathered rotations.
+    PODVector<unsigned> blendBoneIndices_;
     /// Attribute buffer.
     mutable VectorBuffer attrBuffer_;
     /// The frame number animation LOD distance was last calculated on.
@@ -250,6 +314,8 @@ private:
     float animationLodTimer_;
     /// Animation LOD distance, the minimum of all LOD view distances last frame.
     float animationLodDistance_;
+    /// Time quantization step for sharing the evaluated pose. 0 if disabled.
+    float sharedPoseTimeStep_;
     /// Update animation when invisible flag.
     bool updateInvisible_;
     /// Animation dirty flag.
@@ -270,6 +336,8 @@ private:
     bool assignBonesPending_;
     /// Force animation update after becoming visible flag.
     bool forceAnimationUpdate_;
+    /// Lightweight skeleton flag.
+    bool lightweightSkeleton_;
 };
 
 }
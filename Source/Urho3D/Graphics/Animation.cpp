@@ -49,6 +49,142 @@ inline bool CompareKeyFrames(AnimationKeyFrame& lhs, AnimationKeyFrame& rhs)
     return lhs.time_ < rhs.time_;
 }
 
+/// Maximum value of a quantized smallest three rotation component.
+static const float ROTATION_QUANTIZE_MAX = 32767.0f;
+/// Maximum value of a quantized position or scale component.
+static const float VECTOR_QUANTIZE_MAX = 65535.0f;
+/// Maximum absolute value of a rotation component that is not the largest is 1 / sqrt(2). Used to scale it to full range.
+static const float SMALLEST_THREE_SCALE = 1.41421356f;
+
+/// Find the keyframe index for time, starting from the previous index.
+template <class T> static void FindKeyFrameIndex(const T* keyFrames, unsigned numKeyFrames, float (*getTime)(const T&), float time,
+    unsigned& index)
+{
+    if (index >= numKeyFrames)
+        index = numKeyFrames - 1;
+
+    // Sequential playback usually stays on the same keyframe or advances to the next one
+    if (getTime(keyFrames[index]) <= time)
+    {
+        if (index + 1 >= numKeyFrames || time < getTime(keyFrames[index + 1]))
+            return;
+        if (index + 2 >= numKeyFrames || time < getTime(keyFrames[index + 2]))
+        {
+            ++index;
+            return;
+        }
+    }
+
+    // Otherwise binary search for the last keyframe that starts at or before the time
+    unsigned first = 0;
+    unsigned count = numKeyFrames;
+    while (count > 0)
+    {
+        unsigned step = count / 2;
+        unsigned middle = first + step;
+        if (getTime(keyFrames[middle]) <= time)
+        {
+            first = middle + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+
+    index = first ? first - 1 : 0;
+}
+
+static float GetKeyFrameTime(const AnimationKeyFrame& keyFrame)
+{
+    return keyFrame.time_;
+}
+
+static float GetTime(const float& time)
+{
+    return time;
+}
+
+static void QuantizeVector(const Vector3& value, const Vector3& min, const Vector3& range, unsigned short* dest)
+{
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        float normalized = range.Data()[i] > 0.0f ? (value.Data()[i] - min.Data()[i]) / range.Data()[i] : 0.0f;
+        dest[i] = (unsigned short)RoundToInt(Clamp(normalized, 0.0f, 1.0f) * VECTOR_QUANTIZE_MAX);
+    }
+}
+
+static Vector3 DequantizeVector(const unsigned short* src, const Vector3& min, const Vector3& range)
+{
+    return Vector3(
+        min.x_ + src[0] * (1.0f / VECTOR_QUANTIZE_MAX) * range.x_,
+        min.y_ + src[1] * (1.0f / VECTOR_QUANTIZE_MAX) * range.y_,
+        min.z_ + src[2] * (1.0f / VECTOR_QUANTIZE_MAX) * range.z_
+    );
+}
+
+static void QuantizeRotation(const Quaternion& value, unsigned short* dest)
+{
+    // Store the three smallest components. The largest is reconstructed from the unit length, and its index is stored in the
+    // high bits of the first two components
+    Quaternion rotation = value.Normalized();
+    const float* data = rotation.Data();
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(data[i]) > Abs(data[largest]))
+            largest = i;
+    }
+    float sign = data[largest] < 0.0f ? -1.0f : 1.0f;
+
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float normalized = Clamp((data[i] * sign * SMALLEST_THREE_SCALE + 1.0f) * 0.5f, 0.0f, 1.0f);
+        dest[j++] = (unsigned short)RoundToInt(normalized * ROTATION_QUANTIZE_MAX);
+    }
+
+    dest[0] |= (largest & 2u) << 14u;
+    dest[1] |= (largest & 1u) << 15u;
+}
+
+static Quaternion DequantizeRotation(const unsigned short* src)
+{
+    unsigned largest = ((src[0] >> 14u) & 2u) | (src[1] >> 15u);
+    float data[4];
+    float sumSquares = 0.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float value = ((src[j++] & 0x7fffu) * (2.0f / ROTATION_QUANTIZE_MAX) - 1.0f) * (1.0f / SMALLEST_THREE_SCALE);
+        data[i] = value;
+        sumSquares += value * value;
+    }
+    data[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(data[0], data[1], data[2], data[3]);
+}
+
+/// Return whether a keyframe can be reconstructed within tolerance by interpolating between two other keyframes.
+static bool CanInterpolate(const AnimationKeyFrame& keyFrame, const AnimationKeyFrame& start, const AnimationKeyFrame& end,
+    AnimationChannelFlags channels, float positionTolerance, float minRotationDot, float scaleTolerance)
+{
+    float timeInterval = end.time_ - start.time_;
+    float t = timeInterval > 0.0f ? (keyFrame.time_ - start.time_) / timeInterval : 1.0f;
+
+    if ((channels & CHANNEL_POSITION) && (start.position_.Lerp(end.position_, t) - keyFrame.position_).Length() > positionTolerance)
+        return false;
+    if ((channels & CHANNEL_ROTATION) && Abs(start.rotation_.Slerp(end.rotation_, t).DotProduct(keyFrame.rotation_)) < minRotationDot)
+        return false;
+    if ((channels & CHANNEL_SCALE) && (start.scale_.Lerp(end.scale_, t) - keyFrame.scale_).Length() > scaleTolerance)
+        return false;
+
+    return true;
+}
+
 void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
     if (index < keyFrames_.Size())
@@ -89,28 +225,304 @@ AnimationKeyFrame* AnimationTrack::GetKeyFrame(unsigned index)
     return index < keyFrames_.Size() ? &keyFrames_[index] : nullptr;
 }
 
-bool AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
+void AnimationTrack::Compress(float positionTolerance, float rotationTolerance, float scaleTolerance)
 {
+    if (IsCompressed())
+        Decompress();
     if (keyFrames_.Empty())
-        return false;
+        return;
+
+    float minRotationDot = Cos(Max(rotationTolerance, 0.0f) * 0.5f);
+
+    // Find the channels that stay constant
+    AnimationChannelFlags animatedChannels = CHANNEL_NONE;
+    const AnimationKeyFrame& first = keyFrames_.Front();
+    for (unsigned i = 1; i < keyFrames_.Size(); ++i)
+    {
+        const AnimationKeyFrame& keyFrame = keyFrames_[i];
+        if ((channelMask_ & CHANNEL_POSITION) && (keyFrame.position_ - first.position_).Length() > positionTolerance)
+            animatedChannels |= CHANNEL_POSITION;
+        if ((channelMask_ & CHANNEL_ROTATION) && Abs(keyFrame.rotation_.DotProduct(first.rotation_)) < minRotationDot)
+            animatedChannels |= CHANNEL_ROTATION;
+        if ((channelMask_ & CHANNEL_SCALE) && (keyFrame.scale_ - first.scale_).Length() > scaleTolerance)
+            animatedChannels |= CHANNEL_SCALE;
+    }
+
+    // Remove keyframes that can be interpolated from the previous kept keyframe and a later keyframe. The first and last keyframes
+    // are always kept so that looping behaves as before
+    PODVector<unsigned> keptIndices;
+    keptIndices.Push(0);
+    if (animatedChannels)
+    {
+        unsigned start = 0;
+        for (unsigned end = 2; end < keyFrames_.Size(); ++end)
+        {
+            for (unsigned i = start + 1; i < end; ++i)
+            {
+                if (!CanInterpolate(keyFrames_[i], keyFrames_[start], keyFrames_[end], animatedChannels, positionTolerance,
+                    minRotationDot, scaleTolerance))
+                {
+                    start = end - 1;
+                    keptIndices.Push(start);
+                    break;
+                }
+            }
+        }
+    }
+    if (keyFrames_.Size() > 1)
+        keptIndices.Push(keyFrames_.Size() - 1);
+
+    unsigned numKeyFrames = keptIndices.Size();
+    compressedTimes_.Resize(numKeyFrames);
+    for (unsigned i = 0; i < numKeyFrames; ++i)
+        compressedTimes_[i] = keyFrames_[keptIndices[i]].time_;
+
+    positionMin_ = first.position_;
+    positionRange_ = Vector3::ZERO;
+    compressedPositions_.Clear();
+    if (animatedChannels & CHANNEL_POSITION)
+    {
+        Vector3 positionMax = first.position_;
+        for (unsigned i = 0; i < numKeyFrames; ++i)
+        {
+            const Vector3& position = keyFrames_[keptIndices[i]].position_;
+            positionMin_ = VectorMin(positionMin_, position);
+            positionMax = VectorMax(positionMax, position);
+        }
+        positionRange_ = positionMax - positionMin_;
+
+        compressedPositions_.Resize(numKeyFrames * 3);
+        for (unsigned i = 0; i < numKeyFrames; ++i)
+            QuantizeVector(keyFrames_[keptIndices[i]].position_, positionMin_, positionRange_, &compressedPositions_[i * 3]);
+    }
+
+    constantRotation_ = first.rotation_;
+    compressedRotations_.Clear();
+    if (animatedChannels & CHANNEL_ROTATION)
+    {
+        compressedRotations_.Resize(numKeyFrames * 3);
+        for (unsigned i = 0; i < numKeyFrames; ++i)
+            QuantizeRotation(keyFrames_[keptIndices[i]].rotation_, &compressedRotations_[i * 3]);
+    }
+
+    scaleMin_ = first.scale_;
+    scaleRange_ = Vector3::ZERO;
+    compressedScales_.Clear();
+    if (animatedChannels & CHANNEL_SCALE)
+    {
+        Vector3 scaleMax = first.scale_;
+        for (unsigned i = 0; i < numKeyFrames; ++i)
+        {
+            const Vector3& scale = keyFrames_[keptIndices[i]].scale_;
+            scaleMin_ = VectorMin(scaleMin_, scale);
+            scaleMax = VectorMax(scaleMax, scale);
+        }
+        scaleRange_ = scaleMax - scaleMin_;
+
+        compressedScales_.Resize(numKeyFrames * 3);
+        for (unsigned i = 0; i < numKeyFrames; ++i)
+            QuantizeVector(keyFrames_[keptIndices[i]].scale_, scaleMin_, scaleRange_, &compressedScales_[i * 3]);
+    }
+
+    keyFrames_.Clear();
+}
+
+void AnimationTrack::Decompress()
+{
+    if (!IsCompressed())
+        return;
 
+    keyFrames_.Resize(compressedTimes_.Size());
+    for (unsigned i = 0; i < keyFrames_.Size(); ++i)
+    {
+        AnimationKeyFrame& keyFrame = keyFrames_[i];
+        keyFrame.time_ = compressedTimes_[i];
+        keyFrame.position_ = compressedPositions_.Empty() ? positionMin_ : DequantizeVector(&compressedPositions_[i * 3], positionMin_,
+            positionRange_);
+        keyFrame.rotation_ = compressedRotations_.Empty() ? constantRotation_ : DequantizeRotation(&compressedRotations_[i * 3]);
+        keyFrame.scale_ = compressedScales_.Empty() ? scaleMin_ : DequantizeVector(&compressedScales_[i * 3], scaleMin_, scaleRange_);
+    }
+
+    compressedTimes_.Clear();
+    compressedPositions_.Clear();
+    compressedRotations_.Clear();
+    compressedScales_.Clear();
+}
+
+bool AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
+{
     if (time < 0.0f)
         time = 0.0f;
 
-    if (index >= keyFrames_.Size())
-        index = keyFrames_.Size() - 1;
+    if (IsCompressed())
+        FindKeyFrameIndex(&compressedTimes_[0], compressedTimes_.Size(), GetTime, time, index);
+    else if (!keyFrames_.Empty())
+        FindKeyFrameIndex(&keyFrames_[0], keyFrames_.Size(), GetKeyFrameTime, time, index);
+    else
+        return false;
+
+    return true;
+}
+
+bool AnimationTrack::Sample(float time, float length, bool looped, unsigned& index, Vector3& position, Quaternion& rotation,
+    Vector3& scale) const
+{
+    if (!GetKeyFrameIndex(time, index))
+        return false;
+
+    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+    unsigned numKeyFrames = IsCompressed() ? compressedTimes_.Size() : keyFrames_.Size();
+    unsigned nextIndex = index + 1;
+    bool interpolate = true;
+    if (nextIndex >= numKeyFrames)
+    {
+        if (!looped)
+        {
+            nextIndex = index;
+            interpolate = false;
+        }
+        else
+            nextIndex = 0;
+    }
+
+    if (!IsCompressed())
+    {
+        const AnimationKeyFrame* keyFrame = &keyFrames_[index];
 
-    // Check for being too far ahead
-    while (index && time < keyFrames_[index].time_)
-        --index;
+        if (interpolate)
+        {
+            const AnimationKeyFrame* nextKeyFrame = &keyFrames_[nextIndex];
+            float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+            if (timeInterval < 0.0f)
+                timeInterval += length;
+            float t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
+
+            if (channelMask_ & CHANNEL_POSITION)
+                position = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+            if (channelMask_ & CHANNEL_ROTATION)
+                rotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+            if (channelMask_ & CHANNEL_SCALE)
+                scale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+        }
+        else
+        {
+            if (channelMask_ & CHANNEL_POSITION)
+                position = keyFrame->position_;
+            if (channelMask_ & CHANNEL_ROTATION)
+                rotation = keyFrame->rotation_;
+            if (channelMask_ & CHANNEL_SCALE)
+                scale = keyFrame->scale_;
+        }
 
-    // Check for being too far behind
-    while (index < keyFrames_.Size() - 1 && time >= keyFrames_[index + 1].time_)
-        ++index;
+        return true;
+    }
+
+    float t = 0.0f;
+    if (interpolate)
+    {
+        float timeInterval = compressedTimes_[nextIndex] - compressedTimes_[index];
+        if (timeInterval < 0.0f)
+            timeInterval += length;
+        t = timeInterval > 0.0f ? (time - compressedTimes_[index]) / timeInterval : 1.0f;
+    }
+
+    // Constant channels are stored as a single value
+    if (channelMask_ & CHANNEL_POSITION)
+    {
+        if (compressedPositions_.Empty())
+            position = positionMin_;
+        else
+        {
+            position = DequantizeVector(&compressedPositions_[index * 3], positionMin_, positionRange_);
+            if (interpolate)
+                position = position.Lerp(DequantizeVector(&compressedPositions_[nextIndex * 3], positionMin_, positionRange_), t);
+        }
+    }
+    if (channelMask_ & CHANNEL_ROTATION)
+    {
+        if (compressedRotations_.Empty())
+            rotation = constantRotation_;
+        else
+        {
+            rotation = DequantizeRotation(&compressedRotations_[index * 3]);
+            if (interpolate)
+                rotation = rotation.Slerp(DequantizeRotation(&compressedRotations_[nextIndex * 3]), t);
+        }
+    }
+    if (channelMask_ & CHANNEL_SCALE)
+    {
+        if (compressedScales_.Empty())
+            scale = scaleMin_;
+        else
+        {
+            scale = DequantizeVector(&compressedScales_[index * 3], scaleMin_, scaleRange_);
+            if (interpolate)
+                scale = scale.Lerp(DequantizeVector(&compressedScales_[nextIndex * 3], scaleMin_, scaleRange_), t);
+        }
+    }
 
     return true;
 }
 
+unsigned AnimationTrack::GetKeyFrameMemoryUse() const
+{
+    return keyFrames_.Size() * sizeof(AnimationKeyFrame) + compressedTimes_.Size() * sizeof(float) +
+        (compressedPositions_.Size() + compressedRotations_.Size() + compressedScales_.Size()) * sizeof(unsigned short);
+}
+
+static void ReadCompressedTrack(Deserializer& source, AnimationTrack& track)
+{
+    unsigned keyFrames = source.ReadUInt();
+    track.compressedTimes_.Resize(keyFrames);
+    if (keyFrames)
+        source.Read(&track.compressedTimes_[0], keyFrames * sizeof(float));
+
+    AnimationChannelFlags animatedChannels = AnimationChannelFlags(source.ReadUByte());
+    track.positionMin_ = source.ReadVector3();
+    track.positionRange_ = source.ReadVector3();
+    track.constantRotation_ = source.ReadQuaternion();
+    track.scaleMin_ = source.ReadVector3();
+    track.scaleRange_ = source.ReadVector3();
+
+    PODVector<unsigned short>* channelData[] = { &track.compressedPositions_, &track.compressedRotations_, &track.compressedScales_ };
+    const AnimationChannel channels[] = { CHANNEL_POSITION, CHANNEL_ROTATION, CHANNEL_SCALE };
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        PODVector<unsigned short>& data = *channelData[i];
+        data.Resize((animatedChannels & channels[i]) ? keyFrames * 3 : 0);
+        if (data.Size())
+            source.Read(&data[0], data.Size() * sizeof(unsigned short));
+    }
+}
+
+static void WriteCompressedTrack(Serializer& dest, const AnimationTrack& track)
+{
+    unsigned keyFrames = track.compressedTimes_.Size();
+    dest.WriteUInt(keyFrames);
+    dest.Write(&track.compressedTimes_[0], keyFrames * sizeof(float));
+
+    AnimationChannelFlags animatedChannels;
+    if (!track.compressedPositions_.Empty())
+        animatedChannels |= CHANNEL_POSITION;
+    if (!track.compressedRotations_.Empty())
+        animatedChannels |= CHANNEL_ROTATION;
+    if (!track.compressedScales_.Empty())
+        animatedChannels |= CHANNEL_SCALE;
+    dest.WriteUByte(animatedChannels);
+    dest.WriteVector3(track.positionMin_);
+    dest.WriteVector3(track.positionRange_);
+    dest.WriteQuaternion(track.constantRotation_);
+    dest.WriteVector3(track.scaleMin_);
+    dest.WriteVector3(track.scaleRange_);
+
+    const PODVector<unsigned short>* channelData[] = { &track.compressedPositions_, &track.compressedRotations_, &track.compressedScales_ };
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        if (!channelData[i]->Empty())
+            dest.Write(&channelData[i]->Front(), channelData[i]->Size() * sizeof(unsigned short));
+    }
+}
+
 Animation::Animation(Context* context) :
     ResourceWithMetadata(context),
     length_(0.f)
@@ -129,12 +541,15 @@ bool Animation::BeginLoad(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
 
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UAN2")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
     }
 
+    bool hasCompressedTracks = (fileID == "UAN2");
+
     // Read name and length
     animationName_ = source.ReadString();
     animationNameHash_ = animationName_;
@@ -150,6 +565,13 @@ bool Animation::BeginLoad(Deserializer& source)
         AnimationTrack* newTrack = CreateTrack(source.ReadString());
         newTrack->channelMask_ = AnimationChannelFlags(source.ReadUByte());
 
+        if (hasCompressedTracks && source.ReadBool())
+        {
+            ReadCompressedTrack(source, *newTrack);
+            memoryUse += newTrack->GetKeyFrameMemoryUse();
+            continue;
+        }
+
         unsigned keyFrames = source.ReadUInt();
         newTrack->keyFrames_.Resize(keyFrames);
         memoryUse += keyFrames * sizeof(AnimationKeyFrame);
@@ -228,8 +650,19 @@ bool Animation::BeginLoad(Deserializer& source)
 
 bool Animation::Save(Serializer& dest) const
 {
+    // Use the legacy format when there are no compressed tracks
+    bool hasCompressedTracks = false;
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        if (i->second_.IsCompressed())
+        {
+            hasCompressedTracks = true;
+            break;
+        }
+    }
+
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    dest.WriteFileID(hasCompressedTracks ? "UAN2" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
@@ -240,6 +673,17 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = i->second_;
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
+
+        if (hasCompressedTracks)
+        {
+            dest.WriteBool(track.IsCompressed());
+            if (track.IsCompressed())
+            {
+                WriteCompressedTrack(dest, track);
+                continue;
+            }
+        }
+
         dest.WriteUInt(track.keyFrames_.Size());
 
         // Write keyframes of the track
@@ -371,6 +815,23 @@ void Animation::SetNumTriggers(unsigned num)
     triggers_.Resize(num);
 }
 
+void Animation::Compress(float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    unsigned oldKeyFrameMemoryUse = 0;
+    unsigned newKeyFrameMemoryUse = 0;
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        AnimationTrack& track = i->second_;
+        oldKeyFrameMemoryUse += track.GetKeyFrameMemoryUse();
+        track.Compress(positionTolerance, rotationTolerance, scaleTolerance);
+        newKeyFrameMemoryUse += track.GetKeyFrameMemoryUse();
+    }
+
+    // Memory use is not tracked for dynamically created keyframes, so only update it when it includes the old keyframes
+    if (GetMemoryUse() >= oldKeyFrameMemoryUse)
+        SetMemoryUse(GetMemoryUse() - oldKeyFrameMemoryUse + newKeyFrameMemoryUse);
+}
+
 SharedPtr<Animation> Animation::Clone(const String& cloneName) const
 {
     SharedPtr<Animation> ret(new Animation(context_));
@@ -83,13 +83,26 @@ struct URHO3D_API AnimationTrack
     /// Remove all keyframes.
     void RemoveAllKeyFrames();
 
-    /// Return keyframe at index, or null if not found.
+    /// Compress the keyframes. Channels that stay within the tolerances are stored as constants, keyframes that can be interpolated from their neighbours are removed and the rest are quantized. Rotation tolerance is in degrees. The uncompressed keyframes are cleared.
+    void Compress(float positionTolerance, float rotationTolerance, float scaleTolerance);
+    /// Convert compressed data back to uncompressed keyframes.
+    void Decompress();
+
+    /// Return keyframe at index, or null if not found. Compressed keyframes can not be accessed.
     AnimationKeyFrame* GetKeyFrame(unsigned index);
-    /// Return number of keyframes.
+    /// Return number of uncompressed keyframes.
     /// @property
     unsigned GetNumKeyFrames() const { return keyFrames_.Size(); }
+    /// Return number of compressed keyframes.
+    unsigned GetNumCompressedKeyFrames() const { return compressedTimes_.Size(); }
+    /// Return whether the track is compressed.
+    bool IsCompressed() const { return !compressedTimes_.Empty(); }
     /// Return keyframe index based on time and previous index. Return false if animation is empty.
     bool GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Sample the included channels at time, using and updating the previous keyframe index. Return false if animation is empty.
+    bool Sample(float time, float length, bool looped, unsigned& index, Vector3& position, Quaternion& rotation, Vector3& scale) const;
+    /// Return memory use in bytes of the keyframe data.
+    unsigned GetKeyFrameMemoryUse() const;
 
     /// Bone or scene node name.
     String name_;
@@ -99,6 +112,24 @@ struct URHO3D_API AnimationTrack
     AnimationChannelFlags channelMask_{};
     /// Keyframes.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Compressed keyframe times. Empty if the track is not compressed.
+    PODVector<float> compressedTimes_;
+    /// Compressed positions, 3 components per keyframe quantized to 16 bits within the position range. Empty if constant.
+    PODVector<unsigned short> compressedPositions_;
+    /// Compressed rotations, quantized to 48 bits per keyframe by storing the three smallest components. Empty if constant.
+    PODVector<unsigned short> compressedRotations_;
+    /// Compressed scales, 3 components per keyframe quantized to 16 bits within the scale range. Empty if constant.
+    PODVector<unsigned short> compressedScales_;
+    /// Minimum of the compressed positions, or the constant position.
+    Vector3 positionMin_;
+    /// Range of the compressed positions.
+    Vector3 positionRange_;
+    /// Constant rotation of a compressed track.
+    Quaternion constantRotation_;
+    /// Minimum of the compressed scales, or the constant scale.
+    Vector3 scaleMin_;
+    /// Range of the compressed scales.
+    Vector3 scaleRange_;
 };
 
 /// %Animation trigger point.
@@ -163,6 +194,8 @@ public:
     void SetNumTriggers(unsigned num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const String& cloneName = String::EMPTY) const;
+    /// Compress all tracks. Rotation tolerance is in degrees. This is unsafe if the animation is currently used in playback.
+    void Compress(float positionTolerance = 0.001f, float rotationTolerance = 0.05f, float scaleTolerance = 0.001f);
 
     /// Return animation name.
     /// @property
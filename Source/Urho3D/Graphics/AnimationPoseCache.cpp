@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/AnimationPoseCache.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+SharedPtr<AnimationPose> AnimationPoseCache::GetPose(const AnimationPoseKey& key, unsigned frameNumber, bool& created)
+{
+    MutexLock lock(mutex_);
+
+    HashMap<AnimationPoseKey, SharedPtr<AnimationPose> >::Iterator i = poses_.Find(key);
+    if (i != poses_.End())
+    {
+        i->second_->lastUsedFrame_ = frameNumber;
+        created = false;
+        return i->second_;
+    }
+
+    // Acquire the new pose's mutex before it becomes visible to other threads, so that they wait for the evaluation
+    SharedPtr<AnimationPose> pose(new AnimationPose());
+    pose->lastUsedFrame_ = frameNumber;
+    pose->mutex_.Acquire();
+    poses_[key] = pose;
+    created = true;
+    return pose;
+}
+
+void AnimationPoseCache::RemoveUnused(unsigned frameNumber)
+{
+    MutexLock lock(mutex_);
+
+    for (HashMap<AnimationPoseKey, SharedPtr<AnimationPose> >::Iterator i = poses_.Begin(); i != poses_.End();)
+    {
+        if (i->second_->lastUsedFrame_ < frameNumber)
+            i = poses_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/Ptr.h"
+#include "../Core/Mutex.h"
+#include "../Math/BoundingBox.h"
+#include "../Math/Matrix3x4.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Key of a shared animation pose, consisting of the model and the inputs of all enabled animation states.
+struct AnimationPoseKey
+{
+    /// Append a value to the key.
+    void Add(unsigned value)
+    {
+        data_.Push(value);
+        hash_ = hash_ * 31 + value;
+    }
+
+    /// Append a pointer to the key.
+    void Add(const void* ptr)
+    {
+        auto value = (unsigned long long)(size_t)ptr;
+        Add((unsigned)value);
+        Add((unsigned)(value >> 32u));
+    }
+
+    /// Test for equality with another key.
+    bool operator ==(const AnimationPoseKey& rhs) const
+    {
+        return hash_ == rhs.hash_ && data_.Size() == rhs.data_.Size() &&
+            !memcmp(data_.Buffer(), rhs.data_.Buffer(), data_.Size() * sizeof(unsigned));
+    }
+
+    /// Return hash value.
+    unsigned ToHash() const { return hash_; }
+
+    /// Key data.
+    PODVector<unsigned> data_;
+    /// Hash value.
+    unsigned hash_{};
+};
+
+/// Animation pose evaluated once and shared by all animated models with the same key.
+struct AnimationPose : public RefCounted
+{
+    /// Mutex held by the evaluating model until the pose is ready.
+    Mutex mutex_;
+    /// Bone transforms relative to the model's scene node.
+    PODVector<Matrix3x4> boneModelTransforms_;
+    /// Bounding box calculated from the bones.
+    BoundingBox boneBoundingBox_;
+    /// Frame number the pose was last used on.
+    unsigned lastUsedFrame_{};
+};
+
+/// Cache of animation poses shared between animated models that play the same animations at the same quantized time, for example crowd characters. Thread-safe.
+class URHO3D_API AnimationPoseCache
+{
+public:
+    /// Return the pose for a key and mark it used on the frame. If the pose did not exist, it is created with its mutex acquired and the caller must evaluate the pose and then release the mutex.
+    SharedPtr<AnimationPose> GetPose(const AnimationPoseKey& key, unsigned frameNumber, bool& created);
+    /// Remove poses that were not used on the frame or after it.
+    void RemoveUnused(unsigned frameNumber);
+
+    /// Return number of cached poses.
+    unsigned GetNumPoses() const { return poses_.Size(); }
+
+private:
+    /// Cached poses.
+    HashMap<AnimationPoseKey, SharedPtr<AnimationPose> > poses_;
+    /// Mutex for accessing the cache from worker threads.
+    Mutex mutex_;
+};
+
+}
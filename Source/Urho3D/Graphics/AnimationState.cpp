@@ -36,6 +36,7 @@ namespace Urho3D
 AnimationStateTrack::AnimationStateTrack() :
     track_(nullptr),
     bone_(nullptr),
+    boneIndex_(M_MAX_UNSIGNED),
     weight_(1.0f),
     keyFrame_(0)
 {
@@ -43,6 +44,63 @@ AnimationStateTrack::AnimationStateTrack() :
 
 AnimationStateTrack::~AnimationStateTrack() = default;
 
+/// Return whether a bone is the start bone or its descendant in the skeleton hierarchy.
+static bool IsInBoneHierarchy(const Skeleton& skeleton, unsigned boneIndex, unsigned startBoneIndex)
+{
+    const Vector<Bone>& bones = skeleton.GetBones();
+    // Limit the walk to the bone count in case of a malformed hierarchy
+    for (unsigned i = 0; i < bones.Size() && boneIndex < bones.Size(); ++i)
+    {
+        if (boneIndex == startBoneIndex)
+            return true;
+        unsigned parentIndex = bones[boneIndex].parentIndex_;
+        if (parentIndex == boneIndex)
+            return false;
+        boneIndex = parentIndex;
+    }
+
+    return false;
+}
+
+/// Blend a sampled track transform with the current bone transform according to the blending mode and weight.
+static void BlendTrack(AnimationBlendMode blendingMode, const Bone* bone, AnimationChannelFlags channelMask, float weight,
+    const Vector3& position, const Quaternion& rotation, const Vector3& scale, Vector3& newPosition, Quaternion& newRotation,
+    Vector3& newScale)
+{
+    if (blendingMode == ABM_ADDITIVE) // not ABM_LERP
+    {
+        if (channelMask & CHANNEL_POSITION)
+        {
+            Vector3 delta = newPosition - bone->initialPosition_;
+            newPosition = position + delta * weight;
+        }
+        if (channelMask & CHANNEL_ROTATION)
+        {
+            Quaternion delta = newRotation * bone->initialRotation_.Inverse();
+            newRotation = (delta * rotation).Normalized();
+            if (!Equals(weight, 1.0f))
+                newRotation = rotation.Slerp(newRotation, weight);
+        }
+        if (channelMask & CHANNEL_SCALE)
+        {
+            Vector3 delta = newScale - bone->initialScale_;
+            newScale = scale + delta * weight;
+        }
+    }
+    else
+    {
+        if (!Equals(weight, 1.0f)) // not full weight
+        {
+            if (channelMask & CHANNEL_POSITION)
+                newPosition = position.Lerp(newPosition, weight);
+            if (channelMask & CHANNEL_ROTATION)
+                newRotation = rotation.Slerp(newRotation, weight);
+            if (channelMask & CHANNEL_SCALE)
+                newScale = scale.Lerp(newScale, weight);
+        }
+    }
+}
+
 AnimationState::AnimationState(AnimatedModel* model, Animation* animation) :
     model_(model),
     animation_(animation),
@@ -125,9 +183,13 @@ void AnimationState::SetStartBone(Bone* startBone)
     const HashMap<StringHash, AnimationTrack>& tracks = animation_->GetTracks();
     stateTracks_.Clear();
 
-    if (!startBone->node_)
+    // In lightweight skeleton mode the tracks are applied to the model's pose buffers instead of bone nodes
+    bool lightweight = model_->GetLightweightSkeleton();
+    if (!startBone->node_ && !lightweight)
         return;
 
+    unsigned startBoneIndex = skeleton.GetBoneIndex(startBone);
+
     for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks.Begin(); i != tracks.End(); ++i)
     {
         AnimationStateTrack stateTrack;
@@ -139,6 +201,12 @@ void AnimationState::SetStartBone(Bone* startBone)
 
         if (nameHash == startBone->nameHash_)
             trackBone = startBone;
+        else if (lightweight)
+        {
+            Bone* bone = skeleton.GetBone(nameHash);
+            if (bone && IsInBoneHierarchy(skeleton, skeleton.GetBoneIndex(bone), startBoneIndex))
+                trackBone = bone;
+        }
         else
         {
             Node* trackBoneNode = startBone->node_->GetChild(nameHash, true);
@@ -146,10 +214,12 @@ void AnimationState::SetStartBone(Bone* startBone)
                 trackBone = skeleton.GetBone(nameHash);
         }
 
-        if (trackBone && trackBone->node_)
+        if (trackBone && (trackBone->node_ || lightweight))
         {
             stateTrack.bone_ = trackBone;
-            stateTrack.node_ = trackBone->node_;
+            stateTrack.boneIndex_ = skeleton.GetBoneIndex(trackBone);
+            if (!lightweight)
+                stateTrack.node_ = trackBone->node_;
             stateTracks_.Push(stateTrack);
         }
     }
@@ -219,7 +289,21 @@ void AnimationState::SetBoneWeight(unsigned index, float weight, bool recursive)
     if (recursive)
     {
         Node* boneNode = stateTracks_[index].node_;
-        if (boneNode)
+        // Without a bone node, find the child bones from the skeleton
+        if (!boneNode && stateTracks_[index].boneIndex_ != M_MAX_UNSIGNED && model_)
+        {
+            unsigned boneIndex = stateTracks_[index].boneIndex_;
+            const Vector<Bone>& bones = model_->GetSkeleton().GetBones();
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                if (i == boneIndex || bones[i].parentIndex_ != boneIndex)
+                    continue;
+                unsigned childTrackIndex = GetTrackIndex(bones[i].nameHash_);
+                if (childTrackIndex != M_MAX_UNSIGNED)
+                    SetBoneWeight(childTrackIndex, weight, true);
+            }
+        }
+        else if (boneNode)
         {
             const Vector<SharedPtr<Node> >& children = boneNode->GetChildren();
             for (unsigned i = 0; i < children.Size(); ++i)
@@ -405,8 +489,8 @@ unsigned AnimationState::GetTrackIndex(const String& name) const
 {
     for (unsigned i = 0; i < stateTracks_.Size(); ++i)
     {
-        Node* node = stateTracks_[i].node_;
-        if (node && node->GetName() == name)
+        const AnimationStateTrack& stateTrack = stateTracks_[i];
+        if (stateTrack.node_ ? stateTrack.node_->GetName() == name : stateTrack.bone_ && stateTrack.bone_->name_ == name)
             return i;
     }
 
@@ -428,8 +512,8 @@ unsigned AnimationState::GetTrackIndex(StringHash nameHash) const
 {
     for (unsigned i = 0; i < stateTracks_.Size(); ++i)
     {
-        Node* node = stateTracks_[i].node_;
-        if (node && node->GetNameHash() == nameHash)
+        const AnimationStateTrack& stateTrack = stateTracks_[i];
+        if (stateTrack.node_ ? stateTrack.node_->GetNameHash() == nameHash : stateTrack.bone_ && stateTrack.bone_->nameHash_ == nameHash)
             return i;
     }
 
@@ -454,6 +538,12 @@ void AnimationState::Apply()
 
 void AnimationState::ApplyToModel()
 {
+    if (model_->GetLightweightSkeleton() && blendingMode_ == ABM_LERP)
+    {
+        ApplyToPose();
+        return;
+    }
+
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
     {
         AnimationStateTrack& stateTrack = *i;
@@ -467,6 +557,67 @@ void AnimationState::ApplyToModel()
     }
 }
 
+void AnimationState::ApplyToPose()
+{
+    AnimatedModel* model = model_;
+    PODVector<Vector3>& positions = model->bonePositions_;
+    PODVector<Quaternion>& rotations = model->boneRotations_;
+    PODVector<Vector3>& scales = model->boneScales_;
+    PODVector<Quaternion>& blendRotations = model->blendRotations_;
+    PODVector<Quaternion>& blendTargetRotations = model->blendTargetRotations_;
+    PODVector<float>& blendWeights = model->blendWeights_;
+    PODVector<unsigned>& blendBoneIndices = model->blendBoneIndices_;
+    blendRotations.Clear();
+    blendTargetRotations.Clear();
+    blendWeights.Clear();
+    blendBoneIndices.Clear();
+
+    float length = animation_->GetLength();
+
+    for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
+    {
+        AnimationStateTrack& stateTrack = *i;
+        float finalWeight = weight_ * stateTrack.weight_;
+        unsigned index = stateTrack.boneIndex_;
+
+        // Do not apply if zero effective weight or the bone has animation disabled
+        if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_ || index >= positions.Size())
+            continue;
+
+        // Channels not included in the track keep their current values, so blending leaves them unchanged
+        Vector3 newPosition = positions[index];
+        Quaternion newRotation = rotations[index];
+        Vector3 newScale = scales[index];
+        if (!stateTrack.track_->Sample(time_, length, looped_, stateTrack.keyFrame_, newPosition, newRotation, newScale))
+            continue;
+
+        if (Equals(finalWeight, 1.0f))
+        {
+            positions[index] = newPosition;
+            rotations[index] = newRotation;
+            scales[index] = newScale;
+            continue;
+        }
+
+        positions[index] = positions[index].Lerp(newPosition, finalWeight);
+        scales[index] = scales[index].Lerp(newScale, finalWeight);
+        if (stateTrack.track_->channelMask_ & CHANNEL_ROTATION)
+        {
+            blendRotations.Push(rotations[index]);
+            blendTargetRotations.Push(newRotation);
+            blendWeights.Push(finalWeight);
+            blendBoneIndices.Push(index);
+        }
+    }
+
+    if (blendRotations.Empty())
+        return;
+
+    BlendRotations(&blendRotations[0], &blendTargetRotations[0], &blendWeights[0], blendRotations.Size());
+    for (unsigned i = 0; i < blendRotations.Size(); ++i)
+        rotations[blendBoneIndices[i]] = blendRotations[i];
+}
+
 void AnimationState::ApplyToNodes()
 {
     // When applying to a node hierarchy, can only use full weight (nothing to blend to)
@@ -478,91 +629,43 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
 {
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
-
-    if (track->keyFrames_.Empty() || !node)
-        return;
-
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
+    // Without a bone node, apply to the model's pose buffers in lightweight skeleton mode. Otherwise the node has expired,
+    // or the bone index is left from a start bone set in node mode, and the track is skipped
+    AnimatedModel* poseModel = nullptr;
+    if (!node)
     {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
+        AnimatedModel* model = model_.Get();
+        if (!model || !model->GetLightweightSkeleton() || stateTrack.boneIndex_ >= model->bonePositions_.Size())
+            return;
+        poseModel = model;
     }
 
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    const AnimationChannelFlags channelMask = track->channelMask_;
-
     Vector3 newPosition;
     Quaternion newRotation;
     Vector3 newScale;
+    if (!track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, newPosition, newRotation, newScale))
+        return;
 
-    if (interpolate)
-    {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
+    const AnimationChannelFlags channelMask = track->channelMask_;
 
-        if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
-        if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
-        if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
-    }
-    else
+    if (poseModel)
     {
+        unsigned index = stateTrack.boneIndex_;
+        Vector3& position = poseModel->bonePositions_[index];
+        Quaternion& rotation = poseModel->boneRotations_[index];
+        Vector3& scale = poseModel->boneScales_[index];
+        BlendTrack(blendingMode_, stateTrack.bone_, channelMask, weight, position, rotation, scale, newPosition, newRotation, newScale);
         if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_;
+            position = newPosition;
         if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_;
+            rotation = newRotation;
         if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_;
+            scale = newScale;
+        return;
     }
 
-    if (blendingMode_ == ABM_ADDITIVE) // not ABM_LERP
-    {
-        if (channelMask & CHANNEL_POSITION)
-        {
-            Vector3 delta = newPosition - stateTrack.bone_->initialPosition_;
-            newPosition = node->GetPosition() + delta * weight;
-        }
-        if (channelMask & CHANNEL_ROTATION)
-        {
-            Quaternion delta = newRotation * stateTrack.bone_->initialRotation_.Inverse();
-            newRotation = (delta * node->GetRotation()).Normalized();
-            if (!Equals(weight, 1.0f))
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
-        }
-        if (channelMask & CHANNEL_SCALE)
-        {
-            Vector3 delta = newScale - stateTrack.bone_->initialScale_;
-            newScale = node->GetScale() + delta * weight;
-        }
-    }
-    else
-    {
-        if (!Equals(weight, 1.0f)) // not full weight
-        {
-            if (channelMask & CHANNEL_POSITION)
-                newPosition = node->GetPosition().Lerp(newPosition, weight);
-            if (channelMask & CHANNEL_ROTATION)
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
-            if (channelMask & CHANNEL_SCALE)
-                newScale = node->GetScale().Lerp(newScale, weight);
-        }
-    }
+    BlendTrack(blendingMode_, stateTrack.bone_, channelMask, weight, node->GetPosition(), node->GetRotation(), node->GetScale(), newPosition,
+        newRotation, newScale);
 
     if (silent)
     {
@@ -61,6 +61,8 @@ struct AnimationStateTrack
     Bone* bone_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
+    /// Bone index in the model's skeleton. Used to apply the track to the model's pose buffers when the bone has no scene node.
+    unsigned boneIndex_;
     /// Blending weight.
     float weight_;
     /// Last key frame.
@@ -70,6 +72,8 @@ struct AnimationStateTrack
 /// %Animation instance.
 class URHO3D_API AnimationState : public RefCounted
 {
+    friend class AnimatedModel;
+
 public:
     /// Construct with animated model and animation pointers.
     AnimationState(AnimatedModel* model, Animation* animation);
@@ -168,6 +172,8 @@ public:
 private:
     /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
     void ApplyToModel();
+    /// Apply animation to the model's pose buffers in lightweight skeleton mode. Samples all tracks first, then blends the rotations as a batch.
+    void ApplyToPose();
     /// Apply animation to a scene node hierarchy.
     void ApplyToNodes();
     /// Apply track.
@@ -40,44 +40,119 @@
 namespace Urho3D
 {
 
-inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
+/// Non-base pass flag in the state sorting key.
+static const unsigned long long SORTKEY_NONBASE_FLAG = 1ULL << 63u;
+/// Bit offsets of the state sorting key fields.
+static const unsigned sortKeyFieldShifts[] = {51, 39, 29, 15, 0};
+/// Bit widths of the state sorting key fields. IDs wider than the field wrap around, which only affects sorting efficiency.
+static const unsigned sortKeyFieldBits[] = {12, 12, 10, 14, 15};
+/// Bit offset of the render order in the remapped sorting key.
+static const unsigned REMAPPED_RENDERORDER_SHIFT = 56;
+/// Bit offset of the non-base pass flag in the remapped sorting key.
+static const unsigned REMAPPED_NONBASE_SHIFT = 55;
+/// Bit offsets of the fields in the remapped sorting key.
+static const unsigned remappedFieldShifts[] = {46, 37, 28, 15, 0};
+/// Bit widths of the fields in the remapped sorting key. Remapped values saturate at the maximum.
+static const unsigned remappedFieldBits[] = {9, 9, 9, 13, 15};
+/// Remapping table value for a field value that has not been seen yet.
+static const unsigned short NO_REMAPPING = 0xffff;
+/// Below this size radix sort is not worth its histogram setup, so sort by insertion instead.
+static const unsigned MIN_RADIX_SORT_ITEMS = 16;
+
+inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->sortKey_ != rhs->sortKey_)
-        return lhs->sortKey_ < rhs->sortKey_;
-    else
-        return lhs->distance_ < rhs->distance_;
+    return lhs.distance_ < rhs.distance_;
 }
 
-inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+/// Convert a float to an unsigned integer that sorts in the same order.
+inline unsigned FloatToSortKey(float value)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ < rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    unsigned bits;
+    memcpy(&bits, &value, sizeof bits);
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
 }
 
-inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+/// Return a field of a state sorting key.
+inline unsigned GetSortKeyField(unsigned long long sortKey, unsigned field)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    return (unsigned)(sortKey >> sortKeyFieldShifts[field]) & ((1u << sortKeyFieldBits[field]) - 1);
 }
 
-inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
+/// Remap a state sorting key field value to its order of first appearance.
+inline unsigned RemapSortKeyField(PODVector<unsigned short>& remapping, unsigned value, unsigned& freeValue, unsigned maxValue)
 {
-    return lhs.distance_ < rhs.distance_;
+    if (value >= remapping.Size())
+    {
+        unsigned oldSize = remapping.Size();
+        remapping.Resize(value + 1);
+        for (unsigned i = oldSize; i <= value; ++i)
+            remapping[i] = NO_REMAPPING;
+    }
+
+    unsigned short& remapped = remapping[value];
+    if (remapped == NO_REMAPPING)
+        remapped = (unsigned short)Min(freeValue++, maxValue);
+    return remapped;
 }
 
-inline bool CompareBatchGroupOrder(BatchGroup* lhs, BatchGroup* rhs)
+/// Sort items by their keys. The sort is stable, so several sorts can be chained from the least significant key to the most significant.
+static void RadixSort(PODVector<BatchSortItem>& items, PODVector<BatchSortItem>& temp, unsigned keyBytes)
 {
-    return lhs->renderOrder_ < rhs->renderOrder_;
+    unsigned numItems = items.Size();
+    BatchSortItem* src = items.Buffer();
+
+    if (numItems < MIN_RADIX_SORT_ITEMS)
+    {
+        for (unsigned i = 1; i < numItems; ++i)
+        {
+            BatchSortItem item = src[i];
+            unsigned j = i;
+            for (; j > 0 && src[j - 1].key_ > item.key_; --j)
+                src[j] = src[j - 1];
+            src[j] = item;
+        }
+        return;
+    }
+
+    // Count digit occurrences for all passes at once
+    unsigned counts[8][256];
+    memset(counts, 0, keyBytes * sizeof counts[0]);
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        unsigned long long key = src[i].key_;
+        for (unsigned j = 0; j < keyBytes; ++j)
+            ++counts[j][(key >> (j * 8)) & 0xffu];
+    }
+
+    temp.Resize(numItems);
+    BatchSortItem* dest = temp.Buffer();
+    bool swapped = false;
+
+    for (unsigned j = 0; j < keyBytes; ++j)
+    {
+        unsigned shift = j * 8;
+        unsigned* digitCounts = counts[j];
+        // Skip the pass if all keys have the same digit
+        if (digitCounts[(src[0].key_ >> shift) & 0xffu] == numItems)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned k = 0; k < 256; ++k)
+        {
+            unsigned count = digitCounts[k];
+            digitCounts[k] = offset;
+            offset += count;
+        }
+
+        for (unsigned i = 0; i < numItems; ++i)
+            dest[digitCounts[(src[i].key_ >> shift) & 0xffu]++] = src[i];
+
+        Swap(src, dest);
+        swapped = !swapped;
+    }
+
+    if (swapped)
+        items.Swap(temp);
 }
 
 void CalculateShadowMatrix(Matrix4& dest, LightBatchQueue* queue, unsigned split, Renderer* renderer)
@@ -161,18 +236,16 @@ void CalculateSpotMatrix(Matrix4& dest, Light* light)
 
 void Batch::CalculateSortKey()
 {
-    auto shaderID = (unsigned)(
-        ((*((unsigned*)&vertexShader_) / sizeof(ShaderVariation)) + (*((unsigned*)&pixelShader_) / sizeof(ShaderVariation))) &
-        0x7fffu);
-    if (!isBase_)
-        shaderID |= 0x8000;
-
-    auto lightQueueID = (unsigned)((*((unsigned*)&lightQueue_) / sizeof(LightBatchQueue)) & 0xffffu);
-    auto materialID = (unsigned)((*((unsigned*)&material_) / sizeof(Material)) & 0xffffu);
-    auto geometryID = (unsigned)((*((unsigned*)&geometry_) / sizeof(Geometry)) & 0xffffu);
-
-    sortKey_ = (((unsigned long long)shaderID) << 48u) | (((unsigned long long)lightQueueID) << 32u) |
-               (((unsigned long long)materialID) << 16u) | geometryID;
+    unsigned ids[MAX_SORTKEY_FIELDS];
+    ids[SORTKEY_VERTEXSHADER] = vertexShader_ ? vertexShader_->GetSortID() : 0;
+    ids[SORTKEY_PIXELSHADER] = pixelShader_ ? pixelShader_->GetSortID() : 0;
+    ids[SORTKEY_LIGHTQUEUE] = lightQueue_ ? lightQueue_->sortID_ : 0;
+    ids[SORTKEY_MATERIAL] = material_ ? material_->GetSortID() : 0;
+    ids[SORTKEY_GEOMETRY] = geometry_ ? geometry_->GetSortID() : 0;
+
+    sortKey_ = isBase_ ? 0 : SORTKEY_NONBASE_FLAG;
+    for (unsigned i = 0; i < MAX_SORTKEY_FIELDS; ++i)
+        sortKey_ |= ((unsigned long long)(ids[i] & ((1u << sortKeyFieldBits[i]) - 1))) << sortKeyFieldShifts[i];
 }
 
 void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool allowDepthWrite) const
@@ -721,26 +794,62 @@ void BatchQueue::Clear(int maxSortedInstances)
 {
     batches_.Clear();
     sortedBatches_.Clear();
-    batchGroups_.Clear();
+    sortedBatchGroups_.Clear();
+    usedBatchGroups_.Clear();
+
+    // Keep the batch groups used on the last frame, but drop their instances
+    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End();)
+    {
+        if (i->second_.used_)
+        {
+            i->second_.instances_.Clear();
+            i->second_.used_ = false;
+            ++i;
+        }
+        else
+            i = batchGroups_.Erase(i);
+    }
+
     maxSortedInstances_ = (unsigned)maxSortedInstances;
 }
 
 void BatchQueue::SortBackToFront()
 {
-    sortedBatches_.Resize(batches_.Size());
+    unsigned numBatches = batches_.Size();
+    sortItems_.Resize(numBatches);
+    sortedBatches_.Resize(numBatches);
 
-    for (unsigned i = 0; i < batches_.Size(); ++i)
-        sortedBatches_[i] = &batches_[i];
+    // Sort by state first, then stably by render order and decreasing distance, so that state breaks distance ties
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        sortItems_[i].key_ = batches_[i].sortKey_;
+        sortItems_[i].batch_ = &batches_[i];
+    }
+    RadixSort(sortItems_, sortItemsTemp_, 8);
 
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch* batch = sortItems_[i].batch_;
+        sortItems_[i].key_ = ((unsigned long long)batch->renderOrder_ << 32u) | (~FloatToSortKey(batch->distance_));
+    }
+    RadixSort(sortItems_, sortItemsTemp_, 5);
 
-    sortedBatchGroups_.Resize(batchGroups_.Size());
+    for (unsigned i = 0; i < numBatches; ++i)
+        sortedBatches_[i] = sortItems_[i].batch_;
 
-    unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        sortedBatchGroups_[index++] = &i->second_;
+    unsigned numBatchGroups = usedBatchGroups_.Size();
+    sortItems_.Resize(numBatchGroups);
+    sortedBatchGroups_.Resize(numBatchGroups);
 
-    Sort(sortedBatchGroups_.Begin(), sortedBatchGroups_.End(), CompareBatchGroupOrder);
+    for (unsigned i = 0; i < numBatchGroups; ++i)
+    {
+        sortItems_[i].key_ = usedBatchGroups_[i]->renderOrder_;
+        sortItems_[i].batch_ = usedBatchGroups_[i];
+    }
+    RadixSort(sortItems_, sortItemsTemp_, 1);
+
+    for (unsigned i = 0; i < sortItems_.Size(); ++i)
+        sortedBatchGroups_[i] = static_cast<BatchGroup*>(sortItems_[i].batch_);
 }
 
 void BatchQueue::SortFrontToBack()
@@ -753,96 +862,79 @@ void BatchQueue::SortFrontToBack()
     SortFrontToBack2Pass(sortedBatches_);
 
     // Sort each group front to back
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (PODVector<BatchGroup*>::Iterator i = usedBatchGroups_.Begin(); i != usedBatchGroups_.End(); ++i)
     {
-        if (i->second_.instances_.Size() <= maxSortedInstances_)
+        BatchGroup* group = *i;
+        if (group->instances_.Size() <= maxSortedInstances_)
         {
-            Sort(i->second_.instances_.Begin(), i->second_.instances_.End(), CompareInstancesFrontToBack);
-            if (i->second_.instances_.Size())
-                i->second_.distance_ = i->second_.instances_[0].distance_;
+            Sort(group->instances_.Begin(), group->instances_.End(), CompareInstancesFrontToBack);
+            if (group->instances_.Size())
+                group->distance_ = group->instances_[0].distance_;
         }
         else
         {
             float minDistance = M_INFINITY;
-            for (PODVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
+            for (PODVector<InstanceData>::ConstIterator j = group->instances_.Begin(); j != group->instances_.End(); ++j)
                 minDistance = Min(minDistance, j->distance_);
-            i->second_.distance_ = minDistance;
+            group->distance_ = minDistance;
         }
     }
 
-    sortedBatchGroups_.Resize(batchGroups_.Size());
-
-    unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        sortedBatchGroups_[index++] = &i->second_;
-
+    sortedBatchGroups_ = usedBatchGroups_;
     SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_));
 }
 
 void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
 {
-    // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
-    // method is also time consuming, so just sort with state having priority
-#ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
-#else
-    // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    unsigned numBatches = batches.Size();
+    sortItems_.Resize(numBatches);
 
-    unsigned freeShaderID = 0;
-    unsigned short freeMaterialID = 0;
-    unsigned short freeGeometryID = 0;
+    // First sort by render order and distance
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch* batch = batches[i];
+        sortItems_[i].key_ = ((unsigned long long)batch->renderOrder_ << 32u) | FloatToSortKey(batch->distance_);
+        sortItems_[i].batch_ = batch;
+    }
+    RadixSort(sortItems_, sortItemsTemp_, 5);
 
-    for (PODVector<Batch*>::Iterator i = batches.Begin(); i != batches.End(); ++i)
+    // Remap shader/light/material/geometry IDs in their order of first appearance, so that the closest states are drawn first.
+    // The remapped values are dense, which leaves room for the render order in the key
+    unsigned freeValues[MAX_SORTKEY_FIELDS] = {};
+    for (unsigned i = 0; i < numBatches; ++i)
     {
-        Batch* batch = *i;
+        Batch* batch = sortItems_[i].batch_;
+        unsigned long long key = ((unsigned long long)batch->renderOrder_ << REMAPPED_RENDERORDER_SHIFT) |
+            ((batch->sortKey_ >> 63u) << REMAPPED_NONBASE_SHIFT);
 
-        auto shaderID = (unsigned)(batch->sortKey_ >> 32u);
-        HashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
-        if (j != shaderRemapping_.End())
-            shaderID = j->second_;
-        else
+        for (unsigned j = 0; j < MAX_SORTKEY_FIELDS; ++j)
         {
-            shaderID = shaderRemapping_[shaderID] = freeShaderID | (shaderID & 0x80000000);
-            ++freeShaderID;
+            unsigned remapped = RemapSortKeyField(sortKeyRemapping_[j], GetSortKeyField(batch->sortKey_, j), freeValues[j],
+                (1u << remappedFieldBits[j]) - 1);
+            key |= (unsigned long long)remapped << remappedFieldShifts[j];
         }
 
-        auto materialID = (unsigned short)((batch->sortKey_ & 0xffff0000) >> 16u);
-        HashMap<unsigned short, unsigned short>::ConstIterator k = materialRemapping_.Find(materialID);
-        if (k != materialRemapping_.End())
-            materialID = k->second_;
-        else
-        {
-            materialID = materialRemapping_[materialID] = freeMaterialID;
-            ++freeMaterialID;
-        }
-
-        auto geometryID = (unsigned short)(batch->sortKey_ & 0xffffu);
-        HashMap<unsigned short, unsigned short>::ConstIterator l = geometryRemapping_.Find(geometryID);
-        if (l != geometryRemapping_.End())
-            geometryID = l->second_;
-        else
-        {
-            geometryID = geometryRemapping_[geometryID] = freeGeometryID;
-            ++freeGeometryID;
-        }
+        sortItems_[i].key_ = key;
+    }
 
-        batch->sortKey_ = (((unsigned long long)shaderID) << 32u) | (((unsigned long long)materialID) << 16u) | geometryID;
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        unsigned long long sortKey = sortItems_[i].batch_->sortKey_;
+        for (unsigned j = 0; j < MAX_SORTKEY_FIELDS; ++j)
+            sortKeyRemapping_[j][GetSortKeyField(sortKey, j)] = NO_REMAPPING;
     }
 
-    shaderRemapping_.Clear();
-    materialRemapping_.Clear();
-    geometryRemapping_.Clear();
+    // Finally sort again with the remapped keys. The sort is stable, so distance breaks ties
+    RadixSort(sortItems_, sortItemsTemp_, 8);
 
-    // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
-#endif
+    for (unsigned i = 0; i < numBatches; ++i)
+        batches[i] = sortItems_[i].batch_;
 }
 
 void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
 {
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        i->second_.SetInstancingData(lockedData, stride, freeIndex);
+    for (PODVector<BatchGroup*>::Iterator i = usedBatchGroups_.Begin(); i != usedBatchGroups_.End(); ++i)
+        (*i)->SetInstancingData(lockedData, stride, freeIndex);
 }
 
 void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const
@@ -892,10 +984,10 @@ unsigned BatchQueue::GetNumInstances() const
 {
     unsigned total = 0;
 
-    for (HashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (PODVector<BatchGroup*>::ConstIterator i = usedBatchGroups_.Begin(); i != usedBatchGroups_.End(); ++i)
     {
-        if (i->second_.geometryType_ == GEOM_INSTANCED)
-            total += i->second_.instances_.Size();
+        if ((*i)->geometryType_ == GEOM_INSTANCED)
+            total += (*i)->instances_.Size();
     }
 
     return total;
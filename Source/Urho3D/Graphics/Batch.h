@@ -67,7 +67,7 @@ struct Batch
     {
     }
 
-    /// Calculate state sorting key, which consists of base pass flag, light, pass and geometry.
+    /// Calculate state sorting key, which consists of base pass flag, shaders, light, material and geometry.
     void CalculateSortKey();
     /// Prepare for rendering.
     void Prepare(View* view, Camera* camera, bool setModelTransform, bool allowDepthWrite) const;
@@ -108,6 +108,15 @@ struct Batch
     GeometryType geometryType_{};
 };
 
+/// Batch with its key for radix sorting.
+struct BatchSortItem
+{
+    /// Sort key.
+    unsigned long long key_;
+    /// Batch.
+    Batch* batch_;
+};
+
 /// Data for one geometry instance.
 struct InstanceData
 {
@@ -149,6 +158,14 @@ struct BatchGroup : public Batch
     /// Destruct.
     ~BatchGroup() = default;
 
+    /// Reinitialize from the first batch on a frame. Instances added on the previous frame must have been cleared.
+    void Reset(const Batch& batch)
+    {
+        static_cast<Batch&>(*this) = batch;
+        startIndex_ = M_MAX_UNSIGNED;
+        used_ = true;
+    }
+
     /// Add world transform(s) from a batch.
     void AddTransforms(const Batch& batch)
     {
@@ -172,6 +189,8 @@ struct BatchGroup : public Batch
     PODVector<InstanceData> instances_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
+    /// Whether the group has received batches on the current frame.
+    bool used_{};
 };
 
 /// Instanced draw call grouping key.
@@ -222,6 +241,17 @@ struct BatchGroupKey
     unsigned ToHash() const;
 };
 
+/// State sorting key fields, which are remapped to their order of first appearance in the 2-pass state and distance sort.
+enum SortKeyField
+{
+    SORTKEY_VERTEXSHADER = 0,
+    SORTKEY_PIXELSHADER,
+    SORTKEY_LIGHTQUEUE,
+    SORTKEY_MATERIAL,
+    SORTKEY_GEOMETRY,
+    MAX_SORTKEY_FIELDS
+};
+
 /// Queue that contains both instanced and non-instanced draw calls.
 struct BatchQueue
 {
@@ -242,16 +272,18 @@ public:
     unsigned GetNumInstances() const;
 
     /// Return whether the batch group is empty.
-    bool IsEmpty() const { return batches_.Empty() && batchGroups_.Empty(); }
+    bool IsEmpty() const { return batches_.Empty() && usedBatchGroups_.Empty(); }
 
-    /// Instanced draw calls.
+    /// Instanced draw calls. Retained across frames to avoid reallocating them; groups unused for a frame are removed on the next clear.
     HashMap<BatchGroupKey, BatchGroup> batchGroups_;
-    /// Shader remapping table for 2-pass state and distance sort.
-    HashMap<unsigned, unsigned> shaderRemapping_;
-    /// Material remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> materialRemapping_;
-    /// Geometry remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> geometryRemapping_;
+    /// Instanced draw calls that have received batches on the current frame.
+    PODVector<BatchGroup*> usedBatchGroups_;
+    /// Sort key field remapping tables for 2-pass state and distance sort, indexed by field value.
+    PODVector<unsigned short> sortKeyRemapping_[MAX_SORTKEY_FIELDS];
+    /// Batches with their radix sort keys.
+    PODVector<BatchSortItem> sortItems_;
+    /// Radix sort scratch buffer.
+    PODVector<BatchSortItem> sortItemsTemp_;
 
     /// Unsorted non-instanced draw calls.
     PODVector<Batch> batches_;
@@ -295,6 +327,8 @@ struct LightBatchQueue
     Light* light_;
     /// Light negative flag.
     bool negative_;
+    /// ID for batch state sorting, unique within the view. Zero is reserved for batches without a light queue.
+    unsigned sortID_;
     /// Shadow map depth texture.
     Texture2D* shadowMap_;
     /// Lit geometry draw calls, base (replace blend mode).
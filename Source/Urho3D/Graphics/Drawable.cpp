@@ -250,6 +250,13 @@ void Drawable::MarkForUpdate()
         octant_->GetRoot()->QueueUpdate(this);
 }
 
+void Drawable::MarkWorldBoundingBoxDirty()
+{
+    worldBoundingBoxDirty_ = true;
+    if (octant_)
+        octant_->MarkDrawableBoundsDirty();
+}
+
 const BoundingBox& Drawable::GetWorldBoundingBox()
 {
     if (worldBoundingBoxDirty_)
@@ -373,7 +380,7 @@ void Drawable::OnSceneSet(Scene* scene)
 
 void Drawable::OnMarkedDirty(Node* node)
 {
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
     if (!updateQueued_ && octant_)
         octant_->GetRoot()->QueueUpdate(this);
 
@@ -113,7 +113,7 @@ class URHO3D_API Drawable : public Component
 
     friend class Octant;
     friend class Octree;
-    friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void UpdateDrawablesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux);
 
 public:
     /// Construct.
@@ -340,6 +340,8 @@ protected:
     void OnMarkedDirty(Node* node) override;
     /// Recalculate the world-space bounding box.
     virtual void OnWorldBoundingBoxUpdate() = 0;
+    /// Mark the world-space bounding box dirty when it changes without the node transform changing. Subclasses should use this instead of setting the dirty flag directly, so that the octant's batched query bounds are updated.
+    void MarkWorldBoundingBoxDirty();
 
     /// Handle removal from octree.
     virtual void OnRemoveFromOctree() { }
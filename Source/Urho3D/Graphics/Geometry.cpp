@@ -43,7 +43,8 @@ Geometry::Geometry(Context* context) :
     vertexCount_(0),
     rawVertexSize_(0),
     rawIndexSize_(0),
-    lodDistance_(0.0f)
+    lodDistance_(0.0f),
+    sortID_(SORTID_GEOMETRY)
 {
     SetNumVertexBuffers(1);
 }
@@ -25,6 +25,7 @@
 #include "../Container/ArrayPtr.h"
 #include "../Core/Object.h"
 #include "../Graphics/GraphicsDefs.h"
+#include "../Graphics/SortID.h"
 
 namespace Urho3D
 {
@@ -111,6 +112,8 @@ public:
 
     /// Return buffers' combined hash value for state sorting.
     unsigned short GetBufferHash() const;
+    /// Return ID for batch state sorting.
+    unsigned short GetSortID() const { return sortID_.Get(); }
     /// Return raw vertex and index data for CPU operations, or null pointers if not available. Will return data of the first vertex buffer if override data not set.
     void GetRawData(const unsigned char*& vertexData, unsigned& vertexSize, const unsigned char*& indexData, unsigned& indexSize, const PODVector<VertexElement>*& elements) const;
     /// Return raw vertex and index data for CPU operations, or null pointers if not available. Will return data of the first vertex buffer if override data not set.
@@ -152,6 +155,8 @@ private:
     unsigned rawVertexSize_;
     /// Raw index data override size.
     unsigned rawIndexSize_;
+    /// ID for batch state sorting.
+    SortID sortID_;
 };
 
 }
@@ -196,7 +196,8 @@ void ShaderParameterAnimationInfo::ApplyValue(const Variant& newValue)
 }
 
 Material::Material(Context* context) :
-    Resource(context)
+    Resource(context),
+    sortID_(SORTID_MATERIAL)
 {
     ResetToDefaults();
 }
@@ -24,6 +24,7 @@
 
 #include "../Graphics/GraphicsDefs.h"
 #include "../Graphics/Light.h"
+#include "../Graphics/SortID.h"
 #include "../Math/Vector4.h"
 #include "../Resource/Resource.h"
 #include "../Scene/ValueAnimationInfo.h"
@@ -270,6 +271,9 @@ public:
     /// @property
     unsigned char GetRenderOrder() const { return renderOrder_; }
 
+    /// Return ID for batch state sorting.
+    unsigned short GetSortID() const { return sortID_.Get(); }
+
     /// Return last auxiliary view rendered frame number.
     unsigned GetAuxViewFrameNumber() const { return auxViewFrameNumber_; }
 
@@ -357,6 +361,8 @@ private:
     SharedPtr<JSONFile> loadJSONFile_;
     /// Associated scene for shader parameter animation updates.
     WeakPtr<Scene> scene_;
+    /// ID for batch state sorting.
+    SortID sortID_;
 };
 
 }
@@ -45,21 +45,63 @@ namespace Urho3D
 
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
+static const unsigned MIN_DRAWABLE_UPDATES_PER_CHUNK = 4;
+static const unsigned MIN_DRAWABLE_REINSERTIONS_PER_CHUNK = 64;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
-void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
+/// %Drawable update work data.
+struct DrawableUpdateWorkData
 {
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
+    /// Frame info.
+    const FrameInfo* frame_;
+    /// Drawables to update.
+    Drawable** drawables_;
+};
 
-    while (start != end)
+void UpdateDrawablesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* data = reinterpret_cast<DrawableUpdateWorkData*>(aux);
+
+    for (unsigned i = start; i < end; ++i)
     {
-        Drawable* drawable = *start;
+        Drawable* drawable = data->drawables_[i];
         if (drawable)
-            drawable->Update(frame);
-        ++start;
+            drawable->Update(*data->frame_);
+    }
+}
+
+/// %Drawable reinsertion work data.
+struct DrawableReinsertWorkData
+{
+    /// Octree.
+    Octree* octree_;
+    /// Drawables to reinsert.
+    Drawable** drawables_;
+    /// Reinsertion targets to fill.
+    DrawableReinsertion* reinsertions_;
+};
+
+void FindReinsertOctantsWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* data = reinterpret_cast<DrawableReinsertWorkData*>(aux);
+
+    for (unsigned i = start; i < end; ++i)
+    {
+        Drawable* drawable = data->drawables_[i];
+        DrawableReinsertion& reinsertion = data->reinsertions_[i];
+        Octant* octant = reinsertion.oldOctant_;
+        const BoundingBox& box = reinsertion.box_;
+        reinsertion.octant_ = nullptr;
+
+        // Skip if no octant or does not belong to this octree anymore
+        if (!octant || octant->GetRoot() != data->octree_)
+            continue;
+        // Skip if still fits the current octant
+        if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            continue;
+
+        reinsertion.octant_ = data->octree_->FindInsertOctant(drawable, box);
     }
 }
 
@@ -88,8 +130,13 @@ Octant::~Octant()
             root_->drawables_.Push(*i);
             root_->QueueUpdate(*i);
         }
+        if (drawables_.Size())
+            root_->MarkDrawableBoundsDirty();
         drawables_.Clear();
         numDrawables_ = 0;
+
+        if (drawableBoundsDirty_)
+            root_->CancelDrawableBoundsUpdate(this);
     }
 
     for (unsigned i = 0; i < NUM_OCTANTS; ++i)
@@ -135,15 +182,7 @@ void Octant::InsertDrawable(Drawable* drawable)
 {
     const BoundingBox& box = drawable->GetWorldBoundingBox();
 
-    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
-    bool insertHere;
-    if (this == root_)
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
-    else
-        insertHere = CheckDrawableFit(box);
-
-    if (insertHere)
+    if (IsInsertTarget(drawable, box))
     {
         Octant* oldOctant = drawable->octant_;
         if (oldOctant != this)
@@ -155,14 +194,32 @@ void Octant::InsertDrawable(Drawable* drawable)
         }
     }
     else
-    {
-        Vector3 boxCenter = box.Center();
-        unsigned x = boxCenter.x_ < center_.x_ ? 0 : 1;
-        unsigned y = boxCenter.y_ < center_.y_ ? 0 : 2;
-        unsigned z = boxCenter.z_ < center_.z_ ? 0 : 4;
+        GetOrCreateChild(GetChildIndex(box))->InsertDrawable(drawable);
+}
 
-        GetOrCreateChild(x + y + z)->InsertDrawable(drawable);
+bool Octant::IsInsertTarget(Drawable* drawable, const BoundingBox& box) const
+{
+    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
+    // Also if drawable is outside the root octant bounds, insert to root
+    if (this == root_)
+        return !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
+    else
+        return CheckDrawableFit(box);
+}
+
+Octant* Octant::FindInsertOctant(Drawable* drawable, const BoundingBox& box)
+{
+    Octant* octant = this;
+
+    while (!octant->IsInsertTarget(drawable, box))
+    {
+        Octant* child = octant->children_[octant->GetChildIndex(box)];
+        if (!child)
+            break;
+        octant = child;
     }
+
+    return octant;
 }
 
 bool Octant::CheckDrawableFit(const BoundingBox& box) const
@@ -189,6 +246,37 @@ bool Octant::CheckDrawableFit(const BoundingBox& box) const
     return false;
 }
 
+void Octant::MarkDrawableBoundsDirty()
+{
+    // Check first without locking, as the octant is usually queued already
+    if (!drawableBoundsDirty_ && root_)
+        root_->QueueDrawableBoundsUpdate(this);
+}
+
+void Octant::UpdateDrawableBounds()
+{
+    unsigned numDrawables = drawables_.Size();
+    drawableBounds_.Resize((numDrawables + 3) / 4);
+    // Clear the unused lanes of the last block
+    if (numDrawables & 3u)
+        memset(&drawableBounds_.Back(), 0, sizeof(DrawableBoundsBlock));
+
+    for (unsigned i = 0; i < numDrawables; ++i)
+    {
+        const BoundingBox& box = drawables_[i]->GetWorldBoundingBox();
+        DrawableBoundsBlock& block = drawableBounds_[i >> 2u];
+        unsigned lane = i & 3u;
+        block.minX_[lane] = box.min_.x_;
+        block.minY_[lane] = box.min_.y_;
+        block.minZ_[lane] = box.min_.z_;
+        block.maxX_[lane] = box.max_.x_;
+        block.maxY_[lane] = box.max_.y_;
+        block.maxZ_[lane] = box.max_.z_;
+    }
+
+    drawableBoundsDirty_ = false;
+}
+
 void Octant::ResetRoot()
 {
     root_ = nullptr;
@@ -244,7 +332,11 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         auto** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        // Use the batched test when the bounds are up to date. Otherwise the drawables' own bounding boxes are needed
+        if (!drawableBoundsDirty_)
+            query.TestDrawableBlocks(start, end, &drawableBounds_[0], inside);
+        else
+            query.TestDrawables(start, end, inside);
     }
 
     for (auto child : children_)
@@ -369,8 +461,9 @@ void Octree::Update(const FrameInfo& frame)
         return;
     }
 
-    // Let drawables update themselves before reinsertion. This can be used for animation
-    if (!drawableUpdates_.Empty())
+    // Let drawables update themselves before reinsertion. This can be used for animation. Drawables may also have been queued
+    // during a threaded logic update
+    if (!drawableUpdates_.Empty() || !threadedDrawableUpdates_.Empty())
     {
         URHO3D_PROFILE(UpdateDrawables);
 
@@ -380,49 +473,31 @@ void Octree::Update(const FrameInfo& frame)
         auto* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
+        DrawableUpdateWorkData data;
+        data.frame_ = &frame;
+        data.drawables_ = drawableUpdates_.Buffer();
+        if (!drawableUpdates_.Empty())
+            queue->ParallelFor(drawableUpdates_.Size(), UpdateDrawablesWork, &data, MIN_DRAWABLE_UPDATES_PER_CHUNK);
 
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        // Drawables that were marked dirty during the update, for example objects attached to animated bones, are also
+        // updated in worker threads. Their updates may in turn queue more drawables. Each drawable is queued at most once
+        // per frame, so this terminates
+        while (!threadedDrawableUpdates_.Empty())
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
+            URHO3D_PROFILE(UpdateDrawablesQueuedDuringUpdate);
 
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
+            unsigned start = drawableUpdates_.Size();
+            drawableUpdates_.Push(threadedDrawableUpdates_);
+            threadedDrawableUpdates_.Clear();
 
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
+            data.drawables_ = drawableUpdates_.Buffer() + start;
+            queue->ParallelFor(drawableUpdates_.Size() - start, UpdateDrawablesWork, &data, MIN_DRAWABLE_UPDATES_PER_CHUNK);
         }
 
-        queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
-    }
-
-    // If any drawables were inserted during threaded update, update them now from the main thread
-    if (!threadedDrawableUpdates_.Empty())
-    {
-        URHO3D_PROFILE(UpdateDrawablesQueuedDuringUpdate);
-
-        for (PODVector<Drawable*>::ConstIterator i = threadedDrawableUpdates_.Begin(); i != threadedDrawableUpdates_.End(); ++i)
-        {
-            Drawable* drawable = *i;
-            if (drawable)
-            {
-                drawable->Update(frame);
-                drawableUpdates_.Push(drawable);
-            }
-        }
 
-        threadedDrawableUpdates_.Clear();
+        // Shared animation poses not used on this frame are unlikely to be needed again
+        animationPoseCache_.RemoveUnused(frame.frameNumber_);
     }
 
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
@@ -443,25 +518,52 @@ void Octree::Update(const FrameInfo& frame)
     {
         URHO3D_PROFILE(ReinsertToOctree);
 
-        for (PODVector<Drawable*>::Iterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+        unsigned numUpdates = drawableUpdates_.Size();
+        drawableReinsertions_.Resize(numUpdates);
+
+        // Refresh the world bounding boxes first in the main thread. Scene drawable update finished handlers may have dirtied
+        // node transforms, and recalculating them accesses shared parent nodes
+        for (unsigned i = 0; i < numUpdates; ++i)
         {
-            Drawable* drawable = *i;
+            Drawable* drawable = drawableUpdates_[i];
+            DrawableReinsertion& reinsertion = drawableReinsertions_[i];
+            reinsertion.oldOctant_ = drawable->GetOctant();
+            if (reinsertion.oldOctant_ && reinsertion.oldOctant_->GetRoot() == this)
+                reinsertion.box_ = drawable->GetWorldBoundingBox();
+        }
+
+        // Then find the new octants in worker threads, descending through the existing octants only
+
+        DrawableReinsertWorkData data;
+        data.octree_ = this;
+        data.drawables_ = drawableUpdates_.Buffer();
+        data.reinsertions_ = drawableReinsertions_.Buffer();
+        GetSubsystem<WorkQueue>()->ParallelFor(numUpdates, FindReinsertOctantsWork, &data, MIN_DRAWABLE_REINSERTIONS_PER_CHUNK);
+
+        // Finally apply the changes. Add the drawables to their new octants first and remove from the old octants only after that,
+        // because removal deletes octants that become empty, and those could still be insertion targets
+        for (unsigned i = 0; i < numUpdates; ++i)
+        {
+            Drawable* drawable = drawableUpdates_[i];
+            DrawableReinsertion& reinsertion = drawableReinsertions_[i];
             drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
 
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetRoot() != this)
-                continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            Octant* octant = reinsertion.octant_;
+            if (!octant)
                 continue;
 
-            InsertDrawable(drawable);
+            // Create the child octants that did not exist yet
+            const BoundingBox& box = reinsertion.box_;
+            while (!octant->IsInsertTarget(drawable, box))
+                octant = octant->GetOrCreateChild(octant->GetChildIndex(box));
+
+            if (octant != reinsertion.oldOctant_)
+                octant->AddDrawable(drawable);
+            else
+                reinsertion.octant_ = nullptr;
 
 #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
             if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
             {
                 URHO3D_LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
@@ -469,9 +571,31 @@ void Octree::Update(const FrameInfo& frame)
             }
 #endif
         }
+
+        for (unsigned i = 0; i < numUpdates; ++i)
+        {
+            const DrawableReinsertion& reinsertion = drawableReinsertions_[i];
+            if (reinsertion.octant_)
+                reinsertion.oldOctant_->RemoveDrawable(drawableUpdates_[i], false);
+        }
     }
 
     drawableUpdates_.Clear();
+
+    // Refresh the drawable bounds of the octants that changed, so that queries can use the batched tests
+    if (!drawableBoundsUpdates_.Empty())
+    {
+        URHO3D_PROFILE(UpdateDrawableBounds);
+
+        for (PODVector<Octant*>::Iterator i = drawableBoundsUpdates_.Begin(); i != drawableBoundsUpdates_.End(); ++i)
+        {
+            // Octants deleted after being queued have been nulled out
+            if (*i)
+                (*i)->UpdateDrawableBounds();
+        }
+
+        drawableBoundsUpdates_.Clear();
+    }
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -552,23 +676,49 @@ void Octree::QueueUpdate(Drawable* drawable)
     Scene* scene = GetScene();
     if (scene && scene->IsThreadedUpdate())
     {
+        // The caller's check of the queued flag is not synchronized, so several threads may get here for the same drawable.
+        // Check and set the flag again under the lock so that it is queued, and updated, only once
         MutexLock lock(octreeMutex_);
+        if (drawable->updateQueued_)
+            return;
         threadedDrawableUpdates_.Push(drawable);
+        drawable->updateQueued_ = true;
     }
-    else
+    else if (!drawable->updateQueued_)
+    {
         drawableUpdates_.Push(drawable);
-
-    drawable->updateQueued_ = true;
+        drawable->updateQueued_ = true;
+    }
 }
 
 void Octree::CancelUpdate(Drawable* drawable)
 {
-    // This doesn't have to take into account scene being in threaded update, because it is called only
-    // when removing a drawable from octree, which should only ever happen from the main thread.
+    // Removing a drawable from the octree should only ever happen from the main thread, but the drawable may have been
+    // queued during a threaded logic update, and stays in the threaded update queue until the octree is updated
+    MutexLock lock(octreeMutex_);
     drawableUpdates_.Remove(drawable);
+    threadedDrawableUpdates_.Remove(drawable);
     drawable->updateQueued_ = false;
 }
 
+void Octree::QueueDrawableBoundsUpdate(Octant* octant)
+{
+    // Drawables may be marked dirty from worker threads
+    MutexLock lock(octreeMutex_);
+    if (!octant->drawableBoundsDirty_)
+    {
+        octant->drawableBoundsDirty_ = true;
+        octant->drawableBoundsUpdateIndex_ = drawableBoundsUpdates_.Size();
+        drawableBoundsUpdates_.Push(octant);
+    }
+}
+
+void Octree::CancelDrawableBoundsUpdate(Octant* octant)
+{
+    MutexLock lock(octreeMutex_);
+    drawableBoundsUpdates_[octant->drawableBoundsUpdateIndex_] = nullptr;
+}
+
 void Octree::DrawDebugGeometry(bool depthTest)
 {
     auto* debug = GetComponent<DebugRenderer>();
@@ -24,6 +24,7 @@
 
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
+#include "../Graphics/AnimationPoseCache.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
 
@@ -39,6 +40,8 @@ static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
 /// @nobind
 class URHO3D_API Octant
 {
+    friend class Octree;
+
 public:
     /// Construct.
     Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* root, unsigned index = ROOT_INDEX);
@@ -53,12 +56,28 @@ public:
     void InsertDrawable(Drawable* drawable);
     /// Check if a drawable object fits.
     bool CheckDrawableFit(const BoundingBox& box) const;
+    /// Return the octant a drawable object should be inserted to, descending only through existing child octants. If a child octant would have to be created, return its parent instead. Does not modify the octree and is safe to call from worker threads.
+    Octant* FindInsertOctant(Drawable* drawable, const BoundingBox& box);
+
+    /// Return whether a drawable object should be inserted to this octant rather than a child octant.
+    bool IsInsertTarget(Drawable* drawable, const BoundingBox& box) const;
+
+    /// Return index of the child octant for a bounding box.
+    unsigned GetChildIndex(const BoundingBox& box) const
+    {
+        Vector3 boxCenter = box.Center();
+        unsigned x = boxCenter.x_ < center_.x_ ? 0 : 1;
+        unsigned y = boxCenter.y_ < center_.y_ ? 0 : 2;
+        unsigned z = boxCenter.z_ < center_.z_ ? 0 : 4;
+        return x + y + z;
+    }
 
     /// Add a drawable object to this octant.
     void AddDrawable(Drawable* drawable)
     {
         drawable->SetOctant(this);
         drawables_.Push(drawable);
+        MarkDrawableBoundsDirty();
         IncDrawableCount();
     }
 
@@ -69,10 +88,16 @@ public:
         {
             if (resetOctant)
                 drawable->SetOctant(nullptr);
+            MarkDrawableBoundsDirty();
             DecDrawableCount();
         }
     }
 
+    /// Mark the drawable bounds used for batched queries as requiring an update. Called when drawables are added or removed, or when their world bounding box changes. Can be called from worker threads.
+    void MarkDrawableBoundsDirty();
+    /// Update the drawable bounds used for batched queries. Called from the main thread by the octree.
+    void UpdateDrawableBounds();
+
     /// Return world-space bounding box.
     /// @property
     const BoundingBox& GetWorldBoundingBox() const { return worldBoundingBox_; }
@@ -141,6 +166,12 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// World bounding boxes of the drawable objects in blocks of four for batched queries. Valid when not dirty.
+    PODVector<DrawableBoundsBlock> drawableBounds_;
+    /// Drawable bounds dirty flag. Set together with queuing the octant for a bounds update.
+    bool drawableBoundsDirty_{};
+    /// Index in the octree's drawable bounds update queue while dirty.
+    unsigned drawableBoundsUpdateIndex_{};
     /// Child octants.
     Octant* children_[NUM_OCTANTS]{};
     /// World bounding box center.
@@ -159,6 +190,17 @@ protected:
     unsigned index_;
 };
 
+/// %Drawable reinsertion target calculated in worker threads.
+struct DrawableReinsertion
+{
+    /// Octant the drawable was in before reinsertion.
+    Octant* oldOctant_;
+    /// Octant to continue the insertion from, or null if the drawable stays in its current octant.
+    Octant* octant_;
+    /// World bounding box of the drawable.
+    BoundingBox box_;
+};
+
 /// %Octree component. Should be added only to the root scene node.
 class URHO3D_API Octree : public Component, public Octant
 {
@@ -197,10 +239,18 @@ public:
     /// @property
     unsigned GetNumLevels() const { return numLevels_; }
 
+    /// Return the cache of animation poses shared between animated models during the drawable update.
+    /// @nobind
+    AnimationPoseCache& GetAnimationPoseCache() { return animationPoseCache_; }
+
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
     void CancelUpdate(Drawable* drawable);
+    /// Queue an octant's drawable bounds for update. Called by Octant.
+    void QueueDrawableBoundsUpdate(Octant* octant);
+    /// Cancel an octant's drawable bounds update. Called by Octant when it is destroyed.
+    void CancelDrawableBoundsUpdate(Octant* octant);
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
 
@@ -214,8 +264,14 @@ private:
     PODVector<Drawable*> drawableUpdates_;
     /// Drawable objects that were inserted during threaded update phase.
     PODVector<Drawable*> threadedDrawableUpdates_;
+    /// Octants whose drawable bounds require update.
+    PODVector<Octant*> drawableBoundsUpdates_;
+    /// Reinsertion targets of the updated drawable objects.
+    PODVector<DrawableReinsertion> drawableReinsertions_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
+    /// Animation poses shared between animated models.
+    AnimationPoseCache animationPoseCache_;
     /// Ray query temporary list of drawables.
     mutable PODVector<Drawable*> rayQueryDrawables_;
     /// Subdivision level.
@@ -29,6 +29,165 @@
 namespace Urho3D
 {
 
+#ifdef URHO3D_SIMD
+/// Return the min and max coordinates of a drawable bounds block.
+static inline void LoadBounds(const DrawableBoundsBlock& bounds, SimdVector* min, SimdVector* max)
+{
+    min[0] = SimdLoad(bounds.minX_);
+    min[1] = SimdLoad(bounds.minY_);
+    min[2] = SimdLoad(bounds.minZ_);
+    max[0] = SimdLoad(bounds.maxX_);
+    max[1] = SimdLoad(bounds.maxY_);
+    max[2] = SimdLoad(bounds.maxZ_);
+}
+#else
+/// Return a drawable bounding box from a drawable bounds block.
+static inline BoundingBox GetBounds(const DrawableBoundsBlock& bounds, unsigned index)
+{
+    return BoundingBox(Vector3(bounds.minX_[index], bounds.minY_[index], bounds.minZ_[index]),
+        Vector3(bounds.maxX_[index], bounds.maxY_[index], bounds.maxZ_[index]));
+}
+#endif
+
+// The block tests below return a bit for each of the four bounding boxes that is outside the query volume. They use the same
+// arithmetic as the per-drawable tests, so that both paths return the same drawables
+
+static unsigned GetOutsideMask(const Vector3& point, const DrawableBoundsBlock& bounds)
+{
+#ifdef URHO3D_SIMD
+    SimdVector min[3], max[3];
+    LoadBounds(bounds, min, max);
+    SimdVector x = SimdSplat(point.x_);
+    SimdVector y = SimdSplat(point.y_);
+    SimdVector z = SimdSplat(point.z_);
+
+    SimdVector outside = SimdOr(SimdLess(x, min[0]), SimdLess(max[0], x));
+    outside = SimdOr(outside, SimdOr(SimdLess(y, min[1]), SimdLess(max[1], y)));
+    outside = SimdOr(outside, SimdOr(SimdLess(z, min[2]), SimdLess(max[2], z)));
+    return SimdMoveMask(outside);
+#else
+    unsigned outside = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (GetBounds(bounds, i).IsInside(point) == OUTSIDE)
+            outside |= 1u << i;
+    }
+    return outside;
+#endif
+}
+
+static unsigned GetOutsideMask(const Sphere& sphere, const DrawableBoundsBlock& bounds)
+{
+#ifdef URHO3D_SIMD
+    SimdVector min[3], max[3];
+    LoadBounds(bounds, min, max);
+    SimdVector zero = SimdSplat(0.0f);
+    SimdVector distSquared = zero;
+    const float* center = sphere.center_.Data();
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        // Distance from the box along each axis, zero when the center is between min and max
+        SimdVector c = SimdSplat(center[i]);
+        SimdVector temp = SimdMax(SimdMax(SimdSub(min[i], c), SimdSub(c, max[i])), zero);
+        distSquared = SimdAdd(distSquared, SimdMul(temp, temp));
+    }
+
+    return SimdMoveMask(SimdLessEqual(SimdSplat(sphere.radius_ * sphere.radius_), distSquared));
+#else
+    unsigned outside = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (sphere.IsInsideFast(GetBounds(bounds, i)) == OUTSIDE)
+            outside |= 1u << i;
+    }
+    return outside;
+#endif
+}
+
+static unsigned GetOutsideMask(const BoundingBox& box, const DrawableBoundsBlock& bounds)
+{
+#ifdef URHO3D_SIMD
+    SimdVector min[3], max[3];
+    LoadBounds(bounds, min, max);
+    SimdVector outside = SimdSplat(0.0f);
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        outside = SimdOr(outside, SimdLess(max[i], SimdSplat(box.min_.Data()[i])));
+        outside = SimdOr(outside, SimdLess(SimdSplat(box.max_.Data()[i]), min[i]));
+    }
+
+    return SimdMoveMask(outside);
+#else
+    unsigned outside = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (box.IsInsideFast(GetBounds(bounds, i)) == OUTSIDE)
+            outside |= 1u << i;
+    }
+    return outside;
+#endif
+}
+
+static unsigned GetOutsideMask(const Frustum& frustum, const DrawableBoundsBlock& bounds)
+{
+#ifdef URHO3D_SIMD
+    SimdVector min[3], max[3];
+    LoadBounds(bounds, min, max);
+    SimdVector half = SimdSplat(0.5f);
+    SimdVector zero = SimdSplat(0.0f);
+    SimdVector center[3], edge[3];
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        center[i] = SimdMul(SimdAdd(max[i], min[i]), half);
+        edge[i] = SimdSub(center[i], min[i]);
+    }
+
+    SimdVector outside = zero;
+    for (const auto& plane : frustum.planes_)
+    {
+        SimdVector dist = SimdAdd(SimdMul(SimdSplat(plane.normal_.x_), center[0]), SimdMul(SimdSplat(plane.normal_.y_), center[1]));
+        dist = SimdAdd(SimdAdd(dist, SimdMul(SimdSplat(plane.normal_.z_), center[2])), SimdSplat(plane.d_));
+        SimdVector absDist = SimdAdd(SimdMul(SimdSplat(plane.absNormal_.x_), edge[0]), SimdMul(SimdSplat(plane.absNormal_.y_), edge[1]));
+        absDist = SimdAdd(absDist, SimdMul(SimdSplat(plane.absNormal_.z_), edge[2]));
+        outside = SimdOr(outside, SimdLess(dist, SimdSub(zero, absDist)));
+    }
+
+    return SimdMoveMask(outside);
+#else
+    unsigned outside = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (frustum.IsInsideFast(GetBounds(bounds, i)) == OUTSIDE)
+            outside |= 1u << i;
+    }
+    return outside;
+#endif
+}
+
+void OctreeQuery::TestDrawablesInBlock(Drawable** start, Drawable** end, unsigned outsideMask)
+{
+    unsigned count = Min((unsigned)(end - start), 4U);
+
+    // Pass each run of consecutive drawables that are not outside with one call
+    unsigned i = 0;
+    while (i < count)
+    {
+        if (outsideMask & (1u << i))
+        {
+            ++i;
+            continue;
+        }
+
+        unsigned runEnd = i + 1;
+        while (runEnd < count && !(outsideMask & (1u << runEnd)))
+            ++runEnd;
+        TestDrawables(start + i, start + runEnd, true);
+        i = runEnd;
+    }
+}
+
 Intersection PointOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -51,6 +210,17 @@ void PointOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool insi
     }
 }
 
+void PointOctreeQuery::TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    if (inside)
+        TestDrawables(start, end, true);
+    else
+    {
+        for (; start < end; start += 4, ++bounds)
+            TestDrawablesInBlock(start, end, GetOutsideMask(point_, *bounds));
+    }
+}
+
 Intersection SphereOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -73,6 +243,17 @@ void SphereOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool ins
     }
 }
 
+void SphereOctreeQuery::TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    if (inside)
+        TestDrawables(start, end, true);
+    else
+    {
+        for (; start < end; start += 4, ++bounds)
+            TestDrawablesInBlock(start, end, GetOutsideMask(sphere_, *bounds));
+    }
+}
+
 Intersection BoxOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -95,6 +276,17 @@ void BoxOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside
     }
 }
 
+void BoxOctreeQuery::TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    if (inside)
+        TestDrawables(start, end, true);
+    else
+    {
+        for (; start < end; start += 4, ++bounds)
+            TestDrawablesInBlock(start, end, GetOutsideMask(box_, *bounds));
+    }
+}
+
 Intersection FrustumOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -117,6 +309,16 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    if (inside)
+        TestDrawables(start, end, true);
+    else
+    {
+        for (; start < end; start += 4, ++bounds)
+            TestDrawablesInBlock(start, end, GetOutsideMask(frustum_, *bounds));
+    }
+}
 
 Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
@@ -36,6 +36,23 @@ namespace Urho3D
 class Drawable;
 class Node;
 
+/// World bounding boxes of four drawables in structure-of-arrays layout, used for batched intersection tests.
+struct URHO3D_API DrawableBoundsBlock
+{
+    /// Minimum X coordinates.
+    float minX_[4];
+    /// Minimum Y coordinates.
+    float minY_[4];
+    /// Minimum Z coordinates.
+    float minZ_[4];
+    /// Maximum X coordinates.
+    float maxX_[4];
+    /// Maximum Y coordinates.
+    float maxY_[4];
+    /// Maximum Z coordinates.
+    float maxZ_[4];
+};
+
 /// Base class for octree queries.
 class URHO3D_API OctreeQuery
 {
@@ -60,6 +77,11 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for drawables whose world bounding boxes are also given in blocks of four. Defaults to TestDrawables().
+    virtual void TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+    {
+        TestDrawables(start, end, inside);
+    }
 
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -67,6 +89,10 @@ public:
     unsigned char drawableFlags_;
     /// Drawable layers to include.
     unsigned viewMask_;
+
+protected:
+    /// Pass the up to four drawables starting from start that are not set in the outside mask to TestDrawables() as inside.
+    void TestDrawablesInBlock(Drawable** start, Drawable** end, unsigned outsideMask);
 };
 
 /// Point octree query.
@@ -86,6 +112,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables with bounding boxes given in blocks of four.
+    void TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Point.
     Vector3 point_;
@@ -108,6 +136,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables with bounding boxes given in blocks of four.
+    void TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Sphere.
     Sphere sphere_;
@@ -130,6 +160,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables with bounding boxes given in blocks of four.
+    void TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Bounding box.
     BoundingBox box_;
@@ -152,6 +184,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables with bounding boxes given in blocks of four.
+    void TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Frustum.
     Frustum frustum_;
@@ -1176,101 +1176,124 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows,
 
     // Make sure shaders are loaded now
     if (vertexShaders.Size() && pixelShaders.Size())
+        SelectBatchShaders(batch, vertexShaders, pixelShaders, allowShadows);
+
+    // Log error if shaders could not be assigned, but only once per technique
+    if (!batch.vertexShader_ || !batch.pixelShader_)
     {
-        bool heightFog = batch.zone_ && batch.zone_->GetHeightFog();
+        if (!shaderErrorDisplayed_.Contains(tech))
+        {
+            shaderErrorDisplayed_.Insert(tech);
+            URHO3D_LOGERROR("Technique " + tech->GetName() + " has missing shaders");
+        }
+    }
+}
 
-        // If instancing is not supported, but was requested, choose static geometry vertex shader instead
-        if (batch.geometryType_ == GEOM_INSTANCED && !GetDynamicInstancing())
-            batch.geometryType_ = GEOM_STATIC;
+bool Renderer::TrySetBatchShaders(Batch& batch, bool allowShadows, const BatchQueue& queue) const
+{
+    Pass* pass = batch.pass_;
+    if (pass->GetShadersLoadedFrameNumber() != shadersChangedFrameNumber_)
+        return false;
 
-        if (batch.geometryType_ == GEOM_STATIC_NOINSTANCING)
-            batch.geometryType_ = GEOM_STATIC;
+    const Vector<SharedPtr<ShaderVariation> >* vertexShaders = queue.hasExtraDefines_ ?
+        pass->FindVertexShaders(queue.vsExtraDefinesHash_) : &pass->GetVertexShaders();
+    const Vector<SharedPtr<ShaderVariation> >* pixelShaders = queue.hasExtraDefines_ ?
+        pass->FindPixelShaders(queue.psExtraDefinesHash_) : &pass->GetPixelShaders();
+    if (!vertexShaders || !pixelShaders || vertexShaders->Empty() || pixelShaders->Empty())
+        return false;
 
-        //  Check whether is a pixel lit forward pass. If not, there is only one pixel shader
-        if (pass->GetLightingMode() == LIGHTING_PERPIXEL)
-        {
-            LightBatchQueue* lightQueue = batch.lightQueue_;
-            if (!lightQueue)
-            {
-                // Do not log error, as it would result in a lot of spam
-                batch.vertexShader_ = nullptr;
-                batch.pixelShader_ = nullptr;
-                return;
-            }
+    SelectBatchShaders(batch, *vertexShaders, *pixelShaders, allowShadows);
+    // Leave missing shaders to SetBatchShaders() so that the error gets logged
+    return batch.vertexShader_ && batch.pixelShader_;
+}
 
-            Light* light = lightQueue->light_;
-            unsigned vsi = 0;
-            unsigned psi = 0;
-            vsi = batch.geometryType_ * MAX_LIGHT_VS_VARIATIONS;
+void Renderer::SelectBatchShaders(Batch& batch, const Vector<SharedPtr<ShaderVariation> >& vertexShaders,
+    const Vector<SharedPtr<ShaderVariation> >& pixelShaders, bool allowShadows) const
+{
+    Pass* pass = batch.pass_;
+    bool heightFog = batch.zone_ && batch.zone_->GetHeightFog();
 
-            bool materialHasSpecular = batch.material_ ? batch.material_->GetSpecular() : true;
-            if (specularLighting_ && light->GetSpecularIntensity() > 0.0f && materialHasSpecular)
-                psi += LPS_SPEC;
-            if (allowShadows && lightQueue->shadowMap_)
-            {
-                if (light->GetShadowBias().normalOffset_ > 0.0f)
-                    vsi += LVS_SHADOWNORMALOFFSET;
-                else
-                    vsi += LVS_SHADOW;
-                psi += LPS_SHADOW;
-            }
+    // If instancing is not supported, but was requested, choose static geometry vertex shader instead
+    if (batch.geometryType_ == GEOM_INSTANCED && !GetDynamicInstancing())
+        batch.geometryType_ = GEOM_STATIC;
 
-            switch (light->GetLightType())
-            {
-            case LIGHT_DIRECTIONAL:
-                vsi += LVS_DIR;
-                break;
-
-            case LIGHT_SPOT:
-                psi += LPS_SPOT;
-                vsi += LVS_SPOT;
-                break;
-
-            case LIGHT_POINT:
-                if (light->GetShapeTexture())
-                    psi += LPS_POINTMASK;
-                else
-                    psi += LPS_POINT;
-                vsi += LVS_POINT;
-                break;
-            }
+    if (batch.geometryType_ == GEOM_STATIC_NOINSTANCING)
+        batch.geometryType_ = GEOM_STATIC;
 
-            if (heightFog)
-                psi += MAX_LIGHT_PS_VARIATIONS;
+    //  Check whether is a pixel lit forward pass. If not, there is only one pixel shader
+    if (pass->GetLightingMode() == LIGHTING_PERPIXEL)
+    {
+        LightBatchQueue* lightQueue = batch.lightQueue_;
+        if (!lightQueue)
+        {
+            // Do not log error, as it would result in a lot of spam
+            batch.vertexShader_ = nullptr;
+            batch.pixelShader_ = nullptr;
+            return;
+        }
 
-            batch.vertexShader_ = vertexShaders[vsi];
-            batch.pixelShader_ = pixelShaders[psi];
+        Light* light = lightQueue->light_;
+        unsigned vsi = 0;
+        unsigned psi = 0;
+        vsi = batch.geometryType_ * MAX_LIGHT_VS_VARIATIONS;
+
+        bool materialHasSpecular = batch.material_ ? batch.material_->GetSpecular() : true;
+        if (specularLighting_ && light->GetSpecularIntensity() > 0.0f && materialHasSpecular)
+            psi += LPS_SPEC;
+        if (allowShadows && lightQueue->shadowMap_)
+        {
+            if (light->GetShadowBias().normalOffset_ > 0.0f)
+                vsi += LVS_SHADOWNORMALOFFSET;
+            else
+                vsi += LVS_SHADOW;
+            psi += LPS_SHADOW;
         }
-        else
+
+        switch (light->GetLightType())
         {
-            // Check if pass has vertex lighting support
-            if (pass->GetLightingMode() == LIGHTING_PERVERTEX)
-            {
-                unsigned numVertexLights = 0;
-                if (batch.lightQueue_)
-                    numVertexLights = batch.lightQueue_->vertexLights_.Size();
+        case LIGHT_DIRECTIONAL:
+            vsi += LVS_DIR;
+            break;
 
-                unsigned vsi = batch.geometryType_ * MAX_VERTEXLIGHT_VS_VARIATIONS + numVertexLights;
-                batch.vertexShader_ = vertexShaders[vsi];
-            }
-            else
-            {
-                unsigned vsi = batch.geometryType_;
-                batch.vertexShader_ = vertexShaders[vsi];
-            }
+        case LIGHT_SPOT:
+            psi += LPS_SPOT;
+            vsi += LVS_SPOT;
+            break;
 
-            batch.pixelShader_ = pixelShaders[heightFog ? 1 : 0];
+        case LIGHT_POINT:
+            if (light->GetShapeTexture())
+                psi += LPS_POINTMASK;
+            else
+                psi += LPS_POINT;
+            vsi += LVS_POINT;
+            break;
         }
-    }
 
-    // Log error if shaders could not be assigned, but only once per technique
-    if (!batch.vertexShader_ || !batch.pixelShader_)
+        if (heightFog)
+            psi += MAX_LIGHT_PS_VARIATIONS;
+
+        batch.vertexShader_ = vertexShaders[vsi];
+        batch.pixelShader_ = pixelShaders[psi];
+    }
+    else
     {
-        if (!shaderErrorDisplayed_.Contains(tech))
+        // Check if pass has vertex lighting support
+        if (pass->GetLightingMode() == LIGHTING_PERVERTEX)
         {
-            shaderErrorDisplayed_.Insert(tech);
-            URHO3D_LOGERROR("Technique " + tech->GetName() + " has missing shaders");
+            unsigned numVertexLights = 0;
+            if (batch.lightQueue_)
+                numVertexLights = batch.lightQueue_->vertexLights_.Size();
+
+            unsigned vsi = batch.geometryType_ * MAX_VERTEXLIGHT_VS_VARIATIONS + numVertexLights;
+            batch.vertexShader_ = vertexShaders[vsi];
         }
+        else
+        {
+            unsigned vsi = batch.geometryType_;
+            batch.vertexShader_ = vertexShaders[vsi];
+        }
+
+        batch.pixelShader_ = pixelShaders[heightFog ? 1 : 0];
     }
 }
 
@@ -1357,6 +1380,7 @@ bool Renderer::ResizeInstancingBuffer(unsigned numInstances)
         newSize <<= 1;
 
     const PODVector<VertexElement> instancingBufferElements = CreateInstancingBufferElements(numExtraInstancingBufferElements_);
+    numInstancingBufferInstances_ = 0;
     if (!instancingBuffer_->SetSize(newSize, instancingBufferElements, true))
     {
         URHO3D_LOGERROR("Failed to resize instancing buffer to " + String(newSize));
@@ -1369,6 +1393,22 @@ bool Renderer::ResizeInstancingBuffer(unsigned numInstances)
     return true;
 }
 
+void Renderer::SetInstancingBufferData(const void* data, unsigned numInstances)
+{
+    if (!instancingBuffer_ || !numInstances)
+        return;
+
+    // Static scenes produce the same instance data frame after frame, so compare against the shadow copy to avoid the upload
+    if (numInstances == numInstancingBufferInstances_ &&
+        !memcmp(instancingBuffer_->GetShadowData(), data, numInstances * instancingBuffer_->GetVertexSize()))
+        return;
+
+    if (instancingBuffer_->SetDataRange(data, 0, numInstances, true))
+        numInstancingBufferInstances_ = numInstances;
+    else
+        numInstancingBufferInstances_ = 0;
+}
+
 void Renderer::OptimizeLightByScissor(Light* light, Camera* camera)
 {
     if (light && light->GetLightType() != LIGHT_DIRECTIONAL)
@@ -1887,6 +1927,9 @@ void Renderer::CreateInstancingBuffer()
     }
 
     instancingBuffer_ = new VertexBuffer(context_);
+    // Keep a shadow copy to detect unchanged instance data
+    instancingBuffer_->SetShadowed(true);
+    numInstancingBufferInstances_ = 0;
     const PODVector<VertexElement> instancingBufferElements = CreateInstancingBufferElements(numExtraInstancingBufferElements_);
     if (!instancingBuffer_->SetSize(INSTANCING_BUFFER_DEFAULT_SIZE, instancingBufferElements, true))
     {
@@ -482,6 +482,8 @@ public:
     View* GetPreparedView(Camera* camera);
     /// Choose shaders for a forward rendering batch. The related batch queue is provided in case it has extra shader compilation defines.
     void SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue);
+    /// Choose shaders for a forward rendering batch only if they have already been loaded. Return true on success. Does not load shaders or log errors, so it is safe to call from worker threads.
+    bool TrySetBatchShaders(Batch& batch, bool allowShadows, const BatchQueue& queue) const;
     /// Choose shaders for a deferred light volume batch.
     void SetLightVolumeBatchShaders
         (Batch& batch, Camera* camera, const String& vsName, const String& psName, const String& vsDefines, const String& psDefines);
@@ -489,6 +491,8 @@ public:
     void SetCullMode(CullMode mode, Camera* camera);
     /// Ensure sufficient size of the instancing vertex buffer. Return true if successful.
     bool ResizeInstancingBuffer(unsigned numInstances);
+    /// Set instancing vertex buffer contents from the start. The upload is skipped if the buffer already holds identical data.
+    void SetInstancingBufferData(const void* data, unsigned numInstances);
     /// Optimize a light by scissor rectangle.
     void OptimizeLightByScissor(Light* light, Camera* camera);
     /// Optimize a light by marking it to the stencil buffer and setting a stencil test.
@@ -508,6 +512,9 @@ private:
     void LoadPassShaders(Pass* pass, Vector<SharedPtr<ShaderVariation> >& vertexShaders, Vector<SharedPtr<ShaderVariation> >& pixelShaders, const BatchQueue& queue);
     /// Release shaders used in materials.
     void ReleaseMaterialShaders();
+    /// Choose shader variations for a batch from already loaded pass shaders.
+    void SelectBatchShaders(Batch& batch, const Vector<SharedPtr<ShaderVariation> >& vertexShaders,
+        const Vector<SharedPtr<ShaderVariation> >& pixelShaders, bool allowShadows) const;
     /// Reload textures.
     void ReloadTextures();
     /// Create light volume geometries.
@@ -663,6 +670,8 @@ private:
     bool dynamicInstancing_{true};
     /// Number of extra instancing data elements.
     int numExtraInstancingBufferElements_{};
+    /// Number of instances uploaded to the instancing buffer, or zero if its contents are undefined.
+    unsigned numInstancingBufferInstances_{};
     /// Threaded occlusion rendering flag.
     bool threadedOcclusion_{};
     /// Shaders need reloading flag.
@@ -58,7 +58,8 @@ ShaderParameter::ShaderParameter(ShaderType type, const String& name, unsigned r
 ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
     GPUObject(owner->GetSubsystem<Graphics>()),
     owner_(owner),
-    type_(type)
+    type_(type),
+    sortID_(SORTID_SHADERVARIATION)
 {
 }
 
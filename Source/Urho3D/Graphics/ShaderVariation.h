@@ -27,6 +27,7 @@
 #include "../Container/ArrayPtr.h"
 #include "../Graphics/GPUObject.h"
 #include "../Graphics/GraphicsDefs.h"
+#include "../Graphics/SortID.h"
 
 namespace Urho3D
 {
@@ -137,6 +138,9 @@ public:
     /// Return defines with the CLIPPLANE define appended. Used internally on Direct3D11 only, will be empty on other APIs.
     const String& GetDefinesClipPlane() { return definesClipPlane_; }
 
+    /// Return ID for batch state sorting.
+    unsigned short GetSortID() const { return sortID_.Get(); }
+
     /// D3D11 vertex semantic names. Used internally.
     static const char* elementSemanticNames[];
 
@@ -174,6 +178,8 @@ private:
     String definesClipPlane_;
     /// Shader compile error string.
     String compilerOutput_;
+    /// ID for batch state sorting.
+    SortID sortID_;
 };
 
 }
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+#include "../Graphics/SortID.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Registry of sorting IDs for one object type.
+struct SortIDRegistry
+{
+    /// Mutex for allocating and freeing from multiple threads.
+    Mutex mutex_;
+    /// Freed IDs available for reuse.
+    PODVector<unsigned short> freeIDs_;
+    /// Next never-used ID.
+    unsigned nextID_{};
+};
+
+static SortIDRegistry registries[MAX_SORTID_TYPES];
+
+SortID::SortID(SortIDType type) :
+    type_(type)
+{
+    SortIDRegistry& registry = registries[type_];
+    MutexLock lock(registry.mutex_);
+
+    if (!registry.freeIDs_.Empty())
+    {
+        id_ = registry.freeIDs_.Back();
+        registry.freeIDs_.Pop();
+    }
+    else
+    {
+        // If the ID space is exhausted, wrap around. Duplicate IDs only affect sorting efficiency, not correctness
+        id_ = (unsigned short)(registry.nextID_++ & 0xffffu);
+    }
+}
+
+SortID::~SortID()
+{
+    SortIDRegistry& registry = registries[type_];
+    MutexLock lock(registry.mutex_);
+    registry.freeIDs_.Push(id_);
+}
+
+}
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+namespace Urho3D
+{
+
+/// Types of objects that receive batch state sorting IDs. Each type has its own ID space.
+enum SortIDType
+{
+    SORTID_SHADERVARIATION = 0,
+    SORTID_MATERIAL,
+    SORTID_GEOMETRY,
+    MAX_SORTID_TYPES
+};
+
+/// Compact 16-bit ID for batch state sorting. Allocated from a per-type registry on construction and returned to it on destruction, so the ID stays stable for the owner's lifetime and the ID space stays dense. IDs are unique while fewer than 65536 objects of the type exist.
+class URHO3D_API SortID
+{
+public:
+    /// Construct and allocate an ID of the specified type. Thread-safe.
+    explicit SortID(SortIDType type);
+    /// Destruct and free the ID. Thread-safe.
+    ~SortID();
+    /// Prevent copy construction.
+    SortID(const SortID& rhs) = delete;
+    /// Prevent copy assignment.
+    SortID& operator =(const SortID& rhs) = delete;
+
+    /// Return the ID value.
+    unsigned short Get() const { return id_; }
+
+private:
+    /// ID type.
+    SortIDType type_;
+    /// ID value.
+    unsigned short id_;
+};
+
+}
@@ -226,6 +226,22 @@ Vector<SharedPtr<ShaderVariation> >& Pass::GetPixelShaders(const StringHash& ext
         return extraPixelShaders_[extraDefinesHash];
 }
 
+const Vector<SharedPtr<ShaderVariation> >* Pass::FindVertexShaders(const StringHash& extraDefinesHash) const
+{
+    if (!extraDefinesHash.Value())
+        return &vertexShaders_;
+    else
+        return extraVertexShaders_[extraDefinesHash];
+}
+
+const Vector<SharedPtr<ShaderVariation> >* Pass::FindPixelShaders(const StringHash& extraDefinesHash) const
+{
+    if (!extraDefinesHash.Value())
+        return &pixelShaders_;
+    else
+        return extraPixelShaders_[extraDefinesHash];
+}
+
 unsigned Technique::basePassIndex = 0;
 unsigned Technique::alphaPassIndex = 0;
 unsigned Technique::materialPassIndex = 0;
@@ -164,6 +164,10 @@ public:
     Vector<SharedPtr<ShaderVariation> >& GetVertexShaders(const StringHash& extraDefinesHash);
     /// Return pixel shaders with extra defines from the renderpath.
     Vector<SharedPtr<ShaderVariation> >& GetPixelShaders(const StringHash& extraDefinesHash);
+    /// Return vertex shaders with extra defines from the renderpath, or null if not created yet. Does not modify the pass.
+    const Vector<SharedPtr<ShaderVariation> >* FindVertexShaders(const StringHash& extraDefinesHash) const;
+    /// Return pixel shaders with extra defines from the renderpath, or null if not created yet. Does not modify the pass.
+    const Vector<SharedPtr<ShaderVariation> >* FindPixelShaders(const StringHash& extraDefinesHash) const;
     /// Return the effective vertex shader defines, accounting for excludes. Called internally by Renderer.
     String GetEffectiveVertexShaderDefines() const;
     /// Return the effective pixel shader defines, accounting for excludes. Called internally by Renderer.
@@ -55,6 +55,11 @@
 namespace Urho3D
 {
 
+static const unsigned MIN_VISIBILITY_CHECKS_PER_CHUNK = 64;
+static const unsigned MIN_GEOMETRY_UPDATES_PER_CHUNK = 4;
+static const unsigned MIN_BASE_BATCH_DRAWABLES_PER_CHUNK = 16;
+static const unsigned LIT_GEOMETRIES_PER_TASK = 64;
+
 /// %Frustum octree query for shadowcasters.
 class ShadowCasterOctreeQuery : public FrustumOctreeQuery
 {
@@ -157,11 +162,11 @@ public:
     OcclusionBuffer* buffer_;
 };
 
-void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
+void CheckVisibilityWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
 {
-    auto* view = reinterpret_cast<View*>(item->aux_);
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
+    auto* view = reinterpret_cast<View*>(aux);
+    // The drawables to check are in the main thread's scratch vector
+    Drawable** drawables = view->GetSubsystem<WorkQueue>()->GetScratchVector<Drawable*>(0).Buffer();
     OcclusionBuffer* buffer = view->occlusionBuffer_;
     const Matrix3x4& viewMatrix = view->cullCamera_->GetView();
     Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
@@ -170,9 +175,9 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     bool cameraZoneOverride = view->cameraZoneOverride_;
     PerThreadSceneResult& result = view->sceneResults_[threadIndex];
 
-    while (start != end)
+    for (unsigned i = start; i < end; ++i)
     {
-        Drawable* drawable = *start++;
+        Drawable* drawable = drawables[i];
 
         if (!buffer || !drawable->IsOccludee() || buffer->IsVisible(drawable->GetWorldBoundingBox()))
         {
@@ -234,21 +239,62 @@ void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
     view->ProcessLight(*query, threadIndex);
 }
 
-void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
+void ProcessShadowSplitWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* view = reinterpret_cast<View*>(item->aux_);
+    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
+    // The end pointer is the split's shadow caster list, which also identifies the split
+    auto splitIndex = (unsigned)(reinterpret_cast<PODVector<Drawable*>*>(item->end_) - query->shadowCasters_);
+
+    view->ProcessShadowSplit(*query, splitIndex, threadIndex);
+}
+
+void FinishLightWork(const WorkItem* item, unsigned threadIndex)
 {
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
+    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
 
-    while (start != end)
+    // If no shadow casters, the light can be rendered unshadowed. At this point we have not allocated a shadow map yet, so the
+    // only cost has been the shadow camera setup & queries
+    for (unsigned i = 0; i < query->numSplits_; ++i)
     {
-        Drawable* drawable = *start++;
+        if (!query->shadowCasters_[i].Empty())
+            return;
+    }
+
+    query->numSplits_ = 0;
+}
+
+void UpdateDrawableGeometriesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* view = reinterpret_cast<View*>(aux);
+
+    for (unsigned i = start; i < end; ++i)
+    {
+        Drawable* drawable = view->threadedGeometries_[i];
         // We may leave null pointer holes in the queue if a drawable is found out to require a main thread update
         if (drawable)
-            drawable->UpdateGeometry(frame);
+            drawable->UpdateGeometry(view->frame_);
     }
 }
 
+void GetBaseBatchesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* view = reinterpret_cast<View*>(aux);
+    PerThreadBatchResult& result = view->batchResults_[threadIndex];
+
+    for (unsigned i = start; i < end; ++i)
+        view->GetDrawableBaseBatches(view->geometries_[i], result);
+}
+
+void GetLightBatchesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* view = reinterpret_cast<View*>(aux);
+    PerThreadBatchResult& result = view->batchResults_[threadIndex];
+
+    for (unsigned i = start; i < end; ++i)
+        view->GetLightTaskBatches(view->lightBatchTasks_[i], result);
+}
+
 void SortBatchQueueFrontToBackWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* queue = reinterpret_cast<BatchQueue*>(item->start_);
@@ -284,12 +330,14 @@ View::View(Context* context) :
     graphics_(GetSubsystem<Graphics>()),
     renderer_(GetSubsystem<Renderer>())
 {
-    // Create octree query and scene results vector for each thread
+    // Create scene and batch results vector for each thread
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
-    tempDrawables_.Resize(numThreads);
     sceneResults_.Resize(numThreads);
+    batchResults_.Resize(numThreads);
 }
 
+View::~View() = default;
+
 bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
 {
     sourceView_ = nullptr;
@@ -797,7 +845,7 @@ void View::GetDrawables()
     URHO3D_PROFILE(GetDrawables);
 
     auto* queue = GetSubsystem<WorkQueue>();
-    PODVector<Drawable*>& tempDrawables = tempDrawables_[0];
+    PODVector<Drawable*>& tempDrawables = queue->GetScratchVector<Drawable*>(0);
 
     // Get zones and occluders first
     {
@@ -894,30 +942,7 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->ParallelFor(tempDrawables.Size(), CheckVisibilityWork, this, MIN_VISIBILITY_CHECKS_PER_CHUNK);
     }
 
     // Combine lights, geometries & scene Z range from the threads
@@ -981,23 +1006,58 @@ void View::ProcessLights()
 
     auto* queue = GetSubsystem<WorkQueue>();
     lightQueryResults_.Resize(lights_.Size());
+    lightItems_.Resize(lights_.Size());
 
+    // For each light, the lit geometry query is followed by a shadow caster query for each shadow split the light may have,
+    // which run in parallel, and then by the light's finishing item. The lights are not waited for here: they are completed
+    // one at a time when building the light batches, while the rest are still being processed
     for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
     {
-        SharedPtr<WorkItem> item = queue->GetFreeItem();
-        item->priority_ = M_MAX_UNSIGNED;
-        item->workFunction_ = ProcessLightWork;
-        item->aux_ = this;
-
         LightQueryResult& query = lightQueryResults_[i];
-        query.light_ = lights_[i];
+        Light* light = lights_[i];
+        query.light_ = light;
 
-        item->start_ = &query;
-        queue->AddWorkItem(item);
-    }
+        SharedPtr<WorkItem> lightItem = queue->GetFreeItem();
+        lightItem->priority_ = M_MAX_UNSIGNED;
+        lightItem->workFunction_ = ProcessLightWork;
+        lightItem->start_ = &query;
+        lightItem->aux_ = this;
 
-    // Ensure all lights have been processed before proceeding
-    queue->Complete(M_MAX_UNSIGNED);
+        // The finishing items are waited on individually, so they are not pooled to make sure they can not be reused while
+        // the view still refers to them
+        SharedPtr<WorkItem>& finishItem = lightItems_[i];
+        if (!finishItem)
+        {
+            finishItem = new WorkItem();
+            finishItem->priority_ = M_MAX_UNSIGNED;
+            finishItem->workFunction_ = FinishLightWork;
+        }
+        finishItem->start_ = &query;
+        queue->AddDependency(finishItem, lightItem);
+
+        unsigned maxSplits = 0;
+        if (IsShadowed(light))
+        {
+            LightType type = light->GetLightType();
+            maxSplits = type == LIGHT_DIRECTIONAL ? (unsigned)light->GetNumShadowSplits() : (type == LIGHT_SPOT ? 1 : MAX_CUBEMAP_FACES);
+        }
+
+        for (unsigned j = 0; j < maxSplits; ++j)
+        {
+            SharedPtr<WorkItem> splitItem = queue->GetFreeItem();
+            splitItem->priority_ = M_MAX_UNSIGNED;
+            splitItem->workFunction_ = ProcessShadowSplitWork;
+            splitItem->start_ = &query;
+            splitItem->end_ = &query.shadowCasters_[j];
+            splitItem->aux_ = this;
+            queue->AddDependency(splitItem, lightItem);
+            queue->AddDependency(finishItem, splitItem);
+            queue->AddWorkItem(splitItem);
+        }
+
+        queue->AddWorkItem(finishItem);
+        queue->AddWorkItem(lightItem);
+    }
 }
 
 void View::GetLightBatches()
@@ -1008,22 +1068,22 @@ void View::GetLightBatches()
     {
         URHO3D_PROFILE(GetLightBatches);
 
-        // Preallocate light queues: per-pixel lights which have lit geometries
-        unsigned numLightQueues = 0;
-        unsigned usedLightQueues = 0;
-        for (Vector<LightQueryResult>::ConstIterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
-        {
-            if (!i->light_->GetPerVertex() && i->litGeometries_.Size())
-                ++numLightQueues;
-        }
+        auto* queue = GetSubsystem<WorkQueue>();
 
-        lightQueues_.Resize(numLightQueues);
+        // Preallocate light queues for all lights, as the number of per-pixel lights with lit geometries is known only once
+        // all lights have been processed. The queues are not reallocated, so the unused ones can be removed at the end
+        unsigned usedLightQueues = 0;
+        lightQueues_.Resize(lightQueryResults_.Size());
         maxLightsDrawables_.Clear();
+        lightBatchTasks_.Clear();
         auto maxSortedInstances = (unsigned)renderer_->GetMaxSortedInstances();
 
-        for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+        for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
         {
-            LightQueryResult& query = *i;
+            // Wait only for this light, so that the worker threads keep processing the following lights
+            queue->CompleteItem(lightItems_[i]);
+
+            LightQueryResult& query = lightQueryResults_[i];
 
             // If light has no affected geometries, no need to process further
             if (query.litGeometries_.Empty())
@@ -1041,6 +1101,7 @@ void View::GetLightBatches()
                 light->SetLightQueue(&lightQueue);
                 lightQueue.light_ = light;
                 lightQueue.negative_ = light->IsNegative();
+                lightQueue.sortID_ = usedLightQueues;
                 lightQueue.shadowMap_ = nullptr;
                 lightQueue.litBaseBatches_.Clear(maxSortedInstances);
                 lightQueue.litBatches_.Clear(maxSortedInstances);
@@ -1056,6 +1117,10 @@ void View::GetLightBatches()
                 }
                 lightQueue.volumeBatches_.Clear();
 
+                LightBatchTask task;
+                task.query_ = &query;
+                task.lightQueue_ = &lightQueue;
+
                 // Allocate shadow map now
                 if (shadowSplits > 0)
                 {
@@ -1080,59 +1145,32 @@ void View::GetLightBatches()
                     shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
                     FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
 
-                    // Loop through shadow casters
-                    for (PODVector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
-                         k < query.shadowCasters_.Begin() + query.shadowCasterEnd_[j]; ++k)
-                    {
-                        Drawable* drawable = *k;
-                        // If drawable is not in actual view frustum, mark it in view here and check its geometry update type
-                        if (!drawable->IsInView(frame_, true))
-                        {
-                            drawable->MarkInView(frame_.frameNumber_);
-                            UpdateGeometryType type = drawable->GetUpdateGeometryType();
-                            if (type == UPDATE_MAIN_THREAD)
-                                nonThreadedGeometries_.Push(drawable);
-                            else if (type == UPDATE_WORKER_THREAD)
-                                threadedGeometries_.Push(drawable);
-                        }
-
-                        const Vector<SourceBatch>& batches = drawable->GetBatches();
-
-                        for (unsigned l = 0; l < batches.Size(); ++l)
-                        {
-                            const SourceBatch& srcBatch = batches[l];
-
-                            Technique* tech = GetTechnique(drawable, srcBatch.material_);
-                            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
-                                continue;
-
-                            Pass* pass = tech->GetSupportedPass(Technique::shadowPassIndex);
-                            // Skip if material has no shadow pass
-                            if (!pass)
-                                continue;
-
-                            Batch destBatch(srcBatch);
-                            destBatch.pass_ = pass;
-                            destBatch.zone_ = nullptr;
-
-                            AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech);
-                        }
-                    }
+                    // Shadow casters are processed in the worker threads
+                    task.splitIndex_ = j;
+                    task.start_ = 0;
+                    task.end_ = query.shadowCasters_[j].Size();
+                    lightBatchTasks_.Push(task);
                 }
 
-                // Process lit geometries
+                // Record the light to lit geometries now, so that the first light is known when generating batches
+                // If drawable limits maximum lights, check maximum count / build batches later
                 for (PODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
                 {
                     Drawable* drawable = *j;
                     drawable->AddLight(light);
-
-                    // If drawable limits maximum lights, only record the light, and check maximum count / build batches later
-                    if (!drawable->GetMaxLights())
-                        GetLitBatches(drawable, lightQueue, alphaQueue);
-                    else
+                    if (drawable->GetMaxLights())
                         maxLightsDrawables_.Insert(drawable);
                 }
 
+                // Split lit geometries into tasks for the worker threads
+                task.splitIndex_ = M_MAX_UNSIGNED;
+                for (unsigned j = 0; j < query.litGeometries_.Size(); j += LIT_GEOMETRIES_PER_TASK)
+                {
+                    task.start_ = j;
+                    task.end_ = Min(j + LIT_GEOMETRIES_PER_TASK, query.litGeometries_.Size());
+                    lightBatchTasks_.Push(task);
+                }
+
                 // In deferred modes, store the light volume batch now. Since light mask 8 lowest bits are output to the stencil,
                 // lights that have all zeroes in the low 8 bits can be skipped; they would not affect geometry anyway
                 if (deferred_ && (light->GetLightMask() & 0xffu) != 0)
@@ -1164,6 +1202,12 @@ void View::GetLightBatches()
                 }
             }
         }
+
+        lightQueues_.Resize(usedLightQueues);
+
+        // Generate shadow caster and lit geometry batches in the worker threads, then add them to the queues
+        queue->ParallelFor(lightBatchTasks_.Size(), GetLightBatchesWork, this);
+        MergeBatchResults();
     }
 
     // Process drawables with limited per-pixel light count
@@ -1193,87 +1237,186 @@ void View::GetBaseBatches()
 {
     URHO3D_PROFILE(GetBaseBatches);
 
-    for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+    GetSubsystem<WorkQueue>()->ParallelFor(geometries_.Size(), GetBaseBatchesWork, this, MIN_BASE_BATCH_DRAWABLES_PER_CHUNK);
+    MergeBatchResults();
+}
+
+void View::GetDrawableBaseBatches(Drawable* drawable, PerThreadBatchResult& result)
+{
+    UpdateGeometryType type = drawable->GetUpdateGeometryType();
+    if (type == UPDATE_MAIN_THREAD)
+        result.nonThreadedGeometries_.Push(drawable);
+    else if (type == UPDATE_WORKER_THREAD)
+        result.threadedGeometries_.Push(drawable);
+
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+    bool vertexLightsProcessed = false;
+
+    for (unsigned j = 0; j < batches.Size(); ++j)
     {
-        Drawable* drawable = *i;
-        UpdateGeometryType type = drawable->GetUpdateGeometryType();
-        if (type == UPDATE_MAIN_THREAD)
-            nonThreadedGeometries_.Push(drawable);
-        else if (type == UPDATE_WORKER_THREAD)
-            threadedGeometries_.Push(drawable);
+        const SourceBatch& srcBatch = batches[j];
 
-        const Vector<SourceBatch>& batches = drawable->GetBatches();
-        bool vertexLightsProcessed = false;
+        // Check here if the material refers to a rendertarget texture with camera(s) attached
+        // Only check this for backbuffer views (null rendertarget). The check is finished in the main thread
+        if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
+            result.auxViewMaterials_.Push(srcBatch.material_);
 
-        for (unsigned j = 0; j < batches.Size(); ++j)
-        {
-            const SourceBatch& srcBatch = batches[j];
+        Technique* tech = GetTechnique(drawable, srcBatch.material_);
+        if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+            continue;
 
-            // Check here if the material refers to a rendertarget texture with camera(s) attached
-            // Only check this for backbuffer views (null rendertarget)
-            if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
-                CheckMaterialForAuxView(srcBatch.material_);
+        // Check each of the scene passes
+        for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+        {
+            ScenePassInfo& info = scenePasses_[k];
+            // Skip forward base pass if the corresponding litbase pass already exists
+            if (info.passIndex_ == basePassIndex_ && j < 32 && drawable->HasBasePass(j))
+                continue;
 
-            Technique* tech = GetTechnique(drawable, srcBatch.material_);
-            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+            Pass* pass = tech->GetSupportedPass(info.passIndex_);
+            if (!pass)
                 continue;
 
-            // Check each of the scene passes
-            for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+            Batch destBatch(srcBatch);
+            destBatch.pass_ = pass;
+            destBatch.zone_ = GetZone(drawable);
+            destBatch.isBase_ = true;
+            destBatch.lightMask_ = (unsigned char)GetLightMask(drawable);
+
+            if (info.vertexLights_)
             {
-                ScenePassInfo& info = scenePasses_[k];
-                // Skip forward base pass if the corresponding litbase pass already exists
-                if (info.passIndex_ == basePassIndex_ && j < 32 && drawable->HasBasePass(j))
+                const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
+                if (drawableVertexLights.Size() && !vertexLightsProcessed)
+                {
+                    // Limit vertex lights. If this is a deferred opaque batch, remove converted per-pixel lights,
+                    // as they will be rendered as light volumes in any case, and drawing them also as vertex lights
+                    // would result in double lighting
+                    drawable->LimitVertexLights(deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE);
+                    vertexLightsProcessed = true;
+                }
+
+                if (drawableVertexLights.Size())
+                {
+                    // Find a vertex light queue. If not found, create new
+                    unsigned long long hash = GetVertexLightQueueHash(drawableVertexLights);
+                    MutexLock lock(vertexLightQueuesMutex_);
+                    HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
+                    if (i == vertexLightQueues_.End())
+                    {
+                        i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
+                        i->second_.light_ = nullptr;
+                        i->second_.sortID_ = lightQueues_.Size() + vertexLightQueues_.Size();
+                        i->second_.shadowMap_ = nullptr;
+                        i->second_.vertexLights_ = drawableVertexLights;
+                    }
+
+                    destBatch.lightQueue_ = &(i->second_);
+                }
+            }
+            else
+                destBatch.lightQueue_ = nullptr;
+
+            bool allowInstancing = info.allowInstancing_;
+            if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (destBatch.zone_->GetLightMask() & 0xffu))
+                allowInstancing = false;
+
+            QueueBatch(*info.batchQueue_, destBatch, tech, &result, allowInstancing);
+        }
+    }
+}
+
+void View::GetLightTaskBatches(const LightBatchTask& task, PerThreadBatchResult& result)
+{
+    const LightQueryResult& query = *task.query_;
+    LightBatchQueue& lightQueue = *task.lightQueue_;
+
+    if (task.splitIndex_ == M_MAX_UNSIGNED)
+    {
+        HashMap<unsigned, BatchQueue>::Iterator alphaQueue = batchQueues_.Find(alphaPassIndex_);
+
+        for (unsigned i = task.start_; i < task.end_; ++i)
+        {
+            Drawable* drawable = query.litGeometries_[i];
+            // Drawables that limit maximum lights are processed later in the main thread
+            if (!drawable->GetMaxLights())
+                GetLitBatches(drawable, lightQueue, alphaQueue != batchQueues_.End() ? &alphaQueue->second_ : nullptr, &result);
+        }
+    }
+    else
+    {
+        ShadowBatchQueue& shadowQueue = lightQueue.shadowSplits_[task.splitIndex_];
+
+        for (unsigned i = task.start_; i < task.end_; ++i)
+        {
+            Drawable* drawable = query.shadowCasters_[task.splitIndex_][i];
+            // If drawable is not in actual view frustum, it will be marked in view and its geometry update type checked
+            // in the main thread
+            if (!drawable->IsInView(frame_, true))
+                result.shadowCasters_.Push(drawable);
+
+            const Vector<SourceBatch>& batches = drawable->GetBatches();
+
+            for (unsigned j = 0; j < batches.Size(); ++j)
+            {
+                const SourceBatch& srcBatch = batches[j];
+
+                Technique* tech = GetTechnique(drawable, srcBatch.material_);
+                if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
                     continue;
 
-                Pass* pass = tech->GetSupportedPass(info.passIndex_);
+                Pass* pass = tech->GetSupportedPass(Technique::shadowPassIndex);
+                // Skip if material has no shadow pass
                 if (!pass)
                     continue;
 
                 Batch destBatch(srcBatch);
                 destBatch.pass_ = pass;
-                destBatch.zone_ = GetZone(drawable);
-                destBatch.isBase_ = true;
-                destBatch.lightMask_ = (unsigned char)GetLightMask(drawable);
+                destBatch.zone_ = nullptr;
 
-                if (info.vertexLights_)
-                {
-                    const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
-                    if (drawableVertexLights.Size() && !vertexLightsProcessed)
-                    {
-                        // Limit vertex lights. If this is a deferred opaque batch, remove converted per-pixel lights,
-                        // as they will be rendered as light volumes in any case, and drawing them also as vertex lights
-                        // would result in double lighting
-                        drawable->LimitVertexLights(deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE);
-                        vertexLightsProcessed = true;
-                    }
-
-                    if (drawableVertexLights.Size())
-                    {
-                        // Find a vertex light queue. If not found, create new
-                        unsigned long long hash = GetVertexLightQueueHash(drawableVertexLights);
-                        HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
-                        if (i == vertexLightQueues_.End())
-                        {
-                            i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
-                            i->second_.light_ = nullptr;
-                            i->second_.shadowMap_ = nullptr;
-                            i->second_.vertexLights_ = drawableVertexLights;
-                        }
+                QueueBatch(shadowQueue.shadowBatches_, destBatch, tech, &result);
+            }
+        }
+    }
+}
 
-                        destBatch.lightQueue_ = &(i->second_);
-                    }
-                }
-                else
-                    destBatch.lightQueue_ = nullptr;
+void View::MergeBatchResults()
+{
+    for (unsigned i = 0; i < batchResults_.Size(); ++i)
+    {
+        PerThreadBatchResult& result = batchResults_[i];
 
-                bool allowInstancing = info.allowInstancing_;
-                if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (destBatch.zone_->GetLightMask() & 0xffu))
-                    allowInstancing = false;
+        nonThreadedGeometries_.Push(result.nonThreadedGeometries_);
+        threadedGeometries_.Push(result.threadedGeometries_);
 
-                AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing);
+        // A shadow caster may have been recorded by several threads, so check again before marking in view
+        for (PODVector<Drawable*>::ConstIterator j = result.shadowCasters_.Begin(); j != result.shadowCasters_.End(); ++j)
+        {
+            Drawable* drawable = *j;
+            if (!drawable->IsInView(frame_, true))
+            {
+                drawable->MarkInView(frame_.frameNumber_);
+                UpdateGeometryType type = drawable->GetUpdateGeometryType();
+                if (type == UPDATE_MAIN_THREAD)
+                    nonThreadedGeometries_.Push(drawable);
+                else if (type == UPDATE_WORKER_THREAD)
+                    threadedGeometries_.Push(drawable);
             }
         }
+
+        for (PODVector<Material*>::ConstIterator j = result.auxViewMaterials_.Begin(); j != result.auxViewMaterials_.End(); ++j)
+        {
+            if ((*j)->GetAuxViewFrameNumber() != frame_.frameNumber_)
+                CheckMaterialForAuxView(*j);
+        }
+
+        for (PODVector<PendingBatch>::Iterator j = result.batches_.Begin(); j != result.batches_.End(); ++j)
+            AddPreparedBatchToQueue(*j->queue_, j->batch_, j->tech_, j->allowShadows_, j->hasShaders_);
+
+        result.batches_.Clear();
+        result.nonThreadedGeometries_.Clear();
+        result.threadedGeometries_.Clear();
+        result.shadowCasters_.Clear();
+        result.auxViewMaterials_.Clear();
     }
 }
 
@@ -1330,45 +1473,23 @@ void View::UpdateGeometries()
 
     // Update geometries. Split into threaded and non-threaded updates.
     {
-        if (threadedGeometries_.Size())
+        // In special cases (context loss, multi-view) a drawable may theoretically first have reported a threaded update, but will actually
+        // require a main thread update. Check these cases first and move as applicable. The threaded work routine will tolerate the null
+        // pointer holes that we leave to the threaded update queue.
+        for (PODVector<Drawable*>::Iterator i = threadedGeometries_.Begin(); i != threadedGeometries_.End(); ++i)
         {
-            // In special cases (context loss, multi-view) a drawable may theoretically first have reported a threaded update, but will actually
-            // require a main thread update. Check these cases first and move as applicable. The threaded work routine will tolerate the null
-            // pointer holes that we leave to the threaded update queue.
-            for (PODVector<Drawable*>::Iterator i = threadedGeometries_.Begin(); i != threadedGeometries_.End(); ++i)
-            {
-                if ((*i)->GetUpdateGeometryType() == UPDATE_MAIN_THREAD)
-                {
-                    nonThreadedGeometries_.Push(*i);
-                    *i = nullptr;
-                }
-            }
-
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
-
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
+            if ((*i)->GetUpdateGeometryType() == UPDATE_MAIN_THREAD)
             {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
+                nonThreadedGeometries_.Push(*i);
+                *i = nullptr;
             }
         }
 
-        // While the work queue is processed, update non-threaded geometries
+        // While the batch sorting work items are processed, update non-threaded geometries
         for (PODVector<Drawable*>::ConstIterator i = nonThreadedGeometries_.Begin(); i != nonThreadedGeometries_.End(); ++i)
             (*i)->UpdateGeometry(frame_);
+
+        queue->ParallelFor(threadedGeometries_.Size(), UpdateDrawableGeometriesWork, this, MIN_GEOMETRY_UPDATES_PER_CHUNK);
     }
 
     // Finally ensure all threaded work has completed
@@ -1376,7 +1497,7 @@ void View::UpdateGeometries()
     geometriesUpdated_ = true;
 }
 
-void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue)
+void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue, PerThreadBatchResult* result)
 {
     Light* light = lightQueue.light_;
     Zone* zone = GetZone(drawable);
@@ -1434,15 +1555,15 @@ void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQ
         if (!isLitAlpha)
         {
             if (destBatch.isBase_)
-                AddBatchToQueue(lightQueue.litBaseBatches_, destBatch, tech);
+                QueueBatch(lightQueue.litBaseBatches_, destBatch, tech, result);
             else
-                AddBatchToQueue(lightQueue.litBatches_, destBatch, tech);
+                QueueBatch(lightQueue.litBatches_, destBatch, tech, result);
         }
         else if (alphaQueue)
         {
             // Transparent batches can not be instanced, and shadows on transparencies can only be rendered if shadow maps are
             // not reused
-            AddBatchToQueue(*alphaQueue, destBatch, tech, false, !renderer_->GetReuseShadowMaps());
+            QueueBatch(*alphaQueue, destBatch, tech, result, false, !renderer_->GetReuseShadowMaps());
         }
     }
 }
@@ -2273,13 +2394,8 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
     buffer->BuildDepthHierarchy();
 }
 
-void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
+bool View::IsShadowed(Light* light) const
 {
-    Light* light = query.light_;
-    LightType type = light->GetLightType();
-    unsigned lightMask = light->GetLightMask();
-    const Frustum& frustum = cullCamera_->GetFrustum();
-
     // Check if light should be shadowed
     bool isShadowed = drawShadows_ && light->GetCastShadows() && !light->GetPerVertex() && light->GetShadowIntensity() < 1.0f;
     // If shadow distance non-zero, check it
@@ -2287,11 +2403,21 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
         isShadowed = false;
     // OpenGL ES can not support point light shadows
 #ifdef GL_ES_VERSION_2_0
-    if (isShadowed && type == LIGHT_POINT)
+    if (isShadowed && light->GetLightType() == LIGHT_POINT)
         isShadowed = false;
 #endif
-    // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered
-    PODVector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
+    return isShadowed;
+}
+
+void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
+{
+    Light* light = query.light_;
+    LightType type = light->GetLightType();
+    unsigned lightMask = light->GetLightMask();
+
+    // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered. The octree
+    // query result of spot and point lights is kept for finding their shadow casters
+    PODVector<Drawable*>& tempDrawables = query.drawables_;
     query.litGeometries_.Clear();
 
     switch (type)
@@ -2332,48 +2458,51 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     }
 
     // If no lit geometries or not shadowed, no need to process shadow cameras
-    if (query.litGeometries_.Empty() || !isShadowed)
+    if (query.litGeometries_.Empty() || !IsShadowed(light))
     {
         query.numSplits_ = 0;
         return;
     }
 
-    // Determine number of shadow cameras and setup their initial positions
+    // Determine number of shadow cameras and setup their initial positions. The splits are then processed for shadow casters
+    // in their own work items
     SetupShadowCameras(query);
+}
 
-    // Process each split for shadow casters
-    query.shadowCasters_.Clear();
-    for (unsigned i = 0; i < query.numSplits_; ++i)
-    {
-        Camera* shadowCamera = query.shadowCameras_[i];
-        const Frustum& shadowCameraFrustum = shadowCamera->GetFrustum();
-        query.shadowCasterBegin_[i] = query.shadowCasterEnd_[i] = query.shadowCasters_.Size();
+void View::ProcessShadowSplit(LightQueryResult& query, unsigned splitIndex, unsigned threadIndex)
+{
+    query.shadowCasters_[splitIndex].Clear();
 
-        // For point light check that the face is visible: if not, can skip the split
-        if (type == LIGHT_POINT && frustum.IsInsideFast(BoundingBox(shadowCameraFrustum)) == OUTSIDE)
-            continue;
+    // The light may use fewer splits than were queued for it
+    if (splitIndex >= query.numSplits_)
+        return;
 
-        // For directional light check that the split is inside the visible scene: if not, can skip the split
-        if (type == LIGHT_DIRECTIONAL)
-        {
-            if (minZ_ > query.shadowFarSplits_[i])
-                continue;
-            if (maxZ_ < query.shadowNearSplits_[i])
-                continue;
+    LightType type = query.light_->GetLightType();
+    Camera* shadowCamera = query.shadowCameras_[splitIndex];
+    const Frustum& shadowCameraFrustum = shadowCamera->GetFrustum();
 
-            // Reuse lit geometry query for all except directional lights
-            ShadowCasterOctreeQuery query(tempDrawables, shadowCameraFrustum, DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
-            octree_->GetDrawables(query);
-        }
+    // For point light check that the face is visible: if not, can skip the split
+    if (type == LIGHT_POINT && cullCamera_->GetFrustum().IsInsideFast(BoundingBox(shadowCameraFrustum)) == OUTSIDE)
+        return;
+
+    // For directional light check that the split is inside the visible scene: if not, can skip the split
+    if (type == LIGHT_DIRECTIONAL)
+    {
+        if (minZ_ > query.shadowFarSplits_[splitIndex])
+            return;
+        if (maxZ_ < query.shadowNearSplits_[splitIndex])
+            return;
+
+        // Directional lights query the shadow casters for each split, while spot and point lights reuse the lit geometry query
+        PODVector<Drawable*>& tempDrawables = GetSubsystem<WorkQueue>()->GetScratchVector<Drawable*>(threadIndex);
+        ShadowCasterOctreeQuery octreeQuery(tempDrawables, shadowCameraFrustum, DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
+        octree_->GetDrawables(octreeQuery);
 
         // Check which shadow casters actually contribute to the shadowing
-        ProcessShadowCasters(query, tempDrawables, i);
+        ProcessShadowCasters(query, tempDrawables, splitIndex);
     }
-
-    // If no shadow casters, the light can be rendered unshadowed. At this point we have not allocated a shadow map yet, so the
-    // only cost has been the shadow camera setup & queries
-    if (query.shadowCasters_.Empty())
-        query.numSplits_ = 0;
+    else
+        ProcessShadowCasters(query, query.drawables_, splitIndex);
 }
 
 void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex)
@@ -2445,11 +2574,9 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
                 lightProjBox = lightViewBox.Projected(lightProj);
                 query.shadowCasterBox_[splitIndex].Merge(lightProjBox);
             }
-            query.shadowCasters_.Push(drawable);
+            query.shadowCasters_[splitIndex].Push(drawable);
         }
     }
-
-    query.shadowCasterEnd_[splitIndex] = query.shadowCasters_.Size();
 }
 
 bool View::IsShadowCasterVisible(Drawable* drawable, BoundingBox lightViewBox, Camera* shadowCamera, const Matrix3x4& lightView,
@@ -2895,6 +3022,41 @@ void View::SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& com
 }
 
 void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows)
+{
+    PrepareBatch(batch, allowInstancing);
+    AddPreparedBatchToQueue(queue, batch, tech, allowShadows, false);
+}
+
+void View::QueueBatch(BatchQueue& queue, Batch& batch, Technique* tech, PerThreadBatchResult* result, bool allowInstancing,
+    bool allowShadows)
+{
+    if (!result)
+    {
+        AddBatchToQueue(queue, batch, tech, allowInstancing, allowShadows);
+        return;
+    }
+
+    PrepareBatch(batch, allowInstancing);
+
+    // Choose shaders for non-instanced batches already in the worker thread if they do not need to be loaded.
+    // Batch groups choose their shaders when added to the queue
+    bool hasShaders = false;
+    if (batch.geometryType_ != GEOM_INSTANCED && renderer_->TrySetBatchShaders(batch, allowShadows, queue))
+    {
+        batch.CalculateSortKey();
+        hasShaders = true;
+    }
+
+    PendingBatch pending;
+    pending.batch_ = batch;
+    pending.queue_ = &queue;
+    pending.tech_ = tech;
+    pending.allowShadows_ = allowShadows;
+    pending.hasShaders_ = hasShaders;
+    result->batches_.Push(pending);
+}
+
+void View::PrepareBatch(Batch& batch, bool allowInstancing)
 {
     if (!batch.material_)
         batch.material_ = renderer_->GetDefaultMaterial();
@@ -2902,37 +3064,48 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
     // Convert to instanced if possible
     if (allowInstancing && batch.geometryType_ == GEOM_STATIC && batch.geometry_->GetIndexBuffer())
         batch.geometryType_ = GEOM_INSTANCED;
+}
 
+void View::AddPreparedBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowShadows, bool hasShaders)
+{
     if (batch.geometryType_ == GEOM_INSTANCED)
     {
         BatchGroupKey key(batch);
 
+        // Batch groups are retained across frames, so usually the group already exists
         HashMap<BatchGroupKey, BatchGroup>::Iterator i = queue.batchGroups_.Find(key);
         if (i == queue.batchGroups_.End())
+            i = queue.batchGroups_.Insert(MakePair(key, BatchGroup()));
+
+        BatchGroup& group = i->second_;
+        if (!group.used_)
         {
-            // Create a new group based on the batch
+            // Initialize the group from its first batch on this frame
             // In case the group remains below the instancing limit, do not enable instancing shaders yet
-            BatchGroup newGroup(batch);
-            newGroup.geometryType_ = GEOM_STATIC;
-            renderer_->SetBatchShaders(newGroup, tech, allowShadows, queue);
-            newGroup.CalculateSortKey();
-            i = queue.batchGroups_.Insert(MakePair(key, newGroup));
+            group.Reset(batch);
+            group.geometryType_ = GEOM_STATIC;
+            renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+            group.CalculateSortKey();
+            queue.usedBatchGroups_.Push(&group);
         }
 
-        int oldSize = i->second_.instances_.Size();
-        i->second_.AddTransforms(batch);
+        int oldSize = group.instances_.Size();
+        group.AddTransforms(batch);
         // Convert to using instancing shaders when the instancing limit is reached
-        if (oldSize < minInstances_ && (int)i->second_.instances_.Size() >= minInstances_)
+        if (oldSize < minInstances_ && (int)group.instances_.Size() >= minInstances_)
         {
-            i->second_.geometryType_ = GEOM_INSTANCED;
-            renderer_->SetBatchShaders(i->second_, tech, allowShadows, queue);
-            i->second_.CalculateSortKey();
+            group.geometryType_ = GEOM_INSTANCED;
+            renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+            group.CalculateSortKey();
         }
     }
     else
     {
-        renderer_->SetBatchShaders(batch, tech, allowShadows, queue);
-        batch.CalculateSortKey();
+        if (!hasShaders)
+        {
+            renderer_->SetBatchShaders(batch, tech, allowShadows, queue);
+            batch.CalculateSortKey();
+        }
 
         // If batch is static with multiple world transforms and cannot instance, we must push copies of the batch individually
         if (batch.geometryType_ == GEOM_STATIC && batch.numWorldTransforms_ > 1)
@@ -2981,11 +3154,10 @@ void View::PrepareInstancingBuffer()
 
     VertexBuffer* instancingBuffer = renderer_->GetInstancingBuffer();
     unsigned freeIndex = 0;
-    void* dest = instancingBuffer->Lock(0, totalInstances, true);
-    if (!dest)
-        return;
-
     const unsigned stride = instancingBuffer->GetVertexSize();
+    instancingData_.Resize(totalInstances * stride);
+    void* dest = instancingData_.Buffer();
+
     for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
         i->second_.SetInstancingData(dest, stride, freeIndex);
 
@@ -2997,7 +3169,7 @@ void View::PrepareInstancingBuffer()
         i->litBatches_.SetInstancingData(dest, stride, freeIndex);
     }
 
-    instancingBuffer->Unlock();
+    renderer_->SetInstancingBufferData(dest, totalInstances);
 }
 
 void View::SetupLightVolumeBatch(Batch& batch)
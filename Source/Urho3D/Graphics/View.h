@@ -24,6 +24,7 @@
 
 #include "../Container/HashSet.h"
 #include "../Container/List.h"
+#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Light.h"
@@ -58,14 +59,12 @@ struct LightQueryResult
     Light* light_;
     /// Lit geometries.
     PODVector<Drawable*> litGeometries_;
-    /// Shadow casters.
-    PODVector<Drawable*> shadowCasters_;
+    /// Octree query result for spot and point lights, reused for finding the shadow casters.
+    PODVector<Drawable*> drawables_;
+    /// Shadow casters of each split.
+    PODVector<Drawable*> shadowCasters_[MAX_LIGHT_SPLITS];
     /// Shadow cameras.
     Camera* shadowCameras_[MAX_LIGHT_SPLITS];
-    /// Shadow caster start indices.
-    unsigned shadowCasterBegin_[MAX_LIGHT_SPLITS];
-    /// Shadow caster end indices.
-    unsigned shadowCasterEnd_[MAX_LIGHT_SPLITS];
     /// Combined bounding box of shadow casters in light projection space. Only used for focused spot lights.
     BoundingBox shadowCasterBox_[MAX_LIGHT_SPLITS];
     /// Shadow camera near splits (directional lights only).
@@ -104,13 +103,62 @@ struct PerThreadSceneResult
     float maxZ_;
 };
 
+/// Batch generated in a worker thread, to be added to its queue in the main thread.
+struct PendingBatch
+{
+    /// Batch, with shaders and sort key already chosen if possible.
+    Batch batch_;
+    /// Destination batch queue.
+    BatchQueue* queue_;
+    /// Material technique.
+    Technique* tech_;
+    /// Allow shadows flag.
+    bool allowShadows_;
+    /// Whether shaders have been chosen.
+    bool hasShaders_;
+};
+
+/// Per-thread batch generation result.
+struct PerThreadBatchResult
+{
+    /// Generated batches.
+    PODVector<PendingBatch> batches_;
+    /// Geometry objects that will be updated in the main thread.
+    PODVector<Drawable*> nonThreadedGeometries_;
+    /// Geometry objects that will be updated in worker threads.
+    PODVector<Drawable*> threadedGeometries_;
+    /// Shadow casters that were not marked in view yet.
+    PODVector<Drawable*> shadowCasters_;
+    /// Materials to check for auxiliary views.
+    PODVector<Material*> auxViewMaterials_;
+};
+
+/// Batch generation task for one shadow split or a range of lit geometries of a per-pixel light.
+struct LightBatchTask
+{
+    /// Light query result.
+    LightQueryResult* query_;
+    /// Light queue.
+    LightBatchQueue* lightQueue_;
+    /// Shadow split index, or M_MAX_UNSIGNED for lit geometries.
+    unsigned splitIndex_;
+    /// Start index of shadow casters or lit geometries.
+    unsigned start_;
+    /// End index of shadow casters or lit geometries.
+    unsigned end_;
+};
+
 static const unsigned MAX_VIEWPORT_TEXTURES = 2;
 
 /// Internal structure for 3D rendering work. Created for each backbuffer and texture viewport, but not for shadow cameras.
 class URHO3D_API View : public Object
 {
-    friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
+    friend void CheckVisibilityWork(unsigned start, unsigned end, unsigned threadIndex, void* aux);
     friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    friend void ProcessShadowSplitWork(const WorkItem* item, unsigned threadIndex);
+    friend void UpdateDrawableGeometriesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux);
+    friend void GetBaseBatchesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux);
+    friend void GetLightBatchesWork(unsigned start, unsigned end, unsigned threadIndex, void* aux);
 
     URHO3D_OBJECT(View, Object);
 
@@ -118,7 +166,7 @@ public:
     /// Construct.
     explicit View(Context* context);
     /// Destruct.
-    ~View() override = default;
+    ~View() override;
 
     /// Define with rendertarget and viewport. Return true if successful.
     bool Define(RenderSurface* renderTarget, Viewport* viewport);
@@ -206,10 +254,16 @@ private:
     void GetLightBatches();
     /// Get unlit batches.
     void GetBaseBatches();
+    /// Get unlit batches for a drawable. Called from worker threads.
+    void GetDrawableBaseBatches(Drawable* drawable, PerThreadBatchResult& result);
+    /// Get shadow caster or lit geometry batches for a light batch task. Called from worker threads.
+    void GetLightTaskBatches(const LightBatchTask& task, PerThreadBatchResult& result);
+    /// Add batches and geometry updates collected by the worker threads.
+    void MergeBatchResults();
     /// Update geometries and sort batches.
     void UpdateGeometries();
     /// Get pixel lit batches for a certain light and drawable.
-    void GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue);
+    void GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue, PerThreadBatchResult* result = nullptr);
     /// Execute render commands.
     void ExecuteRenderPathCommands();
     /// Set rendertargets for current render command.
@@ -234,8 +288,12 @@ private:
     void UpdateOccluders(PODVector<Drawable*>& occluders, Camera* camera);
     /// Draw occluders to occlusion buffer.
     void DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders);
-    /// Query for lit geometries and shadow casters for a light.
+    /// Return whether a light should be rendered with shadows, before checking for shadow casters.
+    bool IsShadowed(Light* light) const;
+    /// Query for lit geometries for a light and set up its shadow cameras.
     void ProcessLight(LightQueryResult& query, unsigned threadIndex);
+    /// Query for shadow casters for a shadow split of a light.
+    void ProcessShadowSplit(LightQueryResult& query, unsigned splitIndex, unsigned threadIndex);
     /// Process shadow casters' visibilities and build their combined view- or projection-space bounding box.
     void ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex);
     /// Set up initial shadow camera view(s).
@@ -263,6 +321,13 @@ private:
     void SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& command);
     /// Choose shaders for a batch and add it to queue.
     void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
+    /// Add a batch to queue, or if a per-thread result is given, store it to be added to queue in the main thread.
+    void QueueBatch(BatchQueue& queue, Batch& batch, Technique* tech, PerThreadBatchResult* result, bool allowInstancing = true,
+        bool allowShadows = true);
+    /// Assign default material if necessary and convert the batch to instanced if possible.
+    void PrepareBatch(Batch& batch, bool allowInstancing);
+    /// Add a prepared batch to queue. Choose shaders if not chosen yet.
+    void AddPreparedBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowShadows, bool hasShaders);
     /// Prepare instancing buffer by filling it with all instance transforms.
     void PrepareInstancingBuffer();
     /// Set up a light volume rendering batch.
@@ -384,8 +449,6 @@ private:
     bool drawDebug_{};
     /// Renderpath.
     RenderPath* renderPath_{};
-    /// Per-thread octree query results.
-    Vector<PODVector<Drawable*> > tempDrawables_;
     /// Per-thread geometries, lights and Z range collection results.
     Vector<PerThreadSceneResult> sceneResults_;
     /// Visible zones.
@@ -409,14 +472,24 @@ private:
     HashMap<StringHash, Texture*> renderTargets_;
     /// Intermediate light processing results.
     Vector<LightQueryResult> lightQueryResults_;
+    /// Work items that finish the processing of each light.
+    Vector<SharedPtr<WorkItem> > lightItems_;
     /// Info for scene render passes defined by the renderpath.
     PODVector<ScenePassInfo> scenePasses_;
     /// Per-pixel light queues.
     Vector<LightBatchQueue> lightQueues_;
     /// Per-vertex light queues.
     HashMap<unsigned long long, LightBatchQueue> vertexLightQueues_;
+    /// Per-vertex light queue creation mutex.
+    Mutex vertexLightQueuesMutex_;
+    /// Per-thread batch generation results.
+    Vector<PerThreadBatchResult> batchResults_;
+    /// Light batch generation tasks.
+    PODVector<LightBatchTask> lightBatchTasks_;
     /// Batch queues by pass index.
     HashMap<unsigned, BatchQueue> batchQueues_;
+    /// Instancing buffer contents being assembled.
+    PODVector<unsigned char> instancingData_;
     /// Index of the GBuffer pass.
     unsigned gBufferPassIndex_{};
     /// Index of the opaque forward base pass.
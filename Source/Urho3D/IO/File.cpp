@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -33,6 +34,7 @@
 #include <SDL/SDL_rwops.h>
 #endif
 
+#include <atomic>
 #include <cstdio>
 #include <LZ4/lz4.h>
 
@@ -64,6 +66,53 @@ const char* APK = "/apk/";
 static const unsigned READ_BUFFER_SIZE = 32768;
 #endif
 static const unsigned SKIP_BUFFER_SIZE = 1024;
+static const unsigned MIN_DECOMPRESS_BLOCKS_PER_CHUNK = 2;
+
+/// Parallel block decompression data.
+struct DecompressBlocksData
+{
+    /// First block in the memory-mapped package file.
+    const unsigned char* blockData_;
+    /// Block offsets.
+    const unsigned* blockOffsets_;
+    /// Uncompressed block size.
+    unsigned blockSize_;
+    /// Uncompressed size of the whole file.
+    unsigned fileSize_;
+    /// Index of the first block to decompress.
+    unsigned startBlock_;
+    /// Destination for the first block.
+    unsigned char* dest_;
+    /// Failure flag.
+    std::atomic<bool> failed_;
+};
+
+/// Copy or decompress one block depending on whether it is stored uncompressed. Return true if successful.
+static bool DecompressBlockData(const unsigned char* src, unsigned packedSize, unsigned char* dest, unsigned unpackedSize)
+{
+    if (packedSize == unpackedSize)
+    {
+        memcpy(dest, src, unpackedSize);
+        return true;
+    }
+    else
+        return LZ4_decompress_safe((const char*)src, (char*)dest, packedSize, unpackedSize) == (int)unpackedSize;
+}
+
+static void DecompressBlocksWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* data = reinterpret_cast<DecompressBlocksData*>(aux);
+
+    for (unsigned i = start; i < end; ++i)
+    {
+        unsigned index = data->startBlock_ + i;
+        unsigned packedSize = data->blockOffsets_[index + 1] - data->blockOffsets_[index];
+        unsigned unpackedSize = Min(data->blockSize_, data->fileSize_ - index * data->blockSize_);
+        if (!DecompressBlockData(data->blockData_ + data->blockOffsets_[index], packedSize, data->dest_ + i * data->blockSize_,
+            unpackedSize))
+            data->failed_.store(true, std::memory_order_relaxed);
+    }
+}
 
 File::File(Context* context) :
     Object(context),
@@ -72,6 +121,10 @@ File::File(Context* context) :
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
+    mappedData_(nullptr),
+    blockSize_(0),
+    blockDataOffset_(0),
+    readBlock_(M_MAX_UNSIGNED),
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
@@ -89,6 +142,10 @@ File::File(Context* context, const String& fileName, FileMode mode) :
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
+    mappedData_(nullptr),
+    blockSize_(0),
+    blockDataOffset_(0),
+    readBlock_(M_MAX_UNSIGNED),
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
@@ -107,6 +164,10 @@ File::File(Context* context, PackageFile* package, const String& fileName) :
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
+    mappedData_(nullptr),
+    blockSize_(0),
+    blockDataOffset_(0),
+    readBlock_(M_MAX_UNSIGNED),
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
@@ -137,21 +198,91 @@ bool File::Open(PackageFile* package, const String& fileName)
     if (!entry)
         return false;
 
-    bool success = OpenInternal(package->GetName(), FILE_READ, true);
-    if (!success)
+    // From a memory-mapped package, read directly from the mapping without opening the package file again
+    if (package->IsMemoryMapped())
     {
-        URHO3D_LOGERROR("Could not open package file " + fileName);
-        return false;
+        Close();
+
+        name_ = fileName;
+        mode_ = FILE_READ;
+        mapping_ = package->GetMapping();
+        mappedData_ = mapping_->GetData() + entry->offset_;
+        position_ = 0;
+        offset_ = entry->offset_;
+        checksum_ = entry->checksum_;
+        size_ = entry->size_;
+        compressed_ = false;
+        readSyncNeeded_ = false;
+        writeSyncNeeded_ = false;
     }
+    else
+    {
+        bool success = OpenInternal(package->GetName(), FILE_READ, true);
+        if (!success)
+        {
+            URHO3D_LOGERROR("Could not open package file " + fileName);
+            return false;
+        }
 
-    name_ = fileName;
-    offset_ = entry->offset_;
-    checksum_ = entry->checksum_;
-    size_ = entry->size_;
-    compressed_ = package->IsCompressed();
+        name_ = fileName;
+        offset_ = entry->offset_;
+        checksum_ = entry->checksum_;
+        size_ = entry->size_;
+        // Block-indexed files are read through the block index instead of as a compressed stream
+        compressed_ = package->IsCompressed() && !package->IsBlockIndexed();
+
+        // Seek to beginning of package entry's file data
+        SeekInternal(offset_);
+    }
+
+    if (package->IsBlockIndexed())
+    {
+        // Read the block size and count, followed by the block offsets. Check that they fit in the package before reading,
+        // using 64-bit arithmetic so that corrupted values can not wrap around
+        unsigned blockHeader[2];
+        unsigned long long totalSize = package->GetTotalSize();
+        bool success = (unsigned long long)offset_ + sizeof blockHeader <= totalSize;
+        if (success)
+        {
+            if (mappedData_)
+                memcpy(blockHeader, mappedData_, sizeof blockHeader);
+            else
+                success = ReadInternal(blockHeader, sizeof blockHeader);
+        }
+
+        unsigned blockSize = blockHeader[0];
+        unsigned numBlocks = blockHeader[1];
+        success = success && blockSize && blockSize <= LZ4_MAX_INPUT_SIZE && numBlocks == (size_ + blockSize - 1) / blockSize &&
+            ((unsigned long long)numBlocks + 1) * sizeof(unsigned) <= totalSize - offset_ - sizeof blockHeader;
+        if (success)
+        {
+            blockOffsets_.Resize(numBlocks + 1);
+            if (mappedData_)
+                memcpy(blockOffsets_.Buffer(), mappedData_ + sizeof blockHeader, blockOffsets_.Size() * sizeof(unsigned));
+            else
+                success = ReadInternal(blockOffsets_.Buffer(), blockOffsets_.Size() * sizeof(unsigned));
+        }
+
+        // Validate the block offsets so that the blocks can be read without further range checks
+        blockDataOffset_ = success ? sizeof blockHeader + (numBlocks + 1) * sizeof(unsigned) : 0;
+        for (unsigned i = 0; success && i < numBlocks; ++i)
+        {
+            unsigned packedSize = blockOffsets_[i + 1] - blockOffsets_[i];
+            success = blockOffsets_[i + 1] >= blockOffsets_[i] && packedSize <= (unsigned)LZ4_compressBound(blockSize);
+        }
+        success = success && (unsigned long long)offset_ + blockDataOffset_ + blockOffsets_.Back() <= totalSize;
+
+        if (!success)
+        {
+            URHO3D_LOGERROR("Corrupted block index in package file " + fileName);
+            Close();
+            return false;
+        }
+
+        blockSize_ = blockSize;
+        readBlock_ = M_MAX_UNSIGNED;
+    }
 
-    // Seek to beginning of package entry's file data
-    SeekInternal(offset_);
     return true;
 }
 
@@ -174,6 +305,16 @@ unsigned File::Read(void* dest, unsigned size)
     if (!size)
         return 0;
 
+    if (blockSize_)
+        return ReadBlocks((unsigned char*)dest, size);
+
+    if (mappedData_)
+    {
+        memcpy(dest, mappedData_ + position_, size);
+        position_ += size;
+        return size;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_ && !compressed_)
     {
@@ -305,7 +446,10 @@ unsigned File::Seek(unsigned position)
         return position_;
     }
 
-    SeekInternal(position + offset_);
+    // Memory-mapped and block-indexed files have no file position of their own to move. Blocks are found from the index on
+    // the next read, which allows seeking also backward
+    if (!mappedData_ && !blockSize_)
+        SeekInternal(position + offset_);
     position_ = position;
     readSyncNeeded_ = false;
     writeSyncNeeded_ = false;
@@ -393,11 +537,18 @@ void File::Close()
 
     readBuffer_.Reset();
     inputBuffer_.Reset();
+    blockOffsets_.Clear();
+    blockSize_ = 0;
+    blockDataOffset_ = 0;
+    readBlock_ = M_MAX_UNSIGNED;
 
-    if (handle_)
+    if (handle_ || mappedData_)
     {
-        fclose((FILE*)handle_);
+        if (handle_)
+            fclose((FILE*)handle_);
         handle_ = nullptr;
+        mappedData_ = nullptr;
+        mapping_.Reset();
         position_ = 0;
         size_ = 0;
         offset_ = 0;
@@ -414,9 +565,9 @@ void File::Flush()
 bool File::IsOpen() const
 {
 #ifdef __ANDROID__
-    return handle_ != 0 || assetHandle_ != 0;
+    return handle_ != 0 || assetHandle_ != 0 || mappedData_ != 0;
 #else
-    return handle_ != nullptr;
+    return handle_ != nullptr || mappedData_ != nullptr;
 #endif
 }
 
@@ -545,4 +696,97 @@ void File::SeekInternal(unsigned newPosition)
         fseek((FILE*)handle_, newPosition, SEEK_SET);
 }
 
+unsigned File::ReadBlocks(unsigned char* dest, unsigned size)
+{
+    unsigned sizeLeft = size;
+
+    while (sizeLeft)
+    {
+        unsigned blockIndex = position_ / blockSize_;
+        unsigned blockStart = blockIndex * blockSize_;
+        unsigned unpackedSize = Min(blockSize_, size_ - blockStart);
+
+        // Decompress whole blocks directly to the destination. From a memory-mapped package the blocks can be decompressed
+        // in parallel, as long as the work queue is usable from this thread
+        if (position_ == blockStart && sizeLeft >= unpackedSize)
+        {
+            unsigned endPosition = position_ + sizeLeft;
+            unsigned endBlock = endPosition == size_ ? blockOffsets_.Size() - 1 : endPosition / blockSize_;
+            unsigned numBlocks = endBlock - blockIndex;
+            unsigned copySize = Min(numBlocks * blockSize_, size_ - position_);
+            bool success = true;
+
+            auto* queue = GetSubsystem<WorkQueue>();
+            if (mappedData_ && queue && numBlocks >= MIN_DECOMPRESS_BLOCKS_PER_CHUNK && Thread::IsMainThread())
+            {
+                DecompressBlocksData data;
+                data.blockData_ = mappedData_ + blockDataOffset_;
+                data.blockOffsets_ = blockOffsets_.Buffer();
+                data.blockSize_ = blockSize_;
+                data.fileSize_ = size_;
+                data.startBlock_ = blockIndex;
+                data.dest_ = dest;
+                data.failed_ = false;
+                queue->ParallelFor(numBlocks, DecompressBlocksWork, &data, MIN_DECOMPRESS_BLOCKS_PER_CHUNK);
+                success = !data.failed_;
+            }
+            else
+            {
+                for (unsigned i = 0; success && i < numBlocks; ++i)
+                    success = DecompressBlock(blockIndex + i, dest + i * blockSize_);
+            }
+
+            if (!success)
+                break;
+
+            dest += copySize;
+            sizeLeft -= copySize;
+            position_ += copySize;
+            continue;
+        }
+
+        if (readBlock_ != blockIndex)
+        {
+            if (!readBuffer_)
+                readBuffer_ = new unsigned char[blockSize_];
+            if (!DecompressBlock(blockIndex, readBuffer_.Get()))
+            {
+                readBlock_ = M_MAX_UNSIGNED;
+                break;
+            }
+            readBlock_ = blockIndex;
+        }
+
+        unsigned copySize = Min(unpackedSize - (position_ - blockStart), sizeLeft);
+        memcpy(dest, readBuffer_.Get() + position_ - blockStart, copySize);
+        dest += copySize;
+        sizeLeft -= copySize;
+        position_ += copySize;
+    }
+
+    if (sizeLeft)
+        URHO3D_LOGERROR("Error while decompressing file " + GetName());
+
+    return size - sizeLeft;
+}
+
+bool File::DecompressBlock(unsigned index, unsigned char* dest)
+{
+    unsigned packedSize = blockOffsets_[index + 1] - blockOffsets_[index];
+    unsigned unpackedSize = Min(blockSize_, size_ - index * blockSize_);
+
+    if (mappedData_)
+        return DecompressBlockData(mappedData_ + blockDataOffset_ + blockOffsets_[index], packedSize, dest, unpackedSize);
+
+    SeekInternal(offset_ + blockDataOffset_ + blockOffsets_[index]);
+    // Blocks stored uncompressed are read directly to the destination
+    if (packedSize == unpackedSize)
+        return ReadInternal(dest, unpackedSize);
+
+    if (!inputBuffer_)
+        inputBuffer_ = new unsigned char[LZ4_compressBound(blockSize_)];
+    return ReadInternal(inputBuffer_.Get(), packedSize) && DecompressBlockData(inputBuffer_.Get(), packedSize, dest,
+        unpackedSize);
+}
+
 }
@@ -57,6 +57,7 @@ enum FileMode
 };
 
 class PackageFile;
+class PackageFileMapping;
 
 /// %File opened either through the filesystem or from within a package file.
 class URHO3D_API File : public Object, public AbstractFile
@@ -103,6 +104,10 @@ public:
     /// Return the file handle.
     void* GetHandle() const { return handle_; }
 
+    /// Return the file contents when opened from a memory-mapped package file, or null otherwise. Allows parsing the file in place instead of reading it into a buffer. Valid until the file is closed, even if the package file is destroyed.
+    /// @nobind
+    const unsigned char* GetMappedData() const { return blockSize_ ? nullptr : mappedData_; }
+
     /// Return whether the file originates from a package.
     /// @property
     bool IsPackaged() const { return offset_ != 0; }
@@ -114,6 +119,10 @@ private:
     bool ReadInternal(void* dest, unsigned size);
     /// Seek in file internally using either C standard IO functions or SDL RWops for Android asset files.
     void SeekInternal(unsigned newPosition);
+    /// Read and decompress blocks of a block-indexed compressed package file. Whole blocks are decompressed directly to the destination, in parallel when the package file is memory-mapped. Return number of bytes read.
+    unsigned ReadBlocks(unsigned char* dest, unsigned size);
+    /// Decompress one block of a block-indexed compressed package file. Return true if successful.
+    bool DecompressBlock(unsigned index, unsigned char* dest);
 
     /// Open mode.
     FileMode mode_;
@@ -127,6 +136,18 @@ private:
     SharedArrayPtr<unsigned char> readBuffer_;
     /// Decompression input buffer for compressed file loading.
     SharedArrayPtr<unsigned char> inputBuffer_;
+    /// File contents within a memory-mapped package file.
+    const unsigned char* mappedData_;
+    /// Memory mapping of the package file, held to keep the contents mapped while the file is open.
+    SharedPtr<PackageFileMapping> mapping_;
+    /// Block start offsets relative to the first block, followed by the end offset, for block-indexed compressed package file loading.
+    PODVector<unsigned> blockOffsets_;
+    /// Uncompressed block size for block-indexed compressed package file loading, 0 otherwise.
+    unsigned blockSize_;
+    /// Offset of the first block from the start of the file data.
+    unsigned blockDataOffset_;
+    /// Index of the block currently in the read buffer, or M_MAX_UNSIGNED if none.
+    unsigned readBlock_;
     /// Read buffer position.
     unsigned readBufferOffset_;
     /// Bytes in the current read buffer.
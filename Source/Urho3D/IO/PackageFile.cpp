@@ -23,9 +23,20 @@
 #include "../Precompiled.h"
 
 #include "../IO/File.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/PackageFile.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../DebugNew.h"
+
 namespace Urho3D
 {
 
@@ -34,7 +45,8 @@ PackageFile::PackageFile(Context* context) :
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
-    compressed_(false)
+    compressed_(false),
+    blockIndexed_(false)
 {
 }
 
@@ -43,7 +55,8 @@ PackageFile::PackageFile(Context* context, const String& fileName, unsigned star
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
-    compressed_(false)
+    compressed_(false),
+    blockIndexed_(false)
 {
     Open(fileName, startOffset);
 }
@@ -52,6 +65,9 @@ PackageFile::~PackageFile() = default;
 
 bool PackageFile::Open(const String& fileName, unsigned startOffset)
 {
+    // Files already opened from the package keep their own reference to the mapping
+    mapping_.Reset();
+
     SharedPtr<File> file(new File(context_, fileName));
     if (!file->IsOpen())
         return false;
@@ -59,7 +75,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     // Check ID, then read the directory
     file->Seek(startOffset);
     String id = file->ReadFileID();
-    if (id != "UPAK" && id != "ULZ4")
+    if (id != "UPAK" && id != "ULZ4" && id != "ULZB")
     {
         // If start offset has not been explicitly specified, also try to read package size from the end of file
         // to know how much we must rewind to find the package start
@@ -76,7 +92,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
             }
         }
 
-        if (id != "UPAK" && id != "ULZ4")
+        if (id != "UPAK" && id != "ULZ4" && id != "ULZB")
         {
             URHO3D_LOGERROR(fileName + " is not a valid package file");
             return false;
@@ -86,7 +102,8 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     fileName_ = fileName;
     nameHash_ = fileName_;
     totalSize_ = file->GetSize();
-    compressed_ = id == "ULZ4";
+    compressed_ = id == "ULZ4" || id == "ULZB";
+    blockIndexed_ = id == "ULZB";
 
     unsigned numFiles = file->ReadUInt();
     checksum_ = file->ReadUInt();
@@ -95,10 +112,12 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     {
         String entryName = file->ReadString();
         PackageEntry newEntry{};
-        newEntry.offset_ = file->ReadUInt() + startOffset;
+        unsigned long long offset = (unsigned long long)file->ReadUInt() + startOffset;
+        newEntry.offset_ = (unsigned)offset;
         totalDataSize_ += (newEntry.size_ = file->ReadUInt());
         newEntry.checksum_ = file->ReadUInt();
-        if (!compressed_ && newEntry.offset_ + newEntry.size_ > totalSize_)
+        // The compressed data of a file is not its size, but must still start inside the package
+        if (compressed_ ? offset >= totalSize_ : offset + newEntry.size_ > totalSize_)
         {
             URHO3D_LOGERROR("File entry " + entryName + " outside package file");
             return false;
@@ -107,6 +126,15 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
             entries_[entryName] = newEntry;
     }
 
+    // Map uncompressed packages to read files in place, and block-indexed packages to decompress blocks in parallel. Compressed
+    // stream packages are read sequentially anyway, so they are not mapped. If mapping fails, files are opened and read through
+    // the filesystem instead
+    if (!compressed_ || blockIndexed_)
+    {
+        file->Close();
+        MapFile(fileName);
+    }
+
     return true;
 }
 
@@ -153,4 +181,69 @@ const PackageEntry* PackageFile::GetEntry(const String& fileName) const
     return nullptr;
 }
 
+bool PackageFile::MapFile(const String& fileName)
+{
+    if (!totalSize_)
+        return false;
+
+#if defined(__ANDROID__)
+    // Files inside the APK can not be mapped
+    if (URHO3D_IS_ASSET(fileName))
+        return false;
+#endif
+
+    SharedPtr<PackageFileMapping> mapping(new PackageFileMapping(fileName, totalSize_));
+    if (!mapping->GetData())
+        return false;
+
+    mapping_ = mapping;
+    return true;
+}
+
+PackageFileMapping::PackageFileMapping(const String& fileName, unsigned size) :
+    data_(nullptr),
+    size_(size),
+    refs_(0)
+{
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName).CString(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return;
+
+    // The view keeps the mapping object and the file open, so their handles can be closed right away
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(fileHandle);
+    if (!mappingHandle)
+        return;
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, size_);
+    CloseHandle(mappingHandle);
+    if (data)
+        data_ = (const unsigned char*)data;
+#elif !defined(__EMSCRIPTEN__)
+    int fd = open(GetNativePath(fileName).CString(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    // The mapping stays valid after closing the descriptor
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data != MAP_FAILED)
+        data_ = (const unsigned char*)data;
+#endif
+}
+
+PackageFileMapping::~PackageFileMapping()
+{
+    if (!data_)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#elif !defined(__EMSCRIPTEN__)
+    munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+}
+
 }
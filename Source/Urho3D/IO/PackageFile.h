@@ -24,6 +24,8 @@
 
 #include "../Core/Object.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
@@ -38,6 +40,44 @@ struct PackageEntry
     unsigned checksum_;
 };
 
+/// Read-only memory mapping of a package file. Shared by the package file and the files opened from it, so that it is unmapped only after the last of them releases it. The reference count is atomic, as files may be opened and closed in worker threads.
+class URHO3D_API PackageFileMapping
+{
+public:
+    /// Construct and map a file. The data is null if mapping is not supported or fails.
+    PackageFileMapping(const String& fileName, unsigned size);
+    /// Destruct. Unmap the file.
+    ~PackageFileMapping();
+    /// Prevent copy construction.
+    PackageFileMapping(const PackageFileMapping& rhs) = delete;
+    /// Prevent assignment.
+    PackageFileMapping& operator =(const PackageFileMapping& rhs) = delete;
+
+    /// Increment reference count.
+    void AddRef() { refs_.fetch_add(1, std::memory_order_relaxed); }
+    /// Decrement reference count and delete self if no more references.
+    void ReleaseRef()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    /// Return reference count.
+    int Refs() const { return refs_.load(std::memory_order_relaxed); }
+    /// Return the mapped file contents, or null if not mapped.
+    const unsigned char* GetData() const { return data_; }
+    /// Return size of the mapping.
+    unsigned GetSize() const { return size_; }
+
+private:
+    /// Mapped file contents.
+    const unsigned char* data_;
+    /// Size of the mapping.
+    unsigned size_;
+    /// Reference count.
+    std::atomic<int> refs_;
+};
+
 /// Stores files of a directory tree sequentially for convenient access.
 class URHO3D_API PackageFile : public Object
 {
@@ -88,10 +128,29 @@ public:
     /// @property
     bool IsCompressed() const { return compressed_; }
 
+    /// Return whether the compressed files are split into independently compressed blocks with an index, which allows seeking and decompressing the blocks in parallel.
+    /// @property
+    bool IsBlockIndexed() const { return blockIndexed_; }
+
+    /// Return whether the package file is memory-mapped. Uncompressed and block-indexed packages are mapped when the platform supports it, and files opened from them read directly from the mapping.
+    /// @property
+    bool IsMemoryMapped() const { return mapping_.NotNull(); }
+
+    /// Return the memory-mapped package file contents, or null if not mapped. Valid as long as the package file exists.
+    /// @nobind
+    const unsigned char* GetMappedData() const { return mapping_ ? mapping_->GetData() : nullptr; }
+
+    /// Return the memory mapping, or null if not mapped. Files opened from the package hold a reference to keep it mapped.
+    /// @nobind
+    PackageFileMapping* GetMapping() const { return mapping_; }
+
     /// Return list of file names in the package.
     const Vector<String> GetEntryNames() const { return entries_.Keys(); }
 
 private:
+    /// Map the whole package file into memory. Return true if successful.
+    bool MapFile(const String& fileName);
+
     /// File entries.
     HashMap<String, PackageEntry> entries_;
     /// File name.
@@ -104,8 +163,12 @@ private:
     unsigned totalDataSize_;
     /// Package file checksum.
     unsigned checksum_;
+    /// Memory mapping of the package file.
+    SharedPtr<PackageFileMapping> mapping_;
     /// Compressed flag.
     bool compressed_;
+    /// Block-indexed compression flag.
+    bool blockIndexed_;
 };
 
 }
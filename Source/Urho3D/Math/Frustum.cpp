@@ -24,6 +24,8 @@
 
 #include "../Math/Frustum.h"
 
+#include <cstring>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -68,6 +70,7 @@ Frustum& Frustum::operator =(const Frustum& rhs) noexcept
         planes_[i] = rhs.planes_[i];
     for (unsigned i = 0; i < NUM_FRUSTUM_VERTICES; ++i)
         vertices_[i] = rhs.vertices_[i];
+    memcpy(simdPlanes_, rhs.simdPlanes_, sizeof simdPlanes_);
 
     return *this;
 }
@@ -241,6 +244,27 @@ void Frustum::UpdatePlanes()
         }
     }
 
+    for (unsigned i = 0; i < NUM_FRUSTUM_SIMD_PLANES; ++i)
+    {
+        if (i < NUM_FRUSTUM_PLANES)
+        {
+            const Plane& plane = planes_[i];
+            simdPlanes_[0][i] = plane.normal_.x_;
+            simdPlanes_[1][i] = plane.normal_.y_;
+            simdPlanes_[2][i] = plane.normal_.z_;
+            simdPlanes_[3][i] = plane.d_;
+            simdPlanes_[4][i] = plane.absNormal_.x_;
+            simdPlanes_[5][i] = plane.absNormal_.y_;
+            simdPlanes_[6][i] = plane.absNormal_.z_;
+        }
+        else
+        {
+            // Padding plane: zero normal and infinite constant, so every point is at positive distance
+            for (unsigned j = 0; j < 7; ++j)
+                simdPlanes_[j][i] = 0.0f;
+            simdPlanes_[3][i] = M_INFINITY;
+        }
+    }
 }
 
 }
@@ -28,6 +28,7 @@
 #include "../Math/Matrix3x4.h"
 #include "../Math/Plane.h"
 #include "../Math/Rect.h"
+#include "../Math/SIMD.h"
 #include "../Math/Sphere.h"
 
 namespace Urho3D
@@ -46,6 +47,8 @@ enum FrustumPlane
 
 static const unsigned NUM_FRUSTUM_PLANES = 6;
 static const unsigned NUM_FRUSTUM_VERTICES = 8;
+/// Number of planes in the structure-of-arrays plane data, padded to a multiple of the SIMD width.
+static const unsigned NUM_FRUSTUM_SIMD_PLANES = 8;
 
 /// Convex constructed of 6 planes.
 class URHO3D_API Frustum
@@ -82,6 +85,15 @@ public:
     /// Test if a point is inside or outside.
     Intersection IsInside(const Vector3& point) const
     {
+#ifdef URHO3D_SIMD
+        SimdVector x = SimdSplat(point.x_);
+        SimdVector y = SimdSplat(point.y_);
+        SimdVector z = SimdSplat(point.z_);
+        SimdVector zero = SimdSplat(0.0f);
+
+        return SimdAnyTrue(SimdOr(SimdLess(PlaneDistances(0, x, y, z), zero), SimdLess(PlaneDistances(4, x, y, z), zero))) ?
+            OUTSIDE : INSIDE;
+#else
         for (const auto& plane : planes_)
         {
             if (plane.Distance(point) < 0.0f)
@@ -89,11 +101,25 @@ public:
         }
 
         return INSIDE;
+#endif
     }
 
     /// Test if a sphere is inside, outside or intersects.
     Intersection IsInside(const Sphere& sphere) const
     {
+#ifdef URHO3D_SIMD
+        SimdVector x = SimdSplat(sphere.center_.x_);
+        SimdVector y = SimdSplat(sphere.center_.y_);
+        SimdVector z = SimdSplat(sphere.center_.z_);
+        SimdVector radius = SimdSplat(sphere.radius_);
+        SimdVector negRadius = SimdSplat(-sphere.radius_);
+        SimdVector dist0 = PlaneDistances(0, x, y, z);
+        SimdVector dist1 = PlaneDistances(4, x, y, z);
+
+        if (SimdAnyTrue(SimdOr(SimdLess(dist0, negRadius), SimdLess(dist1, negRadius))))
+            return OUTSIDE;
+        return SimdAnyTrue(SimdOr(SimdLess(dist0, radius), SimdLess(dist1, radius))) ? INTERSECTS : INSIDE;
+#else
         bool allInside = true;
         for (const auto& plane : planes_)
         {
@@ -105,11 +131,21 @@ public:
         }
 
         return allInside ? INSIDE : INTERSECTS;
+#endif
     }
 
     /// Test if a sphere if (partially) inside or outside.
     Intersection IsInsideFast(const Sphere& sphere) const
     {
+#ifdef URHO3D_SIMD
+        SimdVector x = SimdSplat(sphere.center_.x_);
+        SimdVector y = SimdSplat(sphere.center_.y_);
+        SimdVector z = SimdSplat(sphere.center_.z_);
+        SimdVector negRadius = SimdSplat(-sphere.radius_);
+
+        return SimdAnyTrue(SimdOr(SimdLess(PlaneDistances(0, x, y, z), negRadius), SimdLess(PlaneDistances(4, x, y, z), negRadius))) ?
+            OUTSIDE : INSIDE;
+#else
         for (const auto& plane : planes_)
         {
             if (plane.Distance(sphere.center_) < -sphere.radius_)
@@ -117,6 +153,7 @@ public:
         }
 
         return INSIDE;
+#endif
     }
 
     /// Test if a bounding box is inside, outside or intersects.
@@ -124,6 +161,23 @@ public:
     {
         Vector3 center = box.Center();
         Vector3 edge = center - box.min_;
+#ifdef URHO3D_SIMD
+        SimdVector x = SimdSplat(center.x_);
+        SimdVector y = SimdSplat(center.y_);
+        SimdVector z = SimdSplat(center.z_);
+        SimdVector edgeX = SimdSplat(edge.x_);
+        SimdVector edgeY = SimdSplat(edge.y_);
+        SimdVector edgeZ = SimdSplat(edge.z_);
+        SimdVector dist0 = PlaneDistances(0, x, y, z);
+        SimdVector dist1 = PlaneDistances(4, x, y, z);
+        SimdVector absDist0 = PlaneAbsDotProducts(0, edgeX, edgeY, edgeZ);
+        SimdVector absDist1 = PlaneAbsDotProducts(4, edgeX, edgeY, edgeZ);
+        SimdVector zero = SimdSplat(0.0f);
+
+        if (SimdAnyTrue(SimdOr(SimdLess(dist0, SimdSub(zero, absDist0)), SimdLess(dist1, SimdSub(zero, absDist1)))))
+            return OUTSIDE;
+        return SimdAnyTrue(SimdOr(SimdLess(dist0, absDist0), SimdLess(dist1, absDist1))) ? INTERSECTS : INSIDE;
+#else
         bool allInside = true;
 
         for (const auto& plane : planes_)
@@ -138,6 +192,7 @@ public:
         }
 
         return allInside ? INSIDE : INTERSECTS;
+#endif
     }
 
     /// Test if a bounding box is (partially) inside or outside.
@@ -145,7 +200,19 @@ public:
     {
         Vector3 center = box.Center();
         Vector3 edge = center - box.min_;
+#ifdef URHO3D_SIMD
+        SimdVector x = SimdSplat(center.x_);
+        SimdVector y = SimdSplat(center.y_);
+        SimdVector z = SimdSplat(center.z_);
+        SimdVector edgeX = SimdSplat(edge.x_);
+        SimdVector edgeY = SimdSplat(edge.y_);
+        SimdVector edgeZ = SimdSplat(edge.z_);
+        SimdVector zero = SimdSplat(0.0f);
+        SimdVector outside0 = SimdLess(PlaneDistances(0, x, y, z), SimdSub(zero, PlaneAbsDotProducts(0, edgeX, edgeY, edgeZ)));
+        SimdVector outside1 = SimdLess(PlaneDistances(4, x, y, z), SimdSub(zero, PlaneAbsDotProducts(4, edgeX, edgeY, edgeZ)));
 
+        return SimdAnyTrue(SimdOr(outside0, outside1)) ? OUTSIDE : INSIDE;
+#else
         for (const auto& plane : planes_)
         {
             float dist = plane.normal_.DotProduct(center) + plane.d_;
@@ -156,6 +223,7 @@ public:
         }
 
         return INSIDE;
+#endif
     }
 
     /// Return distance of a point to the frustum, or 0 if inside.
@@ -182,6 +250,28 @@ public:
     Plane planes_[NUM_FRUSTUM_PLANES];
     /// Frustum vertices.
     Vector3 vertices_[NUM_FRUSTUM_VERTICES];
+
+private:
+#ifdef URHO3D_SIMD
+    /// Return signed distances of a point to four planes starting from index. The point coordinates are given splatted.
+    SimdVector PlaneDistances(unsigned index, SimdVector x, SimdVector y, SimdVector z) const
+    {
+        // Same operation order as Plane::Distance() so that the results match the scalar tests exactly
+        SimdVector dist = SimdAdd(SimdMul(SimdLoad(&simdPlanes_[0][index]), x), SimdMul(SimdLoad(&simdPlanes_[1][index]), y));
+        dist = SimdAdd(dist, SimdMul(SimdLoad(&simdPlanes_[2][index]), z));
+        return SimdAdd(dist, SimdLoad(&simdPlanes_[3][index]));
+    }
+
+    /// Return dot products of a vector with the absolute normals of four planes starting from index. The vector coordinates are given splatted.
+    SimdVector PlaneAbsDotProducts(unsigned index, SimdVector x, SimdVector y, SimdVector z) const
+    {
+        SimdVector dot = SimdAdd(SimdMul(SimdLoad(&simdPlanes_[4][index]), x), SimdMul(SimdLoad(&simdPlanes_[5][index]), y));
+        return SimdAdd(dot, SimdMul(SimdLoad(&simdPlanes_[6][index]), z));
+    }
+#endif
+
+    /// Plane data in structure-of-arrays layout for the SIMD tests: normal x, y, z, constant and absolute normal x, y, z. Padding planes never reject anything. Updated by UpdatePlanes().
+    float simdPlanes_[7][NUM_FRUSTUM_SIMD_PLANES]{};
 };
 
 }
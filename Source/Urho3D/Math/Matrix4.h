@@ -23,12 +23,9 @@
 #pragma once
 
 #include "../Math/Quaternion.h"
+#include "../Math/SIMD.h"
 #include "../Math/Vector4.h"
 
-#ifdef URHO3D_SSE
-#include <emmintrin.h>
-#endif
-
 namespace Urho3D
 {
 
@@ -40,7 +37,7 @@ class URHO3D_API Matrix4
 public:
     /// Construct an identity matrix.
     Matrix4() noexcept
-#ifndef URHO3D_SSE
+#ifndef URHO3D_SIMD
        :m00_(1.0f),
         m01_(0.0f),
         m02_(0.0f),
@@ -59,17 +56,17 @@ public:
         m33_(1.0f)
 #endif
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&m00_, _mm_set_ps(0.f, 0.f, 0.f, 1.f));
-        _mm_storeu_ps(&m10_, _mm_set_ps(0.f, 0.f, 1.f, 0.f));
-        _mm_storeu_ps(&m20_, _mm_set_ps(0.f, 1.f, 0.f, 0.f));
-        _mm_storeu_ps(&m30_, _mm_set_ps(1.f, 0.f, 0.f, 0.f));
+#ifdef URHO3D_SIMD
+        SimdStore(&m00_, SimdSet(1.0f, 0.0f, 0.0f, 0.0f));
+        SimdStore(&m10_, SimdSet(0.0f, 1.0f, 0.0f, 0.0f));
+        SimdStore(&m20_, SimdSet(0.0f, 0.0f, 1.0f, 0.0f));
+        SimdStore(&m30_, SimdSet(0.0f, 0.0f, 0.0f, 1.0f));
 #endif
     }
 
     /// Copy-construct from another matrix.
     Matrix4(const Matrix4& matrix) noexcept
-#ifndef URHO3D_SSE
+#ifndef URHO3D_SIMD
        :m00_(matrix.m00_),
         m01_(matrix.m01_),
         m02_(matrix.m02_),
@@ -88,11 +85,11 @@ public:
         m33_(matrix.m33_)
 #endif
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&m00_, _mm_loadu_ps(&matrix.m00_));
-        _mm_storeu_ps(&m10_, _mm_loadu_ps(&matrix.m10_));
-        _mm_storeu_ps(&m20_, _mm_loadu_ps(&matrix.m20_));
-        _mm_storeu_ps(&m30_, _mm_loadu_ps(&matrix.m30_));
+#ifdef URHO3D_SIMD
+        SimdStore(&m00_, SimdLoad(&matrix.m00_));
+        SimdStore(&m10_, SimdLoad(&matrix.m10_));
+        SimdStore(&m20_, SimdLoad(&matrix.m20_));
+        SimdStore(&m30_, SimdLoad(&matrix.m30_));
 #endif
     }
 
@@ -143,7 +140,7 @@ public:
 
     /// Construct from a float array.
     explicit Matrix4(const float* data) noexcept
-#ifndef URHO3D_SSE
+#ifndef URHO3D_SIMD
        :m00_(data[0]),
         m01_(data[1]),
         m02_(data[2]),
@@ -162,22 +159,22 @@ public:
         m33_(data[15])
 #endif
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&m00_, _mm_loadu_ps(data));
-        _mm_storeu_ps(&m10_, _mm_loadu_ps(data + 4));
-        _mm_storeu_ps(&m20_, _mm_loadu_ps(data + 8));
-        _mm_storeu_ps(&m30_, _mm_loadu_ps(data + 12));
+#ifdef URHO3D_SIMD
+        SimdStore(&m00_, SimdLoad(data));
+        SimdStore(&m10_, SimdLoad(data + 4));
+        SimdStore(&m20_, SimdLoad(data + 8));
+        SimdStore(&m30_, SimdLoad(data + 12));
 #endif
     }
 
     /// Assign from another matrix.
     Matrix4& operator =(const Matrix4& rhs) noexcept
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&m00_, _mm_loadu_ps(&rhs.m00_));
-        _mm_storeu_ps(&m10_, _mm_loadu_ps(&rhs.m10_));
-        _mm_storeu_ps(&m20_, _mm_loadu_ps(&rhs.m20_));
-        _mm_storeu_ps(&m30_, _mm_loadu_ps(&rhs.m30_));
+#ifdef URHO3D_SIMD
+        SimdStore(&m00_, SimdLoad(&rhs.m00_));
+        SimdStore(&m10_, SimdLoad(&rhs.m10_));
+        SimdStore(&m20_, SimdLoad(&rhs.m20_));
+        SimdStore(&m30_, SimdLoad(&rhs.m30_));
 #else
         m00_ = rhs.m00_;
         m01_ = rhs.m01_;
@@ -224,19 +221,12 @@ public:
     /// Test for equality with another matrix without epsilon.
     bool operator ==(const Matrix4& rhs) const
     {
-#ifdef URHO3D_SSE
-        __m128 c0 = _mm_cmpeq_ps(_mm_loadu_ps(&m00_), _mm_loadu_ps(&rhs.m00_));
-        __m128 c1 = _mm_cmpeq_ps(_mm_loadu_ps(&m10_), _mm_loadu_ps(&rhs.m10_));
-        c0 = _mm_and_ps(c0, c1);
-        __m128 c2 = _mm_cmpeq_ps(_mm_loadu_ps(&m20_), _mm_loadu_ps(&rhs.m20_));
-        __m128 c3 = _mm_cmpeq_ps(_mm_loadu_ps(&m30_), _mm_loadu_ps(&rhs.m30_));
-        c2 = _mm_and_ps(c2, c3);
-        c0 = _mm_and_ps(c0, c2);
-        __m128 hi = _mm_movehl_ps(c0, c0);
-        c0 = _mm_and_ps(c0, hi);
-        hi = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(1, 1, 1, 1));
-        c0 = _mm_and_ps(c0, hi);
-        return _mm_cvtsi128_si32(_mm_castps_si128(c0)) == -1;
+#ifdef URHO3D_SIMD
+        SimdVector c0 = SimdEqual(SimdLoad(&m00_), SimdLoad(&rhs.m00_));
+        SimdVector c1 = SimdEqual(SimdLoad(&m10_), SimdLoad(&rhs.m10_));
+        SimdVector c2 = SimdEqual(SimdLoad(&m20_), SimdLoad(&rhs.m20_));
+        SimdVector c3 = SimdEqual(SimdLoad(&m30_), SimdLoad(&rhs.m30_));
+        return SimdAllTrue(SimdAnd(SimdAnd(c0, c1), SimdAnd(c2, c3)));
 #else
         const float* leftData = Data();
         const float* rightData = rhs.Data();
@@ -257,24 +247,20 @@ public:
     /// Multiply a Vector3 which is assumed to represent position.
     Vector3 operator *(const Vector3& rhs) const
     {
-#ifdef URHO3D_SSE
-        __m128 vec = _mm_set_ps(1.f, rhs.z_, rhs.y_, rhs.x_);
-        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00_), vec);
-        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10_), vec);
-        __m128 t0 = _mm_unpacklo_ps(r0, r1);
-        __m128 t1 = _mm_unpackhi_ps(r0, r1);
-        t0 = _mm_add_ps(t0, t1);
-        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20_), vec);
-        __m128 r3 = _mm_mul_ps(_mm_loadu_ps(&m30_), vec);
-        __m128 t2 = _mm_unpacklo_ps(r2, r3);
-        __m128 t3 = _mm_unpackhi_ps(r2, r3);
-        t2 = _mm_add_ps(t2, t3);
-        vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
-        vec = _mm_div_ps(vec, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(3, 3, 3, 3)));
-        return Vector3(
-            _mm_cvtss_f32(vec),
-            _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
-            _mm_cvtss_f32(_mm_movehl_ps(vec, vec)));
+#ifdef URHO3D_SIMD
+        // Sum the columns scaled by the vector components, in the same order as the scalar version
+        SimdVector c0 = SimdLoad(&m00_);
+        SimdVector c1 = SimdLoad(&m10_);
+        SimdVector c2 = SimdLoad(&m20_);
+        SimdVector c3 = SimdLoad(&m30_);
+        SimdTranspose(c0, c1, c2, c3);
+        SimdVector vec = SimdAdd(SimdMul(c0, SimdSplat(rhs.x_)), SimdMul(c1, SimdSplat(rhs.y_)));
+        vec = SimdAdd(SimdAdd(vec, SimdMul(c2, SimdSplat(rhs.z_))), c3);
+
+        float ret[4];
+        SimdStore(ret, vec);
+        float invW = 1.0f / ret[3];
+        return Vector3(ret[0] * invW, ret[1] * invW, ret[2] * invW);
 #else
         float invW = 1.0f / (m30_ * rhs.x_ + m31_ * rhs.y_ + m32_ * rhs.z_ + m33_);
 
@@ -289,22 +275,20 @@ public:
     /// Multiply a Vector4.
     Vector4 operator *(const Vector4& rhs) const
     {
-#ifdef URHO3D_SSE
-        __m128 vec = _mm_loadu_ps(&rhs.x_);
-        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00_), vec);
-        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10_), vec);
-        __m128 t0 = _mm_unpacklo_ps(r0, r1);
-        __m128 t1 = _mm_unpackhi_ps(r0, r1);
-        t0 = _mm_add_ps(t0, t1);
-        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20_), vec);
-        __m128 r3 = _mm_mul_ps(_mm_loadu_ps(&m30_), vec);
-        __m128 t2 = _mm_unpacklo_ps(r2, r3);
-        __m128 t3 = _mm_unpackhi_ps(r2, r3);
-        t2 = _mm_add_ps(t2, t3);
-        vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+#ifdef URHO3D_SIMD
+        // Sum the columns scaled by the vector components, in the same order as the scalar version
+        SimdVector c0 = SimdLoad(&m00_);
+        SimdVector c1 = SimdLoad(&m10_);
+        SimdVector c2 = SimdLoad(&m20_);
+        SimdVector c3 = SimdLoad(&m30_);
+        SimdTranspose(c0, c1, c2, c3);
+        SimdVector vec = SimdLoad(&rhs.x_);
+        SimdVector sum = SimdAdd(SimdMul(c0, SimdSplatLane<0>(vec)), SimdMul(c1, SimdSplatLane<1>(vec)));
+        sum = SimdAdd(sum, SimdMul(c2, SimdSplatLane<2>(vec)));
+        sum = SimdAdd(sum, SimdMul(c3, SimdSplatLane<3>(vec)));
 
         Vector4 ret;
-        _mm_storeu_ps(&ret.x_, vec);
+        SimdStore(&ret.x_, sum);
         return ret;
 #else
         return Vector4(
@@ -319,12 +303,17 @@ public:
     /// Add a matrix.
     Matrix4 operator +(const Matrix4& rhs) const
     {
-#ifdef URHO3D_SSE
+#if defined(URHO3D_AVX)
         Matrix4 ret;
-        _mm_storeu_ps(&ret.m00_, _mm_add_ps(_mm_loadu_ps(&m00_), _mm_loadu_ps(&rhs.m00_)));
-        _mm_storeu_ps(&ret.m10_, _mm_add_ps(_mm_loadu_ps(&m10_), _mm_loadu_ps(&rhs.m10_)));
-        _mm_storeu_ps(&ret.m20_, _mm_add_ps(_mm_loadu_ps(&m20_), _mm_loadu_ps(&rhs.m20_)));
-        _mm_storeu_ps(&ret.m30_, _mm_add_ps(_mm_loadu_ps(&m30_), _mm_loadu_ps(&rhs.m30_)));
+        SimdStore8(&ret.m00_, SimdAdd8(SimdLoad8(&m00_), SimdLoad8(&rhs.m00_)));
+        SimdStore8(&ret.m20_, SimdAdd8(SimdLoad8(&m20_), SimdLoad8(&rhs.m20_)));
+        return ret;
+#elif defined(URHO3D_SIMD)
+        Matrix4 ret;
+        SimdStore(&ret.m00_, SimdAdd(SimdLoad(&m00_), SimdLoad(&rhs.m00_)));
+        SimdStore(&ret.m10_, SimdAdd(SimdLoad(&m10_), SimdLoad(&rhs.m10_)));
+        SimdStore(&ret.m20_, SimdAdd(SimdLoad(&m20_), SimdLoad(&rhs.m20_)));
+        SimdStore(&ret.m30_, SimdAdd(SimdLoad(&m30_), SimdLoad(&rhs.m30_)));
         return ret;
 #else
         return Matrix4(
@@ -351,12 +340,17 @@ public:
     /// Subtract a matrix.
     Matrix4 operator -(const Matrix4& rhs) const
     {
-#ifdef URHO3D_SSE
+#if defined(URHO3D_AVX)
+        Matrix4 ret;
+        SimdStore8(&ret.m00_, SimdSub8(SimdLoad8(&m00_), SimdLoad8(&rhs.m00_)));
+        SimdStore8(&ret.m20_, SimdSub8(SimdLoad8(&m20_), SimdLoad8(&rhs.m20_)));
+        return ret;
+#elif defined(URHO3D_SIMD)
         Matrix4 ret;
-        _mm_storeu_ps(&ret.m00_, _mm_sub_ps(_mm_loadu_ps(&m00_), _mm_loadu_ps(&rhs.m00_)));
-        _mm_storeu_ps(&ret.m10_, _mm_sub_ps(_mm_loadu_ps(&m10_), _mm_loadu_ps(&rhs.m10_)));
-        _mm_storeu_ps(&ret.m20_, _mm_sub_ps(_mm_loadu_ps(&m20_), _mm_loadu_ps(&rhs.m20_)));
-        _mm_storeu_ps(&ret.m30_, _mm_sub_ps(_mm_loadu_ps(&m30_), _mm_loadu_ps(&rhs.m30_)));
+        SimdStore(&ret.m00_, SimdSub(SimdLoad(&m00_), SimdLoad(&rhs.m00_)));
+        SimdStore(&ret.m10_, SimdSub(SimdLoad(&m10_), SimdLoad(&rhs.m10_)));
+        SimdStore(&ret.m20_, SimdSub(SimdLoad(&m20_), SimdLoad(&rhs.m20_)));
+        SimdStore(&ret.m30_, SimdSub(SimdLoad(&m30_), SimdLoad(&rhs.m30_)));
         return ret;
 #else
         return Matrix4(
@@ -383,13 +377,19 @@ public:
     /// Multiply with a scalar.
     Matrix4 operator *(float rhs) const
     {
-#ifdef URHO3D_SSE
+#if defined(URHO3D_AVX)
         Matrix4 ret;
-        const __m128 mul = _mm_set1_ps(rhs);
-        _mm_storeu_ps(&ret.m00_, _mm_mul_ps(_mm_loadu_ps(&m00_), mul));
-        _mm_storeu_ps(&ret.m10_, _mm_mul_ps(_mm_loadu_ps(&m10_), mul));
-        _mm_storeu_ps(&ret.m20_, _mm_mul_ps(_mm_loadu_ps(&m20_), mul));
-        _mm_storeu_ps(&ret.m30_, _mm_mul_ps(_mm_loadu_ps(&m30_), mul));
+        const SimdVector8 mul = SimdSplat8(rhs);
+        SimdStore8(&ret.m00_, SimdMul8(SimdLoad8(&m00_), mul));
+        SimdStore8(&ret.m20_, SimdMul8(SimdLoad8(&m20_), mul));
+        return ret;
+#elif defined(URHO3D_SIMD)
+        Matrix4 ret;
+        const SimdVector mul = SimdSplat(rhs);
+        SimdStore(&ret.m00_, SimdMul(SimdLoad(&m00_), mul));
+        SimdStore(&ret.m10_, SimdMul(SimdLoad(&m10_), mul));
+        SimdStore(&ret.m20_, SimdMul(SimdLoad(&m20_), mul));
+        SimdStore(&ret.m30_, SimdMul(SimdLoad(&m30_), mul));
         return ret;
 #else
         return Matrix4(
@@ -416,41 +416,53 @@ public:
     /// Multiply a matrix.
     Matrix4 operator *(const Matrix4& rhs) const
     {
-#ifdef URHO3D_SSE
+#if defined(URHO3D_AVX)
+        // Two rows at a time. The rows of the result are sums of the rows of rhs scaled by the row elements, in the same
+        // order as the scalar version
         Matrix4 out;
+        SimdVector8 r0 = SimdLoadBoth(&rhs.m00_);
+        SimdVector8 r1 = SimdLoadBoth(&rhs.m10_);
+        SimdVector8 r2 = SimdLoadBoth(&rhs.m20_);
+        SimdVector8 r3 = SimdLoadBoth(&rhs.m30_);
+
+        SimdVector8 l = SimdLoad8(&m00_);
+        SimdVector8 t = SimdAdd8(SimdMul8(SimdSplatLane8<0>(l), r0), SimdMul8(SimdSplatLane8<1>(l), r1));
+        t = SimdAdd8(t, SimdMul8(SimdSplatLane8<2>(l), r2));
+        SimdStore8(&out.m00_, SimdAdd8(t, SimdMul8(SimdSplatLane8<3>(l), r3)));
 
-        __m128 r0 = _mm_loadu_ps(&rhs.m00_);
-        __m128 r1 = _mm_loadu_ps(&rhs.m10_);
-        __m128 r2 = _mm_loadu_ps(&rhs.m20_);
-        __m128 r3 = _mm_loadu_ps(&rhs.m30_);
-
-        __m128 l = _mm_loadu_ps(&m00_);
-        __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m00_, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m10_);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m10_, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m20_);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m20_, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m30_);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m30_, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+        l = SimdLoad8(&m20_);
+        t = SimdAdd8(SimdMul8(SimdSplatLane8<0>(l), r0), SimdMul8(SimdSplatLane8<1>(l), r1));
+        t = SimdAdd8(t, SimdMul8(SimdSplatLane8<2>(l), r2));
+        SimdStore8(&out.m20_, SimdAdd8(t, SimdMul8(SimdSplatLane8<3>(l), r3)));
+
+        return out;
+#elif defined(URHO3D_SIMD)
+        // The rows of the result are sums of the rows of rhs scaled by the row elements, in the same order as the scalar version
+        Matrix4 out;
+        SimdVector r0 = SimdLoad(&rhs.m00_);
+        SimdVector r1 = SimdLoad(&rhs.m10_);
+        SimdVector r2 = SimdLoad(&rhs.m20_);
+        SimdVector r3 = SimdLoad(&rhs.m30_);
+
+        SimdVector l = SimdLoad(&m00_);
+        SimdVector t = SimdAdd(SimdMul(SimdSplatLane<0>(l), r0), SimdMul(SimdSplatLane<1>(l), r1));
+        t = SimdAdd(t, SimdMul(SimdSplatLane<2>(l), r2));
+        SimdStore(&out.m00_, SimdAdd(t, SimdMul(SimdSplatLane<3>(l), r3)));
+
+        l = SimdLoad(&m10_);
+        t = SimdAdd(SimdMul(SimdSplatLane<0>(l), r0), SimdMul(SimdSplatLane<1>(l), r1));
+        t = SimdAdd(t, SimdMul(SimdSplatLane<2>(l), r2));
+        SimdStore(&out.m10_, SimdAdd(t, SimdMul(SimdSplatLane<3>(l), r3)));
+
+        l = SimdLoad(&m20_);
+        t = SimdAdd(SimdMul(SimdSplatLane<0>(l), r0), SimdMul(SimdSplatLane<1>(l), r1));
+        t = SimdAdd(t, SimdMul(SimdSplatLane<2>(l), r2));
+        SimdStore(&out.m20_, SimdAdd(t, SimdMul(SimdSplatLane<3>(l), r3)));
+
+        l = SimdLoad(&m30_);
+        t = SimdAdd(SimdMul(SimdSplatLane<0>(l), r0), SimdMul(SimdSplatLane<1>(l), r1));
+        t = SimdAdd(t, SimdMul(SimdSplatLane<2>(l), r2));
+        SimdStore(&out.m30_, SimdAdd(t, SimdMul(SimdSplatLane<3>(l), r3)));
 
         return out;
 #else
@@ -580,17 +592,17 @@ public:
     /// Return transposed.
     Matrix4 Transpose() const
     {
-#ifdef URHO3D_SSE
-        __m128 m0 = _mm_loadu_ps(&m00_);
-        __m128 m1 = _mm_loadu_ps(&m10_);
-        __m128 m2 = _mm_loadu_ps(&m20_);
-        __m128 m3 = _mm_loadu_ps(&m30_);
-        _MM_TRANSPOSE4_PS(m0, m1, m2, m3);      // NOLINT(modernize-use-bool-literals)
+#ifdef URHO3D_SIMD
+        SimdVector m0 = SimdLoad(&m00_);
+        SimdVector m1 = SimdLoad(&m10_);
+        SimdVector m2 = SimdLoad(&m20_);
+        SimdVector m3 = SimdLoad(&m30_);
+        SimdTranspose(m0, m1, m2, m3);
         Matrix4 out;
-        _mm_storeu_ps(&out.m00_, m0);
-        _mm_storeu_ps(&out.m10_, m1);
-        _mm_storeu_ps(&out.m20_, m2);
-        _mm_storeu_ps(&out.m30_, m3);
+        SimdStore(&out.m00_, m0);
+        SimdStore(&out.m10_, m1);
+        SimdStore(&out.m20_, m2);
+        SimdStore(&out.m30_, m3);
         return out;
 #else
         return Matrix4(
@@ -696,16 +708,16 @@ public:
     {
         for (unsigned i = 0; i < count; ++i)
         {
-#ifdef URHO3D_SSE
-            __m128 m0 = _mm_loadu_ps(src);
-            __m128 m1 = _mm_loadu_ps(src + 4);
-            __m128 m2 = _mm_loadu_ps(src + 8);
-            __m128 m3 = _mm_loadu_ps(src + 12);
-            _MM_TRANSPOSE4_PS(m0, m1, m2, m3);      // NOLINT(modernize-use-bool-literals)
-            _mm_storeu_ps(dest, m0);
-            _mm_storeu_ps(dest + 4, m1);
-            _mm_storeu_ps(dest + 8, m2);
-            _mm_storeu_ps(dest + 12, m3);
+#ifdef URHO3D_SIMD
+            SimdVector m0 = SimdLoad(src);
+            SimdVector m1 = SimdLoad(src + 4);
+            SimdVector m2 = SimdLoad(src + 8);
+            SimdVector m3 = SimdLoad(src + 12);
+            SimdTranspose(m0, m1, m2, m3);
+            SimdStore(dest, m0);
+            SimdStore(dest + 4, m1);
+            SimdStore(dest + 8, m2);
+            SimdStore(dest + 12, m3);
 #else
             dest[0] = src[0];
             dest[1] = src[4];
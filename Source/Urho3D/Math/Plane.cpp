@@ -47,24 +47,6 @@ void Plane::Transform(const Matrix4& transform)
     Define(transform.Inverse().Transpose() * ToVector4());
 }
 
-Matrix3x4 Plane::ReflectionMatrix() const
-{
-    return Matrix3x4(
-        -2.0f * normal_.x_ * normal_.x_ + 1.0f,
-        -2.0f * normal_.x_ * normal_.y_,
-        -2.0f * normal_.x_ * normal_.z_,
-        -2.0f * normal_.x_ * d_,
-        -2.0f * normal_.y_ * normal_.x_,
-        -2.0f * normal_.y_ * normal_.y_ + 1.0f,
-        -2.0f * normal_.y_ * normal_.z_,
-        -2.0f * normal_.y_ * d_,
-        -2.0f * normal_.z_ * normal_.x_,
-        -2.0f * normal_.z_ * normal_.y_,
-        -2.0f * normal_.z_ * normal_.z_ + 1.0f,
-        -2.0f * normal_.z_ * d_
-    );
-}
-
 Plane Plane::Transformed(const Matrix3& transform) const
 {
     return Plane(Matrix4(transform).Inverse().Transpose() * ToVector4());
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Math/Matrix3x4.h"
+#include "../Math/SIMD.h"
 
 namespace Urho3D
 {
@@ -105,7 +106,35 @@ public:
 
     /// Return a reflection matrix.
     /// @property
-    Matrix3x4 ReflectionMatrix() const;
+    Matrix3x4 ReflectionMatrix() const
+    {
+#ifdef URHO3D_SIMD
+        // Each row is the plane scaled by -2 times a normal component, plus one on the diagonal. Negative zero is added
+        // elsewhere, as it keeps the sign of a zero product like the scalar version
+        SimdVector plane = SimdSet(normal_.x_, normal_.y_, normal_.z_, d_);
+        Matrix3x4 ret;
+        SimdStore(&ret.m00_, SimdAdd(SimdMul(SimdSplat(-2.0f * normal_.x_), plane), SimdSet(1.0f, -0.0f, -0.0f, -0.0f)));
+        SimdStore(&ret.m10_, SimdAdd(SimdMul(SimdSplat(-2.0f * normal_.y_), plane), SimdSet(-0.0f, 1.0f, -0.0f, -0.0f)));
+        SimdStore(&ret.m20_, SimdAdd(SimdMul(SimdSplat(-2.0f * normal_.z_), plane), SimdSet(-0.0f, -0.0f, 1.0f, -0.0f)));
+        return ret;
+#else
+        return Matrix3x4(
+            -2.0f * normal_.x_ * normal_.x_ + 1.0f,
+            -2.0f * normal_.x_ * normal_.y_,
+            -2.0f * normal_.x_ * normal_.z_,
+            -2.0f * normal_.x_ * d_,
+            -2.0f * normal_.y_ * normal_.x_,
+            -2.0f * normal_.y_ * normal_.y_ + 1.0f,
+            -2.0f * normal_.y_ * normal_.z_,
+            -2.0f * normal_.y_ * d_,
+            -2.0f * normal_.z_ * normal_.x_,
+            -2.0f * normal_.z_ * normal_.y_,
+            -2.0f * normal_.z_ * normal_.z_ + 1.0f,
+            -2.0f * normal_.z_ * d_
+        );
+#endif
+    }
+
     /// Return transformed by a 3x3 matrix.
     Plane Transformed(const Matrix3& transform) const;
     /// Return transformed by a 3x4 matrix.
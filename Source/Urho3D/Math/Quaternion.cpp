@@ -329,4 +329,78 @@ String Quaternion::ToString() const
     return String(tempBuffer);
 }
 
+void BlendRotations(Quaternion* rotations, const Quaternion* targets, const float* weights, unsigned count)
+{
+    // The interpolation factor is corrected as a function of the angle between the rotations so that the normalized lerp
+    // follows the slerp curve closely
+    unsigned i = 0;
+
+#ifdef URHO3D_SIMD
+    for (; i + 4 <= count; i += 4)
+    {
+        SimdVector aw = SimdLoad(&rotations[i].w_);
+        SimdVector ax = SimdLoad(&rotations[i + 1].w_);
+        SimdVector ay = SimdLoad(&rotations[i + 2].w_);
+        SimdVector az = SimdLoad(&rotations[i + 3].w_);
+        SimdTranspose(aw, ax, ay, az);
+        SimdVector bw = SimdLoad(&targets[i].w_);
+        SimdVector bx = SimdLoad(&targets[i + 1].w_);
+        SimdVector by = SimdLoad(&targets[i + 2].w_);
+        SimdVector bz = SimdLoad(&targets[i + 3].w_);
+        SimdTranspose(bw, bx, by, bz);
+        SimdVector t = SimdLoad(&weights[i]);
+
+        SimdVector d = SimdAdd(SimdAdd(SimdMul(aw, bw), SimdMul(ax, bx)), SimdAdd(SimdMul(ay, by), SimdMul(az, bz)));
+        // Negate the targets that are on the opposite hemisphere
+        SimdVector sign = SimdAnd(d, SimdSplat(-0.0f));
+        d = SimdXor(d, sign);
+        bw = SimdXor(bw, sign);
+        bx = SimdXor(bx, sign);
+        by = SimdXor(by, sign);
+        bz = SimdXor(bz, sign);
+
+        SimdVector a = SimdAdd(SimdSplat(3.55645f), SimdMul(d, SimdSplat(-1.43519f)));
+        a = SimdAdd(SimdSplat(-3.2452f), SimdMul(d, a));
+        a = SimdAdd(SimdSplat(1.0904f), SimdMul(d, a));
+        SimdVector b = SimdAdd(SimdSplat(-1.06021f), SimdMul(d, SimdSplat(0.215638f)));
+        b = SimdAdd(SimdSplat(0.848013f), SimdMul(d, b));
+        SimdVector tm = SimdSub(t, SimdSplat(0.5f));
+        SimdVector k = SimdAdd(SimdMul(a, SimdMul(tm, tm)), b);
+        SimdVector ot = SimdAdd(t, SimdMul(SimdMul(t, tm), SimdMul(SimdSub(t, SimdSplat(1.0f)), k)));
+
+        SimdVector rw = SimdAdd(aw, SimdMul(SimdSub(bw, aw), ot));
+        SimdVector rx = SimdAdd(ax, SimdMul(SimdSub(bx, ax), ot));
+        SimdVector ry = SimdAdd(ay, SimdMul(SimdSub(by, ay), ot));
+        SimdVector rz = SimdAdd(az, SimdMul(SimdSub(bz, az), ot));
+        SimdVector lenSquared = SimdAdd(SimdAdd(SimdMul(rw, rw), SimdMul(rx, rx)), SimdAdd(SimdMul(ry, ry), SimdMul(rz, rz)));
+        SimdVector invLen = SimdDiv(SimdSplat(1.0f), SimdSqrt(lenSquared));
+        rw = SimdMul(rw, invLen);
+        rx = SimdMul(rx, invLen);
+        ry = SimdMul(ry, invLen);
+        rz = SimdMul(rz, invLen);
+
+        SimdTranspose(rw, rx, ry, rz);
+        SimdStore(&rotations[i].w_, rw);
+        SimdStore(&rotations[i + 1].w_, rx);
+        SimdStore(&rotations[i + 2].w_, ry);
+        SimdStore(&rotations[i + 3].w_, rz);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const Quaternion& a = rotations[i];
+        float t = weights[i];
+        float d = a.DotProduct(targets[i]);
+        Quaternion b = d < 0.0f ? -targets[i] : targets[i];
+        d = Abs(d);
+
+        float ka = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+        float kb = 0.848013f + d * (-1.06021f + d * 0.215638f);
+        float tm = t - 0.5f;
+        float ot = t + t * tm * (t - 1.0f) * (ka * tm * tm + kb);
+        rotations[i] = (a + (b - a) * ot).Normalized();
+    }
+}
+
 }
@@ -23,10 +23,7 @@
 #pragma once
 
 #include "../Math/Matrix3.h"
-
-#ifdef URHO3D_SSE
-#include <emmintrin.h>
-#endif
+#include "../Math/SIMD.h"
 
 namespace Urho3D
 {
@@ -37,23 +34,23 @@ class URHO3D_API Quaternion
 public:
     /// Construct an identity quaternion.
     Quaternion() noexcept
-#ifndef URHO3D_SSE
+#ifndef URHO3D_SIMD
        :w_(1.0f),
         x_(0.0f),
         y_(0.0f),
         z_(0.0f)
 #endif
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&w_, _mm_set_ps(0.f, 0.f, 0.f, 1.f));
+#ifdef URHO3D_SIMD
+        SimdStore(&w_, SimdSet(1.0f, 0.0f, 0.0f, 0.0f));
 #endif
     }
 
     /// Copy-construct from another quaternion.
     Quaternion(const Quaternion& quat) noexcept
-#if defined(URHO3D_SSE) && (!defined(_MSC_VER) || _MSC_VER >= 1700) /* Visual Studio 2012 and newer. VS2010 has a bug with these, see https://github.com/urho3d/Urho3D/issues/1044 */
+#if defined(URHO3D_SIMD) && (!defined(_MSC_VER) || _MSC_VER >= 1700) /* Visual Studio 2012 and newer. VS2010 has a bug with these, see https://github.com/urho3d/Urho3D/issues/1044 */
     {
-        _mm_storeu_ps(&w_, _mm_loadu_ps(&quat.w_));
+        SimdStore(&w_, SimdLoad(&quat.w_));
     }
 #else
        :w_(quat.w_),
@@ -66,29 +63,29 @@ public:
 
     /// Construct from values.
     Quaternion(float w, float x, float y, float z) noexcept
-#ifndef URHO3D_SSE
+#ifndef URHO3D_SIMD
        :w_(w),
         x_(x),
         y_(y),
         z_(z)
 #endif
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&w_, _mm_set_ps(z, y, x, w));
+#ifdef URHO3D_SIMD
+        SimdStore(&w_, SimdSet(w, x, y, z));
 #endif
     }
 
     /// Construct from a float array.
     explicit Quaternion(const float* data) noexcept
-#ifndef URHO3D_SSE
+#ifndef URHO3D_SIMD
        :w_(data[0]),
         x_(data[1]),
         y_(data[2]),
         z_(data[3])
 #endif
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&w_, _mm_loadu_ps(data));
+#ifdef URHO3D_SIMD
+        SimdStore(&w_, SimdLoad(data));
 #endif
     }
 
@@ -134,18 +131,18 @@ public:
         FromRotationMatrix(matrix);
     }
 
-#ifdef URHO3D_SSE
-    explicit Quaternion(__m128 wxyz) noexcept
+#ifdef URHO3D_SIMD
+    explicit Quaternion(SimdVector wxyz) noexcept
     {
-        _mm_storeu_ps(&w_, wxyz);
+        SimdStore(&w_, wxyz);
     }
 #endif
 
     /// Assign from another quaternion.
     Quaternion& operator =(const Quaternion& rhs) noexcept
     {
-#if defined(URHO3D_SSE) && (!defined(_MSC_VER) || _MSC_VER >= 1700) /* Visual Studio 2012 and newer. VS2010 has a bug with these, see https://github.com/urho3d/Urho3D/issues/1044 */
-        _mm_storeu_ps(&w_, _mm_loadu_ps(&rhs.w_));
+#if defined(URHO3D_SIMD) && (!defined(_MSC_VER) || _MSC_VER >= 1700) /* Visual Studio 2012 and newer. VS2010 has a bug with these, see https://github.com/urho3d/Urho3D/issues/1044 */
+        SimdStore(&w_, SimdLoad(&rhs.w_));
 #else
         w_ = rhs.w_;
         x_ = rhs.x_;
@@ -158,8 +155,8 @@ public:
     /// Add-assign a quaternion.
     Quaternion& operator +=(const Quaternion& rhs)
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&w_, _mm_add_ps(_mm_loadu_ps(&w_), _mm_loadu_ps(&rhs.w_)));
+#ifdef URHO3D_SIMD
+        SimdStore(&w_, SimdAdd(SimdLoad(&w_), SimdLoad(&rhs.w_)));
 #else
         w_ += rhs.w_;
         x_ += rhs.x_;
@@ -172,8 +169,8 @@ public:
     /// Multiply-assign a scalar.
     Quaternion& operator *=(float rhs)
     {
-#ifdef URHO3D_SSE
-        _mm_storeu_ps(&w_, _mm_mul_ps(_mm_loadu_ps(&w_), _mm_set1_ps(rhs)));
+#ifdef URHO3D_SIMD
+        SimdStore(&w_, SimdMul(SimdLoad(&w_), SimdSplat(rhs)));
 #else
         w_ *= rhs;
         x_ *= rhs;
@@ -186,11 +183,8 @@ public:
     /// Test for equality with another quaternion without epsilon.
     bool operator ==(const Quaternion& rhs) const
     {
-#ifdef URHO3D_SSE
-        __m128 c = _mm_cmpeq_ps(_mm_loadu_ps(&w_), _mm_loadu_ps(&rhs.w_));
-        c = _mm_and_ps(c, _mm_movehl_ps(c, c));
-        c = _mm_and_ps(c, _mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 1, 1, 1)));
-        return _mm_cvtsi128_si32(_mm_castps_si128(c)) == -1;
+#ifdef URHO3D_SIMD
+        return SimdAllTrue(SimdEqual(SimdLoad(&w_), SimdLoad(&rhs.w_)));
 #else
         return w_ == rhs.w_ && x_ == rhs.x_ && y_ == rhs.y_ && z_ == rhs.z_;
 #endif
@@ -202,8 +196,8 @@ public:
     /// Multiply with a scalar.
     Quaternion operator *(float rhs) const
     {
-#ifdef URHO3D_SSE
-        return Quaternion(_mm_mul_ps(_mm_loadu_ps(&w_), _mm_set1_ps(rhs)));
+#ifdef URHO3D_SIMD
+        return Quaternion(SimdMul(SimdLoad(&w_), SimdSplat(rhs)));
 #else
         return Quaternion(w_ * rhs, x_ * rhs, y_ * rhs, z_ * rhs);
 #endif
@@ -212,8 +206,8 @@ public:
     /// Return negation.
     Quaternion operator -() const
     {
-#ifdef URHO3D_SSE
-        return Quaternion(_mm_xor_ps(_mm_loadu_ps(&w_), _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000UL))));
+#ifdef URHO3D_SIMD
+        return Quaternion(SimdXor(SimdLoad(&w_), SimdSplat(-0.0f)));
 #else
         return Quaternion(-w_, -x_, -y_, -z_);
 #endif
@@ -222,8 +216,8 @@ public:
     /// Add a quaternion.
     Quaternion operator +(const Quaternion& rhs) const
     {
-#ifdef URHO3D_SSE
-        return Quaternion(_mm_add_ps(_mm_loadu_ps(&w_), _mm_loadu_ps(&rhs.w_)));
+#ifdef URHO3D_SIMD
+        return Quaternion(SimdAdd(SimdLoad(&w_), SimdLoad(&rhs.w_)));
 #else
         return Quaternion(w_ + rhs.w_, x_ + rhs.x_, y_ + rhs.y_, z_ + rhs.z_);
 #endif
@@ -232,8 +226,8 @@ public:
     /// Subtract a quaternion.
     Quaternion operator -(const Quaternion& rhs) const
     {
-#ifdef URHO3D_SSE
-        return Quaternion(_mm_sub_ps(_mm_loadu_ps(&w_), _mm_loadu_ps(&rhs.w_)));
+#ifdef URHO3D_SIMD
+        return Quaternion(SimdSub(SimdLoad(&w_), SimdLoad(&rhs.w_)));
 #else
         return Quaternion(w_ - rhs.w_, x_ - rhs.x_, y_ - rhs.y_, z_ - rhs.z_);
 #endif
@@ -242,18 +236,16 @@ public:
     /// Multiply a quaternion.
     Quaternion operator *(const Quaternion& rhs) const
     {
-#ifdef URHO3D_SSE
-        __m128 q1 = _mm_loadu_ps(&w_);
-        __m128 q2 = _mm_loadu_ps(&rhs.w_);
-        q2 = _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(0, 3, 2, 1));
-        const __m128 signy = _mm_castsi128_ps(_mm_set_epi32((int)0x80000000UL, (int)0x80000000UL, 0, 0));
-        const __m128 signx = _mm_shuffle_ps(signy, signy, _MM_SHUFFLE(2, 0, 2, 0));
-        const __m128 signz = _mm_shuffle_ps(signy, signy, _MM_SHUFFLE(3, 0, 0, 3));
-        __m128 out = _mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(0, 1, 2, 3)));
-        out = _mm_add_ps(_mm_mul_ps(_mm_xor_ps(signy, _mm_shuffle_ps(q1, q1, _MM_SHUFFLE(2, 2, 2, 2))), _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(1, 0, 3, 2))), _mm_xor_ps(signx, out));
-        out = _mm_add_ps(_mm_mul_ps(_mm_xor_ps(signz, _mm_shuffle_ps(q1, q1, _MM_SHUFFLE(3, 3, 3, 3))), _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(2, 3, 0, 1))), out);
-        out = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(0, 0, 0, 0)), q2), out);
-        return Quaternion(_mm_shuffle_ps(out, out, _MM_SHUFFLE(2, 1, 0, 3)));
+#ifdef URHO3D_SIMD
+        // Each lane sums the same products in the same order as the scalar version. The products that the scalar version
+        // subtracts in the w lane are negated and added instead, which gives the same result
+        SimdVector q1 = SimdLoad(&w_);
+        SimdVector q2 = SimdLoad(&rhs.w_);
+        const SimdVector negW = SimdSet(-0.0f, 0.0f, 0.0f, 0.0f);
+        SimdVector out = SimdMul(SimdSplatLane<0>(q1), q2);
+        out = SimdAdd(out, SimdMul(SimdXor(SimdShuffle<1, 1, 2, 3>(q1), negW), SimdShuffle<1, 0, 0, 0>(q2)));
+        out = SimdAdd(out, SimdMul(SimdXor(SimdShuffle<2, 2, 3, 1>(q1), negW), SimdShuffle<2, 3, 1, 2>(q2)));
+        return Quaternion(SimdSub(out, SimdMul(SimdShuffle<3, 3, 1, 2>(q1), SimdShuffle<3, 2, 3, 1>(q2))));
 #else
         return Quaternion(
             w_ * rhs.w_ - x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_,
@@ -267,26 +259,20 @@ public:
     /// Multiply a Vector3.
     Vector3 operator *(const Vector3& rhs) const
     {
-#ifdef URHO3D_SSE
-        __m128 q = _mm_loadu_ps(&w_);
-        q = _mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 3, 2, 1));
-        __m128 v = _mm_set_ps(0.f, rhs.z_, rhs.y_, rhs.x_);
-        const __m128 W = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3));
-        const __m128 a_yzx = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 0, 2, 1));
-        __m128 x = _mm_mul_ps(q, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1)));
-        __m128 qxv = _mm_sub_ps(x, _mm_mul_ps(a_yzx, v));
-        __m128 Wv = _mm_mul_ps(W, v);
-        __m128 s = _mm_add_ps(qxv, _mm_shuffle_ps(Wv, Wv, _MM_SHUFFLE(3, 1, 0, 2)));
-        __m128 qs = _mm_mul_ps(q, s);
-        __m128 y = _mm_shuffle_ps(qs, qs, _MM_SHUFFLE(3, 1, 0, 2));
-        s = _mm_sub_ps(_mm_mul_ps(a_yzx, s), y);
-        s = _mm_add_ps(s, s);
-        s = _mm_add_ps(s, v);
-
-        return Vector3(
-            _mm_cvtss_f32(s),
-            _mm_cvtss_f32(_mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1))),
-            _mm_cvtss_f32(_mm_movehl_ps(s, s)));
+#ifdef URHO3D_SIMD
+        // The cross products as in the scalar version, with the x, y and z components in the first three lanes
+        SimdVector q = SimdLoad(&w_);
+        SimdVector qYZX = SimdShuffle<2, 3, 1, 0>(q);
+        SimdVector qZXY = SimdShuffle<3, 1, 2, 0>(q);
+        SimdVector v = SimdSet(rhs.x_, rhs.y_, rhs.z_, 0.0f);
+        SimdVector cross1 = SimdSub(SimdMul(qYZX, SimdShuffle<2, 0, 1, 3>(v)), SimdMul(qZXY, SimdShuffle<1, 2, 0, 3>(v)));
+        SimdVector cross2 = SimdSub(SimdMul(qYZX, SimdShuffle<2, 0, 1, 3>(cross1)), SimdMul(qZXY, SimdShuffle<1, 2, 0, 3>(cross1)));
+        SimdVector s = SimdAdd(SimdMul(cross1, SimdSplatLane<0>(q)), cross2);
+        s = SimdAdd(v, SimdMul(s, SimdSplat(2.0f)));
+
+        float ret[4];
+        SimdStore(ret, s);
+        return Vector3(ret);
 #else
         Vector3 qVec(x_, y_, z_);
         Vector3 cross1(qVec.CrossProduct(rhs));
@@ -424,9 +410,8 @@ public:
     /// Return conjugate.
     Quaternion Conjugate() const
     {
-#ifdef URHO3D_SSE
-        __m128 q = _mm_loadu_ps(&w_);
-        return Quaternion(_mm_xor_ps(q, _mm_castsi128_ps(_mm_set_epi32((int)0x80000000UL, (int)0x80000000UL, (int)0x80000000UL, 0))));
+#ifdef URHO3D_SIMD
+        return Quaternion(SimdXor(SimdLoad(&w_), SimdSet(0.0f, -0.0f, -0.0f, -0.0f)));
 #else
         return Quaternion(w_, -x_, -y_, -z_);
 #endif
@@ -477,4 +462,7 @@ public:
     static const Quaternion IDENTITY;
 };
 
+/// Interpolate an array of rotations towards target rotations by per-rotation weights, taking the shortest path. Uses a corrected normalized lerp that approximates slerp, processing four rotations at a time when SIMD is available.
+URHO3D_API void BlendRotations(Quaternion* rotations, const Quaternion* targets, const float* weights, unsigned count);
+
 }
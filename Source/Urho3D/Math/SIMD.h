@@ -0,0 +1,334 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Math/MathDefs.h"
+
+#if defined(URHO3D_SSE)
+#include <emmintrin.h>
+// SSE4.1 and AVX are used when the compiler targets them, for example with URHO3D_DEPLOYMENT_TARGET=native
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+/// Defined when SSE4.1 instructions are available in addition to SSE.
+#define URHO3D_SSE41
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+/// Defined when AVX instructions are available in addition to SSE.
+#define URHO3D_AVX
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define URHO3D_NEON
+#endif
+
+#if defined(URHO3D_SSE) || defined(URHO3D_NEON)
+/// Defined when one of the SIMD backends below is available.
+#define URHO3D_SIMD
+#endif
+
+namespace Urho3D
+{
+
+// Thin wrappers over the SSE and NEON intrinsics for code that only needs basic four-wide float arithmetic and comparisons.
+// Comparison results are lane masks with all bits set in the lanes where the comparison holds. Lanes are numbered in memory
+// order. The arithmetic is exact IEEE single precision on all backends, except for division and square root on 32-bit ARM,
+// so code that keeps the operation order of its scalar version gets bit-identical results.
+
+#if defined(URHO3D_SSE)
+
+/// Four-wide float vector.
+using SimdVector = __m128;
+
+/// Load four floats from an unaligned address.
+inline SimdVector SimdLoad(const float* data) { return _mm_loadu_ps(data); }
+
+/// Store four floats to an unaligned address.
+inline void SimdStore(float* data, SimdVector v) { _mm_storeu_ps(data, v); }
+
+/// Return a vector with all lanes set to a value.
+inline SimdVector SimdSplat(float value) { return _mm_set1_ps(value); }
+
+/// Return a vector from lane values.
+inline SimdVector SimdSet(float v0, float v1, float v2, float v3) { return _mm_setr_ps(v0, v1, v2, v3); }
+
+/// Return a vector with lanes picked from another vector by index.
+template <int I0, int I1, int I2, int I3> inline SimdVector SimdShuffle(SimdVector v)
+{
+#ifdef URHO3D_AVX
+    return _mm_permute_ps(v, _MM_SHUFFLE(I3, I2, I1, I0));
+#else
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(I3, I2, I1, I0));
+#endif
+}
+
+/// Return a vector with all lanes set to one lane of another vector.
+template <int I> inline SimdVector SimdSplatLane(SimdVector v) { return SimdShuffle<I, I, I, I>(v); }
+
+/// Transpose four vectors as the rows of a 4x4 matrix.
+inline void SimdTranspose(SimdVector& v0, SimdVector& v1, SimdVector& v2, SimdVector& v3)
+{
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);      // NOLINT(modernize-use-bool-literals)
+}
+
+/// Return the lane-wise sum.
+inline SimdVector SimdAdd(SimdVector lhs, SimdVector rhs) { return _mm_add_ps(lhs, rhs); }
+
+/// Return the lane-wise difference.
+inline SimdVector SimdSub(SimdVector lhs, SimdVector rhs) { return _mm_sub_ps(lhs, rhs); }
+
+/// Return the lane-wise product.
+inline SimdVector SimdMul(SimdVector lhs, SimdVector rhs) { return _mm_mul_ps(lhs, rhs); }
+
+/// Return the lane-wise quotient.
+inline SimdVector SimdDiv(SimdVector lhs, SimdVector rhs) { return _mm_div_ps(lhs, rhs); }
+
+/// Return the lane-wise square root.
+inline SimdVector SimdSqrt(SimdVector v) { return _mm_sqrt_ps(v); }
+
+/// Return the lane-wise minimum.
+inline SimdVector SimdMin(SimdVector lhs, SimdVector rhs) { return _mm_min_ps(lhs, rhs); }
+
+/// Return the lane-wise maximum.
+inline SimdVector SimdMax(SimdVector lhs, SimdVector rhs) { return _mm_max_ps(lhs, rhs); }
+
+/// Return the mask of lanes where lhs is less than rhs.
+inline SimdVector SimdLess(SimdVector lhs, SimdVector rhs) { return _mm_cmplt_ps(lhs, rhs); }
+
+/// Return the mask of lanes where lhs is less than or equal to rhs.
+inline SimdVector SimdLessEqual(SimdVector lhs, SimdVector rhs) { return _mm_cmple_ps(lhs, rhs); }
+
+/// Return the mask of lanes where lhs is equal to rhs.
+inline SimdVector SimdEqual(SimdVector lhs, SimdVector rhs) { return _mm_cmpeq_ps(lhs, rhs); }
+
+/// Return the bitwise and of two vectors.
+inline SimdVector SimdAnd(SimdVector lhs, SimdVector rhs) { return _mm_and_ps(lhs, rhs); }
+
+/// Return the bitwise or of two vectors.
+inline SimdVector SimdOr(SimdVector lhs, SimdVector rhs) { return _mm_or_ps(lhs, rhs); }
+
+/// Return the bitwise exclusive or of two vectors. With a vector of negative zeros, flips the signs.
+inline SimdVector SimdXor(SimdVector lhs, SimdVector rhs) { return _mm_xor_ps(lhs, rhs); }
+
+/// Return the lanes of a where the mask is set and the lanes of b elsewhere.
+inline SimdVector SimdSelect(SimdVector mask, SimdVector a, SimdVector b)
+{
+#ifdef URHO3D_SSE41
+    return _mm_blendv_ps(b, a, mask);
+#else
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#endif
+}
+
+/// Return true if any lane of a mask is set.
+inline bool SimdAnyTrue(SimdVector mask) { return _mm_movemask_ps(mask) != 0; }
+
+/// Return true if all lanes of a mask are set.
+inline bool SimdAllTrue(SimdVector mask) { return _mm_movemask_ps(mask) == 0xf; }
+
+/// Return the lanes of a mask as bits 0-3 of an integer.
+inline unsigned SimdMoveMask(SimdVector mask) { return (unsigned)_mm_movemask_ps(mask); }
+
+#ifdef URHO3D_AVX
+/// Eight-wide float vector, which holds two four-wide vectors in its low and high halves.
+using SimdVector8 = __m256;
+
+/// Load eight floats from an unaligned address.
+inline SimdVector8 SimdLoad8(const float* data) { return _mm256_loadu_ps(data); }
+
+/// Store eight floats to an unaligned address.
+inline void SimdStore8(float* data, SimdVector8 v) { _mm256_storeu_ps(data, v); }
+
+/// Return an eight-wide vector with all lanes set to a value.
+inline SimdVector8 SimdSplat8(float value) { return _mm256_set1_ps(value); }
+
+/// Load four floats from an unaligned address into both halves of an eight-wide vector.
+inline SimdVector8 SimdLoadBoth(const float* data)
+{
+    __m128 v = _mm_loadu_ps(data);
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(v), v, 1);
+}
+
+/// Return the lane-wise sum of eight-wide vectors.
+inline SimdVector8 SimdAdd8(SimdVector8 lhs, SimdVector8 rhs) { return _mm256_add_ps(lhs, rhs); }
+
+/// Return the lane-wise difference of eight-wide vectors.
+inline SimdVector8 SimdSub8(SimdVector8 lhs, SimdVector8 rhs) { return _mm256_sub_ps(lhs, rhs); }
+
+/// Return the lane-wise product of eight-wide vectors.
+inline SimdVector8 SimdMul8(SimdVector8 lhs, SimdVector8 rhs) { return _mm256_mul_ps(lhs, rhs); }
+
+/// Return an eight-wide vector with the lanes of each half set to one lane of the same half.
+template <int I> inline SimdVector8 SimdSplatLane8(SimdVector8 v) { return _mm256_permute_ps(v, _MM_SHUFFLE(I, I, I, I)); }
+#endif
+
+#elif defined(URHO3D_NEON)
+
+/// Four-wide float vector.
+using SimdVector = float32x4_t;
+
+/// Load four floats from an unaligned address.
+inline SimdVector SimdLoad(const float* data) { return vld1q_f32(data); }
+
+/// Store four floats to an unaligned address.
+inline void SimdStore(float* data, SimdVector v) { vst1q_f32(data, v); }
+
+/// Return a vector with all lanes set to a value.
+inline SimdVector SimdSplat(float value) { return vdupq_n_f32(value); }
+
+/// Return a vector from lane values.
+inline SimdVector SimdSet(float v0, float v1, float v2, float v3)
+{
+    const float values[4] = {v0, v1, v2, v3};
+    return vld1q_f32(values);
+}
+
+/// Return a vector with lanes picked from another vector by index.
+template <int I0, int I1, int I2, int I3> inline SimdVector SimdShuffle(SimdVector v)
+{
+    SimdVector ret = vdupq_n_f32(vgetq_lane_f32(v, I0));
+    ret = vsetq_lane_f32(vgetq_lane_f32(v, I1), ret, 1);
+    ret = vsetq_lane_f32(vgetq_lane_f32(v, I2), ret, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(v, I3), ret, 3);
+}
+
+/// Return a vector with all lanes set to one lane of another vector.
+template <int I> inline SimdVector SimdSplatLane(SimdVector v)
+{
+    return I < 2 ? vdupq_lane_f32(vget_low_f32(v), I & 1) : vdupq_lane_f32(vget_high_f32(v), I & 1);
+}
+
+/// Transpose four vectors as the rows of a 4x4 matrix.
+inline void SimdTranspose(SimdVector& v0, SimdVector& v1, SimdVector& v2, SimdVector& v3)
+{
+    float32x4x2_t t01 = vtrnq_f32(v0, v1);
+    float32x4x2_t t23 = vtrnq_f32(v2, v3);
+    v0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    v1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    v2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    v3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+/// Return the lane-wise sum.
+inline SimdVector SimdAdd(SimdVector lhs, SimdVector rhs) { return vaddq_f32(lhs, rhs); }
+
+/// Return the lane-wise difference.
+inline SimdVector SimdSub(SimdVector lhs, SimdVector rhs) { return vsubq_f32(lhs, rhs); }
+
+/// Return the lane-wise product.
+inline SimdVector SimdMul(SimdVector lhs, SimdVector rhs) { return vmulq_f32(lhs, rhs); }
+
+/// Return the lane-wise quotient. 32-bit ARM has no division instruction, so there it is a refined reciprocal estimate.
+inline SimdVector SimdDiv(SimdVector lhs, SimdVector rhs)
+{
+#ifdef __aarch64__
+    return vdivq_f32(lhs, rhs);
+#else
+    SimdVector inv = vrecpeq_f32(rhs);
+    inv = vmulq_f32(inv, vrecpsq_f32(rhs, inv));
+    inv = vmulq_f32(inv, vrecpsq_f32(rhs, inv));
+    return vmulq_f32(lhs, inv);
+#endif
+}
+
+/// Return the lane-wise square root. 32-bit ARM has no square root instruction, so there it is a refined estimate.
+inline SimdVector SimdSqrt(SimdVector v)
+{
+#ifdef __aarch64__
+    return vsqrtq_f32(v);
+#else
+    SimdVector inv = vrsqrteq_f32(v);
+    inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(v, inv), inv));
+    inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(v, inv), inv));
+    // The estimate of zero is infinite, so mask those lanes to keep the square root of zero at zero
+    uint32x4_t nonZero = vmvnq_u32(vceqq_f32(v, vdupq_n_f32(0.0f)));
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(v, inv)), nonZero));
+#endif
+}
+
+/// Return the lane-wise minimum.
+inline SimdVector SimdMin(SimdVector lhs, SimdVector rhs) { return vminq_f32(lhs, rhs); }
+
+/// Return the lane-wise maximum.
+inline SimdVector SimdMax(SimdVector lhs, SimdVector rhs) { return vmaxq_f32(lhs, rhs); }
+
+/// Return the mask of lanes where lhs is less than rhs.
+inline SimdVector SimdLess(SimdVector lhs, SimdVector rhs) { return vreinterpretq_f32_u32(vcltq_f32(lhs, rhs)); }
+
+/// Return the mask of lanes where lhs is less than or equal to rhs.
+inline SimdVector SimdLessEqual(SimdVector lhs, SimdVector rhs) { return vreinterpretq_f32_u32(vcleq_f32(lhs, rhs)); }
+
+/// Return the mask of lanes where lhs is equal to rhs.
+inline SimdVector SimdEqual(SimdVector lhs, SimdVector rhs) { return vreinterpretq_f32_u32(vceqq_f32(lhs, rhs)); }
+
+/// Return the bitwise and of two vectors.
+inline SimdVector SimdAnd(SimdVector lhs, SimdVector rhs)
+{
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(lhs), vreinterpretq_u32_f32(rhs)));
+}
+
+/// Return the bitwise or of two vectors.
+inline SimdVector SimdOr(SimdVector lhs, SimdVector rhs)
+{
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(lhs), vreinterpretq_u32_f32(rhs)));
+}
+
+/// Return the bitwise exclusive or of two vectors. With a vector of negative zeros, flips the signs.
+inline SimdVector SimdXor(SimdVector lhs, SimdVector rhs)
+{
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(lhs), vreinterpretq_u32_f32(rhs)));
+}
+
+/// Return the lanes of a where the mask is set and the lanes of b elsewhere.
+inline SimdVector SimdSelect(SimdVector mask, SimdVector a, SimdVector b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+
+/// Return true if any lane of a mask is set.
+inline bool SimdAnyTrue(SimdVector mask)
+{
+    uint32x4_t bits = vreinterpretq_u32_f32(mask);
+    uint32x2_t half = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return vget_lane_u32(vpmax_u32(half, half), 0) != 0;
+}
+
+/// Return true if all lanes of a mask are set.
+inline bool SimdAllTrue(SimdVector mask)
+{
+    uint32x4_t bits = vreinterpretq_u32_f32(mask);
+    uint32x2_t half = vand_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return vget_lane_u32(vpmin_u32(half, half), 0) == 0xffffffffU;
+}
+
+/// Return the lanes of a mask as bits 0-3 of an integer.
+inline unsigned SimdMoveMask(SimdVector mask)
+{
+    static const uint32_t laneBits[4] = {1, 2, 4, 8};
+    uint32x4_t bits = vandq_u32(vreinterpretq_u32_f32(mask), vld1q_u32(laneBits));
+    uint32x2_t half = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return vget_lane_u32(vpadd_u32(half, half), 0);
+}
+
+#endif
+
+}
@@ -24,6 +24,7 @@
 
 #include "../Math/Frustum.h"
 #include "../Math/Polyhedron.h"
+#include "../Math/SIMD.h"
 
 #include "../DebugNew.h"
 
@@ -136,8 +137,48 @@ void Sphere::Merge(const Sphere& sphere)
     }
 }
 
+#ifdef URHO3D_SIMD
+/// Return the squared distance from a point to a bounding box, or 0 if inside. Matches the scalar calculation exactly.
+static float SimdBoxDistanceSquared(SimdVector center, SimdVector min, SimdVector max)
+{
+    // The difference to the clamped point is zero on the axes where the point is within the box
+    SimdVector diff = SimdSub(center, SimdMin(SimdMax(center, min), max));
+    float squares[4];
+    SimdStore(squares, SimdMul(diff, diff));
+    return squares[0] + squares[1] + squares[2];
+}
+#endif
+
 Intersection Sphere::IsInside(const BoundingBox& box) const
 {
+#ifdef URHO3D_SIMD
+    float radiusSquared = radius_ * radius_;
+    SimdVector center = SimdSet(center_.x_, center_.y_, center_.z_, 0.0f);
+    SimdVector min = SimdLoad(&box.min_.x_);
+    SimdVector max = SimdLoad(&box.max_.x_);
+
+    if (SimdBoxDistanceSquared(center, min, max) >= radiusSquared)
+        return OUTSIDE;
+
+    // Squared distances to the eight corners, the first four with the minimum z and the rest with the maximum z
+    SimdVector minSquared = SimdSub(min, center);
+    minSquared = SimdMul(minSquared, minSquared);
+    SimdVector maxSquared = SimdSub(max, center);
+    maxSquared = SimdMul(maxSquared, maxSquared);
+    const SimdVector zero = SimdSplat(0.0f);
+    SimdVector x = SimdSelect(SimdLess(zero, SimdSet(0.0f, 1.0f, 0.0f, 1.0f)), SimdSplatLane<0>(maxSquared),
+        SimdSplatLane<0>(minSquared));
+    SimdVector y = SimdSelect(SimdLess(zero, SimdSet(0.0f, 0.0f, 1.0f, 1.0f)), SimdSplatLane<1>(maxSquared),
+        SimdSplatLane<1>(minSquared));
+    SimdVector xy = SimdAdd(x, y);
+    SimdVector r = SimdSplat(radiusSquared);
+
+    if (SimdAnyTrue(SimdOr(SimdLessEqual(r, SimdAdd(xy, SimdSplatLane<2>(minSquared))),
+        SimdLessEqual(r, SimdAdd(xy, SimdSplatLane<2>(maxSquared))))))
+        return INTERSECTS;
+
+    return INSIDE;
+#else
     float radiusSquared = radius_ * radius_;
     float distSquared = 0;
     float temp;
@@ -207,10 +248,16 @@ Intersection Sphere::IsInside(const BoundingBox& box) const
         return INTERSECTS;
 
     return INSIDE;
+#endif
 }
 
 Intersection Sphere::IsInsideFast(const BoundingBox& box) const
 {
+#ifdef URHO3D_SIMD
+    float distSquared = SimdBoxDistanceSquared(SimdSet(center_.x_, center_.y_, center_.z_, 0.0f), SimdLoad(&box.min_.x_),
+        SimdLoad(&box.max_.x_));
+    return distSquared >= radius_ * radius_ ? OUTSIDE : INSIDE;
+#else
     float radiusSquared = radius_ * radius_;
     float distSquared = 0;
     float temp;
@@ -252,6 +299,7 @@ Intersection Sphere::IsInsideFast(const BoundingBox& box) const
         return OUTSIDE;
     else
         return INSIDE;
+#endif
 }
 
 Vector3 Sphere::GetLocalPoint(float theta, float phi) const
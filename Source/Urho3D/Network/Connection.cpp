@@ -23,12 +23,14 @@
 #include "../Precompiled.h"
 
 #include "../Core/Profiler.h"
+#include "../IO/Compression.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestGrid.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -54,6 +56,136 @@ namespace Urho3D
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
+/// Compact transform entry flag: position follows.
+static const unsigned char TRANSFORM_POSITION = 0x1;
+/// Compact transform entry flag: rotation follows.
+static const unsigned char TRANSFORM_ROTATION = 0x2;
+/// Compact transform entry flag: values are relative to an earlier transform, whose sequence number age follows.
+static const unsigned char TRANSFORM_DELTA = 0x4;
+/// Largest quantized position magnitude, so that zigzag-encoded deltas fit in a VLE.
+static const int MAX_QUANTIZED_POSITION = (1 << 27) - 1;
+/// Compact transforms message size below which LZ4 compression is not attempted.
+static const unsigned MIN_TRANSFORM_COMPRESS_SIZE = 64;
+/// Scale that maps the three smallest quaternion components from [-1/sqrt(2), 1/sqrt(2)] to [-1, 1].
+static const float SMALLEST_THREE_SCALE = 1.41421356f;
+
+static unsigned ZigZagEncode(int value)
+{
+    return ((unsigned)value << 1u) ^ (unsigned)(value >> 31);
+}
+
+static int ZigZagDecode(unsigned value)
+{
+    return (int)(value >> 1u) ^ -(int)(value & 1u);
+}
+
+static unsigned GetRotationBytes(unsigned bits)
+{
+    return (2 + 3 * bits + 7) / 8;
+}
+
+static unsigned long long QuantizeRotation(const Quaternion& rotation, unsigned bits)
+{
+    Quaternion norm = rotation.Normalized();
+    float components[4] = {norm.w_, norm.x_, norm.y_, norm.z_};
+
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+
+    // q and -q are the same rotation, so flip the sign to make the omitted component positive
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    auto maxValue = (float)((1u << bits) - 1);
+    unsigned long long packed = largest;
+    unsigned shift = 2;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float value = Clamp(components[i] * sign * SMALLEST_THREE_SCALE * 0.5f + 0.5f, 0.0f, 1.0f);
+        packed |= (unsigned long long)RoundToInt(value * maxValue) << shift;
+        shift += bits;
+    }
+
+    return packed;
+}
+
+static Quaternion DequantizeRotation(unsigned long long packed, unsigned bits)
+{
+    auto largest = (unsigned)(packed & 3u);
+    auto maxValue = (float)((1u << bits) - 1);
+    unsigned long long mask = (1u << bits) - 1;
+    float components[4];
+    float sumSquares = 0.0f;
+    unsigned shift = 2;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float value = (float)((packed >> shift) & mask) / maxValue;
+        components[i] = (value * 2.0f - 1.0f) / SMALLEST_THREE_SCALE;
+        sumSquares += components[i] * components[i];
+        shift += bits;
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(components[0], components[1], components[2], components[3]).Normalized();
+}
+
+void TransformAckWindow::Add(unsigned short sequence, unsigned mask)
+{
+    if (!valid_)
+    {
+        latest_ = sequence;
+        mask_ = mask;
+        valid_ = true;
+        return;
+    }
+
+    auto age = (unsigned short)(latest_ - sequence);
+    if (age == 0)
+        mask_ |= mask;
+    else if (age < 0x8000u)
+    {
+        // Older than the newest: merge if still within the window
+        if (age <= 32)
+            mask_ |= 1u << (age - 1);
+        if (age < 32)
+            mask_ |= mask << age;
+    }
+    else
+    {
+        // Newer than the newest: slide the window
+        auto advance = (unsigned short)(sequence - latest_);
+        unsigned oldMask = advance < 32 ? (mask_ << advance) | (1u << (advance - 1)) : (advance == 32 ? 1u << 31 : 0);
+        latest_ = sequence;
+        mask_ = mask | oldMask;
+    }
+}
+
+bool TransformAckWindow::Contains(unsigned short sequence) const
+{
+    if (!valid_)
+        return false;
+
+    auto age = (unsigned short)(latest_ - sequence);
+    if (age == 0)
+        return true;
+    else if (age <= 32)
+        return (mask_ & (1u << (age - 1))) != 0;
+    else
+        return false;
+}
+
+void TransformAckWindow::Clear()
+{
+    latest_ = 0;
+    mask_ = 0;
+    valid_ = false;
+}
 
 PackageDownload::PackageDownload() :
     totalFragments_(0),
@@ -72,6 +204,15 @@ Connection::Connection(Context* context, bool isClient, const SLNet::AddressOrGU
     Object(context),
     timeStamp_(0),
     peer_(peer),
+    interestGrid_(nullptr),
+    interestUpdateCount_(0),
+    transformPositionPrecision_(1.0f),
+    transformRotationBits_(0),
+    numTransforms_(0),
+    transformSequence_(0),
+    compactTransforms_(false),
+    transformCompression_(false),
+    transformAckPending_(false),
     sendMode_(OPSM_NONE),
     isClient_(isClient),
     connectPending_(false),
@@ -193,6 +334,8 @@ void Connection::SetScene(Scene* newScene)
     if (isClient_)
     {
         sceneState_.Clear();
+        pendingTransforms_.Clear();
+        transformAcks_.Clear();
 
         // When scene is assigned on the server, instruct the client to load it. This may require downloading packages
         const Vector<SharedPtr<PackageFile> >& packages = scene_->GetRequiredPackageFiles();
@@ -258,8 +401,46 @@ void Connection::Disconnect(int waitMSec)
 
 void Connection::SendServerUpdate()
 {
-    if (!scene_ || !sceneLoaded_)
+    if (!scene_)
+        return;
+    if (!sceneLoaded_)
+    {
+        // Nodes created and removed while the client is loading would otherwise stay in the dirty set
+        RemoveStaleDirtyNodes();
         return;
+    }
+
+    auto* network = GetSubsystem<Network>();
+    compactTransforms_ = network->GetCompactTransforms();
+    transformCompression_ = network->GetTransformCompression();
+    transformPositionPrecision_ = network->GetTransformPositionPrecision();
+    transformRotationBits_ = network->GetTransformRotationBits();
+    transformMsg_.Clear();
+    numTransforms_ = 0;
+
+    // Resend compact transforms that have not been acknowledged yet and will not be sent as part of a dirty node
+    if (!pendingTransforms_.Empty())
+    {
+        PODVector<unsigned> pendingNodeIDs;
+        for (HashSet<unsigned>::ConstIterator i = pendingTransforms_.Begin(); i != pendingTransforms_.End(); ++i)
+        {
+            if (!sceneState_.dirtyNodes_.Contains(*i))
+                pendingNodeIDs.Push(*i);
+        }
+
+        for (PODVector<unsigned>::ConstIterator i = pendingNodeIDs.Begin(); i != pendingNodeIDs.End(); ++i)
+        {
+            HashMap<unsigned, NodeReplicationState>::Iterator j = sceneState_.nodeStates_.Find(*i);
+            Node* node = j != sceneState_.nodeStates_.End() ? j->second_.node_.Get() : nullptr;
+            if (node && compactTransforms_)
+                WriteNodeTransform(node, j->second_);
+            else
+                pendingTransforms_.Erase(*i);
+        }
+    }
+
+    interestGrid_ = network->GetInterestGrid(scene_);
+    processedNodes_.Clear();
 
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
@@ -267,8 +448,11 @@ void Connection::SendServerUpdate()
     nodesToProcess_.Insert(sceneID);
     ProcessNode(sceneID);
 
-    // Then go through all dirtied nodes
-    nodesToProcess_.Insert(sceneState_.dirtyNodes_);
+    // Then go through all dirtied nodes, or with interest management only those relevant to the observer
+    if (interestGrid_)
+        CollectRelevantNodes(network->GetInterestTiers());
+    else
+        nodesToProcess_.Insert(sceneState_.dirtyNodes_);
     nodesToProcess_.Erase(sceneID); // Do not process the root node twice
 
     while (nodesToProcess_.Size())
@@ -276,6 +460,9 @@ void Connection::SendServerUpdate()
         unsigned nodeID = nodesToProcess_.Front();
         ProcessNode(nodeID);
     }
+
+    SendNodeTransforms();
+    interestGrid_ = nullptr;
 }
 
 void Connection::SendClientUpdate()
@@ -295,6 +482,16 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    // Acknowledge compact transforms so that the server can delta-encode against them
+    if (transformAckPending_)
+    {
+        msg_.Clear();
+        msg_.WriteUShort(transformAcks_.latest_);
+        msg_.WriteUInt(transformAcks_.mask_);
+        SendMessage(MSG_TRANSFORMACK, false, false, msg_, TRANSFORMACK_CONTENT_ID);
+        transformAckPending_ = false;
+    }
+
     ++timeStamp_;
 }
 
@@ -473,6 +670,10 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& buffer)
                 ProcessControls(msgID, msg);
                 break;
 
+            case MSG_TRANSFORMACK:
+                ProcessTransformAck(msgID, msg);
+                break;
+
             case MSG_SCENELOADED:
                 ProcessSceneLoaded(msgID, msg);
                 break;
@@ -493,6 +694,7 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& buffer)
             case MSG_CREATENODE:
             case MSG_NODEDELTAUPDATE:
             case MSG_NODELATESTDATA:
+            case MSG_NODETRANSFORMS:
             case MSG_REMOVENODE:
             case MSG_CREATECOMPONENT:
             case MSG_COMPONENTDELTAUPDATE:
@@ -544,6 +746,8 @@ void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
 
     // Clear previous pending latest data and package downloads if any
     nodeLatestData_.Clear();
+    receivedTransforms_.Clear();
+    transformAcks_.Clear();
     componentLatestData_.Clear();
     downloads_.Clear();
 
@@ -702,6 +906,10 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
         }
         break;
 
+    case MSG_NODETRANSFORMS:
+        ProcessNodeTransforms(msg);
+        break;
+
     case MSG_REMOVENODE:
         {
             unsigned nodeID = msg.ReadNetID();
@@ -709,6 +917,7 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             if (node)
                 node->Remove();
             nodeLatestData_.Erase(nodeID);
+            receivedTransforms_.Erase(nodeID);
         }
         break;
 
@@ -793,6 +1002,85 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
     }
 }
 
+void Connection::ProcessNodeTransforms(MemoryBuffer& msg)
+{
+    PODVector<unsigned char> decompressed;
+    bool compressed = msg.ReadBool();
+    if (compressed)
+    {
+        decompressed.Resize(msg.ReadVLE());
+        if (decompressed.Empty() || DecompressData(&decompressed[0], msg.GetData() + msg.GetPosition(), decompressed.Size()) !=
+            msg.GetSize() - msg.GetPosition())
+        {
+            URHO3D_LOGERROR("Failed to decompress NodeTransforms message");
+            return;
+        }
+    }
+
+    MemoryBuffer source = compressed ? MemoryBuffer(decompressed) :
+        MemoryBuffer(msg.GetData() + msg.GetPosition(), msg.GetSize() - msg.GetPosition());
+
+    unsigned short sequence = source.ReadUShort();
+    unsigned char timeStamp = source.ReadUByte();
+    float positionPrecision = source.ReadFloat();
+    unsigned rotationBits = source.ReadUByte();
+    unsigned numTransforms = source.ReadVLE();
+    unsigned rotationBytes = GetRotationBytes(rotationBits);
+
+    transformAcks_.Add(sequence, 0);
+    transformAckPending_ = true;
+
+    VectorBuffer latestData;
+    VectorBuffer rotationData;
+    while (numTransforms-- && !source.IsEof())
+    {
+        unsigned nodeID = source.ReadNetID();
+        unsigned char flags = source.ReadUByte();
+
+        TransformHistory& history = receivedTransforms_[nodeID];
+        QuantizedTransform transform;
+        const QuantizedTransform* base = nullptr;
+        if (flags & TRANSFORM_DELTA)
+        {
+            base = history.Find(sequence - source.ReadUByte());
+            if (base)
+                transform = *base;
+        }
+
+        if (flags & TRANSFORM_POSITION)
+        {
+            for (unsigned i = 0; i < 3; ++i)
+                transform.position_[i] += ZigZagDecode(source.ReadVLE());
+        }
+        if (flags & TRANSFORM_ROTATION)
+        {
+            transform.rotation_ = 0;
+            source.Read(&transform.rotation_, rotationBytes);
+        }
+
+        if ((flags & TRANSFORM_DELTA) && !base)
+        {
+            URHO3D_LOGWARNING("NodeTransforms message received with unknown baseline for node " + String(nodeID));
+            continue;
+        }
+
+        history.Add(sequence, transform);
+
+        // Apply as a regular latest data update, so that smoothing, interception and caching for not yet created nodes work
+        // the same way
+        rotationData.Clear();
+        rotationData.WritePackedQuaternion(DequantizeRotation(transform.rotation_, rotationBits));
+        latestData.Clear();
+        latestData.WriteNetID(nodeID);
+        latestData.WriteUByte(timeStamp);
+        latestData.WriteVector3(Vector3((float)transform.position_[0], (float)transform.position_[1],
+            (float)transform.position_[2]) * positionPrecision);
+        latestData.WriteBuffer(rotationData.GetBuffer());
+        MemoryBuffer latestDataMsg(latestData.GetData(), latestData.GetSize());
+        ProcessSceneUpdate(MSG_NODELATESTDATA, latestDataMsg);
+    }
+}
+
 void Connection::ProcessPackageDownload(int msgID, MemoryBuffer& msg)
 {
     switch (msgID)
@@ -980,6 +1268,19 @@ void Connection::ProcessControls(int msgID, MemoryBuffer& msg)
         rotation_ = msg.ReadPackedQuaternion();
 }
 
+void Connection::ProcessTransformAck(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected TransformAck message from server");
+        return;
+    }
+
+    unsigned short sequence = msg.ReadUShort();
+    unsigned mask = msg.ReadUInt();
+    transformAcks_.Add(sequence, mask);
+}
+
 void Connection::ProcessSceneLoaded(int msgID, MemoryBuffer& msg)
 {
     if (!IsClient())
@@ -1196,10 +1497,98 @@ void Connection::HandleAsyncLoadFinished(StringHash eventType, VariantMap& event
     SendMessage(MSG_SCENELOADED, true, true, msg_);
 }
 
+void Connection::CollectRelevantNodes(const PODVector<InterestTier>& tiers)
+{
+    // Only the collected nodes are processed, so drop the IDs that would never be collected
+    RemoveStaleDirtyNodes();
+
+    // Nodes without spatial interest management, and removed nodes, are always relevant
+    const PODVector<Node*>& globalNodes = interestGrid_->GetGlobalNodes();
+    for (PODVector<Node*>::ConstIterator i = globalNodes.Begin(); i != globalNodes.End(); ++i)
+    {
+        unsigned nodeID = (*i)->GetID();
+        if (sceneState_.dirtyNodes_.Contains(nodeID))
+            nodesToProcess_.Insert(nodeID);
+    }
+
+    const PODVector<unsigned>& removedNodeIDs = scene_->GetRemovedNetworkNodes();
+    for (PODVector<unsigned>::ConstIterator i = removedNodeIDs.Begin(); i != removedNodeIDs.End(); ++i)
+    {
+        if (sceneState_.dirtyNodes_.Contains(*i))
+            nodesToProcess_.Insert(*i);
+    }
+
+    // Nodes owned by this connection may be set to update regardless of distance
+    const PODVector<const InterestGridNode*>& ownerUpdateNodes = interestGrid_->GetOwnerUpdateNodes();
+    for (PODVector<const InterestGridNode*>::ConstIterator i = ownerUpdateNodes.Begin(); i != ownerUpdateNodes.End(); ++i)
+    {
+        Node* node = (*i)->node_;
+        unsigned nodeID = node->GetID();
+        if (node->GetOwner() == this && sceneState_.dirtyNodes_.Contains(nodeID))
+            nodesToProcess_.Insert(nodeID);
+    }
+
+    // Then the dirty nodes near the observer, at the update rate of their distance tier
+    float maxDistance = tiers.Back().distance_;
+    relevantNodes_.Clear();
+    interestGrid_->GetNodes(relevantNodes_, position_, maxDistance);
+
+    for (PODVector<const InterestGridNode*>::ConstIterator i = relevantNodes_.Begin(); i != relevantNodes_.End(); ++i)
+    {
+        const InterestGridNode& gridNode = **i;
+        unsigned nodeID = gridNode.node_->GetID();
+        if (!sceneState_.dirtyNodes_.Contains(nodeID))
+            continue;
+
+        // Check the owner first, as the owner's updates do not depend on distance. These were collected above
+        if (gridNode.priority_->GetAlwaysUpdateOwner() && gridNode.node_->GetOwner() == this)
+            continue;
+
+        float distance = (gridNode.position_ - position_).Length();
+        if (distance > maxDistance)
+            continue;
+
+        unsigned interval = 1;
+        for (PODVector<InterestTier>::ConstIterator j = tiers.Begin(); j != tiers.End(); ++j)
+        {
+            if (distance <= j->distance_)
+            {
+                interval = j->interval_;
+                break;
+            }
+        }
+
+        // Stagger the reduced rate updates by node ID to spread them evenly. Skipped nodes stay dirty
+        if ((interestUpdateCount_ + nodeID) % interval == 0)
+            nodesToProcess_.Insert(nodeID);
+    }
+
+    ++interestUpdateCount_;
+}
+
+void Connection::RemoveStaleDirtyNodes()
+{
+    for (HashSet<unsigned>::Iterator i = sceneState_.dirtyNodes_.Begin(); i != sceneState_.dirtyNodes_.End();)
+    {
+        if (!sceneState_.nodeStates_.Contains(*i) && !scene_->GetNode(*i))
+            i = sceneState_.dirtyNodes_.Erase(i);
+        else
+            ++i;
+    }
+}
+
 void Connection::ProcessNode(unsigned nodeID)
 {
-    // Check that we have not already processed this due to dependency recursion
-    if (!nodesToProcess_.Erase(nodeID))
+    // Check that we have not already processed this due to dependency recursion. With interest management, depended upon
+    // nodes are processed even if they were not collected for this update
+    if (interestGrid_)
+    {
+        if (processedNodes_.Contains(nodeID))
+            return;
+        processedNodes_.Insert(nodeID);
+        nodesToProcess_.Erase(nodeID);
+    }
+    else if (!nodesToProcess_.Erase(nodeID))
         return;
 
     // Find replication state for the node
@@ -1217,6 +1606,9 @@ void Connection::ProcessNode(unsigned nodeID)
             // would be enough. However, this may be better due to the client not possibly having updated parenting
             // information at the time of receiving this message
             SendMessage(MSG_REMOVENODE, true, true, msg_);
+
+            // Releasing the weak references to the removed node and its components is not threadsafe
+            MutexLock lock(GetSubsystem<Network>()->GetReplicationMutex());
             sceneState_.nodeStates_.Erase(nodeID);
         }
         else
@@ -1250,11 +1642,17 @@ void Connection::ProcessNewNode(Node* node)
     msg_.Clear();
     msg_.WriteNetID(node->GetID());
 
+    // Other connections may be registering replication states to the same node and components in worker threads
+    Mutex& replicationMutex = GetSubsystem<Network>()->GetReplicationMutex();
+
     NodeReplicationState& nodeState = sceneState_.nodeStates_[node->GetID()];
     nodeState.connection_ = this;
     nodeState.sceneState_ = &sceneState_;
-    nodeState.node_ = node;
-    node->AddReplicationState(&nodeState);
+    {
+        MutexLock lock(replicationMutex);
+        nodeState.node_ = node;
+        node->AddReplicationState(&nodeState);
+    }
 
     // Write node's attributes
     node->WriteInitialDeltaUpdate(msg_, timeStamp_);
@@ -1281,8 +1679,11 @@ void Connection::ProcessNewNode(Node* node)
         ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
         componentState.connection_ = this;
         componentState.nodeState_ = &nodeState;
-        componentState.component_ = component;
-        component->AddReplicationState(&componentState);
+        {
+            MutexLock lock(replicationMutex);
+            componentState.component_ = component;
+            component->AddReplicationState(&componentState);
+        }
 
         msg_.WriteStringHash(component->GetType());
         msg_.WriteNetID(component->GetID());
@@ -1306,11 +1707,13 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             ProcessNode(nodeID);
     }
 
-    // Check from the interest management component, if exists, whether should update
+    // Check from the interest management component, if exists, whether should update. When using the interest management
+    // grid, the update rate has already been checked
     /// \todo Searching for the component is a potential CPU hotspot. It should be cached
-    auto* priority = node->GetComponent<NetworkPriority>();
+    auto* priority = !interestGrid_ ? node->GetComponent<NetworkPriority>() : nullptr;
     if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
     {
+        // The world position is up to date since Scene::PrepareNetworkUpdate(), so reading it from worker threads is safe
         float distance = (node->GetWorldPosition() - position_).Length();
         if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
             return;
@@ -1332,8 +1735,11 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             }
         }
 
-        // Send latestdata message if necessary
-        if (hasLatestData)
+        // Send latestdata message if necessary. The only latest data attributes of a node are its transform, which can
+        // alternatively be sent in compact form
+        if (hasLatestData && compactTransforms_)
+            WriteNodeTransform(node, nodeState);
+        else if (hasLatestData)
         {
             msg_.Clear();
             msg_.WriteNetID(node->GetID());
@@ -1390,6 +1796,8 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             msg_.WriteNetID(current->first_);
 
             SendMessage(MSG_REMOVECOMPONENT, true, true, msg_);
+
+            MutexLock lock(GetSubsystem<Network>()->GetReplicationMutex());
             nodeState.componentStates_.Erase(current);
         }
         else
@@ -1453,8 +1861,11 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
                 componentState.connection_ = this;
                 componentState.nodeState_ = &nodeState;
-                componentState.component_ = component;
-                component->AddReplicationState(&componentState);
+                {
+                    MutexLock lock(GetSubsystem<Network>()->GetReplicationMutex());
+                    componentState.component_ = component;
+                    component->AddReplicationState(&componentState);
+                }
 
                 msg_.Clear();
                 msg_.WriteNetID(node->GetID());
@@ -1471,6 +1882,119 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     sceneState_.dirtyNodes_.Erase(node->GetID());
 }
 
+void Connection::WriteNodeTransform(Node* node, NodeReplicationState& nodeState)
+{
+    const Vector3& position = node->GetPosition();
+    QuantizedTransform transform;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        transform.position_[i] = Clamp(RoundToInt(position.Data()[i] / transformPositionPrecision_), -MAX_QUANTIZED_POSITION,
+            MAX_QUANTIZED_POSITION);
+    }
+    transform.rotation_ = QuantizeRotation(node->GetRotation(), transformRotationBits_);
+
+    // Find the newest transform the client is known to have received. Older ones are no longer needed as baselines
+    TransformHistory& history = nodeState.sentTransforms_;
+    const QuantizedTransform* base = nullptr;
+    for (unsigned i = history.count_ - 1; i < history.count_; --i)
+    {
+        if (transformAcks_.Contains(history.sequences_[i]))
+        {
+            history.RemoveOlder(i);
+            base = &history.transforms_[0];
+            break;
+        }
+    }
+
+    if (base)
+    {
+        // If the client has acknowledged the newest transform and it has not changed, there is nothing to send
+        if (history.count_ == 1 && *base == transform)
+        {
+            pendingTransforms_.Erase(node->GetID());
+            return;
+        }
+        // The age must fit in a byte
+        if ((unsigned short)(transformSequence_ - history.sequences_[0]) > 255)
+            base = nullptr;
+    }
+
+    unsigned char flags = 0;
+    if (base)
+    {
+        flags |= TRANSFORM_DELTA;
+        if (transform.position_[0] != base->position_[0] || transform.position_[1] != base->position_[1] ||
+            transform.position_[2] != base->position_[2])
+            flags |= TRANSFORM_POSITION;
+        if (transform.rotation_ != base->rotation_)
+            flags |= TRANSFORM_ROTATION;
+    }
+    else
+        flags |= TRANSFORM_POSITION | TRANSFORM_ROTATION;
+
+    transformMsg_.WriteNetID(node->GetID());
+    transformMsg_.WriteUByte(flags);
+    if (base)
+        transformMsg_.WriteUByte((unsigned char)(transformSequence_ - history.sequences_[0]));
+    if (flags & TRANSFORM_POSITION)
+    {
+        for (unsigned i = 0; i < 3; ++i)
+            transformMsg_.WriteVLE(ZigZagEncode(transform.position_[i] - (base ? base->position_[i] : 0)));
+    }
+    if (flags & TRANSFORM_ROTATION)
+        transformMsg_.Write(&transform.rotation_, GetRotationBytes(transformRotationBits_));
+
+    history.Add(transformSequence_, transform);
+    pendingTransforms_.Insert(node->GetID());
+    ++numTransforms_;
+
+    // Split to several messages so that a lost packet loses only a part of the update
+    if (transformMsg_.GetSize() >= (unsigned)packedMessageLimit_)
+        SendNodeTransforms();
+}
+
+void Connection::SendNodeTransforms()
+{
+    if (!numTransforms_)
+        return;
+
+    msg_.Clear();
+    msg_.WriteUShort(transformSequence_);
+    msg_.WriteUByte(timeStamp_);
+    msg_.WriteFloat(transformPositionPrecision_);
+    msg_.WriteUByte((unsigned char)transformRotationBits_);
+    msg_.WriteVLE(numTransforms_);
+    msg_.Write(transformMsg_.GetData(), transformMsg_.GetSize());
+
+    // Prefix with the compression flag and compress if it makes the message smaller
+    unsigned dataSize = msg_.GetSize();
+    transformMsg_.Clear();
+    if (transformCompression_ && dataSize >= MIN_TRANSFORM_COMPRESS_SIZE)
+    {
+        transformMsg_.WriteBool(true);
+        transformMsg_.WriteVLE(dataSize);
+        unsigned headerSize = transformMsg_.GetSize();
+        transformMsg_.Resize(headerSize + EstimateCompressBound(dataSize));
+        unsigned compressedSize = CompressData(transformMsg_.GetModifiableData() + headerSize, msg_.GetData(), dataSize);
+        if (compressedSize && headerSize + compressedSize <= dataSize)
+            transformMsg_.Resize(headerSize + compressedSize);
+        else
+            transformMsg_.Clear();
+    }
+    if (!transformMsg_.GetSize())
+    {
+        transformMsg_.WriteBool(false);
+        transformMsg_.Write(msg_.GetData(), dataSize);
+    }
+
+    // The message is unreliable: lost transforms stay pending and are resent, delta-encoded against what the client did receive
+    SendMessage(MSG_NODETRANSFORMS, false, true, transformMsg_);
+
+    transformMsg_.Clear();
+    numTransforms_ = 0;
+    ++transformSequence_;
+}
+
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
 {
     auto* cache = GetSubsystem<ResourceCache>();
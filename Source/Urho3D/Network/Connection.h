@@ -45,11 +45,14 @@ namespace Urho3D
 {
 
 class File;
+class InterestGrid;
 class MemoryBuffer;
 class Node;
 class Scene;
 class Serializable;
 class PackageFile;
+struct InterestGridNode;
+struct InterestTier;
 
 /// Queued remote event.
 struct RemoteEvent
@@ -98,6 +101,24 @@ struct PackageUpload
     unsigned totalFragments_;
 };
 
+/// Window of recently received or acknowledged node transform update sequence numbers.
+struct URHO3D_API TransformAckWindow
+{
+    /// Mark a sequence number as received, along with the preceding ones set in the mask.
+    void Add(unsigned short sequence, unsigned mask);
+    /// Return whether a sequence number has been marked received.
+    bool Contains(unsigned short sequence) const;
+    /// Clear all sequence numbers.
+    void Clear();
+
+    /// Newest received sequence number.
+    unsigned short latest_{};
+    /// Bitmask of received sequence numbers preceding the newest, starting from the one just before it.
+    unsigned mask_{};
+    /// Whether any sequence number has been received.
+    bool valid_{};
+};
+
 /// Send modes for observer position/rotation. Activated by the client setting either position or rotation.
 enum ObserverPositionSendMode
 {
@@ -295,12 +316,24 @@ private:
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
+    /// Process a compact node transforms message from the server.
+    void ProcessNodeTransforms(MemoryBuffer& msg);
+    /// Process a node transform acknowledgement message from the client.
+    void ProcessTransformAck(int msgID, MemoryBuffer& msg);
+    /// Collect the dirty nodes to process from the interest management grid.
+    void CollectRelevantNodes(const PODVector<InterestTier>& tiers);
+    /// Remove dirty node IDs that have neither a scene node nor a replication state.
+    void RemoveStaleDirtyNodes();
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
     void ProcessNode(unsigned nodeID);
     /// Process a node that the client has not yet received.
     void ProcessNewNode(Node* node);
     /// Process a node that the client has already received.
     void ProcessExistingNode(Node* node, NodeReplicationState& nodeState);
+    /// Write a node's quantized transform into the compact transforms message, delta-encoded against the newest acknowledged one.
+    void WriteNodeTransform(Node* node, NodeReplicationState& nodeState);
+    /// Send the compact transforms message if it has any transforms.
+    void SendNodeTransforms();
     /// Process a SyncPackagesInfo message from server.
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
     /// Process unknown message. All unknown messages are forwarded as an events
@@ -332,8 +365,24 @@ private:
     HashMap<unsigned, PODVector<unsigned char> > componentLatestData_;
     /// Node ID's to process during a replication update.
     HashSet<unsigned> nodesToProcess_;
+    /// Node ID's processed during a replication update with interest management.
+    HashSet<unsigned> processedNodes_;
+    /// Interest management grid nodes near the observer.
+    PODVector<const InterestGridNode*> relevantNodes_;
+    /// Interest management grid of the scene during a replication update, or null if not used.
+    InterestGrid* interestGrid_;
+    /// Replication updates sent with interest management, used to stagger reduced rate updates.
+    unsigned interestUpdateCount_;
+    /// Node ID's whose newest compact transform has not been acknowledged.
+    HashSet<unsigned> pendingTransforms_;
+    /// Compact node transforms received from the server, used as delta baselines.
+    HashMap<unsigned, TransformHistory> receivedTransforms_;
+    /// Node transform update sequence numbers acknowledged by the client, or received from the server.
+    TransformAckWindow transformAcks_;
     /// Reusable message buffer.
     VectorBuffer msg_;
+    /// Compact node transform entries being collected during a replication update.
+    VectorBuffer transformMsg_;
     /// Queued remote events.
     Vector<RemoteEvent> remoteEvents_;
     /// Scene file to load once all packages (if any) have been downloaded.
@@ -346,6 +395,20 @@ private:
     Vector3 position_;
     /// Observer rotation for interest management.
     Quaternion rotation_;
+    /// Position precision of the compact transforms being collected.
+    float transformPositionPrecision_;
+    /// Rotation bits of the compact transforms being collected.
+    unsigned transformRotationBits_;
+    /// Number of compact transform entries being collected.
+    unsigned numTransforms_;
+    /// Sequence number of the next compact transforms message.
+    unsigned short transformSequence_;
+    /// Compact transforms mode flag for the current replication update.
+    bool compactTransforms_;
+    /// Compact transforms message compression flag for the current replication update.
+    bool transformCompression_;
+    /// Whether compact transforms have been received since the last acknowledgement was sent.
+    bool transformAckPending_;
     /// Send mode for the observer position & rotation.
     ObserverPositionSendMode sendMode_;
     /// Client connection flag.
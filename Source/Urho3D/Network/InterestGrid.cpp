@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Network/InterestGrid.h"
+#include "../Network/NetworkPriority.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+InterestGrid::InterestGrid() :
+    cellSize_(1.0f)
+{
+}
+
+void InterestGrid::Update(Scene* scene, float cellSize)
+{
+    cellSize_ = Max(cellSize, M_EPSILON);
+    unorderedNodes_.Clear();
+    cells_.Clear();
+    globalNodes_.Clear();
+    ownerUpdateNodes_.Clear();
+
+    // Count the spatially managed nodes in each cell. The cell's end index is used as the counter
+    const HashMap<unsigned, Node*>& replicatedNodes = scene->GetReplicatedNodes();
+    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes.Begin(); i != replicatedNodes.End(); ++i)
+    {
+        Node* node = i->second_;
+        if (node == scene)
+            continue;
+
+        auto* priority = node->GetComponent<NetworkPriority>();
+        if (!priority)
+        {
+            globalNodes_.Push(node);
+            continue;
+        }
+
+        InterestGridNode entry;
+        entry.node_ = node;
+        entry.priority_ = priority;
+        entry.position_ = node->GetWorldPosition();
+        unorderedNodes_.Push(entry);
+        ++cells_[GetCell(entry.position_)].y_;
+    }
+
+    // Assign index ranges to the cells, then place the nodes
+    unsigned start = 0;
+    for (HashMap<IntVector2, IntVector2>::Iterator i = cells_.Begin(); i != cells_.End(); ++i)
+    {
+        unsigned count = i->second_.y_;
+        i->second_ = IntVector2(start, start);
+        start += count;
+    }
+
+    nodes_.Resize(unorderedNodes_.Size());
+    for (PODVector<InterestGridNode>::ConstIterator i = unorderedNodes_.Begin(); i != unorderedNodes_.End(); ++i)
+    {
+        IntVector2& range = cells_[GetCell(i->position_)];
+        InterestGridNode& entry = nodes_[range.y_++];
+        entry = *i;
+        if (entry.priority_->GetAlwaysUpdateOwner() && entry.node_->GetOwner())
+            ownerUpdateNodes_.Push(&entry);
+    }
+}
+
+void InterestGrid::GetNodes(PODVector<const InterestGridNode*>& dest, const Vector3& position, float radius) const
+{
+    IntVector2 min = GetCell(position - Vector3(radius, 0.0f, radius));
+    IntVector2 max = GetCell(position + Vector3(radius, 0.0f, radius));
+
+    // If the area covers more cells than are occupied, check the occupied cells instead
+    if ((long long)(max.x_ - min.x_ + 1) * (max.y_ - min.y_ + 1) > (long long)cells_.Size())
+    {
+        for (HashMap<IntVector2, IntVector2>::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            const IntVector2& cell = i->first_;
+            if (cell.x_ < min.x_ || cell.x_ > max.x_ || cell.y_ < min.y_ || cell.y_ > max.y_)
+                continue;
+
+            for (int j = i->second_.x_; j < i->second_.y_; ++j)
+                dest.Push(&nodes_[j]);
+        }
+        return;
+    }
+
+    for (int z = min.y_; z <= max.y_; ++z)
+    {
+        for (int x = min.x_; x <= max.x_; ++x)
+        {
+            HashMap<IntVector2, IntVector2>::ConstIterator i = cells_.Find(IntVector2(x, z));
+            if (i == cells_.End())
+                continue;
+
+            for (int j = i->second_.x_; j < i->second_.y_; ++j)
+                dest.Push(&nodes_[j]);
+        }
+    }
+}
+
+IntVector2 InterestGrid::GetCell(const Vector3& position) const
+{
+    return IntVector2(FloorToInt(position.x_ / cellSize_), FloorToInt(position.z_ / cellSize_));
+}
+
+}
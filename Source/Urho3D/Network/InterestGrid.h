@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/RefCounted.h"
+#include "../Math/Vector3.h"
+
+namespace Urho3D
+{
+
+class NetworkPriority;
+class Node;
+class Scene;
+
+/// Interest management update rate tier. Nodes within the distance from a client's observer position are updated on every Nth network update.
+struct InterestTier
+{
+    /// Maximum distance from the observer.
+    float distance_;
+    /// Update interval in network updates.
+    unsigned interval_;
+};
+
+/// Spatially managed replicated node in an interest grid.
+struct InterestGridNode
+{
+    /// Node.
+    Node* node_;
+    /// Interest management settings component.
+    NetworkPriority* priority_;
+    /// World position.
+    Vector3 position_;
+};
+
+/// %Grid of replicated scene nodes on the XZ plane for server-side interest management. Rebuilt on each network update.
+class URHO3D_API InterestGrid : public RefCounted
+{
+public:
+    /// Construct.
+    InterestGrid();
+
+    /// Rebuild from the scene's replicated nodes. Nodes with a NetworkPriority component are sorted into cells, while other nodes are always relevant.
+    void Update(Scene* scene, float cellSize);
+    /// Return spatially managed nodes in the cells overlapping a circle on the XZ plane. Nodes may be further away than the radius.
+    void GetNodes(PODVector<const InterestGridNode*>& dest, const Vector3& position, float radius) const;
+
+    /// Return nodes that are not spatially managed.
+    const PODVector<Node*>& GetGlobalNodes() const { return globalNodes_; }
+    /// Return spatially managed nodes that have an owner connection and are always updated to it regardless of distance.
+    const PODVector<const InterestGridNode*>& GetOwnerUpdateNodes() const { return ownerUpdateNodes_; }
+
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+
+private:
+    /// Return cell coordinates of a position.
+    IntVector2 GetCell(const Vector3& position) const;
+
+    /// Spatially managed nodes, ordered by cell.
+    PODVector<InterestGridNode> nodes_;
+    /// Spatially managed nodes before ordering by cell.
+    PODVector<InterestGridNode> unorderedNodes_;
+    /// Start and end indices into the node array by cell coordinates.
+    HashMap<IntVector2, IntVector2> cells_;
+    /// Nodes that are not spatially managed.
+    PODVector<Node*> globalNodes_;
+    /// Spatially managed nodes that are always updated to their owner.
+    PODVector<const InterestGridNode*> ownerUpdateNodes_;
+    /// Cell size.
+    float cellSize_;
+};
+
+}
@@ -25,6 +25,7 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
@@ -192,12 +193,27 @@ static const char* RAKNET_MESSAGEID_STRINGS[] = {
 
 static const int DEFAULT_UPDATE_FPS = 30;
 static const int SERVER_TIMEOUT_TIME = 10000;
+static const float DEFAULT_TRANSFORM_POSITION_PRECISION = 0.001f;
+static const unsigned DEFAULT_TRANSFORM_ROTATION_BITS = 12;
+
+void SendServerUpdateWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto** connections = reinterpret_cast<Connection**>(aux);
+
+    for (unsigned i = start; i < end; ++i)
+        connections[i]->SendServerUpdate();
+}
 
 Network::Network(Context* context) :
     Object(context),
     updateFps_(DEFAULT_UPDATE_FPS),
     simulatedLatency_(0),
     simulatedPacketLoss_(0.0f),
+    transformPositionPrecision_(DEFAULT_TRANSFORM_POSITION_PRECISION),
+    transformRotationBits_(DEFAULT_TRANSFORM_ROTATION_BITS),
+    compactTransforms_(false),
+    transformCompression_(false),
+    interestCellSize_(0.0f),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
     updateAcc_(0.0f),
     isServer_(false),
@@ -589,6 +605,48 @@ void Network::SetSimulatedPacketLoss(float probability)
     ConfigureNetworkSimulator();
 }
 
+void Network::SetCompactTransforms(bool enable)
+{
+    compactTransforms_ = enable;
+}
+
+void Network::SetTransformPositionPrecision(float precision)
+{
+    transformPositionPrecision_ = Max(precision, M_LARGE_EPSILON);
+}
+
+void Network::SetTransformRotationBits(unsigned bits)
+{
+    transformRotationBits_ = Clamp(bits, 6U, 15U);
+}
+
+void Network::SetTransformCompression(bool enable)
+{
+    transformCompression_ = enable;
+}
+
+void Network::SetInterestCellSize(float size)
+{
+    interestCellSize_ = Max(size, 0.0f);
+}
+
+void Network::AddInterestTier(float distance, unsigned interval)
+{
+    InterestTier tier;
+    tier.distance_ = Max(distance, 0.0f);
+    tier.interval_ = Max(interval, 1U);
+
+    unsigned index = 0;
+    while (index < interestTiers_.Size() && interestTiers_[index].distance_ < tier.distance_)
+        ++index;
+    interestTiers_.Insert(index, tier);
+}
+
+void Network::RemoveAllInterestTiers()
+{
+    interestTiers_.Clear();
+}
+
 void Network::RegisterRemoteEvent(StringHash eventType)
 {
     if (blacklistedRemoteEvents_.Find(eventType) != blacklistedRemoteEvents_.End())
@@ -665,6 +723,12 @@ Connection* Network::GetConnection(const SLNet::AddressOrGUID& connection) const
     }
 }
 
+InterestGrid* Network::GetInterestGrid(Scene* scene) const
+{
+    HashMap<Scene*, SharedPtr<InterestGrid> >::ConstIterator i = interestGrids_.Find(scene);
+    return i != interestGrids_.End() ? i->second_.Get() : nullptr;
+}
+
 Connection* Network::GetServerConnection() const
 {
     return serverConnection_;
@@ -941,19 +1005,46 @@ void Network::PostUpdate(float timeStep)
 
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
                     (*i)->PrepareNetworkUpdate();
+
+                // Rebuild the interest management grids once per scene, so that each connection only needs to visit its surroundings
+                for (HashMap<Scene*, SharedPtr<InterestGrid> >::Iterator i = interestGrids_.Begin(); i != interestGrids_.End();)
+                {
+                    if (!networkScenes_.Contains(i->first_) || interestCellSize_ <= 0.0f || interestTiers_.Empty())
+                        i = interestGrids_.Erase(i);
+                    else
+                        ++i;
+                }
+                if (interestCellSize_ > 0.0f && !interestTiers_.Empty())
+                {
+                    for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+                    {
+                        SharedPtr<InterestGrid>& grid = interestGrids_[*i];
+                        if (!grid)
+                            grid = new InterestGrid();
+                        grid->Update(*i, interestCellSize_);
+                    }
+                }
             }
 
             {
                 URHO3D_PROFILE(SendServerUpdate);
 
-                // Then send server updates for each client connection
+                // Then build the scene updates of the client connections in worker threads. The prepared scenes are only
+                // read, except for registering replication states, which is guarded by the replication mutex
+                updateConnections_.Clear();
                 for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
                      i != clientConnections_.End(); ++i)
+                    updateConnections_.Push(i->second_);
+
+                if (!updateConnections_.Empty())
+                    GetSubsystem<WorkQueue>()->ParallelFor(updateConnections_.Size(), SendServerUpdateWork, updateConnections_.Buffer());
+
+                // Remote events and package uploads may access files and other subsystems, so send them in the main thread
+                for (PODVector<Connection*>::ConstIterator i = updateConnections_.Begin(); i != updateConnections_.End(); ++i)
                 {
-                    i->second_->SendServerUpdate();
-                    i->second_->SendRemoteEvents();
-                    i->second_->SendPackages();
-                    i->second_->SendAllBuffers();
+                    (*i)->SendRemoteEvents();
+                    (*i)->SendPackages();
+                    (*i)->SendAllBuffers();
                 }
             }
         }
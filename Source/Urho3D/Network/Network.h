@@ -23,9 +23,11 @@
 #pragma once
 
 #include "../Container/HashSet.h"
+#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 #include "../IO/VectorBuffer.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestGrid.h"
 
 namespace Urho3D
 {
@@ -94,6 +96,25 @@ public:
     /// Set simulated packet loss probability between 0.0 - 1.0.
     /// @property
     void SetSimulatedPacketLoss(float probability);
+    /// Set whether to send node transforms quantized and delta-compressed against the last transforms acknowledged by each client.
+    /// @property
+    void SetCompactTransforms(bool enable);
+    /// Set position precision in world units for compact node transforms.
+    /// @property
+    void SetTransformPositionPrecision(float precision);
+    /// Set bits per smallest-three rotation component for compact node transforms, between 6 and 15.
+    /// @property
+    void SetTransformRotationBits(unsigned bits);
+    /// Set whether to LZ4 compress compact node transform messages when it makes them smaller.
+    /// @property
+    void SetTransformCompression(bool enable);
+    /// Set interest management grid cell size. Zero (default) disables grid-based interest management.
+    /// @property
+    void SetInterestCellSize(float size);
+    /// Add an interest management update rate tier: nodes with a NetworkPriority component within the distance from a client's observer are updated on every Nth network update. Nodes beyond the farthest tier are not updated. Grid-based interest management requires at least one tier.
+    void AddInterestTier(float distance, unsigned interval);
+    /// Remove all interest management update rate tiers.
+    void RemoveAllInterestTiers();
     /// Register a remote event as allowed to be received. There is also a fixed blacklist of events that can not be allowed in any case, such as ConsoleCommand.
     void RegisterRemoteEvent(StringHash eventType);
     /// Unregister a remote event as allowed to received.
@@ -121,6 +142,37 @@ public:
     /// @property
     float GetSimulatedPacketLoss() const { return simulatedPacketLoss_; }
 
+    /// Return whether node transforms are sent quantized and delta-compressed.
+    /// @property
+    bool GetCompactTransforms() const { return compactTransforms_; }
+
+    /// Return position precision for compact node transforms.
+    /// @property
+    float GetTransformPositionPrecision() const { return transformPositionPrecision_; }
+
+    /// Return bits per rotation component for compact node transforms.
+    /// @property
+    unsigned GetTransformRotationBits() const { return transformRotationBits_; }
+
+    /// Return whether compact node transform messages are LZ4 compressed.
+    /// @property
+    bool GetTransformCompression() const { return transformCompression_; }
+
+    /// Return interest management grid cell size.
+    /// @property
+    float GetInterestCellSize() const { return interestCellSize_; }
+
+    /// Return interest management update rate tiers, sorted by distance.
+    /// @nobind
+    const PODVector<InterestTier>& GetInterestTiers() const { return interestTiers_; }
+
+    /// Return the interest management grid of a networked scene, or null if grid-based interest management is disabled.
+    /// @nobind
+    InterestGrid* GetInterestGrid(Scene* scene) const;
+    /// Return the mutex for registering replication states, which client connections do while building their scene updates in worker threads.
+    /// @nobind
+    Mutex& GetReplicationMutex() { return replicationMutex_; }
+
     /// Return a client or server connection by RakNet connection address, or null if none exist.
     Connection* GetConnection(const SLNet::AddressOrGUID& connection) const;
     /// Return the connection to the server. Null if not connected.
@@ -172,12 +224,30 @@ private:
     HashSet<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
     HashSet<Scene*> networkScenes_;
+    /// Client connections receiving a scene update this frame.
+    PODVector<Connection*> updateConnections_;
+    /// Mutex for registering and releasing replication states during threaded scene updates.
+    Mutex replicationMutex_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
     int simulatedLatency_;
     /// Simulated packet loss probability between 0.0 - 1.0.
     float simulatedPacketLoss_;
+    /// Position precision for compact node transforms.
+    float transformPositionPrecision_;
+    /// Bits per rotation component for compact node transforms.
+    unsigned transformRotationBits_;
+    /// Compact node transforms flag.
+    bool compactTransforms_;
+    /// Compact node transform message compression flag.
+    bool transformCompression_;
+    /// Interest management grid cell size.
+    float interestCellSize_;
+    /// Interest management update rate tiers.
+    PODVector<InterestTier> interestTiers_;
+    /// Interest management grids of networked scenes.
+    HashMap<Scene*, SharedPtr<InterestGrid> > interestGrids_;
     /// Update time interval.
     float updateInterval_;
     /// Update time accumulator.
@@ -67,11 +67,18 @@ static const int MSG_PACKAGEINFO = 0x98;
 /// Packet that includes all the above messages
 static const int MSG_PACKED_MESSAGE = 0x99;
 
+/// Server->client: quantized and delta-compressed node transforms.
+static const int MSG_NODETRANSFORMS = 0x9A;
+/// Client->server: acknowledge received node transform updates.
+static const int MSG_TRANSFORMACK = 0x9B;
+
 /// Used to define custom messages, usually of the form MSG_USER + x, where x is an integer value.
 static const int MSG_USER = 0x200;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
+/// Fixed content ID for node transform acknowledgement.
+static const unsigned TRANSFORMACK_CONTENT_ID = 2;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
 
@@ -31,96 +31,168 @@
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 
+#include <algorithm>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Background resource loader thread.
+class BackgroundLoadThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    explicit BackgroundLoadThread(BackgroundLoader* owner) :
+        owner_(owner)
+    {
+    }
+
+    /// Load resources until stopped.
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD("BackgroundLoader Thread");
+        owner_->ProcessItems(this);
+    }
+
+    /// Sleep until woken up.
+    void Sleep() { wakeCondition_.Wait(); }
+    /// Wake up from sleep.
+    void Wake() { wakeCondition_.Set(); }
+
+private:
+    /// Background loader.
+    BackgroundLoader* owner_;
+    /// Condition for waking up when resources have been queued.
+    Condition wakeCondition_;
+};
+
+static bool CompareBackgroundLoadRequests(const BackgroundLoadRequest& lhs, const BackgroundLoadRequest& rhs)
+{
+    // The heap keeps the greatest request first: highest priority, then earliest queued
+    if (lhs.priority_ != rhs.priority_)
+        return lhs.priority_ < rhs.priority_;
+    else
+        return lhs.order_ > rhs.order_;
+}
+
 BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
-    owner_(owner)
+    owner_(owner),
+    numThreads_(1),
+    nextOrder_(0),
+    shouldRun_(false)
 {
 }
 
 BackgroundLoader::~BackgroundLoader()
 {
+    StopThreads();
+
     MutexLock lock(backgroundLoadMutex_);
 
     backgroundLoadQueue_.Clear();
+    requests_.Clear();
 }
 
-void BackgroundLoader::ThreadFunction()
+void BackgroundLoader::SetNumThreads(unsigned num)
 {
-    URHO3D_PROFILE_THREAD("BackgroundLoader Thread");
+    num = Max(num, 1U);
+    if (num == numThreads_)
+        return;
+
+    // Restart the threads if already running
+    bool running = !threads_.Empty();
+    if (running)
+        StopThreads();
 
+    numThreads_ = num;
+
+    if (running)
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        StartThreads();
+    }
+}
+
+void BackgroundLoader::ProcessItems(BackgroundLoadThread* thread)
+{
     while (shouldRun_)
     {
         backgroundLoadMutex_.Acquire();
 
-        // Search for a queued resource that has not been loaded yet
-        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-        while (i != backgroundLoadQueue_.End())
+        // Take the highest priority resource that has not been loaded yet. Skip the entries left behind by raising priority
+        BackgroundLoadItem* item = nullptr;
+        while (!requests_.Empty() && !item)
         {
-            if (i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
-                break;
-            else
-                ++i;
+            Pair<StringHash, StringHash> key = requests_.Front().key_;
+            std::pop_heap(requests_.Buffer(), requests_.Buffer() + requests_.Size(), CompareBackgroundLoadRequests);
+            requests_.Pop();
+
+            HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
+            if (i != backgroundLoadQueue_.End() && i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+                item = &i->second_;
         }
 
-        if (i == backgroundLoadQueue_.End())
+        if (!item)
         {
-            // No resources to load found
+            // No resources to load found: sleep until more are queued, or the threads are stopped
+            idleThreads_.Push(thread);
             backgroundLoadMutex_.Release();
-            Time::Sleep(5);
+            thread->Sleep();
         }
         else
         {
-            BackgroundLoadItem& item = i->second_;
-            Resource* resource = item.resource_;
+            Resource* resource = item->resource_;
             // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
+            // "queued" or "loading" state. Mark it loading before releasing the mutex so that other
+            // loader threads do not pick it up
+            resource->SetAsyncLoadState(ASYNC_LOADING);
             backgroundLoadMutex_.Release();
 
             bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
+            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item->sendEventOnFailure_);
             if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
                 success = resource->BeginLoad(*file);
-            }
 
             // Process dependencies now
             // Need to lock the queue again when manipulating other entries
             Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
             backgroundLoadMutex_.Acquire();
-            if (item.dependents_.Size())
+            if (item->dependents_.Size())
             {
-                for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item.dependents_.Begin();
-                     i != item.dependents_.End(); ++i)
+                for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item->dependents_.Begin();
+                     i != item->dependents_.End(); ++i)
                 {
                     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
                     if (j != backgroundLoadQueue_.End())
                         j->second_.dependencies_.Erase(key);
                 }
 
-                item.dependents_.Clear();
+                item->dependents_.Clear();
             }
 
             resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
             backgroundLoadMutex_.Release();
+
+            // Wake up the main thread in case it is waiting for this resource
+            loadedCondition_.Set();
         }
     }
 }
 
-bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority)
 {
     StringHash nameHash(name);
     Pair<StringHash, StringHash> key = MakePair(type, nameHash);
 
     MutexLock lock(backgroundLoadMutex_);
 
-    // Check if already exists in the queue
+    // Check if already exists in the queue. If requested with a higher priority, load sooner
     if (backgroundLoadQueue_.Find(key) != backgroundLoadQueue_.End())
+    {
+        RaisePriority(key, priority);
         return false;
+    }
 
     BackgroundLoadItem& item = backgroundLoadQueue_[key];
     item.sendEventOnFailure_ = sendEventOnFailure;
@@ -149,7 +221,8 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
     item.resource_->SetName(name);
     item.resource_->SetAsyncLoadState(ASYNC_QUEUED);
 
-    // If this is a resource calling for the background load of more resources, mark the dependency as necessary
+    // If this is a resource calling for the background load of more resources, mark the dependency as necessary.
+    // The caller can not finish before this resource, so load it with at least the same priority
     if (caller)
     {
         Pair<StringHash, StringHash> callerKey = MakePair(caller->GetType(), caller->GetNameHash());
@@ -159,15 +232,24 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
             BackgroundLoadItem& callerItem = j->second_;
             item.dependents_.Insert(callerKey);
             callerItem.dependencies_.Insert(key);
+            priority = Max(priority, callerItem.priority_);
         }
         else
             URHO3D_LOGWARNING("Resource " + caller->GetName() +
                        " requested for a background loaded resource but was not in the background load queue");
     }
 
-    // Start the background loader thread now
-    if (!IsStarted())
-        Run();
+    item.priority_ = priority;
+    PushRequest(key, priority);
+
+    // Start the background loader threads now, or wake up an idle one
+    if (threads_.Empty())
+        StartThreads();
+    else if (!idleThreads_.Empty())
+    {
+        idleThreads_.Back()->Wake();
+        idleThreads_.Pop();
+    }
 
     return true;
 }
@@ -181,6 +263,8 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
     if (i != backgroundLoadQueue_.End())
     {
+        // The resource is needed now, so load it and the resources it depends on before anything else
+        RaisePriority(key, M_MAX_INT);
         backgroundLoadMutex_.Release();
 
         {
@@ -195,7 +279,7 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
                 if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
                 {
                     didWait = true;
-                    Time::Sleep(1);
+                    loadedCondition_.Wait();
                 }
                 else
                     break;
@@ -219,7 +303,7 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 
 void BackgroundLoader::FinishResources(int maxMs)
 {
-    if (IsStarted())
+    if (!threads_.Empty())
     {
         HiresTimer timer;
 
@@ -258,6 +342,66 @@ unsigned BackgroundLoader::GetNumQueuedResources() const
     return backgroundLoadQueue_.Size();
 }
 
+void BackgroundLoader::StartThreads()
+{
+    shouldRun_ = true;
+
+    for (unsigned i = 0; i < numThreads_; ++i)
+    {
+        SharedPtr<BackgroundLoadThread> thread(new BackgroundLoadThread(this));
+        thread->Run();
+        threads_.Push(thread);
+    }
+}
+
+void BackgroundLoader::StopThreads()
+{
+    if (threads_.Empty())
+        return;
+
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        shouldRun_ = false;
+        idleThreads_.Clear();
+    }
+
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        threads_[i]->Wake();
+        threads_[i]->Stop();
+    }
+
+    threads_.Clear();
+}
+
+void BackgroundLoader::PushRequest(const Pair<StringHash, StringHash>& key, int priority)
+{
+    BackgroundLoadRequest request;
+    request.priority_ = priority;
+    request.order_ = nextOrder_++;
+    request.key_ = key;
+
+    requests_.Push(request);
+    std::push_heap(requests_.Buffer(), requests_.Buffer() + requests_.Size(), CompareBackgroundLoadRequests);
+}
+
+void BackgroundLoader::RaisePriority(const Pair<StringHash, StringHash>& key, int priority)
+{
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
+    if (i == backgroundLoadQueue_.End() || i->second_.priority_ >= priority)
+        return;
+
+    BackgroundLoadItem& item = i->second_;
+    item.priority_ = priority;
+
+    // The old queue entry is skipped when encountered, as the resource is no longer in queued state by then
+    if (item.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+        PushRequest(key, priority);
+
+    for (HashSet<Pair<StringHash, StringHash> >::ConstIterator j = item.dependencies_.Begin(); j != item.dependencies_.End(); ++j)
+        RaisePriority(*j, priority);
+}
+
 void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 {
     Resource* resource = item.resource_;
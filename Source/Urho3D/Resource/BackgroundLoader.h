@@ -24,6 +24,7 @@
 
 #include "../Container/HashMap.h"
 #include "../Container/HashSet.h"
+#include "../Core/Condition.h"
 #include "../Core/Mutex.h"
 #include "../Container/Ptr.h"
 #include "../Container/RefCounted.h"
@@ -33,6 +34,7 @@
 namespace Urho3D
 {
 
+class BackgroundLoadThread;
 class Resource;
 class ResourceCache;
 
@@ -45,35 +47,61 @@ struct BackgroundLoadItem
     HashSet<Pair<StringHash, StringHash> > dependencies_;
     /// Resources that depend on this resource's loading.
     HashSet<Pair<StringHash, StringHash> > dependents_;
+    /// Loading priority. Raised when a higher priority resource depends on this resource.
+    int priority_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
 };
 
+/// Entry in the background load priority queue.
+struct BackgroundLoadRequest
+{
+    /// Loading priority.
+    int priority_;
+    /// Queue order, so that resources of equal priority are loaded in the order they were requested.
+    unsigned order_;
+    /// Resource type and name hash.
+    Pair<StringHash, StringHash> key_;
+};
+
 /// Background loader of resources. Owned by the ResourceCache.
 /// @nobind
-class BackgroundLoader : public RefCounted, public Thread
+class BackgroundLoader : public RefCounted
 {
+    friend class BackgroundLoadThread;
+
 public:
     /// Construct.
     explicit BackgroundLoader(ResourceCache* owner);
 
-    /// Destruct. Forcibly clear the load queue.
+    /// Destruct. Stop the loader threads and forcibly clear the load queue.
     ~BackgroundLoader() override;
 
-    /// Resource background loading loop.
-    void ThreadFunction() override;
-
+    /// Set number of loader threads. The threads start on the first queued resource. Must be called from the main thread.
+    void SetNumThreads(unsigned num);
     /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type).
-    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller);
+    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority = 0);
     /// Wait and finish possible loading of a resource when being requested from the cache.
     void WaitForResource(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
 
+    /// Return number of loader threads.
+    unsigned GetNumThreads() const { return numThreads_; }
     /// Return amount of resources in the load queue.
     unsigned GetNumQueuedResources() const;
 
 private:
+    /// Resource background loading loop of a loader thread.
+    void ProcessItems(BackgroundLoadThread* thread);
+    /// Start the loader threads.
+    void StartThreads();
+    /// Stop the loader threads. Resources being loaded are finished first.
+    void StopThreads();
+    /// Add a resource to the priority queue. The mutex must be held.
+    void PushRequest(const Pair<StringHash, StringHash>& key, int priority);
+    /// Raise the loading priority of a queued resource and the resources it depends on. The mutex must be held.
+    void RaisePriority(const Pair<StringHash, StringHash>& key, int priority);
     /// Finish one background loaded resource.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
 
@@ -83,6 +111,20 @@ private:
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// Resources waiting to be loaded, as a binary heap with the highest priority first. May contain stale entries of resources that have been raised in priority.
+    PODVector<BackgroundLoadRequest> requests_;
+    /// Loader threads.
+    Vector<SharedPtr<BackgroundLoadThread> > threads_;
+    /// Loader threads waiting for resources to load.
+    PODVector<BackgroundLoadThread*> idleThreads_;
+    /// Condition signaled when a resource has been loaded, for waiting on it in the main thread.
+    Condition loadedCondition_;
+    /// Number of loader threads.
+    unsigned numThreads_;
+    /// Next queue order.
+    unsigned nextOrder_;
+    /// Loader threads running flag.
+    volatile bool shouldRun_;
 };
 
 }
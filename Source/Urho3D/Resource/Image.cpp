@@ -2340,6 +2340,16 @@ unsigned char* Image::GetImageData(Deserializer& source, int& width, int& height
 {
     unsigned dataSize = source.GetSize();
 
+    // Decode directly from a memory-mapped package file without copying the file data
+    auto* file = dynamic_cast<File*>(&source);
+    if (file && file->GetMappedData())
+    {
+        const unsigned char* data = file->GetMappedData() + source.GetPosition();
+        dataSize -= source.GetPosition();
+        source.Seek(source.GetSize());
+        return stbi_load_from_memory(data, dataSize, &width, &height, (int*)&components, 0);
+    }
+
     SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
     source.Read(buffer.Get(), dataSize);
     return stbi_load_from_memory(buffer.Get(), dataSize, &width, &height, (int*)&components, 0);
@@ -0,0 +1,664 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/WorkQueue.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
+#include "../Scene/BulkSceneData.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneResolver.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned BULK_SCENE_VERSION = 1;
+static const unsigned MIN_DECODE_ROWS_PER_CHUNK = 64;
+
+void DecodeBulkSceneRowsWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    reinterpret_cast<BulkSceneData*>(aux)->DecodeRows(start, end);
+}
+
+/// Write a table header and its rows.
+static bool WriteTable(Serializer& dest, const PODVector<const Serializable*>& objects, const Vector<AttributeInfo>* attributes,
+    bool raw, bool writeIDs)
+{
+    PODVector<unsigned> columns;
+    dest.WriteBool(raw);
+    if (!raw)
+    {
+        if (attributes)
+        {
+            for (unsigned i = 0; i < attributes->Size(); ++i)
+            {
+                const AttributeInfo& attr = attributes->At(i);
+                if ((attr.mode_ & AM_FILE) && (attr.mode_ & AM_FILEREADONLY) != AM_FILEREADONLY)
+                    columns.Push(i);
+            }
+        }
+
+        dest.WriteVLE(columns.Size());
+        for (unsigned i = 0; i < columns.Size(); ++i)
+        {
+            const AttributeInfo& attr = attributes->At(columns[i]);
+            dest.WriteString(attr.name_);
+            dest.WriteUByte((unsigned char)attr.type_);
+        }
+    }
+
+    // Write the rows into one buffer first, as the row sizes come before the rows
+    VectorBuffer rowData;
+    PODVector<unsigned> rowSizes(objects.Size());
+    Variant value;
+
+    for (unsigned i = 0; i < objects.Size(); ++i)
+    {
+        unsigned start = rowData.GetSize();
+        if (raw)
+        {
+            // Write in the per-object binary format, leaving out the type and ID which the table stores already
+            VectorBuffer objectData;
+            if (!objects[i]->Save(objectData))
+                return false;
+            static const unsigned HEADER_SIZE = sizeof(StringHash) + sizeof(unsigned);
+            if (objectData.GetSize() > HEADER_SIZE)
+                rowData.Write(objectData.GetData() + HEADER_SIZE, objectData.GetSize() - HEADER_SIZE);
+        }
+        else
+        {
+            for (unsigned j = 0; j < columns.Size(); ++j)
+            {
+                objects[i]->OnGetAttribute(attributes->At(columns[j]), value);
+                if (!rowData.WriteVariantData(value))
+                    return false;
+            }
+        }
+        rowSizes[i] = rowData.GetSize() - start;
+    }
+
+    dest.WriteVLE(objects.Size());
+    for (unsigned i = 0; i < objects.Size(); ++i)
+    {
+        if (writeIDs)
+            dest.WriteUInt(static_cast<const Component*>(objects[i])->GetID());
+        dest.WriteVLE(rowSizes[i]);
+    }
+
+    return dest.Write(rowData.GetData(), rowData.GetSize()) == rowData.GetSize();
+}
+
+bool BulkSceneData::Save(Serializer& dest, const Node* node)
+{
+    PODVector<Node*> children;
+    for (unsigned i = 0; i < node->GetNumChildren(); ++i)
+    {
+        Node* child = node->GetChildren()[i];
+        if (!child->IsTemporary())
+            children.Push(child);
+    }
+
+    return SaveNodes(dest, node, children, true);
+}
+
+bool BulkSceneData::Save(Serializer& dest, const Node* node, const PODVector<Node*>& children)
+{
+    return SaveNodes(dest, node, children, false);
+}
+
+bool BulkSceneData::SaveNodes(Serializer& dest, const Node* node, const PODVector<Node*>& rootChildren, bool saveRootComponents)
+{
+    Context* context = node->GetContext();
+
+    // Collect the persistent nodes depth-first, so that they are created in the same order as from the per-object binary format
+    PODVector<const Node*> nodes;
+    PODVector<unsigned> parents;
+    PODVector<const Node*> stack;
+    PODVector<unsigned> stackParents;
+    nodes.Push(node);
+    parents.Push(M_MAX_UNSIGNED);
+    for (unsigned i = rootChildren.Size() - 1; i < rootChildren.Size(); --i)
+    {
+        stack.Push(rootChildren[i]);
+        stackParents.Push(0);
+    }
+
+    while (stack.Size())
+    {
+        const Node* current = stack.Back();
+        unsigned index = nodes.Size();
+        nodes.Push(current);
+        parents.Push(stackParents.Back());
+        stack.Pop();
+        stackParents.Pop();
+
+        const Vector<SharedPtr<Node> >& children = current->GetChildren();
+        for (unsigned i = children.Size() - 1; i < children.Size(); --i)
+        {
+            if (!children[i]->IsTemporary())
+            {
+                stack.Push(children[i]);
+                stackParents.Push(index);
+            }
+        }
+    }
+
+    // Sort the persistent components into tables by type. Types whose attribute list may vary by instance are stored in
+    // the per-object binary format
+    HashMap<StringHash, unsigned> tableIndices;
+    PODVector<StringHash> tableTypes;
+    Vector<PODVector<const Serializable*> > tableObjects;
+    PODVector<bool> tableRaw;
+    PODVector<unsigned> componentTables;
+    PODVector<unsigned> nodeNumComponents(nodes.Size());
+
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        const Vector<SharedPtr<Component> >& components = nodes[i]->GetComponents();
+        nodeNumComponents[i] = 0;
+        if (!i && !saveRootComponents)
+            continue;
+        for (unsigned j = 0; j < components.Size(); ++j)
+        {
+            const Component* component = components[j];
+            if (component->IsTemporary())
+                continue;
+
+            StringHash type = component->GetType();
+            HashMap<StringHash, unsigned>::ConstIterator k = tableIndices.Find(type);
+            unsigned tableIndex;
+            if (k != tableIndices.End())
+                tableIndex = k->second_;
+            else
+            {
+                tableIndex = tableIndices[type] = tableTypes.Size();
+                tableTypes.Push(type);
+                tableObjects.Resize(tableTypes.Size());
+                tableRaw.Push(false);
+            }
+
+            if (component->GetAttributes() != context->GetAttributes(type))
+                tableRaw[tableIndex] = true;
+            tableObjects[tableIndex].Push(component);
+            componentTables.Push(tableIndex);
+            ++nodeNumComponents[i];
+        }
+    }
+
+    dest.WriteUInt(BULK_SCENE_VERSION);
+    dest.WriteVLE(nodes.Size());
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        dest.WriteUInt(nodes[i]->GetID());
+        if (i)
+            dest.WriteVLE(parents[i]);
+    }
+
+    VectorBuffer rootAttributes;
+    if (!node->Animatable::Save(rootAttributes))
+        return false;
+    dest.WriteVLE(rootAttributes.GetSize());
+    dest.Write(rootAttributes.GetData(), rootAttributes.GetSize());
+
+    unsigned componentIndex = 0;
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        dest.WriteVLE(nodeNumComponents[i]);
+        for (unsigned j = 0; j < nodeNumComponents[i]; ++j)
+            dest.WriteVLE(componentTables[componentIndex++]);
+    }
+
+    PODVector<const Serializable*> nodeObjects(nodes.Size() - 1);
+    for (unsigned i = 1; i < nodes.Size(); ++i)
+        nodeObjects[i - 1] = nodes[i];
+    if (!WriteTable(dest, nodeObjects, context->GetAttributes(Node::GetTypeStatic()), false, false))
+        return false;
+
+    dest.WriteVLE(tableTypes.Size());
+    for (unsigned i = 0; i < tableTypes.Size(); ++i)
+    {
+        dest.WriteStringHash(tableTypes[i]);
+        if (!WriteTable(dest, tableObjects[i], context->GetAttributes(tableTypes[i]), tableRaw[i], true))
+            return false;
+    }
+
+    return true;
+}
+
+bool BulkSceneData::Read(Deserializer& source)
+{
+    Clear();
+
+    unsigned dataSize = source.GetSize() - source.GetPosition();
+    data_.Resize(dataSize);
+    if (dataSize && source.Read(data_.Buffer(), dataSize) != dataSize)
+    {
+        URHO3D_LOGERROR("Could not read bulk scene data from " + source.GetName());
+        return false;
+    }
+
+    MemoryBuffer buffer(data_);
+    unsigned version = buffer.ReadUInt();
+    if (version != BULK_SCENE_VERSION)
+    {
+        URHO3D_LOGERROR("Unsupported bulk scene data version " + String(version) + " in " + source.GetName());
+        return false;
+    }
+
+    // Each node takes at least 5 bytes, which bounds the counts to read before allocating
+    unsigned numNodes = buffer.ReadVLE();
+    bool success = numNodes && numNodes <= dataSize / 5;
+    if (success)
+    {
+        nodeIDs_.Resize(numNodes);
+        nodeParents_.Resize(numNodes);
+        nodeNumChildren_.Resize(numNodes, 0);
+        nodeComponentStarts_.Resize(numNodes + 1);
+        nodeParents_[0] = M_MAX_UNSIGNED;
+
+        for (unsigned i = 0; success && i < numNodes; ++i)
+        {
+            nodeIDs_[i] = buffer.ReadUInt();
+            if (i)
+            {
+                unsigned parent = buffer.ReadVLE();
+                success = parent < i;
+                if (success)
+                {
+                    nodeParents_[i] = parent;
+                    ++nodeNumChildren_[parent];
+                }
+            }
+        }
+    }
+
+    if (success)
+    {
+        rootAttributesSize_ = buffer.ReadVLE();
+        rootAttributesOffset_ = buffer.GetPosition();
+        success = rootAttributesSize_ <= dataSize - rootAttributesOffset_;
+        buffer.Seek(rootAttributesOffset_ + rootAttributesSize_);
+    }
+
+    for (unsigned i = 0; success && i < numNodes; ++i)
+    {
+        nodeComponentStarts_[i] = componentTables_.Size();
+        unsigned numComponents = buffer.ReadVLE();
+        success = numComponents <= buffer.GetSize() - buffer.GetPosition();
+        for (unsigned j = 0; success && j < numComponents; ++j)
+            componentTables_.Push(buffer.ReadVLE());
+    }
+
+    if (success)
+    {
+        nodeComponentStarts_[numNodes] = componentTables_.Size();
+        success = ReadTable(buffer, nodeTable_, false) && !nodeTable_.raw_ && nodeTable_.rowOffsets_.Size() == numNodes;
+    }
+
+    if (success)
+    {
+        unsigned numTables = buffer.ReadVLE();
+        success = numTables <= componentTables_.Size();
+        if (success)
+            tables_.Resize(numTables);
+        for (unsigned i = 0; success && i < numTables; ++i)
+        {
+            tables_[i].type_ = buffer.ReadStringHash();
+            success = ReadTable(buffer, tables_[i], true);
+        }
+    }
+
+    // Check that the components use up the table rows exactly
+    if (success)
+    {
+        PODVector<unsigned> numRows(tables_.Size(), 0);
+        for (unsigned i = 0; success && i < componentTables_.Size(); ++i)
+        {
+            success = componentTables_[i] < tables_.Size();
+            if (success)
+                ++numRows[componentTables_[i]];
+        }
+        for (unsigned i = 0; success && i < tables_.Size(); ++i)
+            success = numRows[i] == tables_[i].ids_.Size();
+    }
+
+    if (!success)
+    {
+        URHO3D_LOGERROR("Corrupted bulk scene data in " + source.GetName());
+        Clear();
+        return false;
+    }
+
+    return true;
+}
+
+void BulkSceneData::Decode(WorkQueue* queue)
+{
+    if (decoded_)
+        return;
+
+    // Rows in the per-object binary format are read by the objects themselves when instantiating
+    decodeTables_.Clear();
+    numDecodeRows_ = 0;
+    decodeTables_.Push(&nodeTable_);
+    for (unsigned i = 0; i < tables_.Size(); ++i)
+    {
+        if (!tables_[i].raw_)
+            decodeTables_.Push(&tables_[i]);
+    }
+
+    for (unsigned i = 0; i < decodeTables_.Size(); ++i)
+    {
+        BulkSceneTable& table = *decodeTables_[i];
+        unsigned numRows = table.rowOffsets_.Size() - 1;
+        table.decodeStart_ = numDecodeRows_;
+        table.values_.Resize(numRows * table.columnTypes_.Size());
+        numDecodeRows_ += numRows;
+    }
+
+    if (queue)
+        queue->ParallelFor(numDecodeRows_, DecodeBulkSceneRowsWork, this, MIN_DECODE_ROWS_PER_CHUNK);
+    else
+        DecodeRows(0, numDecodeRows_);
+
+    decoded_ = true;
+}
+
+bool BulkSceneData::Instantiate(Node* node, SceneResolver& resolver, bool rewriteIDs, CreateMode mode)
+{
+    return BeginInstantiate(node, resolver, rewriteIDs, mode) && InstantiateNodes(resolver, M_MAX_UNSIGNED);
+}
+
+bool BulkSceneData::BeginInstantiate(Node* node, SceneResolver& resolver, bool rewriteIDs, CreateMode mode)
+{
+    instantiateNodes_.Clear();
+    nextNode_ = 0;
+
+    if (nodeIDs_.Empty())
+    {
+        URHO3D_LOGERROR("No bulk scene data to instantiate");
+        return false;
+    }
+
+    if (!decoded_)
+        Decode();
+
+    Context* context = node->GetContext();
+
+    // Remove all children and components first in case this is not a fresh load
+    node->RemoveAllChildren();
+    node->RemoveAllComponents();
+
+    // The root ID is not applied, only stored for resolving possible references
+    MemoryBuffer rootAttributes(data_.Buffer() + rootAttributesOffset_, rootAttributesSize_);
+    if (!node->Animatable::Load(rootAttributes))
+        return false;
+    resolver.AddNode(nodeIDs_[0], node);
+
+    MapColumns(nodeTable_, context->GetAttributes(Node::GetTypeStatic()), nodeColumns_);
+    tableColumns_.Clear();
+    tableColumns_.Resize(tables_.Size());
+    for (unsigned i = 0; i < tables_.Size(); ++i)
+    {
+        if (!tables_[i].raw_)
+            MapColumns(tables_[i], context->GetAttributes(tables_[i].type_), tableColumns_[i]);
+    }
+
+    nextRows_.Clear();
+    nextRows_.Resize(tables_.Size(), 0);
+    instantiateNodes_.Resize(nodeIDs_.Size());
+    instantiateNodes_[0] = node;
+    rewriteIDs_ = rewriteIDs;
+    createMode_ = mode;
+    return true;
+}
+
+bool BulkSceneData::InstantiateNodes(SceneResolver& resolver, unsigned maxNodes)
+{
+    if (instantiateNodes_.Empty())
+    {
+        URHO3D_LOGERROR("Bulk scene data instantiation not begun");
+        return false;
+    }
+
+    unsigned end = nextNode_ + Min(maxNodes, nodeIDs_.Size() - nextNode_);
+
+    for (unsigned i = nextNode_; i < end; ++i)
+    {
+        Node* current = instantiateNodes_[i];
+        if (i)
+        {
+            unsigned nodeID = nodeIDs_[i];
+            current = instantiateNodes_[nodeParents_[i]]->CreateChild(rewriteIDs_ ? 0 : nodeID, (createMode_ == REPLICATED &&
+                Scene::IsReplicatedID(nodeID)) ? REPLICATED : LOCAL);
+            instantiateNodes_[i] = current;
+            resolver.AddNode(nodeID, current);
+            if (!LoadRow(current, nodeTable_, i - 1, nodeColumns_))
+            {
+                instantiateNodes_.Clear();
+                return false;
+            }
+        }
+
+        // The child nodes and components are known in advance, so size their containers once
+        current->children_.Reserve(nodeNumChildren_[i]);
+        current->components_.Reserve(nodeComponentStarts_[i + 1] - nodeComponentStarts_[i]);
+
+        for (unsigned j = nodeComponentStarts_[i]; j < nodeComponentStarts_[i + 1]; ++j)
+        {
+            unsigned tableIndex = componentTables_[j];
+            const BulkSceneTable& table = tables_[tableIndex];
+            unsigned row = nextRows_[tableIndex]++;
+            unsigned compID = table.ids_[row];
+
+            Component* newComponent = current->SafeCreateComponent(String::EMPTY, table.type_,
+                (createMode_ == REPLICATED && Scene::IsReplicatedID(compID)) ? REPLICATED : LOCAL, rewriteIDs_ ? 0 : compID);
+            if (newComponent)
+            {
+                resolver.AddComponent(compID, newComponent);
+                // Do not abort if component fails to load, as its row is separate from the rest
+                LoadRow(newComponent, table, row, tableColumns_[tableIndex]);
+            }
+        }
+    }
+
+    nextNode_ = end;
+    if (nextNode_ >= nodeIDs_.Size())
+        instantiateNodes_.Clear();
+    return true;
+}
+
+void BulkSceneData::GetResourceRefs(Vector<ResourceRef>& dest) const
+{
+    for (unsigned i = 0; i < decodeTables_.Size(); ++i)
+    {
+        const BulkSceneTable& table = *decodeTables_[i];
+        unsigned numColumns = table.columnTypes_.Size();
+
+        for (unsigned j = 0; j < numColumns; ++j)
+        {
+            if (table.columnTypes_[j] != VAR_RESOURCEREF && table.columnTypes_[j] != VAR_RESOURCEREFLIST)
+                continue;
+
+            for (unsigned k = j; k < table.values_.Size(); k += numColumns)
+            {
+                const Variant& value = table.values_[k];
+                if (value.GetType() == VAR_RESOURCEREF)
+                {
+                    const ResourceRef& ref = value.GetResourceRef();
+                    if (!ref.name_.Empty())
+                        dest.Push(ref);
+                }
+                else if (value.GetType() == VAR_RESOURCEREFLIST)
+                {
+                    const ResourceRefList& refList = value.GetResourceRefList();
+                    for (unsigned l = 0; l < refList.names_.Size(); ++l)
+                    {
+                        if (!refList.names_[l].Empty())
+                            dest.Push(ResourceRef(refList.type_, refList.names_[l]));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BulkSceneData::Clear()
+{
+    data_.Clear();
+    nodeIDs_.Clear();
+    nodeParents_.Clear();
+    nodeNumChildren_.Clear();
+    nodeComponentStarts_.Clear();
+    componentTables_.Clear();
+    rootAttributesOffset_ = 0;
+    rootAttributesSize_ = 0;
+    nodeTable_ = BulkSceneTable();
+    tables_.Clear();
+    decodeTables_.Clear();
+    numDecodeRows_ = 0;
+    decoded_ = false;
+    instantiateNodes_.Clear();
+    nodeColumns_.Clear();
+    tableColumns_.Clear();
+    nextRows_.Clear();
+    nextNode_ = 0;
+}
+
+bool BulkSceneData::ReadTable(Deserializer& source, BulkSceneTable& table, bool hasIDs)
+{
+    table.raw_ = source.ReadBool();
+    if (!table.raw_)
+    {
+        unsigned numColumns = source.ReadVLE();
+        if (numColumns > source.GetSize() - source.GetPosition())
+            return false;
+
+        table.columnNames_.Resize(numColumns);
+        table.columnTypes_.Resize(numColumns);
+        for (unsigned i = 0; i < numColumns; ++i)
+        {
+            table.columnNames_[i] = source.ReadString();
+            table.columnTypes_[i] = (VariantType)source.ReadUByte();
+            if (table.columnTypes_[i] >= MAX_VAR_TYPES)
+                return false;
+        }
+    }
+
+    unsigned numRows = source.ReadVLE();
+    if (numRows > source.GetSize() - source.GetPosition())
+        return false;
+
+    if (hasIDs)
+        table.ids_.Resize(numRows);
+    table.rowOffsets_.Resize(numRows + 1);
+
+    // The row sizes come before the rows, so convert them to offsets once the start of the rows is known
+    unsigned offset = 0;
+    for (unsigned i = 0; i < numRows; ++i)
+    {
+        if (hasIDs)
+            table.ids_[i] = source.ReadUInt();
+        table.rowOffsets_[i] = offset;
+        offset += source.ReadVLE();
+        if (offset > source.GetSize())
+            return false;
+    }
+    table.rowOffsets_[numRows] = offset;
+
+    unsigned start = source.GetPosition();
+    if (offset > source.GetSize() - start)
+        return false;
+    for (unsigned i = 0; i <= numRows; ++i)
+        table.rowOffsets_[i] += start;
+
+    source.Seek(start + offset);
+    return true;
+}
+
+void BulkSceneData::DecodeRows(unsigned start, unsigned end)
+{
+    unsigned tableIndex = 0;
+
+    for (unsigned i = start; i < end; ++i)
+    {
+        while (i >= decodeTables_[tableIndex]->decodeStart_ + decodeTables_[tableIndex]->rowOffsets_.Size() - 1)
+            ++tableIndex;
+
+        BulkSceneTable& table = *decodeTables_[tableIndex];
+        unsigned row = i - table.decodeStart_;
+        unsigned numColumns = table.columnTypes_.Size();
+        MemoryBuffer rowData(data_.Buffer() + table.rowOffsets_[row], table.rowOffsets_[row + 1] - table.rowOffsets_[row]);
+        Variant* values = table.values_.Buffer() + row * numColumns;
+
+        for (unsigned j = 0; j < numColumns; ++j)
+            values[j] = rowData.ReadVariant(table.columnTypes_[j]);
+    }
+}
+
+bool BulkSceneData::LoadRow(Serializable* object, const BulkSceneTable& table, unsigned row,
+    const PODVector<unsigned>& attributeIndices) const
+{
+    if (table.raw_)
+    {
+        MemoryBuffer rowData(data_.Buffer() + table.rowOffsets_[row], table.rowOffsets_[row + 1] - table.rowOffsets_[row]);
+        return object->Load(rowData);
+    }
+    else
+    {
+        unsigned numColumns = table.columnTypes_.Size();
+        return object->LoadValues(table.values_.Buffer() + row * numColumns, attributeIndices.Buffer(), numColumns);
+    }
+}
+
+void BulkSceneData::MapColumns(const BulkSceneTable& table, const Vector<AttributeInfo>* attributes, PODVector<unsigned>& dest) const
+{
+    dest.Resize(table.columnNames_.Size());
+
+    for (unsigned i = 0; i < table.columnNames_.Size(); ++i)
+    {
+        dest[i] = M_MAX_UNSIGNED;
+        if (attributes)
+        {
+            for (unsigned j = 0; j < attributes->Size(); ++j)
+            {
+                const AttributeInfo& attr = attributes->At(j);
+                if ((attr.mode_ & AM_FILE) && attr.name_ == table.columnNames_[i] && attr.type_ == table.columnTypes_[i])
+                {
+                    dest[i] = j;
+                    break;
+                }
+            }
+        }
+
+        if (dest[i] == M_MAX_UNSIGNED)
+            URHO3D_LOGWARNING("Skipping unknown attribute " + table.columnNames_[i] + " in bulk scene data");
+    }
+}
+
+}
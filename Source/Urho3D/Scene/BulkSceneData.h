@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+#include "../Core/Variant.h"
+#include "../Scene/Node.h"
+
+namespace Urho3D
+{
+
+class Deserializer;
+class SceneResolver;
+class Serializer;
+class WorkQueue;
+
+/// Attribute table of one node or component type in the bulk binary scene format.
+struct BulkSceneTable
+{
+    /// Component type. Zero for the node table.
+    StringHash type_;
+    /// Whether rows are stored in the per-object binary attribute format, because the attribute list may vary by instance.
+    bool raw_{};
+    /// Column attribute names.
+    Vector<String> columnNames_;
+    /// Column attribute types.
+    PODVector<VariantType> columnTypes_;
+    /// Object IDs by row. Empty for the node table.
+    PODVector<unsigned> ids_;
+    /// Row start offsets within the file data, followed by the end offset of the last row.
+    PODVector<unsigned> rowOffsets_;
+    /// Decoded attribute values, by row and then by column.
+    Vector<Variant> values_;
+    /// Decoded row start index in the table of all decoded rows.
+    unsigned decodeStart_{};
+};
+
+/// Scene content in the bulk binary format, which stores the attributes of all nodes and of each component type in contiguous tables. Reading and decoding the attribute values can be done in any thread, and decoding can be parallelized over the rows. Instantiating the content into a scene must be done in the main thread.
+class URHO3D_API BulkSceneData
+{
+public:
+    /// Save a node with its child nodes and components, omitting temporary objects. The file ID is not written. Return true if successful.
+    static bool Save(Serializer& dest, const Node* node);
+    /// Save the attributes of a node with the given persistent nodes as its child nodes, omitting the node's own child nodes and components. The file ID is not written. Return true if successful.
+    static bool Save(Serializer& dest, const Node* node, const PODVector<Node*>& children);
+
+    /// Read from a stream after its file ID. Return true if successful.
+    bool Read(Deserializer& source);
+    /// Decode the attribute values of the tables. If a work queue is given, decode also in its worker threads, which requires calling from the main thread.
+    void Decode(WorkQueue* queue = nullptr);
+    /// Instantiate the content under a node in a single pass, which first removes the node's existing child nodes and components. The node receives the attributes of the saved root. Decodes the attribute values first if not decoded yet. Object IDs are added to the resolver for resolving references, but are not resolved yet. Return true if successful.
+    bool Instantiate(Node* node, SceneResolver& resolver, bool rewriteIDs = false, CreateMode mode = REPLICATED);
+    /// Begin instantiating the content under a node incrementally. Removes the node's existing child nodes and components and applies the saved root's attributes. The node must not be destroyed before the instantiation finishes. Return true if successful.
+    bool BeginInstantiate(Node* node, SceneResolver& resolver, bool rewriteIDs = false, CreateMode mode = REPLICATED);
+    /// Continue instantiating by creating at most the given number of nodes with their components. Return true if successful.
+    bool InstantiateNodes(SceneResolver& resolver, unsigned maxNodes);
+    /// Append the resources referenced by the decoded attribute values. Resources in rows stored in the per-object binary format are not included.
+    void GetResourceRefs(Vector<ResourceRef>& dest) const;
+    /// Release the file data and the decoded attribute values.
+    void Clear();
+
+    /// Return number of nodes, including the saved root.
+    unsigned GetNumNodes() const { return nodeIDs_.Size(); }
+    /// Return number of components.
+    unsigned GetNumComponents() const { return componentTables_.Size(); }
+    /// Return whether the attribute values have been decoded.
+    bool IsDecoded() const { return decoded_; }
+    /// Return whether an incremental instantiation is in progress.
+    bool IsInstantiating() const { return !instantiateNodes_.Empty(); }
+    /// Return number of nodes instantiated so far, including the saved root.
+    unsigned GetNumInstantiatedNodes() const { return nextNode_; }
+
+private:
+    /// Save a node with the given child nodes, optionally including the node's components.
+    static bool SaveNodes(Serializer& dest, const Node* node, const PODVector<Node*>& rootChildren, bool saveRootComponents);
+    /// Read a table header and its rows. Return true if successful.
+    bool ReadTable(Deserializer& source, BulkSceneTable& table, bool hasIDs);
+    /// Decode a range of rows in the table of all decoded rows.
+    void DecodeRows(unsigned start, unsigned end);
+    /// Set the attributes of an object from a table row. Return true if successful.
+    bool LoadRow(Serializable* object, const BulkSceneTable& table, unsigned row, const PODVector<unsigned>& attributeIndices) const;
+    /// Map table columns to attribute indices of the current attribute list, so that attributes can be added or removed between saving and loading.
+    void MapColumns(const BulkSceneTable& table, const Vector<AttributeInfo>* attributes, PODVector<unsigned>& dest) const;
+
+    /// Decode rows work function.
+    friend void DecodeBulkSceneRowsWork(unsigned start, unsigned end, unsigned threadIndex, void* aux);
+
+    /// File data after the file ID.
+    PODVector<unsigned char> data_;
+    /// Node IDs in depth-first order, starting from the saved root.
+    PODVector<unsigned> nodeIDs_;
+    /// Parent node indices. The saved root has no parent.
+    PODVector<unsigned> nodeParents_;
+    /// Number of child nodes by node.
+    PODVector<unsigned> nodeNumChildren_;
+    /// Start index of each node's components, followed by the total component count.
+    PODVector<unsigned> nodeComponentStarts_;
+    /// Table index of each component in node order.
+    PODVector<unsigned> componentTables_;
+    /// Offset of the saved root's attributes within the file data.
+    unsigned rootAttributesOffset_{};
+    /// Size of the saved root's attributes.
+    unsigned rootAttributesSize_{};
+    /// Node table for nodes other than the saved root.
+    BulkSceneTable nodeTable_;
+    /// Component tables.
+    Vector<BulkSceneTable> tables_;
+    /// Tables to decode, including the node table.
+    PODVector<BulkSceneTable*> decodeTables_;
+    /// Total number of rows to decode.
+    unsigned numDecodeRows_{};
+    /// Decoded flag.
+    bool decoded_{};
+    /// Nodes created by the instantiation in progress, by node index.
+    PODVector<Node*> instantiateNodes_;
+    /// Attribute indices of the node table columns for the instantiation in progress.
+    PODVector<unsigned> nodeColumns_;
+    /// Attribute indices of the component table columns for the instantiation in progress.
+    Vector<PODVector<unsigned> > tableColumns_;
+    /// Next row to instantiate by component table.
+    PODVector<unsigned> nextRows_;
+    /// Next node index to instantiate.
+    unsigned nextNode_{};
+    /// Whether the instantiation in progress assigns new IDs.
+    bool rewriteIDs_{};
+    /// Creation mode of the instantiation in progress.
+    CreateMode createMode_{REPLICATED};
+};
+
+}
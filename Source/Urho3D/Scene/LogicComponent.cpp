@@ -37,6 +37,7 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
+    threadedUpdateScene_(nullptr),
     delayedStartCalled_(false)
 {
 }
@@ -64,6 +65,25 @@ void LogicComponent::FixedPostUpdate(float timeStep)
 {
 }
 
+void LogicComponent::ThreadedUpdate(float timeStep)
+{
+}
+
+void LogicComponent::ThreadedPostUpdate(float timeStep)
+{
+}
+
+void LogicComponent::MainThreadUpdate(float timeStep)
+{
+}
+
+void LogicComponent::RequestMainThreadUpdate()
+{
+    Scene* scene = GetScene();
+    if (scene)
+        scene->DelayedMainThreadUpdate(this);
+}
+
 void LogicComponent::SetUpdateEventMask(UpdateEventFlags mask)
 {
     if (updateEventMask_ != mask)
@@ -99,6 +119,14 @@ void LogicComponent::OnSceneSet(Scene* scene)
         UnsubscribeFromEvent(E_PHYSICSPRESTEP);
         UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
 #endif
+        if (threadedUpdateScene_)
+        {
+            if (currentEventMask_ & USE_THREADEDUPDATE)
+                threadedUpdateScene_->RemoveThreadedUpdate(this, false);
+            if (currentEventMask_ & USE_THREADEDPOSTUPDATE)
+                threadedUpdateScene_->RemoveThreadedUpdate(this, true);
+            threadedUpdateScene_ = nullptr;
+        }
         currentEventMask_ = USE_NO_EVENT;
     }
 }
@@ -114,7 +142,7 @@ void LogicComponent::UpdateEventSubscription()
     bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
     if (needUpdate && !(currentEventMask_ & USE_UPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LogicComponent, HandleSceneUpdate));
+        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_TYPED_HANDLER(LogicComponent, HandleSceneUpdate));
         currentEventMask_ |= USE_UPDATE;
     }
     else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
@@ -126,7 +154,7 @@ void LogicComponent::UpdateEventSubscription()
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
     if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(LogicComponent, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_TYPED_HANDLER(LogicComponent, HandleScenePostUpdate));
         currentEventMask_ |= USE_POSTUPDATE;
     }
     else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
@@ -135,6 +163,33 @@ void LogicComponent::UpdateEventSubscription()
         currentEventMask_ &= ~USE_POSTUPDATE;
     }
 
+    // Threaded updates begin only after the delayed start, which is called from the main thread update events
+    bool needThreadedUpdate = enabled && delayedStartCalled_ && (updateEventMask_ & USE_THREADEDUPDATE);
+    if (needThreadedUpdate && !(currentEventMask_ & USE_THREADEDUPDATE))
+    {
+        scene->AddThreadedUpdate(this, false);
+        threadedUpdateScene_ = scene;
+        currentEventMask_ |= USE_THREADEDUPDATE;
+    }
+    else if (!needThreadedUpdate && (currentEventMask_ & USE_THREADEDUPDATE))
+    {
+        scene->RemoveThreadedUpdate(this, false);
+        currentEventMask_ &= ~USE_THREADEDUPDATE;
+    }
+
+    bool needThreadedPostUpdate = enabled && delayedStartCalled_ && (updateEventMask_ & USE_THREADEDPOSTUPDATE);
+    if (needThreadedPostUpdate && !(currentEventMask_ & USE_THREADEDPOSTUPDATE))
+    {
+        scene->AddThreadedUpdate(this, true);
+        threadedUpdateScene_ = scene;
+        currentEventMask_ |= USE_THREADEDPOSTUPDATE;
+    }
+    else if (!needThreadedPostUpdate && (currentEventMask_ & USE_THREADEDPOSTUPDATE))
+    {
+        scene->RemoveThreadedUpdate(this, true);
+        currentEventMask_ &= ~USE_THREADEDPOSTUPDATE;
+    }
+
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
     Component* world = GetFixedUpdateSource();
     if (!world)
@@ -166,35 +221,28 @@ void LogicComponent::UpdateEventSubscription()
 #endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleSceneUpdate(StringHash eventType, SceneUpdateEventData& eventData)
 {
-    using namespace SceneUpdate;
-
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
         DelayedStart();
         delayedStartCalled_ = true;
 
-        // If did not need actual update events, unsubscribe now
+        // Register threaded updates now that they are allowed, and unsubscribe if did not need actual update events
+        UpdateEventSubscription();
         if (!(updateEventMask_ & USE_UPDATE))
-        {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
             return;
-        }
     }
 
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleScenePostUpdate(StringHash eventType, SceneUpdateEventData& eventData)
 {
-    using namespace ScenePostUpdate;
-
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(eventData.timeStep_);
 }
 
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
@@ -208,6 +256,7 @@ void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& even
     {
         DelayedStart();
         delayedStartCalled_ = true;
+        UpdateEventSubscription();
     }
 
     // Execute user-defined fixed update function
@@ -30,6 +30,8 @@
 namespace Urho3D
 {
 
+struct SceneUpdateEventData;
+
 enum UpdateEvent : unsigned
 {
     /// Bitmask for not using any events.
@@ -42,6 +44,10 @@ enum UpdateEvent : unsigned
     USE_FIXEDUPDATE = 0x4,
     /// Bitmask for using the physics post-update event.
     USE_FIXEDPOSTUPDATE = 0x8,
+    /// Bitmask for updating in worker threads after the scene update event.
+    USE_THREADEDUPDATE = 0x10,
+    /// Bitmask for updating in worker threads after the scene post-update event.
+    USE_THREADEDPOSTUPDATE = 0x20,
 };
 URHO3D_FLAGSET(UpdateEvent, UpdateEventFlags);
 
@@ -75,10 +81,19 @@ class URHO3D_API LogicComponent : public Component
     virtual void FixedUpdate(float timeStep);
     /// Called on physics post-update, fixed timestep.
     virtual void FixedPostUpdate(float timeStep);
+    /// Called in a worker thread after the scene update event, variable timestep. Must only modify this component and its node's transform; other changes should be deferred with RequestMainThreadUpdate().
+    virtual void ThreadedUpdate(float timeStep);
+    /// Called in a worker thread after the scene post-update event, variable timestep. Same restrictions as in ThreadedUpdate() apply.
+    virtual void ThreadedPostUpdate(float timeStep);
+    /// Called in the main thread at the end of a threaded update phase if requested with RequestMainThreadUpdate().
+    virtual void MainThreadUpdate(float timeStep);
 
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(UpdateEventFlags mask);
 
+    /// Request MainThreadUpdate() to be called at the end of the current or next threaded update phase. Is thread-safe.
+    void RequestMainThreadUpdate();
+
     /// Return what update events are subscribed to.
     UpdateEventFlags GetUpdateEventMask() const { return updateEventMask_; }
 
@@ -95,9 +110,9 @@ private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
     /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneUpdate(StringHash eventType, SceneUpdateEventData& eventData);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, SceneUpdateEventData& eventData);
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
     /// Handle physics pre-step event.
     void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
@@ -108,6 +123,8 @@ private:
     UpdateEventFlags updateEventMask_;
     /// Current event subscription mask.
     UpdateEventFlags currentEventMask_;
+    /// Scene the component is registered to for threaded updates.
+    Scene* threadedUpdateScene_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
 };
@@ -34,6 +34,7 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
+#include "../Scene/TransformStore.h"
 #include "../Scene/UnknownComponent.h"
 
 #include "../DebugNew.h"
@@ -55,6 +56,8 @@ Node::Node(Context* context) :
     parent_(nullptr),
     scene_(nullptr),
     id_(0),
+    transformIndex_(M_MAX_UNSIGNED),
+    transformLevel_(0),
     position_(Vector3::ZERO),
     rotation_(Quaternion::IDENTITY),
     scale_(Vector3::ONE),
@@ -755,6 +758,8 @@ void Node::MarkDirty()
         if (cur->dirty_)
             return;
         cur->dirty_ = true;
+        if (cur->transformIndex_ != M_MAX_UNSIGNED)
+            cur->scene_->GetTransformStore()->MarkDirty(cur->transformLevel_, cur->transformIndex_);
 
         // Notify listener components first, then mark child nodes
         for (Vector<WeakPtr<Component> >::Iterator i = cur->listeners_.Begin(); i != cur->listeners_.End();)
@@ -845,6 +850,9 @@ void Node::AddChild(Node* node, unsigned index)
     node->parent_ = this;
     node->MarkDirty();
     node->MarkNetworkUpdate();
+    // Also moves the node to its new hierarchy level when reparenting within the same scene
+    if (scene_ && scene_->GetTransformStore())
+        scene_->GetTransformStore()->AddNode(node);
     // If the child node has components, also mark network update on them to ensure they have a valid NetworkState
     for (Vector<SharedPtr<Component> >::Iterator i = node->components_.Begin(); i != node->components_.End(); ++i)
         (*i)->MarkNetworkUpdate();
@@ -1443,6 +1451,8 @@ void Node::SetID(unsigned id)
 
 void Node::SetScene(Scene* scene)
 {
+    if (scene != scene_)
+        transformIndex_ = M_MAX_UNSIGNED;
     scene_ = scene;
 }
 
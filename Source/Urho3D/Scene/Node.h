@@ -76,7 +76,9 @@ class URHO3D_API Node : public Animatable
 {
     URHO3D_OBJECT(Node, Animatable);
 
+    friend class BulkSceneData;
     friend class Connection;
+    friend class TransformStore;
 
 public:
     /// Construct.
@@ -737,6 +739,10 @@ private:
     Scene* scene_;
     /// Unique ID within the scene.
     unsigned id_;
+    /// Index in the scene's transform store hierarchy level, or M_MAX_UNSIGNED if not stored.
+    unsigned transformIndex_;
+    /// Hierarchy level in the scene's transform store.
+    unsigned transformLevel_;
     /// Position.
     Vector3 position_;
     /// Rotation.
@@ -34,6 +34,8 @@ namespace Urho3D
 {
 
 static const unsigned MAX_NETWORK_ATTRIBUTES = 64;
+/// Number of quantized transforms remembered per node for delta encoding.
+static const unsigned NETWORK_TRANSFORM_HISTORY = 8;
 
 class Component;
 class Connection;
@@ -117,6 +119,70 @@ struct URHO3D_API DirtyBits
     unsigned char count_{};
 };
 
+/// Quantized node transform for compact network replication.
+struct URHO3D_API QuantizedTransform
+{
+    /// Test for equality with another quantized transform.
+    bool operator ==(const QuantizedTransform& rhs) const
+    {
+        return position_[0] == rhs.position_[0] && position_[1] == rhs.position_[1] && position_[2] == rhs.position_[2] &&
+               rotation_ == rhs.rotation_;
+    }
+
+    /// Test for inequality with another quantized transform.
+    bool operator !=(const QuantizedTransform& rhs) const { return !(*this == rhs); }
+
+    /// Position in multiples of the position precision.
+    int position_[3]{};
+    /// Smallest-three packed rotation.
+    unsigned long long rotation_{};
+};
+
+/// Recently sent or received quantized transforms of a node, tagged with their update sequence numbers. Ordered from oldest to newest.
+struct URHO3D_API TransformHistory
+{
+    /// Add a transform, discarding the oldest one if full.
+    void Add(unsigned short sequence, const QuantizedTransform& transform)
+    {
+        if (count_ == NETWORK_TRANSFORM_HISTORY)
+            RemoveOlder(1);
+        sequences_[count_] = sequence;
+        transforms_[count_] = transform;
+        ++count_;
+    }
+
+    /// Remove entries older than the specified index.
+    void RemoveOlder(unsigned index)
+    {
+        if (!index || index > count_)
+            return;
+        count_ -= index;
+        for (unsigned i = 0; i < count_; ++i)
+        {
+            sequences_[i] = sequences_[i + index];
+            transforms_[i] = transforms_[i + index];
+        }
+    }
+
+    /// Return the transform with the specified sequence number, or null if not remembered.
+    const QuantizedTransform* Find(unsigned short sequence) const
+    {
+        for (unsigned i = count_ - 1; i < count_; --i)
+        {
+            if (sequences_[i] == sequence)
+                return &transforms_[i];
+        }
+        return nullptr;
+    }
+
+    /// Sequence numbers.
+    unsigned short sequences_[NETWORK_TRANSFORM_HISTORY]{};
+    /// Quantized transforms.
+    QuantizedTransform transforms_[NETWORK_TRANSFORM_HISTORY];
+    /// Number of entries.
+    unsigned count_{};
+};
+
 /// Per-object attribute state for network replication, allocated on demand.
 struct URHO3D_API NetworkState
 {
@@ -165,6 +231,8 @@ struct URHO3D_API NodeReplicationState : public ReplicationState
     HashSet<StringHash> dirtyVars_;
     /// Components by ID.
     HashMap<unsigned, ComponentReplicationState> componentStates_;
+    /// Quantized transforms sent in compact transform updates.
+    TransformHistory sentTransforms_;
     /// Interest management priority accumulator.
     float priorityAcc_{};
     /// Whether exists in the SceneState's dirty set.
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Sort.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
@@ -33,15 +34,19 @@
 #include "../Resource/ResourceEvents.h"
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
+#include "../Scene/BulkSceneData.h"
 #include "../Scene/Component.h"
+#include "../Scene/LogicComponent.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
 #include "../Scene/SplinePath.h"
+#include "../Scene/TransformStore.h"
 #include "../Scene/UnknownComponent.h"
 #include "../Scene/ValueAnimation.h"
+#include "../Scene/WorldPartition.h"
 
 #include "../DebugNew.h"
 
@@ -54,6 +59,78 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const unsigned MIN_LOGIC_UPDATES_PER_CHUNK = 16;
+
+/// Threaded logic update work data.
+struct LogicUpdateWorkData
+{
+    /// Components to update.
+    LogicComponent** components_;
+    /// Frame timestep.
+    float timeStep_;
+    /// Post-update flag.
+    bool postUpdate_;
+};
+
+static const unsigned MIN_SMOOTHING_UPDATES_PER_CHUNK = 64;
+
+/// Threaded transform smoothing work data.
+struct SmoothingWorkData
+{
+    /// Components to update.
+    SmoothedTransform** components_;
+    /// Smoothing constant.
+    float constant_;
+    /// Squared snap threshold.
+    float squaredSnapThreshold_;
+};
+
+static void SmoothingWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* data = reinterpret_cast<SmoothingWorkData*>(aux);
+    for (unsigned i = start; i < end; ++i)
+        data->components_[i]->Update(data->constant_, data->squaredSnapThreshold_);
+}
+
+static void LogicUpdateWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* data = reinterpret_cast<LogicUpdateWorkData*>(aux);
+    LogicComponent** components = data->components_;
+
+    if (data->postUpdate_)
+    {
+        for (unsigned i = start; i < end; ++i)
+            components[i]->ThreadedPostUpdate(data->timeStep_);
+    }
+    else
+    {
+        for (unsigned i = start; i < end; ++i)
+            components[i]->ThreadedUpdate(data->timeStep_);
+    }
+}
+
+static bool CompareLogicComponentTypes(LogicComponent* lhs, LogicComponent* rhs)
+{
+    return lhs->GetType() < rhs->GetType();
+}
+
+void SceneUpdateEventData::FromVariantMap(const VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+
+    VariantMap::ConstIterator i = eventData.Find(P_SCENE);
+    scene_ = i != eventData.End() ? static_cast<Scene*>(i->second_.GetPtr()) : nullptr;
+    i = eventData.Find(P_TIMESTEP);
+    timeStep_ = i != eventData.End() ? i->second_.GetFloat() : 0.0f;
+}
+
+void SceneUpdateEventData::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace SceneUpdate;
+
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
 
 Scene::Scene(Context* context) :
     Node(context),
@@ -69,13 +146,15 @@ Scene::Scene(Context* context) :
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    threadedUpdateDirty_(false),
+    threadedPostUpdateDirty_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(Scene, HandleUpdate));
+    SubscribeToEvent(E_UPDATE, URHO3D_TYPED_HANDLER(Scene, HandleUpdate));
     SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(Scene, HandleResourceBackgroundLoaded));
 }
 
@@ -118,7 +197,8 @@ bool Scene::Load(Deserializer& source)
     StopAsyncLoading();
 
     // Check ID
-    if (source.ReadFileID() != "USCN")
+    String fileID = source.ReadFileID();
+    if (fileID != "USCN" && fileID != "USCB")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid scene file");
         return false;
@@ -129,7 +209,29 @@ bool Scene::Load(Deserializer& source)
     Clear();
 
     // Load the whole scene, then perform post-load if successfully loaded
-    if (Node::Load(source))
+    bool success;
+    if (fileID == "USCB")
+    {
+        // Decode the attribute tables first, using the worker threads when possible, then create the objects in one pass
+        BulkSceneData data;
+        success = data.Read(source);
+        if (success)
+        {
+            data.Decode(Thread::IsMainThread() ? GetSubsystem<WorkQueue>() : nullptr);
+
+            SceneResolver resolver;
+            success = data.Instantiate(this, resolver);
+            if (success)
+            {
+                resolver.Resolve();
+                ApplyAttributes();
+            }
+        }
+    }
+    else
+        success = Node::Load(source);
+
+    if (success)
     {
         FinishLoading(&source);
         return true;
@@ -162,6 +264,30 @@ bool Scene::Save(Serializer& dest) const
         return false;
 }
 
+bool Scene::SaveBulk(Serializer& dest) const
+{
+    URHO3D_PROFILE(SaveSceneBulk);
+
+    // Write ID first
+    if (!dest.WriteFileID("USCB"))
+    {
+        URHO3D_LOGERROR("Could not save scene, writing to stream failed");
+        return false;
+    }
+
+    auto* ptr = dynamic_cast<Deserializer*>(&dest);
+    if (ptr)
+        URHO3D_LOGINFO("Saving scene to " + ptr->GetName());
+
+    if (BulkSceneData::Save(dest, this))
+    {
+        FinishSaving(&dest);
+        return true;
+    }
+    else
+        return false;
+}
+
 bool Scene::LoadXML(const XMLElement& source)
 {
     URHO3D_PROFILE(LoadSceneXML);
@@ -773,13 +899,20 @@ void Scene::Update(float timeStep)
 
     using namespace SceneUpdate;
 
+    SceneUpdateEventData updateData;
+    updateData.scene_ = this;
+    updateData.timeStep_ = timeStep;
+
+    // Update variable timestep logic
+    SendEvent(E_SCENEUPDATE, updateData);
+
+    // Update variable timestep logic that runs in worker threads
+    UpdateThreadedLogic(threadedUpdateComponents_, threadedUpdateDirty_, timeStep, false);
+
     VariantMap& eventData = GetEventDataMap();
     eventData[P_SCENE] = this;
     eventData[P_TIMESTEP] = timeStep;
 
-    // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
-
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
@@ -798,10 +931,16 @@ void Scene::Update(float timeStep)
         smoothingData_[P_CONSTANT] = constant;
         smoothingData_[P_SQUAREDSNAPTHRESHOLD] = squaredSnapThreshold;
         SendEvent(E_UPDATESMOOTHING, smoothingData_);
+
+        UpdateSmoothing(constant, squaredSnapThreshold);
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    SendEvent(E_SCENEPOSTUPDATE, updateData);
+    UpdateThreadedLogic(threadedPostUpdateComponents_, threadedPostUpdateDirty_, timeStep, true);
+
+    // Update the world transforms changed during the frame in batches, if the transform store is in use
+    UpdateTransforms();
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -809,6 +948,29 @@ void Scene::Update(float timeStep)
     elapsedTime_ += timeStep;
 }
 
+void Scene::SetTransformStoreEnabled(bool enable)
+{
+    if (enable == transformStore_.NotNull())
+        return;
+
+    if (enable)
+        transformStore_ = new TransformStore(this);
+    else
+    {
+        transformStore_->Reset();
+        transformStore_.Reset();
+    }
+}
+
+void Scene::UpdateTransforms()
+{
+    if (transformStore_)
+    {
+        URHO3D_PROFILE(UpdateTransforms);
+        transformStore_->Update();
+    }
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
@@ -839,6 +1001,62 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::AddThreadedUpdate(LogicComponent* component, bool postUpdate)
+{
+    if (!component)
+        return;
+
+    if (postUpdate)
+    {
+        threadedPostUpdateComponents_.Push(component);
+        threadedPostUpdateDirty_ = true;
+    }
+    else
+    {
+        threadedUpdateComponents_.Push(component);
+        threadedUpdateDirty_ = true;
+    }
+}
+
+void Scene::RemoveThreadedUpdate(LogicComponent* component, bool postUpdate)
+{
+    if (postUpdate)
+    {
+        if (threadedPostUpdateComponents_.RemoveSwap(component))
+            threadedPostUpdateDirty_ = true;
+    }
+    else
+    {
+        if (threadedUpdateComponents_.RemoveSwap(component))
+            threadedUpdateDirty_ = true;
+    }
+
+    // The component may be removed during the main thread updates of the threaded update phase
+    PODVector<LogicComponent*>::Iterator i = delayedMainThreadUpdates_.Find(component);
+    while (i != delayedMainThreadUpdates_.End())
+    {
+        *i = nullptr;
+        i = delayedMainThreadUpdates_.Find(component);
+    }
+}
+
+void Scene::AddSmoothedTransform(SmoothedTransform* component)
+{
+    if (component)
+        smoothedTransforms_.Push(component);
+}
+
+void Scene::RemoveSmoothedTransform(SmoothedTransform* component)
+{
+    smoothedTransforms_.RemoveSwap(component);
+}
+
+void Scene::DelayedMainThreadUpdate(LogicComponent* component)
+{
+    MutexLock lock(sceneMutex_);
+    delayedMainThreadUpdates_.Push(component);
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -986,10 +1204,14 @@ void Scene::NodeRemoved(Node* node)
     {
         replicatedNodes_.Erase(id);
         MarkReplicationDirty(node);
+        if (networkState_ && !networkState_->replicationStates_.Empty())
+            pendingRemovedNetworkNodes_.Push(id);
     }
     else
         localNodes_.Erase(id);
 
+    if (transformStore_)
+        transformStore_->RemoveNode(node);
     node->ResetScene();
 
     // Remove node from tag cache
@@ -1106,6 +1328,18 @@ void Scene::PrepareNetworkUpdate()
 
     networkUpdateNodes_.Clear();
     networkUpdateComponents_.Clear();
+
+    removedNetworkNodes_.Swap(pendingRemovedNetworkNodes_);
+    pendingRemovedNetworkNodes_.Clear();
+
+    // Connections read the world positions of replicated nodes in worker threads, where recalculating dirty transforms would
+    // race, so recalculate them now
+    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    {
+        Node* node = i->second_;
+        if (node->IsDirty())
+            node->GetWorldTransform();
+    }
 }
 
 void Scene::CleanupConnection(Connection* connection)
@@ -1161,13 +1395,12 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void Scene::HandleUpdate(StringHash eventType, UpdateEventData& eventData)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace Update;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
@@ -1185,6 +1418,67 @@ void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eve
     }
 }
 
+void Scene::UpdateThreadedLogic(PODVector<LogicComponent*>& components, bool& sortDirty, float timeStep, bool postUpdate)
+{
+    if (components.Empty())
+        return;
+
+    URHO3D_PROFILE(UpdateThreadedLogic);
+
+    if (sortDirty)
+    {
+        Sort(components.Begin(), components.End(), CompareLogicComponentTypes);
+        sortDirty = false;
+    }
+
+    LogicUpdateWorkData data;
+    data.components_ = components.Buffer();
+    data.timeStep_ = timeStep;
+    data.postUpdate_ = postUpdate;
+
+    BeginThreadedUpdate();
+    GetSubsystem<WorkQueue>()->ParallelFor(components.Size(), LogicUpdateWork, &data, MIN_LOGIC_UPDATES_PER_CHUNK);
+    EndThreadedUpdate();
+
+    // Run main thread updates requested from the worker threads. Components removed meanwhile leave null holes in the queue,
+    // and requests made during the main thread updates are left for the next threaded update phase
+    unsigned numUpdates = delayedMainThreadUpdates_.Size();
+    for (unsigned i = 0; i < numUpdates; ++i)
+    {
+        LogicComponent* component = delayedMainThreadUpdates_[i];
+        if (component)
+            component->MainThreadUpdate(timeStep);
+    }
+    delayedMainThreadUpdates_.Erase(0, numUpdates);
+}
+
+void Scene::UpdateSmoothing(float constant, float squaredSnapThreshold)
+{
+    if (smoothedTransforms_.Empty())
+        return;
+
+    // Each component only moves its own node, so they can be updated in worker threads like threaded logic updates
+    SmoothingWorkData data;
+    data.components_ = smoothedTransforms_.Buffer();
+    data.constant_ = constant;
+    data.squaredSnapThreshold_ = squaredSnapThreshold;
+
+    BeginThreadedUpdate();
+    GetSubsystem<WorkQueue>()->ParallelFor(smoothedTransforms_.Size(), SmoothingWork, &data, MIN_SMOOTHING_UPDATES_PER_CHUNK);
+    EndThreadedUpdate();
+
+    // Remove the components whose smoothing has completed
+    for (unsigned i = smoothedTransforms_.Size() - 1; i < smoothedTransforms_.Size(); --i)
+    {
+        SmoothedTransform* component = smoothedTransforms_[i];
+        if (!component->IsInProgress())
+        {
+            component->registeredScene_ = nullptr;
+            smoothedTransforms_.EraseSwap(i);
+        }
+    }
+}
+
 void Scene::UpdateAsyncLoading()
 {
     URHO3D_PROFILE(UpdateAsyncLoading);
@@ -1536,6 +1830,7 @@ void RegisterSceneLibrary(Context* context)
     SmoothedTransform::RegisterObject(context);
     UnknownComponent::RegisterObject(context);
     SplinePath::RegisterObject(context);
+    WorldPartition::RegisterObject(context);
 }
 
 }
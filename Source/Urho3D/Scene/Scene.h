@@ -35,7 +35,11 @@ namespace Urho3D
 {
 
 class File;
+class LogicComponent;
 class PackageFile;
+class SmoothedTransform;
+class TransformStore;
+struct UpdateEventData;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -104,7 +108,7 @@ public:
     /// @nobind
     static void RegisterObject(Context* context);
 
-    /// Load from binary data. Removes all existing child nodes and components first. Return true if successful.
+    /// Load from binary data in either the per-object or the bulk format. Removes all existing child nodes and components first. Return true if successful.
     bool Load(Deserializer& source) override;
     /// Save to binary data. Return true if successful.
     bool Save(Serializer& dest) const override;
@@ -125,6 +129,8 @@ public:
     bool SaveXML(Serializer& dest, const String& indentation = "\t") const;
     /// Save to a JSON file. Return true if successful.
     bool SaveJSON(Serializer& dest, const String& indentation = "\t") const;
+    /// Save to binary data in the bulk format, which stores the attributes of each component type in contiguous tables for faster loading. Load with Load(). Return true if successful.
+    bool SaveBulk(Serializer& dest) const;
     /// Load from a binary file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
     bool LoadAsync(File* file, LoadMode mode = LOAD_SCENE_AND_RESOURCES);
     /// Load from an XML file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
@@ -235,18 +241,42 @@ public:
     /// Return a node user variable name, or empty if not registered.
     const String& GetVarName(StringHash hash) const;
 
+    /// Return replicated nodes by ID.
+    /// @nobind
+    const HashMap<unsigned, Node*>& GetReplicatedNodes() const { return replicatedNodes_; }
+
     /// Update scene. Called by HandleUpdate.
     void Update(float timeStep);
     /// Begin a threaded update. During threaded update components can choose to delay dirty processing.
     void BeginThreadedUpdate();
     /// End a threaded update. Notify components that marked themselves for delayed dirty processing.
     void EndThreadedUpdate();
+    /// Enable or disable the structure-of-arrays transform store, which updates the world transforms of dirty nodes in batches at the end of the scene update. Not serialized.
+    void SetTransformStoreEnabled(bool enable);
+    /// Update the world transforms of dirty nodes through the transform store, if enabled. Called at the end of the scene update; call manually to update the transforms changed after it.
+    void UpdateTransforms();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Add a logic component to the threaded update or post-update phase. Called by LogicComponent.
+    void AddThreadedUpdate(LogicComponent* component, bool postUpdate);
+    /// Remove a logic component from the threaded update or post-update phase. Called by LogicComponent.
+    void RemoveThreadedUpdate(LogicComponent* component, bool postUpdate);
+    /// Add a transform smoothing component to the smoothing update, which runs in worker threads. Called by SmoothedTransform.
+    void AddSmoothedTransform(SmoothedTransform* component);
+    /// Remove a transform smoothing component from the smoothing update. Called by SmoothedTransform.
+    void RemoveSmoothedTransform(SmoothedTransform* component);
+    /// Add a logic component to the queue of main thread updates to run after the current threaded update phase. Is thread-safe.
+    void DelayedMainThreadUpdate(LogicComponent* component);
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Return the transform store, or null if not enabled.
+    TransformStore* GetTransformStore() const { return transformStore_.Get(); }
+
+    /// Return whether the transform store is enabled.
+    bool IsTransformStoreEnabled() const { return transformStore_.NotNull(); }
+
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -271,8 +301,11 @@ public:
     void SetVarNamesAttr(const String& value);
     /// Return node user variable reverse mappings.
     String GetVarNamesAttr() const;
-    /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
+    /// Prepare network update by comparing attributes and marking replication states dirty as necessary. Also recalculates the dirty world transforms of replicated nodes.
     void PrepareNetworkUpdate();
+    /// Return IDs of replicated nodes removed before the current network update.
+    /// @nobind
+    const PODVector<unsigned>& GetRemovedNetworkNodes() const { return removedNetworkNodes_; }
     /// Clean up all references to a network connection that is about to be removed.
     /// @manualbind
     void CleanupConnection(Connection* connection);
@@ -285,11 +318,15 @@ public:
 
 private:
     /// Handle the logic update event to update the scene, if active.
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleUpdate(StringHash eventType, UpdateEventData& eventData);
     /// Handle a background loaded resource completing.
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
     void UpdateAsyncLoading();
+    /// Update logic components in worker threads, then run the main thread updates they requested.
+    void UpdateThreadedLogic(PODVector<LogicComponent*>& components, bool& sortDirty, float timeStep, bool postUpdate);
+    /// Update transform smoothing components in worker threads.
+    void UpdateSmoothing(float constant, float squaredSnapThreshold);
     /// Finish asynchronous loading.
     void FinishAsyncLoading();
     /// Finish loading. Sets the scene filename and checksum.
@@ -327,8 +364,22 @@ private:
     HashSet<unsigned> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
     HashSet<unsigned> networkUpdateComponents_;
+    /// Replicated nodes removed before the current network update.
+    PODVector<unsigned> removedNetworkNodes_;
+    /// Replicated nodes removed since the current network update, to be reported on the next.
+    PODVector<unsigned> pendingRemovedNetworkNodes_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
+    /// Logic components updated in worker threads after the scene update event. Sorted by type to batch the same update code together.
+    PODVector<LogicComponent*> threadedUpdateComponents_;
+    /// Logic components updated in worker threads after the scene post-update event. Sorted by type to batch the same update code together.
+    PODVector<LogicComponent*> threadedPostUpdateComponents_;
+    /// Transform smoothing components with smoothing in progress.
+    PODVector<SmoothedTransform*> smoothedTransforms_;
+    /// Main thread update queue for logic components updated in worker threads.
+    PODVector<LogicComponent*> delayedMainThreadUpdates_;
+    /// Structure-of-arrays transform store.
+    UniquePtr<TransformStore> transformStore_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
@@ -359,6 +410,10 @@ private:
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Threaded update components need sorting flag.
+    bool threadedUpdateDirty_;
+    /// Threaded post-update components need sorting flag.
+    bool threadedPostUpdateDirty_;
 };
 
 /// Register Scene library objects.
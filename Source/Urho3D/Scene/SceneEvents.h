@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -93,6 +95,20 @@ URHO3D_EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed event data of the scene update events E_SCENEUPDATE and E_SCENEPOSTUPDATE.
+struct URHO3D_API SceneUpdateEventData
+{
+    /// Fill from event parameters.
+    void FromVariantMap(const VariantMap& eventData);
+    /// Store to event parameters.
+    void ToVariantMap(VariantMap& eventData) const;
+
+    /// Scene.
+    Scene* scene_;
+    /// Scene timestep.
+    float timeStep_;
+};
+
 /// Asynchronous scene loading progress.
 URHO3D_EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
@@ -212,4 +228,19 @@ URHO3D_EVENT(E_INTERCEPTNETWORKUPDATE, InterceptNetworkUpdate)
     URHO3D_PARAM(P_VALUE, Value);                  // Variant
 }
 
+/// A world partition cell has been streamed in.
+URHO3D_EVENT(E_WORLDCELLLOADED, WorldCellLoaded)
+{
+    URHO3D_PARAM(P_PARTITION, Partition);          // WorldPartition pointer
+    URHO3D_PARAM(P_CELL, Cell);                    // IntVector2
+    URHO3D_PARAM(P_NODE, Node);                    // Node pointer, null if the cell has no content
+}
+
+/// A world partition cell has been streamed out.
+URHO3D_EVENT(E_WORLDCELLUNLOADED, WorldCellUnloaded)
+{
+    URHO3D_PARAM(P_PARTITION, Partition);          // WorldPartition pointer
+    URHO3D_PARAM(P_CELL, Cell);                    // IntVector2
+}
+
 }
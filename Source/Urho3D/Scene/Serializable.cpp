@@ -341,6 +341,21 @@ bool Serializable::Save(Serializer& dest) const
     return true;
 }
 
+bool Serializable::LoadValues(const Variant* values, const unsigned* attributeIndices, unsigned numValues)
+{
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return true;
+
+    for (unsigned i = 0; i < numValues; ++i)
+    {
+        if (attributeIndices[i] < attributes->Size())
+            OnSetAttribute(attributes->At(attributeIndices[i]), values[i]);
+    }
+
+    return true;
+}
+
 bool Serializable::LoadXML(const XMLElement& source)
 {
     if (source.IsNull())
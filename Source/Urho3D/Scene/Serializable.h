@@ -71,6 +71,9 @@ public:
     virtual bool LoadJSON(const JSONValue& source);
     /// Save as JSON data. Return true if successful.
     virtual bool SaveJSON(JSONValue& dest) const;
+    /// Load from attribute values decoded in advance. Each value is set to the attribute at the corresponding index, skipping indices that are out of range. Return true if successful.
+    /// @nobind
+    virtual bool LoadValues(const Variant* values, const unsigned* attributeIndices, unsigned numValues);
 
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     virtual void ApplyAttributes() { }
@@ -37,7 +37,7 @@ SmoothedTransform::SmoothedTransform(Context* context) :
     targetPosition_(Vector3::ZERO),
     targetRotation_(Quaternion::IDENTITY),
     smoothingMask_(SMOOTH_NONE),
-    subscribed_(false)
+    registeredScene_(nullptr)
 {
 }
 
@@ -88,12 +88,6 @@ void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
         }
     }
 
-    // If smoothing has completed, unsubscribe from the update event
-    if (!smoothingMask_)
-    {
-        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
-        subscribed_ = false;
-    }
 }
 
 void SmoothedTransform::SetTargetPosition(const Vector3& position)
@@ -101,12 +95,8 @@ void SmoothedTransform::SetTargetPosition(const Vector3& position)
     targetPosition_ = position;
     smoothingMask_ |= SMOOTH_POSITION;
 
-    // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    // Add to the scene's smoothing update if not yet added
+    UpdateRegistration();
 
     SendEvent(E_TARGETPOSITION);
 }
@@ -116,11 +106,7 @@ void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
     targetRotation_ = rotation;
     smoothingMask_ |= SMOOTH_ROTATION;
 
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    UpdateRegistration();
 
     SendEvent(E_TARGETROTATION);
 }
@@ -167,13 +153,32 @@ void SmoothedTransform::OnNodeSet(Node* node)
     }
 }
 
-void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData)
+void SmoothedTransform::OnSceneSet(Scene* scene)
 {
-    using namespace UpdateSmoothing;
+    if (scene)
+        UpdateRegistration();
+    else if (registeredScene_)
+    {
+        registeredScene_->RemoveSmoothedTransform(this);
+        registeredScene_ = nullptr;
+    }
+}
+
+void SmoothedTransform::UpdateRegistration()
+{
+    Scene* scene = GetScene();
+    bool needUpdate = scene && smoothingMask_;
 
-    float constant = eventData[P_CONSTANT].GetFloat();
-    float squaredSnapThreshold = eventData[P_SQUAREDSNAPTHRESHOLD].GetFloat();
-    Update(constant, squaredSnapThreshold);
+    if (registeredScene_ && (!needUpdate || registeredScene_ != scene))
+    {
+        registeredScene_->RemoveSmoothedTransform(this);
+        registeredScene_ = nullptr;
+    }
+    if (needUpdate && !registeredScene_)
+    {
+        scene->AddSmoothedTransform(this);
+        registeredScene_ = scene;
+    }
 }
 
 }
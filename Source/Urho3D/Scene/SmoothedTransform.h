@@ -45,6 +45,8 @@ class URHO3D_API SmoothedTransform : public Component
 {
     URHO3D_OBJECT(SmoothedTransform, Component);
 
+    friend class Scene;
+
 public:
     /// Construct.
     explicit SmoothedTransform(Context* context);
@@ -54,7 +56,7 @@ public:
     /// @nobind
     static void RegisterObject(Context* context);
 
-    /// Update smoothing.
+    /// Update smoothing. Called by the scene in worker threads, so only modifies the own node.
     void Update(float constant, float squaredSnapThreshold);
     /// Set target position in parent space.
     /// @property
@@ -91,10 +93,15 @@ public:
 protected:
     /// Handle scene node being assigned at creation.
     void OnNodeSet(Node* node) override;
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
 
 private:
-    /// Handle smoothing update event.
-    void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    /// Add to or remove from the scene's smoothing update depending on whether smoothing is in progress.
+    void UpdateRegistration();
+
+    /// Scene updating the smoothing. Completed smoothing is removed by the scene after the update.
+    Scene* registeredScene_;
 
     /// Target position.
     Vector3 targetPosition_;
@@ -102,8 +109,6 @@ private:
     Quaternion targetRotation_;
     /// Active smoothing operations bitmask.
     SmoothingTypeFlags smoothingMask_;
-    /// Subscribed to smoothing update event flag.
-    bool subscribed_;
 };
 
 }
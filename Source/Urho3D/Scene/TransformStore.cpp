@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/WorkQueue.h"
+#include "../Scene/Scene.h"
+#include "../Scene/TransformStore.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned MIN_TRANSFORMS_PER_CHUNK = 256;
+static const unsigned MIN_TRANSFORMS_FOR_THREADING = 4 * MIN_TRANSFORMS_PER_CHUNK;
+
+/// Work data for calculating the world transforms of one hierarchy level.
+struct TransformLevelWorkData
+{
+    /// Transform store.
+    TransformStore* store_;
+    /// Hierarchy level.
+    unsigned level_;
+};
+
+void CalculateTransformsWork(unsigned start, unsigned end, unsigned threadIndex, void* aux)
+{
+    auto* data = reinterpret_cast<TransformLevelWorkData*>(aux);
+    data->store_->CalculateWorldTransforms(data->level_, start, end);
+}
+
+TransformStore::TransformStore(Scene* scene) :
+    scene_(scene),
+    hierarchyDirty_(true)
+{
+}
+
+TransformStore::~TransformStore() = default;
+
+void TransformStore::Update()
+{
+    if (hierarchyDirty_)
+        Rebuild();
+
+    auto* queue = scene_->GetSubsystem<WorkQueue>();
+    bool threaded = queue && queue->GetNumThreads();
+
+    // World transforms depend on the parent, so go through the hierarchy levels in order. Within a level the nodes are independent
+    for (unsigned i = 0; i < levels_.Size(); ++i)
+    {
+        unsigned numNodes = levels_[i].nodes_.Size();
+        if (threaded && numNodes >= MIN_TRANSFORMS_FOR_THREADING)
+        {
+            TransformLevelWorkData data;
+            data.store_ = this;
+            data.level_ = i;
+            queue->ParallelFor(numNodes, CalculateTransformsWork, &data, MIN_TRANSFORMS_PER_CHUNK);
+        }
+        else
+            CalculateWorldTransforms(i, 0, numNodes);
+    }
+}
+
+void TransformStore::Reset()
+{
+    // Removed nodes may still be in the storage if the hierarchy is dirty, so go through the scene hierarchy instead
+    PODVector<Node*> nodes;
+    scene_->GetChildren(nodes, true);
+    for (PODVector<Node*>::Iterator i = nodes.Begin(); i != nodes.End(); ++i)
+        (*i)->transformIndex_ = M_MAX_UNSIGNED;
+
+    levels_.Clear();
+    hierarchyDirty_ = true;
+}
+
+void TransformStore::AddNode(Node* node)
+{
+    // A pending rebuild will pick up the node
+    if (hierarchyDirty_)
+        return;
+
+    // When reparenting within the scene the node and its children move to different levels
+    if (node->transformIndex_ != M_MAX_UNSIGNED)
+        RemoveSubtree(node);
+
+    Node* parent = node->GetParent();
+    if (parent == scene_)
+        InsertNode(node, 0, M_MAX_UNSIGNED);
+    else if (parent && parent->transformIndex_ != M_MAX_UNSIGNED)
+        InsertNode(node, parent->transformLevel_ + 1, parent->transformIndex_);
+    else
+    {
+        MarkHierarchyDirty();
+        return;
+    }
+
+    // Add the child nodes breadth-first, so that parents are stored before their children
+    PODVector<Node*> queue;
+    queue.Push(node);
+    for (unsigned i = 0; i < queue.Size(); ++i)
+    {
+        Node* current = queue[i];
+        const Vector<SharedPtr<Node> >& children = current->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+        {
+            InsertNode(*j, current->transformLevel_ + 1, current->transformIndex_);
+            queue.Push(*j);
+        }
+    }
+}
+
+void TransformStore::RemoveNode(Node* node)
+{
+    unsigned index = node->transformIndex_;
+    if (index == M_MAX_UNSIGNED)
+        return;
+
+    node->transformIndex_ = M_MAX_UNSIGNED;
+    // A pending rebuild will drop the node
+    if (hierarchyDirty_)
+        return;
+
+    unsigned level = node->transformLevel_;
+    TransformLevel& nodes = levels_[level];
+    unsigned last = nodes.nodes_.Size() - 1;
+
+    // Swap the last node of the level into the freed slot and point its children to the new index
+    if (index != last)
+    {
+        Node* moved = nodes.nodes_[last];
+        nodes.nodes_[index] = moved;
+        nodes.parents_[index] = nodes.parents_[last];
+        nodes.worldTransforms_[index] = nodes.worldTransforms_[last];
+        nodes.worldRotations_[index] = nodes.worldRotations_[last];
+        nodes.dirty_[index] = nodes.dirty_[last];
+        moved->transformIndex_ = index;
+
+        const Vector<SharedPtr<Node> >& children = moved->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        {
+            Node* child = *i;
+            if (child->transformIndex_ != M_MAX_UNSIGNED)
+                levels_[level + 1].parents_[child->transformIndex_] = index;
+        }
+    }
+
+    nodes.nodes_.Pop();
+    nodes.parents_.Pop();
+    nodes.worldTransforms_.Pop();
+    nodes.worldRotations_.Pop();
+    nodes.dirty_.Pop();
+
+    // Children of a removed node are removed after it, so only trailing levels can become empty
+    while (levels_.Size() && levels_.Back().nodes_.Empty())
+        levels_.Pop();
+}
+
+void TransformStore::RemoveSubtree(Node* node)
+{
+    RemoveNode(node);
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        RemoveSubtree(*i);
+}
+
+unsigned TransformStore::GetNumNodes() const
+{
+    unsigned numNodes = 0;
+    for (unsigned i = 0; i < levels_.Size(); ++i)
+        numNodes += levels_[i].nodes_.Size();
+    return numNodes;
+}
+
+void TransformStore::Rebuild()
+{
+    levels_.Clear();
+
+    // Breadth-first traversal sorts the nodes by depth, so that parents are always stored before their children
+    const Vector<SharedPtr<Node> >& rootChildren = scene_->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = rootChildren.Begin(); i != rootChildren.End(); ++i)
+        InsertNode(*i, 0, M_MAX_UNSIGNED);
+
+    for (unsigned level = 0; level < levels_.Size(); ++level)
+    {
+        for (unsigned i = 0; i < levels_[level].nodes_.Size(); ++i)
+        {
+            const Vector<SharedPtr<Node> >& children = levels_[level].nodes_[i]->GetChildren();
+            for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+                InsertNode(*j, level + 1, i);
+        }
+    }
+
+    hierarchyDirty_ = false;
+}
+
+void TransformStore::InsertNode(Node* node, unsigned level, unsigned parent)
+{
+    if (level >= levels_.Size())
+        levels_.Resize(level + 1);
+
+    // The stored world transform is not valid yet, so calculate it on the next update
+    TransformLevel& nodes = levels_[level];
+    node->transformLevel_ = level;
+    node->transformIndex_ = nodes.nodes_.Size();
+    nodes.nodes_.Push(node);
+    nodes.parents_.Push(parent);
+    nodes.worldTransforms_.Push(Matrix3x4::IDENTITY);
+    nodes.worldRotations_.Push(Quaternion::IDENTITY);
+    nodes.dirty_.Push(1);
+}
+
+void TransformStore::CalculateWorldTransforms(unsigned level, unsigned start, unsigned end)
+{
+    TransformLevel& nodes = levels_[level];
+    const TransformLevel* parents = level ? &levels_[level - 1] : nullptr;
+
+    for (unsigned i = start; i < end; ++i)
+    {
+        if (!nodes.dirty_[i])
+            continue;
+
+        Node* node = nodes.nodes_[i];
+        Matrix3x4& worldTransform = nodes.worldTransforms_[i];
+        Quaternion& worldRotation = nodes.worldRotations_[i];
+
+        // Assume the root node (scene) has identity transform, like Node does
+        if (!parents)
+        {
+            worldTransform = node->GetTransform();
+            worldRotation = node->rotation_;
+        }
+        else
+        {
+            unsigned parent = nodes.parents_[i];
+            worldTransform = parents->worldTransforms_[parent] * node->GetTransform();
+            worldRotation = parents->worldRotations_[parent] * node->rotation_;
+        }
+
+        node->worldTransform_ = worldTransform;
+        node->worldRotation_ = worldRotation;
+        node->dirty_ = false;
+        nodes.dirty_[i] = 0;
+    }
+}
+
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/Matrix3x4.h"
+#include "../Math/Quaternion.h"
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Transforms of one hierarchy level in the transform store.
+struct TransformLevel
+{
+    /// Nodes.
+    PODVector<Node*> nodes_;
+    /// Parent indices in the previous level. M_MAX_UNSIGNED for children of the scene.
+    PODVector<unsigned> parents_;
+    /// World transforms.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// World rotations.
+    PODVector<Quaternion> worldRotations_;
+    /// Dirty flags.
+    PODVector<unsigned char> dirty_;
+};
+
+/// Structure-of-arrays storage of a scene's node transforms, grouped by hierarchy depth. Updates the world transforms of dirty nodes in batches, level by level, instead of recursively through parent pointers. Owned by Scene when enabled; Node's transform functions remain the interface.
+class URHO3D_API TransformStore
+{
+public:
+    /// Construct.
+    explicit TransformStore(Scene* scene);
+    /// Destruct.
+    ~TransformStore();
+
+    /// Recalculate the world transforms of all dirty nodes and store them to the nodes. Rebuilds the storage first if the hierarchy has been marked changed. Called at the end of the scene update. Must be called from the main thread.
+    void Update();
+    /// Detach all nodes from the storage. Called before the storage is destroyed while the scene still exists.
+    void Reset();
+    /// Add a node that has been added or reparented in the scene, along with its child nodes. Called by Node.
+    void AddNode(Node* node);
+    /// Remove a node without its child nodes. Called by Scene for each node removed from it.
+    void RemoveNode(Node* node);
+    /// Remove a node along with its child nodes before reparenting. Called by Node.
+    void RemoveSubtree(Node* node);
+    /// Mark the hierarchy changed. The storage will be rebuilt on the next update.
+    void MarkHierarchyDirty() { hierarchyDirty_ = true; }
+    /// Mark a node dirty by hierarchy level and index. Called by Node. Is thread-safe.
+    void MarkDirty(unsigned level, unsigned index) { levels_[level].dirty_[index] = 1; }
+
+    /// Return the scene.
+    Scene* GetScene() const { return scene_; }
+    /// Return number of nodes stored.
+    unsigned GetNumNodes() const;
+    /// Return number of hierarchy levels stored.
+    unsigned GetNumLevels() const { return levels_.Size(); }
+    /// Return whether the hierarchy has been marked changed since the last update.
+    bool IsHierarchyDirty() const { return hierarchyDirty_; }
+
+private:
+    /// Rebuild the storage by traversing the scene hierarchy breadth-first.
+    void Rebuild();
+    /// Append a node to a hierarchy level and mark it dirty.
+    void InsertNode(Node* node, unsigned level, unsigned parent);
+    /// Calculate world transforms of dirty nodes in an index range of a level, store them to the nodes and clear the dirty flags. The parents must have been processed already.
+    void CalculateWorldTransforms(unsigned level, unsigned start, unsigned end);
+
+    /// Calculate world transforms of a hierarchy level work function.
+    friend void CalculateTransformsWork(unsigned start, unsigned end, unsigned threadIndex, void* aux);
+
+    /// Scene.
+    Scene* scene_;
+    /// Hierarchy levels.
+    Vector<TransformLevel> levels_;
+    /// Hierarchy changed flag.
+    bool hierarchyDirty_;
+};
+
+}
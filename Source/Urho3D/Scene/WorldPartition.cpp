@@ -0,0 +1,616 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+#include "../Scene/WorldPartition.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* SUBSYSTEM_CATEGORY;
+
+static const float DEFAULT_CELL_SIZE = 100.0f;
+static const float DEFAULT_LOAD_DISTANCE = 200.0f;
+static const float DEFAULT_UNLOAD_DISTANCE = 250.0f;
+static const int DEFAULT_LOADING_MS = 5;
+static const int DEFAULT_MAX_READING_CELLS = 4;
+
+/// Cell to start loading with its distance to the nearest observer.
+struct WorldCellCandidate
+{
+    /// Cell coordinates.
+    IntVector2 coordinates_;
+    /// Squared distance to the nearest observer.
+    float distanceSquared_;
+};
+
+static bool CompareWorldCellCandidates(const WorldCellCandidate& lhs, const WorldCellCandidate& rhs)
+{
+    return lhs.distanceSquared_ < rhs.distanceSquared_;
+}
+
+static void LoadWorldCellWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* loadItem = static_cast<WorldCellLoadItem*>(const_cast<WorkItem*>(item));
+    File* file = loadItem->file_;
+
+    if (file->ReadFileID() != "USCB")
+    {
+        URHO3D_LOGERROR(file->GetName() + " is not a valid bulk scene file");
+        return;
+    }
+
+    // Decode serially, as the cells are decoded in parallel with each other
+    loadItem->success_ = loadItem->data_.Read(*file);
+    if (loadItem->success_)
+        loadItem->data_.Decode();
+    file->Close();
+}
+
+WorldPartition::WorldPartition(Context* context) :
+    Component(context),
+    cellSize_(DEFAULT_CELL_SIZE),
+    loadDistance_(DEFAULT_LOAD_DISTANCE),
+    unloadDistance_(DEFAULT_UNLOAD_DISTANCE),
+    loadingMs_(DEFAULT_LOADING_MS),
+    maxReadingCells_(DEFAULT_MAX_READING_CELLS)
+{
+}
+
+WorldPartition::~WorldPartition()
+{
+    UnloadCells(false);
+}
+
+void WorldPartition::RegisterObject(Context* context)
+{
+    context->RegisterFactory<WorldPartition>(SUBSYSTEM_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cell Size", GetCellSize, SetCellSize, float, DEFAULT_CELL_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Load Distance", GetLoadDistance, SetLoadDistance, float, DEFAULT_LOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Unload Distance", GetUnloadDistance, SetUnloadDistance, float, DEFAULT_UNLOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Loading Ms", GetLoadingMs, SetLoadingMs, int, DEFAULT_LOADING_MS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Reading Cells", GetMaxReadingCells, SetMaxReadingCells, int, DEFAULT_MAX_READING_CELLS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cell Path", GetCellPath, SetCellPath, String, String::EMPTY, AM_DEFAULT);
+}
+
+void WorldPartition::OnSetEnabled()
+{
+    UpdateEventSubscription();
+}
+
+void WorldPartition::SetCellSize(float size)
+{
+    size = Max(size, M_EPSILON);
+    if (size != cellSize_)
+    {
+        // The loaded cells no longer match the cell coordinates
+        UnloadAllCells();
+        cellSize_ = size;
+        MarkNetworkUpdate();
+    }
+}
+
+void WorldPartition::SetLoadDistance(float distance)
+{
+    loadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void WorldPartition::SetUnloadDistance(float distance)
+{
+    unloadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void WorldPartition::SetLoadingMs(int ms)
+{
+    loadingMs_ = Max(ms, 1);
+    MarkNetworkUpdate();
+}
+
+void WorldPartition::SetMaxReadingCells(int cells)
+{
+    maxReadingCells_ = Max(cells, 1);
+    MarkNetworkUpdate();
+}
+
+void WorldPartition::SetCellPath(const String& path)
+{
+    String newPath = path.Empty() ? path : AddTrailingSlash(path);
+    if (newPath != cellPath_)
+    {
+        UnloadAllCells();
+        cellPath_ = newPath;
+        MarkNetworkUpdate();
+    }
+}
+
+void WorldPartition::AddObserver(Node* node)
+{
+    if (!node)
+        return;
+
+    for (unsigned i = 0; i < observers_.Size(); ++i)
+    {
+        if (observers_[i] == node)
+            return;
+    }
+
+    observers_.Push(WeakPtr<Node>(node));
+}
+
+void WorldPartition::RemoveObserver(Node* node)
+{
+    for (unsigned i = 0; i < observers_.Size(); ++i)
+    {
+        if (observers_[i] == node)
+        {
+            observers_.Erase(i);
+            return;
+        }
+    }
+}
+
+void WorldPartition::RemoveAllObservers()
+{
+    observers_.Clear();
+}
+
+void WorldPartition::Update()
+{
+    if (!node_)
+        return;
+
+    URHO3D_PROFILE(UpdateWorldPartition);
+
+    // Observer positions in the partition node's local space, which is the space of the cell content
+    PODVector<Vector3> positions;
+    Matrix3x4 inverseTransform = node_->GetWorldTransform().Inverse();
+    for (unsigned i = observers_.Size() - 1; i < observers_.Size(); --i)
+    {
+        if (observers_[i])
+            positions.Push(inverseTransform * observers_[i]->GetWorldPosition());
+        else
+            observers_.Erase(i);
+    }
+
+    // Unload cells beyond the unload distance from all observers. The unload distance is at least the load distance, so that
+    // a cell does not unload right after loading
+    float unloadDistanceSquared = Max(unloadDistance_, loadDistance_);
+    unloadDistanceSquared *= unloadDistanceSquared;
+    PODVector<IntVector2> unloadedCells;
+    int numReading = 0;
+
+    for (HashMap<IntVector2, WorldCell>::Iterator i = cells_.Begin(); i != cells_.End();)
+    {
+        bool keep = false;
+        for (unsigned j = 0; j < positions.Size() && !keep; ++j)
+            keep = GetCellDistanceSquared(positions[j], i->first_) <= unloadDistanceSquared;
+
+        if (keep)
+        {
+            if (i->second_.state_ == CELL_READING)
+                ++numReading;
+            ++i;
+        }
+        else
+        {
+            if (i->second_.state_ == CELL_LOADED)
+                unloadedCells.Push(i->first_);
+            i = UnloadCell(i, true);
+        }
+    }
+
+    // Start loading the missing cells within the load distance, nearest first. The observers' areas may overlap, so the
+    // candidates are indexed by their coordinates
+    float loadDistanceSquared = loadDistance_ * loadDistance_;
+    PODVector<WorldCellCandidate> candidates;
+    HashMap<IntVector2, unsigned> candidateIndices;
+
+    for (unsigned i = 0; i < positions.Size(); ++i)
+    {
+        IntVector2 minCell = GetCellCoordinates(positions[i] - Vector3(loadDistance_, 0.0f, loadDistance_));
+        IntVector2 maxCell = GetCellCoordinates(positions[i] + Vector3(loadDistance_, 0.0f, loadDistance_));
+
+        for (int y = minCell.y_; y <= maxCell.y_; ++y)
+        {
+            for (int x = minCell.x_; x <= maxCell.x_; ++x)
+            {
+                IntVector2 coordinates(x, y);
+                if (cells_.Contains(coordinates))
+                    continue;
+
+                float distanceSquared = GetCellDistanceSquared(positions[i], coordinates);
+                if (distanceSquared > loadDistanceSquared)
+                    continue;
+
+                HashMap<IntVector2, unsigned>::Iterator j = candidateIndices.Find(coordinates);
+                if (j != candidateIndices.End())
+                    candidates[j->second_].distanceSquared_ = Min(candidates[j->second_].distanceSquared_, distanceSquared);
+                else
+                {
+                    candidateIndices[coordinates] = candidates.Size();
+                    candidates.Push(WorldCellCandidate{coordinates, distanceSquared});
+                }
+            }
+        }
+    }
+
+    // Limit the number of cell files being read at the same time. The remaining cells are candidates again on later frames
+    Sort(candidates.Begin(), candidates.End(), CompareWorldCellCandidates);
+    for (unsigned i = 0; i < candidates.Size() && numReading < maxReadingCells_; ++i)
+    {
+        if (LoadCell(candidates[i].coordinates_))
+            ++numReading;
+    }
+
+    // Advance the loading cells in the order they were started, until the time budget is used
+    PODVector<IntVector2> loadedCells;
+    HiresTimer loadTimer;
+
+    for (HashMap<IntVector2, WorldCell>::Iterator i = cells_.Begin(); i != cells_.End(); ++i)
+    {
+        if (i->second_.state_ == CELL_LOADED)
+            continue;
+        if (loadTimer.GetUSec(false) >= loadingMs_ * 1000LL)
+            break;
+        if (UpdateCell(i->second_, loadTimer))
+            loadedCells.Push(i->first_);
+    }
+
+    // Send the events last, as the event handlers may load or unload cells
+    for (unsigned i = 0; i < unloadedCells.Size(); ++i)
+    {
+        using namespace WorldCellUnloaded;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_PARTITION] = this;
+        eventData[P_CELL] = unloadedCells[i];
+        SendEvent(E_WORLDCELLUNLOADED, eventData);
+    }
+
+    for (unsigned i = 0; i < loadedCells.Size(); ++i)
+    {
+        using namespace WorldCellLoaded;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_PARTITION] = this;
+        eventData[P_CELL] = loadedCells[i];
+        eventData[P_NODE] = GetCellNode(loadedCells[i]);
+        SendEvent(E_WORLDCELLLOADED, eventData);
+    }
+}
+
+void WorldPartition::UnloadAllCells()
+{
+    UnloadCells(true);
+}
+
+unsigned WorldPartition::SaveCells(const String& directory) const
+{
+    if (!node_)
+        return 0;
+
+    // Sort the persistent child nodes into cells by their position
+    HashMap<IntVector2, PODVector<Node*> > cellNodes;
+    const Vector<SharedPtr<Node> >& children = node_->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+    {
+        if (!children[i]->IsTemporary())
+            cellNodes[GetCellCoordinates(children[i]->GetPosition())].Push(children[i]);
+    }
+
+    String path = AddTrailingSlash(directory);
+    GetSubsystem<FileSystem>()->CreateDir(path);
+    unsigned numSaved = 0;
+
+    for (HashMap<IntVector2, PODVector<Node*> >::ConstIterator i = cellNodes.Begin(); i != cellNodes.End(); ++i)
+    {
+        // The cell root is instantiated as the cell node, so it only needs a descriptive name
+        SharedPtr<Node> cellRoot(new Node(context_));
+        cellRoot->SetName("Cell " + i->first_.ToString());
+
+        String fileName = path + GetCellFileName(i->first_);
+        File file(context_, fileName, FILE_WRITE);
+        if (!file.IsOpen() || !file.WriteFileID("USCB") || !BulkSceneData::Save(file, cellRoot, i->second_))
+        {
+            URHO3D_LOGERROR("Could not save world partition cell " + fileName);
+            continue;
+        }
+
+        ++numSaved;
+    }
+
+    return numSaved;
+}
+
+unsigned WorldPartition::GetNumLoadedCells() const
+{
+    unsigned numLoaded = 0;
+    for (HashMap<IntVector2, WorldCell>::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+    {
+        if (i->second_.state_ == CELL_LOADED)
+            ++numLoaded;
+    }
+
+    return numLoaded;
+}
+
+IntVector2 WorldPartition::GetCellCoordinates(const Vector3& position) const
+{
+    return IntVector2(FloorToInt(position.x_ / cellSize_), FloorToInt(position.z_ / cellSize_));
+}
+
+const WorldCell* WorldPartition::GetCell(const IntVector2& coordinates) const
+{
+    HashMap<IntVector2, WorldCell>::ConstIterator i = cells_.Find(coordinates);
+    return i != cells_.End() ? &i->second_ : nullptr;
+}
+
+Node* WorldPartition::GetCellNode(const IntVector2& coordinates) const
+{
+    const WorldCell* cell = GetCell(coordinates);
+    return cell && cell->state_ == CELL_LOADED ? cell->node_.Get() : nullptr;
+}
+
+String WorldPartition::GetCellFileName(const IntVector2& coordinates) const
+{
+    return String(coordinates.x_) + "_" + String(coordinates.y_) + ".bin";
+}
+
+void WorldPartition::OnSceneSet(Scene* scene)
+{
+    if (scene)
+        SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(WorldPartition, HandleResourceBackgroundLoaded));
+    else
+    {
+        // When the partition's node is being removed from the scene, the cell nodes are removed along with it
+        UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
+        UnloadCells(node_ && node_->GetScene());
+    }
+
+    UpdateEventSubscription();
+}
+
+void WorldPartition::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+{
+    Update();
+}
+
+void WorldPartition::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    if (!pendingResources_.Empty())
+        pendingResources_.Erase(StringHash(eventData[P_RESOURCENAME].GetString()));
+}
+
+bool WorldPartition::LoadCell(const IntVector2& coordinates)
+{
+    // A missing cell file means an empty cell
+    auto* cache = GetSubsystem<ResourceCache>();
+    String fileName = cellPath_ + GetCellFileName(coordinates);
+    if (!cache->Exists(fileName))
+    {
+        cells_[coordinates].state_ = CELL_LOADED;
+        return false;
+    }
+
+    // If an existing file can not be opened, leave the cell out so that it is retried on a later frame
+    SharedPtr<File> file = cache->GetFile(fileName, false);
+    if (!file)
+    {
+        URHO3D_LOGERROR("Could not open world partition cell " + fileName);
+        return false;
+    }
+
+    WorldCell& cell = cells_[coordinates];
+    cell.loadItem_ = new WorldCellLoadItem();
+    cell.loadItem_->workFunction_ = LoadWorldCellWork;
+    cell.loadItem_->file_ = file;
+    cell.state_ = CELL_READING;
+
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (queue)
+        queue->AddWorkItem(SharedPtr<WorkItem>(cell.loadItem_));
+    else
+    {
+        cell.loadItem_->workFunction_(cell.loadItem_, 0);
+        cell.loadItem_->completed_ = true;
+    }
+
+    return true;
+}
+
+HashMap<IntVector2, WorldCell>::Iterator WorldPartition::UnloadCell(HashMap<IntVector2, WorldCell>::Iterator i, bool removeNode)
+{
+    WorldCell& cell = i->second_;
+
+    // If the cell file is already being read, the work item finishes on its own and is then discarded
+    if (cell.state_ == CELL_READING && cell.loadItem_)
+    {
+        auto* queue = GetSubsystem<WorkQueue>();
+        if (queue)
+            queue->RemoveWorkItem(SharedPtr<WorkItem>(cell.loadItem_));
+    }
+
+    if (removeNode && cell.node_)
+        cell.node_->Remove();
+    cell.loadItem_.Reset();
+
+    // Release the resources that are no longer used by anything but the resource cache
+    cell.resources_.Clear();
+    auto* cache = GetSubsystem<ResourceCache>();
+    if (cache)
+    {
+        for (unsigned j = 0; j < cell.resourceRefs_.Size(); ++j)
+            cache->ReleaseResource(cell.resourceRefs_[j].type_, cell.resourceRefs_[j].name_);
+    }
+
+    return cells_.Erase(i);
+}
+
+bool WorldPartition::UpdateCell(WorldCell& cell, HiresTimer& timer)
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+
+    if (cell.state_ == CELL_READING)
+    {
+        if (!cell.loadItem_->completed_)
+            return false;
+
+        if (!cell.loadItem_->success_)
+        {
+            cell.loadItem_.Reset();
+            cell.state_ = CELL_LOADED;
+            return true;
+        }
+
+        // Queue the resources for background loading. Names are sanitated beforehand so that they match the loaded events
+        Vector<ResourceRef> refs;
+        cell.loadItem_->data_.GetResourceRefs(refs);
+        HashSet<StringHash> names;
+
+        for (unsigned i = 0; i < refs.Size(); ++i)
+        {
+            String name = cache->SanitateResourceName(refs[i].name_);
+            StringHash nameHash(name);
+            if (name.Empty() || names.Contains(nameHash))
+                continue;
+            names.Insert(nameHash);
+
+            // Without threading support, the resource is loaded right away
+            if (cache->BackgroundLoadResource(refs[i].type_, name) && !cache->GetExistingResource(refs[i].type_, name))
+                pendingResources_.Insert(nameHash);
+            cell.resourceRefs_.Push(ResourceRef(refs[i].type_, name));
+        }
+
+        cell.state_ = CELL_PRELOADING;
+    }
+
+    if (cell.state_ == CELL_PRELOADING)
+    {
+        // Resources queued by other cells or by other users may also be still loading. A resource that already exists in the
+        // cache has finished even if its loaded event was missed, for example while the partition was outside the scene
+        for (unsigned i = 0; i < cell.resourceRefs_.Size(); ++i)
+        {
+            const ResourceRef& ref = cell.resourceRefs_[i];
+            StringHash nameHash(ref.name_);
+            if (!pendingResources_.Contains(nameHash))
+                continue;
+            if (!cache->GetExistingResource(ref.type_, ref.name_))
+                return false;
+            pendingResources_.Erase(nameHash);
+        }
+
+        // Hold the resources from now on, so that unloading other cells does not release them
+        for (unsigned i = 0; i < cell.resourceRefs_.Size(); ++i)
+        {
+            Resource* resource = cache->GetExistingResource(cell.resourceRefs_[i].type_, cell.resourceRefs_[i].name_);
+            if (resource)
+                cell.resources_.Push(SharedPtr<Resource>(resource));
+        }
+
+        Node* cellNode = node_->CreateChild(String::EMPTY, LOCAL);
+        cellNode->SetTemporary(true);
+        cell.node_ = cellNode;
+        if (!cell.loadItem_->data_.BeginInstantiate(cellNode, cell.resolver_, true, LOCAL))
+        {
+            FinishCell(cell);
+            return true;
+        }
+
+        cell.state_ = CELL_INSTANTIATING;
+    }
+
+    // Create one node with its components at a time until the time budget is used
+    BulkSceneData& data = cell.loadItem_->data_;
+    while (cell.node_ && data.IsInstantiating())
+    {
+        if (!data.InstantiateNodes(cell.resolver_, 1))
+            break;
+        if (timer.GetUSec(false) >= loadingMs_ * 1000LL)
+            break;
+    }
+
+    if (cell.node_ && data.IsInstantiating())
+        return false;
+
+    FinishCell(cell);
+    return true;
+}
+
+void WorldPartition::FinishCell(WorldCell& cell)
+{
+    if (cell.node_)
+    {
+        cell.resolver_.Resolve();
+        cell.node_->ApplyAttributes();
+    }
+
+    cell.resolver_.Reset();
+    cell.loadItem_.Reset();
+    cell.state_ = CELL_LOADED;
+}
+
+void WorldPartition::UnloadCells(bool removeNodes)
+{
+    for (HashMap<IntVector2, WorldCell>::Iterator i = cells_.Begin(); i != cells_.End();)
+        i = UnloadCell(i, removeNodes);
+
+    // Without the loaded events the pending resources would never finish, so forget them. Otherwise keep them, as they may
+    // still be loading when the cells are loaded again
+    if (!HasSubscribedToEvent(E_RESOURCEBACKGROUNDLOADED))
+        pendingResources_.Clear();
+}
+
+void WorldPartition::UpdateEventSubscription()
+{
+    Scene* scene = GetScene();
+    if (scene && IsEnabledEffective())
+        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(WorldPartition, HandleSceneUpdate));
+    else
+        UnsubscribeFromEvent(E_SCENEUPDATE);
+}
+
+float WorldPartition::GetCellDistanceSquared(const Vector3& position, const IntVector2& coordinates) const
+{
+    float minX = coordinates.x_ * cellSize_;
+    float minZ = coordinates.y_ * cellSize_;
+    float dx = Max(Max(minX - position.x_, position.x_ - (minX + cellSize_)), 0.0f);
+    float dz = Max(Max(minZ - position.z_, position.z_ - (minZ + cellSize_)), 0.0f);
+    return dx * dx + dz * dz;
+}
+
+}
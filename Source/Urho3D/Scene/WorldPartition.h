@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+/// \file
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/HashSet.h"
+#include "../Core/WorkQueue.h"
+#include "../IO/File.h"
+#include "../Math/Vector2.h"
+#include "../Resource/Resource.h"
+#include "../Scene/BulkSceneData.h"
+#include "../Scene/Component.h"
+#include "../Scene/SceneResolver.h"
+
+namespace Urho3D
+{
+
+class HiresTimer;
+
+/// World partition cell loading state.
+enum WorldCellState
+{
+    /// Reading and decoding the cell file in a worker thread.
+    CELL_READING = 0,
+    /// Waiting for the referenced resources to finish background loading.
+    CELL_PRELOADING,
+    /// Creating the cell content within the per-frame time budget.
+    CELL_INSTANTIATING,
+    /// Content loaded, or the cell has no file.
+    CELL_LOADED
+};
+
+/// Work item that reads and decodes a world partition cell file.
+/// @nobind
+struct WorldCellLoadItem : public WorkItem
+{
+    /// Cell file.
+    SharedPtr<File> file_;
+    /// Decoded cell content.
+    BulkSceneData data_;
+    /// Whether the file was read successfully.
+    bool success_{};
+};
+
+/// Streamed cell of a world partition.
+/// @nobind
+struct WorldCell
+{
+    /// Loading state.
+    WorldCellState state_{CELL_READING};
+    /// Node containing the cell content.
+    WeakPtr<Node> node_;
+    /// Work item reading and decoding the cell file.
+    SharedPtr<WorldCellLoadItem> loadItem_;
+    /// Resolver for the references between the cell's objects.
+    SceneResolver resolver_;
+    /// Resources referenced by the cell content.
+    Vector<ResourceRef> resourceRefs_;
+    /// Resources held while the cell is loaded.
+    Vector<SharedPtr<Resource> > resources_;
+};
+
+/// %Scene component that splits the child nodes of its node into square cells on the XZ plane, each stored as a separate bulk binary scene file, and streams the cells in and out around observer nodes. Cells are read in worker threads, their resources are loaded in the background, and their content is created within a time budget per frame.
+class URHO3D_API WorldPartition : public Component
+{
+    URHO3D_OBJECT(WorldPartition, Component);
+
+public:
+    /// Construct.
+    explicit WorldPartition(Context* context);
+    /// Destruct.
+    ~WorldPartition() override;
+    /// Register object factory.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Handle enabled/disabled state change.
+    void OnSetEnabled() override;
+
+    /// Set cell size.
+    /// @property
+    void SetCellSize(float size);
+    /// Set distance from an observer within which cells are loaded.
+    /// @property
+    void SetLoadDistance(float distance);
+    /// Set distance from all observers beyond which cells are unloaded. Kept at least the load distance; a larger value prevents cells near the boundary from loading and unloading repeatedly.
+    /// @property
+    void SetUnloadDistance(float distance);
+    /// Set maximum milliseconds per frame to spend on creating cell content.
+    /// @property
+    void SetLoadingMs(int ms);
+    /// Set maximum number of cell files being read at the same time. The other cells start loading on later frames.
+    /// @property
+    void SetMaxReadingCells(int cells);
+    /// Set resource path of the directory containing the cell files.
+    /// @property
+    void SetCellPath(const String& path);
+    /// Add an observer node around which cells are loaded.
+    void AddObserver(Node* node);
+    /// Remove an observer node.
+    void RemoveObserver(Node* node);
+    /// Remove all observer nodes.
+    void RemoveAllObservers();
+    /// Update the cells to load and unload, and continue loading within the time budget. Called automatically on scene update.
+    void Update();
+    /// Unload all cells and release their resources.
+    void UnloadAllCells();
+    /// Save the persistent child nodes of the partition's node into cell files in a directory by their position, and return the number of cell files written. Existing cell files in the directory are not removed.
+    unsigned SaveCells(const String& directory) const;
+
+    /// Return cell size.
+    /// @property
+    float GetCellSize() const { return cellSize_; }
+
+    /// Return load distance.
+    /// @property
+    float GetLoadDistance() const { return loadDistance_; }
+
+    /// Return unload distance.
+    /// @property
+    float GetUnloadDistance() const { return unloadDistance_; }
+
+    /// Return maximum milliseconds per frame to spend on creating cell content.
+    /// @property
+    int GetLoadingMs() const { return loadingMs_; }
+
+    /// Return maximum number of cell files being read at the same time.
+    /// @property
+    int GetMaxReadingCells() const { return maxReadingCells_; }
+
+    /// Return resource path of the cell files.
+    /// @property
+    const String& GetCellPath() const { return cellPath_; }
+
+    /// Return number of observer nodes.
+    /// @property
+    unsigned GetNumObservers() const { return observers_.Size(); }
+
+    /// Return number of cells either loaded or loading.
+    /// @property
+    unsigned GetNumCells() const { return cells_.Size(); }
+
+    /// Return number of fully loaded cells.
+    /// @property
+    unsigned GetNumLoadedCells() const;
+    /// Return cell coordinates of a position in the partition node's local space.
+    IntVector2 GetCellCoordinates(const Vector3& position) const;
+    /// Return loading state of a cell, or null if not loaded or loading.
+    /// @nobind
+    const WorldCell* GetCell(const IntVector2& coordinates) const;
+    /// Return node containing the content of a cell, or null if not loaded or the cell has no file.
+    Node* GetCellNode(const IntVector2& coordinates) const;
+    /// Return file name of a cell relative to the cell path.
+    String GetCellFileName(const IntVector2& coordinates) const;
+
+protected:
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
+
+private:
+    /// Handle scene update event.
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle a background loaded resource.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    /// Start loading a cell. Return true if the cell file is being read.
+    bool LoadCell(const IntVector2& coordinates);
+    /// Unload a cell and release its resources, optionally removing the cell node. Return iterator to the next cell.
+    HashMap<IntVector2, WorldCell>::Iterator UnloadCell(HashMap<IntVector2, WorldCell>::Iterator i, bool removeNode);
+    /// Unload all cells, optionally removing the cell nodes.
+    void UnloadCells(bool removeNodes);
+    /// Advance the loading of a cell. Return true if the cell finished loading.
+    bool UpdateCell(WorldCell& cell, HiresTimer& timer);
+    /// Finish loading a cell.
+    void FinishCell(WorldCell& cell);
+    /// Update the scene update event subscription.
+    void UpdateEventSubscription();
+    /// Return the squared distance on the XZ plane from a position to a cell.
+    float GetCellDistanceSquared(const Vector3& position, const IntVector2& coordinates) const;
+
+    /// Cells either loaded or loading.
+    HashMap<IntVector2, WorldCell> cells_;
+    /// Observer nodes.
+    Vector<WeakPtr<Node> > observers_;
+    /// Names of resources queued for background loading and not yet finished.
+    HashSet<StringHash> pendingResources_;
+    /// Resource path of the cell files.
+    String cellPath_;
+    /// Cell size.
+    float cellSize_;
+    /// Load distance.
+    float loadDistance_;
+    /// Unload distance.
+    float unloadDistance_;
+    /// Maximum milliseconds per frame to spend on creating cell content.
+    int loadingMs_;
+    /// Maximum number of cell files being read at the same time.
+    int maxReadingCells_;
+};
+
+}